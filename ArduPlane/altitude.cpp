@@ -663,12 +663,13 @@ void Plane::rangefinder_terrain_correction(float &height)
         !terrain_enabled_in_current_mode()) {
         return;
     }
-    float terrain_amsl1, terrain_amsl2;
-    if (!terrain.height_amsl(current_loc, terrain_amsl1) ||
-        !terrain.height_amsl(next_WP_loc, terrain_amsl2)) {
+    const Location locs[2] { current_loc, next_WP_loc };
+    float terrain_amsl[2];
+    bool valid[2];
+    if (terrain.height_amsl(locs, 2, terrain_amsl, valid) != 2) {
         return;
     }
-    float correction = (terrain_amsl1 - terrain_amsl2);
+    float correction = (terrain_amsl[0] - terrain_amsl[1]);
     height += correction;
     auto_state.terrain_correction = correction;
 #endif
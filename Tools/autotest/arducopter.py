@@ -9504,6 +9504,51 @@ class AutoTestCopter(vehicle_test_suite.TestSuite):
         self.wait_disarmed()
         self.reboot_sitl()
 
+    def SITLSnapshot(self):
+        '''Ensure SITL returns to a snapshot of a flying vehicle'''
+        self.takeoff(20, mode='GUIDED')
+        self.delay_sim_time(5)
+        snapshot_pos = self.assert_receive_message('GLOBAL_POSITION_INT')
+        snapshot_time = self.get_sim_time()
+        self.snapshot_SITL()
+        self.delay_sim_time(5)
+
+        self.progress("fly 50m North")
+        self.fly_guided_move_local(50, 0, 20)
+        moved_pos = self.assert_receive_message('GLOBAL_POSITION_INT')
+        if self.get_distance_int(snapshot_pos, moved_pos) < 40:
+            raise NotAchievedException("Did not move away from snapshot")
+        restore_time = self.get_sim_time()
+        self.restore_SITL()
+
+        # messages sent before the restore may still arrive, so wait
+        # for time to go backwards
+        tstart = time.time()
+        while True:
+            if time.time() - tstart > 30:
+                raise NotAchievedException("Time did not go back after restore")
+            m = self.assert_receive_message('SYSTEM_TIME', timeout=5)
+            restored_time = m.time_boot_ms * 1.0e-3
+            if restored_time < restore_time:
+                break
+        self.progress("snapshot_time=%f restored_time=%f" % (snapshot_time, restored_time))
+        # the snapshot is taken during the 5 seconds after the signal
+        if restored_time < snapshot_time or restored_time > snapshot_time + 5:
+            raise NotAchievedException("Time not restored to snapshot (snapshot=%f restored=%f)" %
+                                       (snapshot_time, restored_time))
+
+        restored_pos = self.assert_receive_message('GLOBAL_POSITION_INT')
+        delta = self.get_distance_int(snapshot_pos, restored_pos)
+        self.progress("Distance from snapshot position: %f" % delta)
+        if delta > 5:
+            raise NotAchievedException("Position not restored to snapshot (distance=%f)" % delta)
+
+        # the vehicle flies on from the snapshot
+        self.fly_guided_move_local(0, 30, 20)
+        self.land_and_disarm()
+        # leave a SITL which doesn't hold a snapshot
+        self.reset_SITL_commandline()
+
     def SMART_RTL(self):
         '''Check SMART_RTL'''
         self.progress("arm the vehicle and takeoff in Guided")
@@ -12068,6 +12113,7 @@ class AutoTestCopter(vehicle_test_suite.TestSuite):
             self.MotorVibration,
             Test(self.DynamicNotches, attempts=4),
             self.PositionWhenGPSIsZero,
+            self.SITLSnapshot,
             self.DynamicRpmNotches, # Do not add attempts to this - failure is sign of a bug
             self.PIDNotches,
             self.StaticNotches,
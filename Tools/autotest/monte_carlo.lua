@@ -0,0 +1,103 @@
+--[[
+  Monte Carlo run schedule, installed in each run's scripts directory
+  by monte_carlo.py
+
+  Loads the run's mission, arms in AUTO and injects the run's failures
+  at fixed simulated times, so that no event of a run depends on the
+  latency of the harness. The schedule is read from
+  monte_carlo_schedule.txt in the run directory, one event per line:
+    mode MODE_NUMBER
+    arm SECONDS_AFTER_BOOT
+    fail NAME VALUE SECONDS_AFTER_ARMING
+  The mission is read from mission.txt in the run directory
+--]]
+
+local SCHEDULE_FILE = 'monte_carlo_schedule.txt'
+local MISSION_FILE = 'mission.txt'
+local MAV_SEVERITY_INFO = 6
+
+local auto_mode = nil
+local arm_ms = nil
+local failures = {}
+local armed_ms = nil
+local last_arm_attempt_ms = nil
+
+local function read_schedule()
+   local file = assert(io.open(SCHEDULE_FILE), 'Could not open ' .. SCHEDULE_FILE)
+   for line in file:lines() do
+      local _, _, mode = string.find(line, '^mode%s+(%d+)')
+      local _, _, arm = string.find(line, '^arm%s+([-.%deE]+)')
+      local _, _, name, value, when = string.find(line, '^fail%s+(%S+)%s+([-.%deE]+)%s+([-.%deE]+)')
+      if mode then
+         auto_mode = tonumber(mode)
+      elseif arm then
+         arm_ms = math.floor(tonumber(arm) * 1000)
+      elseif name then
+         failures[#failures+1] = { name = name, value = tonumber(value), ms = math.floor(tonumber(when) * 1000) }
+      end
+   end
+   file:close()
+   assert(auto_mode and arm_ms, SCHEDULE_FILE .. ': mode and arm are needed')
+   table.sort(failures, function(a, b) return a.ms < b.ms end)
+end
+
+local function read_mission()
+   local file = assert(io.open(MISSION_FILE), 'Could not open ' .. MISSION_FILE)
+   assert(string.find(file:read('l'), 'QGC WPL 110') == 1, MISSION_FILE .. ': incorrect format')
+   assert(mission:clear(), 'Could not clear mission')
+   local item = mavlink_mission_item_int_t()
+   local index = 0
+   for line in file:lines() do
+      local ret, _, seq, _, frame, cmd, p1, p2, p3, p4, x, y, z = string.find(line, "^(%d+)%s+(%d+)%s+(%d+)%s+(%d+)%s+([-.%d]+)%s+([-.%d]+)%s+([-.%d]+)%s+([-.%d]+)%s+([-.%d]+)%s+([-.%d]+)%s+([-.%d]+)%s+(%d+)")
+      assert(ret and tonumber(seq) == index, MISSION_FILE .. ': bad item ' .. index)
+      item:seq(index)
+      item:frame(tonumber(frame))
+      item:command(tonumber(cmd))
+      item:param1(tonumber(p1))
+      item:param2(tonumber(p2))
+      item:param3(tonumber(p3))
+      item:param4(tonumber(p4))
+      if mission:cmd_has_location(tonumber(cmd)) then
+         item:x(math.floor(tonumber(x)*10^7))
+         item:y(math.floor(tonumber(y)*10^7))
+      else
+         item:x(math.floor(tonumber(x)))
+         item:y(math.floor(tonumber(y)))
+      end
+      item:z(tonumber(z))
+      assert(mission:set_item(index, item), MISSION_FILE .. ': could not store item ' .. index)
+      index = index + 1
+   end
+   file:close()
+   gcs:send_text(MAV_SEVERITY_INFO, string.format("MonteCarlo: loaded %u mission items", index))
+end
+
+local function update()
+   local now_ms = millis():toint()
+
+   if armed_ms == nil then
+      if arming:is_armed() then
+         armed_ms = now_ms
+         gcs:send_text(MAV_SEVERITY_INFO, "MonteCarlo: armed")
+      elseif now_ms >= arm_ms and (last_arm_attempt_ms == nil or now_ms - last_arm_attempt_ms >= 1000) then
+         -- keep trying once a second until prearm checks pass
+         last_arm_attempt_ms = now_ms
+         vehicle:set_mode(auto_mode)
+         arming:arm()
+      end
+      return update, 10
+   end
+
+   while #failures > 0 and now_ms - armed_ms >= failures[1].ms do
+      local failure = table.remove(failures, 1)
+      if not param:set(failure.name, failure.value) then
+         gcs:send_text(0, "MonteCarlo: failed to set " .. failure.name)
+      end
+   end
+   return update, 10
+end
+
+read_schedule()
+read_mission()
+
+return update, 10
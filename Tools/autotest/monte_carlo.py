@@ -0,0 +1,371 @@
+#!/usr/bin/env python3
+
+'''
+Run a mission many times in SITL under randomised conditions
+
+Each run is given a seed.  The seed picks the values of the swept
+parameters and the times of the injected failures, and seeds the
+simulated sensor noise in SITL, so a run can be repeated from its
+seed.  The mission is loaded, the vehicle armed in AUTO and the
+failures injected by monte_carlo.lua inside SITL at fixed simulated
+times, so they don't depend on the latency of this harness, which only
+collects metrics.  Runs are spread over parallel SITL instances, and a
+row of metrics is appended to a CSV results file as each run finishes.
+A run repeated with --only-run writes its row to its own CSV file.
+
+Example:
+  ./Tools/autotest/monte_carlo.py build/sitl/bin/arducopter quad mission.txt \\
+      --defaults Tools/autotest/default_params/copter.parm \\
+      --param AUTO_OPTIONS=3 \\
+      --sweep SIM_WIND_SPD=uniform:0:10 --sweep SIM_WIND_DIR=uniform:0:360 \\
+      --sweep SIM_ACC1_RND=normal:0:0.5 \\
+      --fail SIM_GPS1_ENABLE=0@uniform:30:120 \\
+      --runs 100 --jobs 8 --seed 1
+
+AP_FLAKE8_CLEAN
+'''
+
+import argparse
+import csv
+import math
+import multiprocessing
+import os
+import random
+import shutil
+import subprocess
+import sys
+import time
+
+from pymavlink import mavutil
+
+# start every run at the same UTC time so GPS time doesn't vary
+DEFAULT_START_TIME = 1700000000
+
+# script which runs each run's schedule inside SITL
+SCHEDULE_SCRIPT = os.path.join(os.path.dirname(os.path.realpath(__file__)), 'monte_carlo.lua')
+
+# AUTO mode number of each vehicle binary
+AUTO_MODES = {
+    'arducopter': 3,
+    'arducopter-heli': 3,
+    'arduplane': 10,
+    'ardurover': 10,
+    'ardusub': 3,
+}
+
+METRICS = [
+    'outcome',
+    'flight_time',
+    'xtrack_max',
+    'xtrack_rms',
+    'ekf_vel_max',
+    'ekf_pos_horiz_max',
+    'ekf_pos_vert_max',
+    'ekf_compass_max',
+    'battery_mah',
+]
+
+
+class Distribution(object):
+    '''a value drawn from a distribution, given as one of:
+    VALUE, uniform:LOW:HIGH, normal:MEAN:SD, choice:A,B,C'''
+
+    def __init__(self, spec):
+        self.spec = spec
+        fields = spec.split(':')
+        self.kind = fields[0]
+        if self.kind == 'uniform' and len(fields) == 3:
+            self.args = (float(fields[1]), float(fields[2]))
+        elif self.kind == 'normal' and len(fields) == 3:
+            self.args = (float(fields[1]), float(fields[2]))
+        elif self.kind == 'choice' and len(fields) == 2:
+            self.args = [float(x) for x in fields[1].split(',')]
+        elif len(fields) == 1:
+            self.kind = 'fixed'
+            self.args = float(fields[0])
+        else:
+            raise ValueError("Bad distribution (%s)" % spec)
+
+    def sample(self, rng):
+        if self.kind == 'uniform':
+            return rng.uniform(*self.args)
+        if self.kind == 'normal':
+            return rng.gauss(*self.args)
+        if self.kind == 'choice':
+            return rng.choice(self.args)
+        return self.args
+
+
+def parse_sweep(spec):
+    '''NAME=DISTRIBUTION'''
+    (name, dist) = spec.split('=', 1)
+    return (name, Distribution(dist))
+
+
+def parse_failure(spec):
+    '''NAME=VALUE@TIME, with TIME in seconds after arming'''
+    (name, rest) = spec.split('=', 1)
+    (value, when) = rest.split('@', 1)
+    return (name, float(value), Distribution(when))
+
+
+class MonteCarloRun(object):
+    '''one seeded run of the mission'''
+
+    def __init__(self, args, index, seed, instance):
+        self.args = args
+        self.index = index
+        self.seed = seed
+        self.instance = instance
+        self.rundir = os.path.join(args.outdir, "run%05u" % index)
+
+        # draw in a fixed order so each value only depends on the seed
+        rng = random.Random(seed)
+        self.params = [(name, dist.sample(rng)) for (name, dist) in args.sweep]
+        self.failures = [(name, value, dist.sample(rng)) for (name, value, dist) in args.fail]
+
+        self.row = {
+            'run': index,
+            'seed': seed,
+        }
+        for (name, value) in self.params:
+            self.row[name] = value
+        for (name, value, when) in self.failures:
+            self.row['%s@' % name] = when
+
+    def write_defaults(self):
+        path = os.path.join(self.rundir, 'monte_carlo.parm')
+        with open(path, 'w') as f:
+            # the schedule runs as a script
+            f.write("SCR_ENABLE 1\n")
+            for (name, value) in self.args.param + self.params:
+                f.write("%s %s\n" % (name, value))
+        return path
+
+    def install_schedule(self):
+        '''install the script, mission and schedule which SITL runs'''
+        scripts_dir = os.path.join(self.rundir, 'scripts')
+        os.makedirs(scripts_dir, exist_ok=True)
+        shutil.copy(SCHEDULE_SCRIPT, os.path.join(scripts_dir, 'monte_carlo.lua'))
+        shutil.copy(self.args.mission, os.path.join(self.rundir, 'mission.txt'))
+        with open(os.path.join(self.rundir, 'monte_carlo_schedule.txt'), 'w') as f:
+            f.write("mode %u\n" % self.args.auto_mode)
+            f.write("arm %f\n" % self.args.arm_time)
+            for (name, value, when) in self.failures:
+                f.write("fail %s %s %f\n" % (name, value, when))
+
+    def start_sitl(self):
+        self.install_schedule()
+        defaults = self.args.defaults[:]
+        defaults.append(self.write_defaults())
+        cmd = [
+            self.args.binary,
+            '--model', self.args.model,
+            '--speedup', str(self.args.speedup),
+            '--instance', str(self.instance),
+            '--seed', str(self.seed),
+            '--start-time', str(self.args.start_time),
+            '--defaults', ','.join([os.path.abspath(x) for x in defaults]),
+            '--wipe',
+        ]
+        if self.args.home is not None:
+            cmd.extend(['--home', self.args.home])
+        self.logfile = open(os.path.join(self.rundir, 'sitl.log'), 'w')
+        self.sitl = subprocess.Popen(cmd, cwd=self.rundir, stdout=self.logfile, stderr=subprocess.STDOUT)
+
+    def connect(self):
+        port = 5760 + 10 * self.instance
+        deadline = time.time() + 60
+        while True:
+            try:
+                self.mav = mavutil.mavlink_connection('tcp:127.0.0.1:%u' % port, retries=1)
+                break
+            except Exception:
+                if time.time() > deadline or self.sitl.poll() is not None:
+                    raise
+                time.sleep(0.5)
+        self.mav.wait_heartbeat()
+        self.mav.mav.request_data_stream_send(self.mav.target_system,
+                                              self.mav.target_component,
+                                              mavutil.mavlink.MAV_DATA_STREAM_ALL,
+                                              10,
+                                              1)
+
+    def fly(self):
+        '''collect metrics until the vehicle disarms or the simulated
+        timeout passes.  Arming and failures are done by the schedule
+        script in SITL'''
+        xtrack_max = 0
+        xtrack_sum_sq = 0
+        xtrack_count = 0
+        ekf = {
+            'ekf_vel_max': 0,
+            'ekf_pos_horiz_max': 0,
+            'ekf_pos_vert_max': 0,
+            'ekf_compass_max': 0,
+        }
+        battery_mah = 0
+        boot_ms = 0
+        armed_ms = None
+        disarmed_ms = None
+        outcome = 'timeout'
+
+        while True:
+            if self.sitl.poll() is not None:
+                outcome = 'crashed'
+                break
+            m = self.mav.recv_match(blocking=True, timeout=10)
+            if m is None:
+                outcome = 'no-data'
+                break
+            mtype = m.get_type()
+            if mtype == 'SYSTEM_TIME':
+                boot_ms = m.time_boot_ms
+            elif mtype == 'HEARTBEAT' and m.get_srcComponent() == self.mav.target_component:
+                armed = (m.base_mode & mavutil.mavlink.MAV_MODE_FLAG_SAFETY_ARMED) != 0
+                if armed and armed_ms is None:
+                    armed_ms = boot_ms
+                elif not armed and armed_ms is not None:
+                    disarmed_ms = boot_ms
+                    outcome = 'complete'
+                    break
+            elif mtype == 'NAV_CONTROLLER_OUTPUT' and armed_ms is not None:
+                xtrack = abs(m.xtrack_error)
+                xtrack_max = max(xtrack_max, xtrack)
+                xtrack_sum_sq += xtrack * xtrack
+                xtrack_count += 1
+            elif mtype == 'EKF_STATUS_REPORT' and armed_ms is not None:
+                ekf['ekf_vel_max'] = max(ekf['ekf_vel_max'], m.velocity_variance)
+                ekf['ekf_pos_horiz_max'] = max(ekf['ekf_pos_horiz_max'], m.pos_horiz_variance)
+                ekf['ekf_pos_vert_max'] = max(ekf['ekf_pos_vert_max'], m.pos_vert_variance)
+                ekf['ekf_compass_max'] = max(ekf['ekf_compass_max'], m.compass_variance)
+            elif mtype == 'BATTERY_STATUS' and m.id == 0 and m.current_consumed >= 0:
+                battery_mah = m.current_consumed
+
+            if armed_ms is None:
+                if boot_ms > self.args.timeout * 1000:
+                    break
+                continue
+
+            if boot_ms - armed_ms > self.args.timeout * 1000:
+                break
+
+        if armed_ms is not None:
+            end_ms = disarmed_ms if disarmed_ms is not None else boot_ms
+            self.row['flight_time'] = (end_ms - armed_ms) * 0.001
+        self.row['outcome'] = outcome
+        self.row['xtrack_max'] = xtrack_max
+        self.row['xtrack_rms'] = math.sqrt(xtrack_sum_sq / xtrack_count) if xtrack_count else 0
+        self.row.update(ekf)
+        self.row['battery_mah'] = battery_mah
+
+    def run(self):
+        os.makedirs(self.rundir, exist_ok=True)
+        self.start_sitl()
+        try:
+            self.connect()
+            self.fly()
+        except Exception as ex:
+            self.row['outcome'] = 'error: %s' % ex
+        finally:
+            self.sitl.terminate()
+            try:
+                self.sitl.wait(timeout=10)
+            except subprocess.TimeoutExpired:
+                self.sitl.kill()
+                self.sitl.wait()
+            self.logfile.close()
+        return self.row
+
+
+# each worker process owns a SITL instance number, and so its ports
+worker_instance = None
+
+
+def init_worker(counter, first_instance):
+    global worker_instance
+    with counter.get_lock():
+        worker_instance = first_instance + counter.value
+        counter.value += 1
+
+
+def run_one(job):
+    (args, index, seed) = job
+    return MonteCarloRun(args, index, seed, worker_instance).run()
+
+
+def main():
+    parser = argparse.ArgumentParser("monte_carlo.py")
+    parser.add_argument('binary', type=str, help='vehicle binary to use')
+    parser.add_argument('model', type=str, help='vehicle model to use')
+    parser.add_argument('mission', type=str, help='mission file path')
+    parser.add_argument('--home', type=str, default=None, help='start location (lat,lng,alt,yaw) or location name')
+    parser.add_argument('--defaults', type=str, action='append', default=[], help='defaults file, may be repeated')
+    parser.add_argument('--param', type=str, action='append', default=[], help='NAME=VALUE set for every run')
+    parser.add_argument('--sweep', type=str, action='append', default=[],
+                        help='NAME=DIST parameter drawn for each run; DIST is VALUE, uniform:LOW:HIGH, '
+                        'normal:MEAN:SD or choice:A,B,C')
+    parser.add_argument('--fail', type=str, action='append', default=[],
+                        help='NAME=VALUE@DIST set parameter NAME to VALUE DIST seconds after arming')
+    parser.add_argument('--runs', type=int, default=10, help='number of runs')
+    parser.add_argument('--jobs', type=int, default=multiprocessing.cpu_count(), help='number of parallel SITL instances')
+    parser.add_argument('--seed', type=int, default=0, help='seed of the first run; run N uses SEED+N')
+    parser.add_argument('--only-run', type=int, default=None, help='repeat a single run from a results file')
+    parser.add_argument('--speedup', type=int, default=100, help='simulation speedup')
+    parser.add_argument('--timeout', type=float, default=1200, help='simulated seconds allowed for a run')
+    parser.add_argument('--arm-time', type=float, default=30, help='simulated seconds after boot to start arming')
+    parser.add_argument('--auto-mode', type=int, default=None,
+                        help='AUTO mode number, found from the binary name if not given')
+    parser.add_argument('--start-time', type=int, default=DEFAULT_START_TIME, help='simulated UNIX start time')
+    parser.add_argument('--first-instance', type=int, default=0, help='SITL instance of the first parallel job')
+    parser.add_argument('--outdir', type=str, default='monte_carlo', help='directory for runs and results')
+    args = parser.parse_args()
+
+    args.binary = os.path.abspath(args.binary)
+    if args.auto_mode is None:
+        binary_name = os.path.basename(args.binary)
+        if binary_name not in AUTO_MODES:
+            print("Unknown vehicle binary %s, use --auto-mode" % binary_name)
+            return 1
+        args.auto_mode = AUTO_MODES[binary_name]
+    args.mission = os.path.abspath(args.mission)
+    args.param = [tuple(x.split('=', 1)) for x in args.param]
+    args.sweep = [parse_sweep(x) for x in args.sweep]
+    args.fail = [parse_failure(x) for x in args.fail]
+    os.makedirs(args.outdir, exist_ok=True)
+
+    if args.only_run is not None:
+        indexes = [args.only_run]
+    else:
+        indexes = range(args.runs)
+    jobs = [(args, i, args.seed + i) for i in indexes]
+
+    columns = ['run', 'seed']
+    columns += [name for (name, dist) in args.sweep]
+    columns += ['%s@' % name for (name, value, dist) in args.fail]
+    columns += METRICS
+
+    if args.only_run is not None:
+        # keep the results of the whole sweep
+        results_path = os.path.join(args.outdir, 'run%05u.csv' % args.only_run)
+    else:
+        results_path = os.path.join(args.outdir, 'results.csv')
+    counter = multiprocessing.Value('i', 0)
+    with open(results_path, 'w', newline='') as f:
+        writer = csv.DictWriter(f, fieldnames=columns, restval='')
+        writer.writeheader()
+        pool = multiprocessing.Pool(min(args.jobs, len(jobs)),
+                                    initializer=init_worker,
+                                    initargs=(counter, args.first_instance))
+        for row in pool.imap_unordered(run_one, jobs):
+            writer.writerow(row)
+            f.flush()
+            print("run %u: %s" % (row['run'], row.get('outcome')))
+        pool.close()
+        pool.join()
+    print("Results in %s" % results_path)
+
+
+if __name__ == "__main__":
+    os.environ['PYTHONUNBUFFERED'] = '1'
+    sys.exit(main())
@@ -11,6 +11,7 @@ import copy
 import math
 import operator
 import os
+import shutil
 import sys
 import time
 
@@ -5186,6 +5187,57 @@ Brakes have negligible effect (with=%0.2fm without=%0.2fm delta=%0.2fm)
         if count < 3:
             raise NotAchievedException("Expected at least three hellos")
 
+    def test_scripting_bytecode_cache(self):
+        self.start_subtest("Scripting bytecode cache")
+
+        self.context_push()
+        self.context_collect('STATUSTEXT')
+
+        self.set_parameters({
+            "SCR_ENABLE": 1,
+            "SCR_DEBUG_OPTS": 2 | 64,  # runtime messages, cache compiled scripts
+        })
+        self.install_example_script_context("simple_loop.lua")
+        cache_dir = os.path.join("scripts", "cache")
+        shutil.rmtree(cache_dir, ignore_errors=True)
+
+        self.progress("First load compiles the script and fills the cache")
+        self.reboot_sitl()
+        self.wait_statustext("hello, world", check_context=True)
+        if self.statustext_in_collections("loaded from cache"):
+            raise NotAchievedException("Loaded from an empty cache")
+        entries = [x for x in os.listdir(cache_dir) if x.endswith(".luac")]
+        if len(entries) != 1:
+            raise NotAchievedException("Expected one cache entry, got %s" % str(entries))
+        entry = os.path.join(cache_dir, entries[0])
+        with open(entry, 'rb') as f:
+            contents = f.read()
+
+        self.progress("Second load comes from the cache")
+        self.context_clear_collection('STATUSTEXT')
+        self.reboot_sitl()
+        self.wait_statustext("simple_loop.lua loaded from cache", check_context=True)
+        self.wait_statustext("hello, world", check_context=True)
+        with open(entry, 'rb') as f:
+            if f.read() != contents:
+                raise NotAchievedException("Cache entry was rebuilt")
+
+        self.progress("A modified entry is rejected and rebuilt")
+        with open(entry, 'wb') as f:
+            f.write(contents[:-1] + bytes([contents[-1] ^ 0xFF]))
+        self.context_clear_collection('STATUSTEXT')
+        self.reboot_sitl()
+        self.wait_statustext("hello, world", check_context=True)
+        if self.statustext_in_collections("loaded from cache"):
+            raise NotAchievedException("Loaded a modified cache entry")
+        with open(entry, 'rb') as f:
+            if f.read() != contents:
+                raise NotAchievedException("Cache entry was not rebuilt")
+
+        self.context_pop()
+        shutil.rmtree(cache_dir, ignore_errors=True)
+        self.reboot_sitl()
+
     def test_scripting_internal_test(self):
         self.start_subtest("Scripting internal test")
 
@@ -5231,6 +5283,27 @@ Brakes have negligible effect (with=%0.2fm without=%0.2fm delta=%0.2fm)
         self.context_pop()
         self.reboot_sitl()
 
+    def test_scripting_benchmark(self):
+        self.start_subtest("Scripting benchmark")
+
+        self.context_push()
+        self.context_collect("STATUSTEXT")
+
+        self.set_parameters({
+            "SCR_ENABLE": 1,
+            "SCR_DEBUG_OPTS": 2,
+        })
+        self.install_test_script_context("benchmark.lua")
+        self.reboot_sitl()
+
+        self.wait_statustext("Benchmarks complete", check_context=True, timeout=60)
+        for m in self.context_collection("STATUSTEXT"):
+            if m.text.startswith("Benchmark "):
+                self.progress(m.text)
+
+        self.context_pop()
+        self.reboot_sitl()
+
     def test_scripting_hello_world(self):
         self.start_subtest("Scripting hello world")
 
@@ -5345,7 +5418,9 @@ Brakes have negligible effect (with=%0.2fm without=%0.2fm delta=%0.2fm)
         self.test_scripting_print_home_and_origin()
         self.test_scripting_hello_world()
         self.test_scripting_simple_loop()
+        self.test_scripting_bytecode_cache()
         self.test_scripting_internal_test()
+        self.test_scripting_benchmark()
         self.test_scripting_auxfunc()
         self.test_scripting_serial_loopback()
 
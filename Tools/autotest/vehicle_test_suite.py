@@ -3303,6 +3303,17 @@ class TestSuite(ABC):
         util.pexpect_close(self.sitl)
         self.sitl = None
 
+    def snapshot_SITL(self):
+        '''snapshot the state of SITL, which restore_SITL returns to'''
+        self.progress("Snapshotting SITL")
+        self.sitl.kill(signal.SIGUSR1)
+
+    def restore_SITL(self):
+        '''return SITL to its most recent snapshot'''
+        self.progress("Restoring SITL snapshot")
+        self.sitl.kill(signal.SIGUSR2)
+        self.drain_mav()
+
     def start_test(self, description):
         self.progress("##################################################################################")
         self.progress("########## %s  ##########" % description)
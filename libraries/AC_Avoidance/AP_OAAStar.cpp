@@ -0,0 +1,289 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AC_Avoidance_config.h"
+
+#if AP_OAPATHPLANNER_DIJKSTRA_ENABLED
+
+#include "AP_OAAStar.h"
+
+#include <float.h>
+
+#define OA_ASTAR_NODES_PER_CHUNK        32      // node and open set arrays grow in increments of 32 elements
+#define OA_ASTAR_ADJ_PER_CHUNK          256     // adjacency lists grow in increments of 256 elements
+
+AP_OAAStar::AP_OAAStar() :
+    _nodes(OA_ASTAR_NODES_PER_CHUNK),
+    _adj_start(OA_ASTAR_NODES_PER_CHUNK),
+    _adj(OA_ASTAR_ADJ_PER_CHUNK),
+    _open_set(OA_ASTAR_NODES_PER_CHUNK)
+{
+}
+
+// set the visibility graph between the num_points intermediate points
+// returns false if out of memory or there are too many points
+bool AP_OAAStar::set_intermediate_graph(const AP_OAVisGraph &visgraph, uint8_t num_points)
+{
+    _visgraph = nullptr;
+    _num_nodes = 0;
+
+    // each item is listed under both of its points
+    if ((num_points + 2 > NOTSET_IDX) || (visgraph.num_items() > UINT16_MAX / 2)) {
+        return false;
+    }
+    if (!_nodes.expand_to_hold(num_points + 2) ||
+        !_adj_start.expand_to_hold(num_points + 1) ||
+        !_adj.expand_to_hold(visgraph.num_items() * 2)) {
+        return false;
+    }
+
+    // count the items touching each point
+    for (uint16_t i = 0; i <= num_points; i++) {
+        _adj_start[i] = 0;
+    }
+    for (uint16_t i = 0; i < visgraph.num_items(); i++) {
+        const AP_OAVisGraph::VisGraphItem &item = visgraph[i];
+        if ((item.id1.id_num < num_points) && (item.id2.id_num < num_points)) {
+            _adj_start[item.id1.id_num + 1]++;
+            _adj_start[item.id2.id_num + 1]++;
+        }
+    }
+    for (uint16_t i = 0; i < num_points; i++) {
+        _adj_start[i + 1] += _adj_start[i];
+    }
+
+    // fill in the lists, using the start of each list as a cursor
+    // and then shifting the starts back into place
+    for (uint16_t i = 0; i < visgraph.num_items(); i++) {
+        const AP_OAVisGraph::VisGraphItem &item = visgraph[i];
+        if ((item.id1.id_num < num_points) && (item.id2.id_num < num_points)) {
+            _adj[_adj_start[item.id1.id_num]++] = i;
+            _adj[_adj_start[item.id2.id_num]++] = i;
+        }
+    }
+    for (uint16_t i = num_points; i > 0; i--) {
+        _adj_start[i] = _adj_start[i - 1];
+    }
+    _adj_start[0] = 0;
+
+    _visgraph = &visgraph;
+    _num_nodes = num_points + 2;
+
+    // no heuristic until set
+    for (uint16_t i = 0; i < _num_nodes; i++) {
+        _nodes[i].heuristic_cm = 0;
+    }
+
+    return true;
+}
+
+// set the straight line distance from an intermediate point to the destination
+void AP_OAAStar::set_heuristic(uint8_t point_num, float distance_cm)
+{
+    if (point_num + 2 < _num_nodes) {
+        _nodes[point_num + 2].heuristic_cm = distance_cm;
+    }
+}
+
+// search for the shortest path from the source to the destination
+AP_OAAStar::Result AP_OAAStar::search(const AP_OAVisGraph &source_visgraph, const AP_OAVisGraph &destination_visgraph)
+{
+    if (_visgraph == nullptr) {
+        return Result::NO_PATH;
+    }
+
+    for (uint16_t i = 0; i < _num_nodes; i++) {
+        Node &node = _nodes[i];
+        node.distance_cm = FLT_MAX;
+        node.dest_distance_cm = FLT_MAX;
+        node.prev_idx = NOTSET_IDX;
+        node.visited = false;
+    }
+    _nodes[SOURCE_IDX].heuristic_cm = 0;
+    _nodes[DESTINATION_IDX].heuristic_cm = 0;
+    _open_set_numitems = 0;
+
+    // record which points can see the destination
+    for (uint16_t i = 0; i < destination_visgraph.num_items(); i++) {
+        node_index node_idx;
+        if (find_node_from_id(destination_visgraph[i].id2, node_idx)) {
+            _nodes[node_idx].dest_distance_cm = destination_visgraph[i].distance_cm;
+        }
+    }
+
+    // start algorithm from source point
+    _nodes[SOURCE_IDX].distance_cm = 0;
+    _nodes[SOURCE_IDX].visited = true;
+    for (uint16_t i = 0; i < source_visgraph.num_items(); i++) {
+        node_index node_idx;
+        if (!find_node_from_id(source_visgraph[i].id2, node_idx)) {
+            return Result::NO_PATH;
+        }
+        if (!relax(SOURCE_IDX, node_idx, source_visgraph[i].distance_cm)) {
+            return Result::OUT_OF_MEMORY;
+        }
+    }
+
+    // move to the open node with the lowest cost until we reach the destination
+    node_index curr_idx;
+    while (open_set_pop(curr_idx)) {
+        Node &curr_node = _nodes[curr_idx];
+        if (curr_node.visited) {
+            // stale entry for a node we have already reached by a shorter path
+            continue;
+        }
+        if (curr_idx == DESTINATION_IDX) {
+            return Result::SUCCESS;
+        }
+        curr_node.visited = true;
+
+        // update distances to all intermediate points visible from the current node
+        const uint8_t point_num = curr_idx - 2;
+        for (uint16_t k = _adj_start[point_num]; k < _adj_start[point_num + 1]; k++) {
+            const AP_OAVisGraph::VisGraphItem &item = (*_visgraph)[_adj[k]];
+            const node_index other_idx = ((item.id1.id_num == point_num) ? item.id2.id_num : item.id1.id_num) + 2;
+            if (!relax(curr_idx, other_idx, item.distance_cm)) {
+                return Result::OUT_OF_MEMORY;
+            }
+        }
+
+        // and to the destination if visible
+        if (curr_node.dest_distance_cm < FLT_MAX) {
+            if (!relax(curr_idx, DESTINATION_IDX, curr_node.dest_distance_cm)) {
+                return Result::OUT_OF_MEMORY;
+            }
+        }
+    }
+
+    return Result::NO_PATH;
+}
+
+// update distance to a node via another node, adding it to the open set if shorter
+// returns false if out of memory
+bool AP_OAAStar::relax(node_index from_idx, node_index to_idx, float distance_cm)
+{
+    Node &to_node = _nodes[to_idx];
+    if (to_node.visited) {
+        return true;
+    }
+    const float dist_via_from_node = _nodes[from_idx].distance_cm + distance_cm;
+    if (dist_via_from_node >= to_node.distance_cm) {
+        return true;
+    }
+    to_node.distance_cm = dist_via_from_node;
+    to_node.prev_idx = from_idx;
+    return open_set_push(to_idx);
+}
+
+// returns the node before idx on the shortest path, or NOTSET_IDX
+AP_OAAStar::node_index AP_OAAStar::prev_node(node_index idx) const
+{
+    if (idx >= _num_nodes) {
+        return NOTSET_IDX;
+    }
+    return _nodes[idx].prev_idx;
+}
+
+// find a node's index from its id (i.e. id type and id number)
+// returns true if successful and node_idx is updated
+bool AP_OAAStar::find_node_from_id(const AP_OAVisGraph::OAItemID &id, node_index &node_idx) const
+{
+    switch (id.id_type) {
+    case AP_OAVisGraph::OATYPE_SOURCE:
+        node_idx = SOURCE_IDX;
+        return true;
+    case AP_OAVisGraph::OATYPE_DESTINATION:
+        node_idx = DESTINATION_IDX;
+        return true;
+    case AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT:
+        // intermediate nodes start from 3rd node
+        if (id.id_num + 2 < _num_nodes) {
+            node_idx = id.id_num + 2;
+            return true;
+        }
+        break;
+    }
+
+    // could not find node
+    return false;
+}
+
+// returns the id of a node
+AP_OAVisGraph::OAItemID AP_OAAStar::node_id(node_index idx)
+{
+    switch (idx) {
+    case SOURCE_IDX:
+        return {AP_OAVisGraph::OATYPE_SOURCE, 0};
+    case DESTINATION_IDX:
+        return {AP_OAVisGraph::OATYPE_DESTINATION, 0};
+    default:
+        return {AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, (AP_OAVisGraph::oaid_num)(idx - 2)};
+    }
+}
+
+// add a node to the open set, returns false if out of memory
+bool AP_OAAStar::open_set_push(node_index idx)
+{
+    if ((_open_set_numitems == UINT16_MAX) || !_open_set.expand_to_hold(_open_set_numitems + 1)) {
+        return false;
+    }
+    const OpenSetItem new_item {_nodes[idx].distance_cm + _nodes[idx].heuristic_cm, idx};
+
+    // sift the new item up from the bottom of the heap
+    uint16_t i = _open_set_numitems++;
+    while (i > 0) {
+        const uint16_t parent = (i - 1) / 2;
+        if (_open_set[parent].cost_cm <= new_item.cost_cm) {
+            break;
+        }
+        _open_set[i] = _open_set[parent];
+        i = parent;
+    }
+    _open_set[i] = new_item;
+    return true;
+}
+
+// remove the lowest cost node from the open set, returns false if empty
+bool AP_OAAStar::open_set_pop(node_index &idx)
+{
+    if (_open_set_numitems == 0) {
+        return false;
+    }
+    idx = _open_set[0].idx;
+
+    // sift the last item down from the top of the heap
+    const OpenSetItem last_item = _open_set[--_open_set_numitems];
+    uint16_t i = 0;
+    while (true) {
+        uint16_t child = 2 * i + 1;
+        if (child >= _open_set_numitems) {
+            break;
+        }
+        if ((child + 1 < _open_set_numitems) && (_open_set[child + 1].cost_cm < _open_set[child].cost_cm)) {
+            child++;
+        }
+        if (last_item.cost_cm <= _open_set[child].cost_cm) {
+            break;
+        }
+        _open_set[i] = _open_set[child];
+        i = child;
+    }
+    if (_open_set_numitems > 0) {
+        _open_set[i] = last_item;
+    }
+    return true;
+}
+
+#endif  // AP_OAPATHPLANNER_DIJKSTRA_ENABLED
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "AC_Avoidance_config.h"
+
+#if AP_OAPATHPLANNER_DIJKSTRA_ENABLED
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Common/AP_ExpandingArray.h>
+#include "AP_OAVisGraph.h"
+
+/*
+ * A* search over the visibility graphs used by Dijkstra's path planner
+ *
+ * Nodes are the source (node 0), the destination (node 1) and the
+ * intermediate points (node 2 onwards).  The open set is a binary heap
+ * ordered by distance from the source plus the straight line distance
+ * to the destination.  Edges between intermediate points are found
+ * through adjacency lists built once per visibility graph.
+ */
+class AP_OAAStar {
+public:
+    AP_OAAStar();
+
+    CLASS_NO_COPY(AP_OAAStar);  /* Do not allow copies */
+
+    typedef uint8_t node_index;
+
+    static const node_index SOURCE_IDX = 0;
+    static const node_index DESTINATION_IDX = 1;
+    static const node_index NOTSET_IDX = 255;   // no node, so at most 252 intermediate points
+
+    enum class Result : uint8_t {
+        SUCCESS = 0,
+        OUT_OF_MEMORY,
+        NO_PATH
+    };
+
+    // set the visibility graph between the num_points intermediate
+    // points.  visgraph must not change until this is called again
+    // returns false if out of memory or there are too many points
+    bool set_intermediate_graph(const AP_OAVisGraph &visgraph, uint8_t num_points) WARN_IF_UNUSED;
+
+    // set the straight line distance from an intermediate point to
+    // the destination.  Must be set for every point before each search
+    void set_heuristic(uint8_t point_num, float distance_cm);
+
+    // search for the shortest path from the source to the destination
+    // source_visgraph holds the points visible from the source (which may include the destination)
+    // destination_visgraph holds the points visible from the destination
+    Result search(const AP_OAVisGraph &source_visgraph, const AP_OAVisGraph &destination_visgraph) WARN_IF_UNUSED;
+
+    // returns the node before idx on the shortest path, or NOTSET_IDX
+    // requires search to have succeeded
+    node_index prev_node(node_index idx) const;
+
+    // find a node's index from its id
+    // returns true if successful and node_idx is updated
+    bool find_node_from_id(const AP_OAVisGraph::OAItemID &id, node_index &node_idx) const;
+
+    // returns the id of a node
+    static AP_OAVisGraph::OAItemID node_id(node_index idx);
+
+private:
+
+    struct Node {
+        float distance_cm;          // distance from source (tentative until visited)
+        float heuristic_cm;         // straight line distance to destination
+        float dest_distance_cm;     // distance to destination if visible, FLT_MAX if not
+        node_index prev_idx;        // node from where distance was updated (or NOTSET_IDX if not set)
+        bool visited;               // true if all this node's neighbour's distances have been updated
+    };
+    AP_ExpandingArray<Node> _nodes;
+    uint16_t _num_nodes;
+
+    // adjacency lists. The visgraph items touching intermediate point
+    // i are _adj[_adj_start[i]] to _adj[_adj_start[i+1]-1]
+    const AP_OAVisGraph *_visgraph;
+    AP_ExpandingArray<uint16_t> _adj_start;
+    AP_ExpandingArray<uint16_t> _adj;
+
+    // update distance to a node via another node, adding it to the open set if shorter
+    // returns false if out of memory
+    bool relax(node_index from_idx, node_index to_idx, float distance_cm) WARN_IF_UNUSED;
+
+    // open set held as a binary heap with lowest cost first.  Nodes
+    // may appear more than once, stale entries are skipped when popped
+    struct OpenSetItem {
+        float cost_cm;              // distance from source plus heuristic
+        node_index idx;
+    };
+    AP_ExpandingArray<OpenSetItem> _open_set;
+    uint16_t _open_set_numitems;
+
+    // add a node to the open set, returns false if out of memory
+    bool open_set_push(node_index idx) WARN_IF_UNUSED;
+
+    // remove the lowest cost node from the open set, returns false if empty
+    bool open_set_pop(node_index &idx);
+};
+
+#endif  // AP_OAPATHPLANNER_DIJKSTRA_ENABLED
@@ -30,7 +30,6 @@ const float OA_BENDYRULER_RATIO_DEFAULT = 1.5f;
 const int16_t OA_BENDYRULER_ANGLE_DEFAULT = 75;
 const int16_t OA_BENDYRULER_TYPE_DEFAULT = 1;
 
-const int16_t OA_BENDYRULER_BEARING_INC_XY = 5;            // check every 5 degrees around vehicle
 const int16_t OA_BENDYRULER_BEARING_INC_VERTICAL = 90;
 const float OA_BENDYRULER_LOOKAHEAD_STEP2_RATIO = 1.0f; // step2's lookahead length as a ratio of step1's lookahead length
 const float OA_BENDYRULER_LOOKAHEAD_STEP2_MIN = 2.0f;   // step2 checks at least this many meters past step1's location
@@ -140,10 +139,10 @@ bool AP_OABendyRuler::update(const Location& current_loc, const Location& destin
 // Search for path in the horizontal directions
 bool AP_OABendyRuler::search_xy_path(const Location& current_loc, const Location& destination, float ground_course_deg, Location &destination_new, float lookahead_step1_dist, float lookahead_step2_dist, float bearing_to_dest, float distance_to_dest, bool proximity_only) 
 {
-    // check OA_BEARING_INC definition allows checking in all directions
-    static_assert(360 % OA_BENDYRULER_BEARING_INC_XY == 0, "check 360 is a multiple of OA_BEARING_INC");
+    // check AP_OABENDYRULER_BEARING_INC_XY definition allows checking in all directions
+    static_assert(360 % AP_OABENDYRULER_BEARING_INC_XY == 0, "check 360 is a multiple of AP_OABENDYRULER_BEARING_INC_XY");
 
-    // search in OA_BENDYRULER_BEARING_INC degree increments around the vehicle alternating left
+    // search in AP_OABENDYRULER_BEARING_INC_XY degree increments around the vehicle alternating left
     // and right. For each direction check if vehicle would avoid all obstacles
     float best_bearing = bearing_to_dest;
     float best_bearing_margin = -FLT_MAX;
@@ -151,70 +150,89 @@ bool AP_OABendyRuler::search_xy_path(const Location& current_loc, const Location
     float best_margin = -FLT_MAX;
     float best_margin_bearing = best_bearing;
 
-    for (uint8_t i = 0; i <= (170 / OA_BENDYRULER_BEARING_INC_XY); i++) {
+    // list the bearings in the order they are checked
+    uint8_t num_bearings = 0;
+    for (uint8_t i = 0; i <= (170 / AP_OABENDYRULER_BEARING_INC_XY); i++) {
         for (uint8_t bdir = 0; bdir <= 1; bdir++) {
             // skip duplicate check of bearing straight towards destination
             if ((i==0) && (bdir > 0)) {
                 continue;
             }
             // bearing that we are probing
-            const float bearing_delta = i * OA_BENDYRULER_BEARING_INC_XY * (bdir == 0 ? -1.0f : 1.0f);
+            const float bearing_delta = i * AP_OABENDYRULER_BEARING_INC_XY * (bdir == 0 ? -1.0f : 1.0f);
             const float bearing_test = wrap_180(bearing_to_dest + bearing_delta);
 
             // ToDo: add effective groundspeed calculations using airspeed
             // ToDo: add prediction of vehicle's position change as part of turn to desired heading
 
-            // test location is projected from current location at test bearing
+            // test location is projected from current location at test bearing, offsets are in cm
+            _xy_bearings[num_bearings] = bearing_test;
+            _xy_offsets_NE[num_bearings] = Vector2f{cosf(radians(bearing_test)), sinf(radians(bearing_test))} * (lookahead_step1_dist * 100.0f);
+            _xy_margins[num_bearings] = FLT_MAX;
+            num_bearings++;
+        }
+    }
+
+    // the bearing straight towards the destination is usually clear so it is checked on its own.
+    // The remaining bearings are checked a chunk at a time as they are needed, so the search
+    // still stops soon after the first acceptable bearing
+    uint8_t num_scored = 0;
+    for (uint8_t i = 0; i < num_bearings; i++) {
+        if (i == num_scored) {
+            const uint8_t n = (i == 0) ? 1 : MIN(AP_OABENDYRULER_MARGIN_CHUNK_XY, num_bearings - i);
+            calc_avoidance_margins(current_loc, &_xy_offsets_NE[i], n, &_xy_margins[i], proximity_only);
+            num_scored += n;
+        }
+        const float bearing_test = _xy_bearings[i];
+
+        // margin from obstacles for this scenario
+        const float margin = _xy_margins[i];
+        if (margin > best_margin) {
+            best_margin_bearing = bearing_test;
+            best_margin = margin;
+        }
+        if (margin > _margin_max) {
+            // this bearing avoids obstacles out to the lookahead_step1_dist
+            // now check in there is a clear path in three directions towards the destination
             Location test_loc = current_loc;
             test_loc.offset_bearing(bearing_test, lookahead_step1_dist);
-
-            // calculate margin from obstacles for this scenario
-            float margin = calc_avoidance_margin(current_loc, test_loc, proximity_only);
-            if (margin > best_margin) {
-                best_margin_bearing = bearing_test;
-                best_margin = margin;
+            if (!have_best_bearing) {
+                best_bearing = bearing_test;
+                best_bearing_margin = margin;
+                have_best_bearing = true;
+            } else if (fabsf(wrap_180(ground_course_deg - bearing_test)) <
+                       fabsf(wrap_180(ground_course_deg - best_bearing))) {
+                // replace bearing with one that is closer to our current ground course
+                best_bearing = bearing_test;
+                best_bearing_margin = margin;
             }
-            if (margin > _margin_max) {
-                // this bearing avoids obstacles out to the lookahead_step1_dist
-                // now check in there is a clear path in three directions towards the destination
-                if (!have_best_bearing) {
-                    best_bearing = bearing_test;
-                    best_bearing_margin = margin;
-                    have_best_bearing = true;
-                } else if (fabsf(wrap_180(ground_course_deg - bearing_test)) <
-                           fabsf(wrap_180(ground_course_deg - best_bearing))) {
-                    // replace bearing with one that is closer to our current ground course
-                    best_bearing = bearing_test;
-                    best_bearing_margin = margin;
-                }
 
-                // perform second stage test in three directions looking for obstacles
-                const float test_bearings[] { 0.0f, 45.0f, -45.0f };
-                const float bearing_to_dest2 = test_loc.get_bearing_to(destination) * 0.01f;
-                float distance2 = constrain_float(lookahead_step2_dist, OA_BENDYRULER_LOOKAHEAD_STEP2_MIN, test_loc.get_distance(destination));
-                for (uint8_t j = 0; j < ARRAY_SIZE(test_bearings); j++) {
-                    float bearing_test2 = wrap_180(bearing_to_dest2 + test_bearings[j]);
-                    Location test_loc2 = test_loc;
-                    test_loc2.offset_bearing(bearing_test2, distance2);
-
-                    // calculate minimum margin to fence and obstacles for this scenario
-                    float margin2 = calc_avoidance_margin(test_loc, test_loc2, proximity_only);
-                    if (margin2 > _margin_max) {
-                        // if the chosen direction is directly towards the destination avoidance can be turned off
-                        // i == 0 && j == 0 implies no deviation from bearing to destination 
-                        const bool active = (i != 0 || j != 0);
-                        float final_bearing = bearing_test;
-                        float final_margin = margin;
-                        // check if we need ignore test_bearing and continue on previous bearing
-                        const bool ignore_bearing_change = resist_bearing_change(destination, current_loc, active, bearing_test, lookahead_step1_dist, margin, _destination_prev,_bearing_prev, final_bearing, final_margin, proximity_only);
-
-                        // all good, now project in the chosen direction by the full distance
-                        destination_new = current_loc;
-                        destination_new.offset_bearing(final_bearing, MIN(distance_to_dest, lookahead_step1_dist));
-                        _current_lookahead = MIN(_lookahead, _current_lookahead * 1.1f);
-                        Write_OABendyRuler((uint8_t)OABendyType::OA_BENDY_HORIZONTAL, active, bearing_to_dest, 0.0f, ignore_bearing_change, final_margin, destination, destination_new);
-                        return active;
-                    }
+            // perform second stage test in three directions looking for obstacles
+            const float test_bearings[] { 0.0f, 45.0f, -45.0f };
+            const float bearing_to_dest2 = test_loc.get_bearing_to(destination) * 0.01f;
+            float distance2 = constrain_float(lookahead_step2_dist, OA_BENDYRULER_LOOKAHEAD_STEP2_MIN, test_loc.get_distance(destination));
+            for (uint8_t j = 0; j < ARRAY_SIZE(test_bearings); j++) {
+                float bearing_test2 = wrap_180(bearing_to_dest2 + test_bearings[j]);
+                Location test_loc2 = test_loc;
+                test_loc2.offset_bearing(bearing_test2, distance2);
+
+                // calculate minimum margin to fence and obstacles for this scenario
+                float margin2 = calc_avoidance_margin(test_loc, test_loc2, proximity_only);
+                if (margin2 > _margin_max) {
+                    // if the chosen direction is directly towards the destination avoidance can be turned off
+                    // i == 0 && j == 0 implies no deviation from bearing to destination 
+                    const bool active = (i != 0 || j != 0);
+                    float final_bearing = bearing_test;
+                    float final_margin = margin;
+                    // check if we need ignore test_bearing and continue on previous bearing
+                    const bool ignore_bearing_change = resist_bearing_change(destination, current_loc, active, bearing_test, lookahead_step1_dist, margin, _destination_prev,_bearing_prev, final_bearing, final_margin, proximity_only);
+
+                    // all good, now project in the chosen direction by the full distance
+                    destination_new = current_loc;
+                    destination_new.offset_bearing(final_bearing, MIN(distance_to_dest, lookahead_step1_dist));
+                    _current_lookahead = MIN(_lookahead, _current_lookahead * 1.1f);
+                    Write_OABendyRuler((uint8_t)OABendyType::OA_BENDY_HORIZONTAL, active, bearing_to_dest, 0.0f, ignore_bearing_change, final_margin, destination, destination_new);
+                    return active;
                 }
             }
         }
@@ -457,9 +475,65 @@ float AP_OABendyRuler::calc_avoidance_margin(const Location &start, const Locati
     return margin_min;
 }
 
+// calculate minimum distance between any obstacle and each of the horizontal paths from start to start plus offsets_NE (in cm)
+// margins (in meters) must be initialised by the caller and are lowered to the margin from the closest obstacle
+void AP_OABendyRuler::calc_avoidance_margins(const Location &start, const Vector2f *offsets_NE, uint8_t count, float *margins, bool proximity_only)
+{
+    // convert start to offset (in cm) from EKF origin
+    Vector3f start_NEU;
+    if (!start.get_vector_from_origin_NEU(start_NEU)) {
+        // check each path separately
+        for (uint8_t i = 0; i < count; i++) {
+            Location end = start;
+            end.offset(offsets_NE[i].x * 0.01f, offsets_NE[i].y * 0.01f);
+            margins[i] = MIN(margins[i], calc_avoidance_margin(start, end, proximity_only));
+        }
+        return;
+    }
+
+    // ends of all paths as offsets from EKF origin, in cm for the fences and in meters for the database
+    const Vector2f start_NE = start_NEU.xy();
+    for (uint8_t i = 0; i < count; i++) {
+        _batch_ends_NE[i] = start_NE + offsets_NE[i];
+        _batch_ends_NEU[i] = Vector3f{_batch_ends_NE[i], start_NEU.z} * 0.01f;
+    }
+
+    const AP_OADatabase *oaDb = AP::oadatabase();
+    if (oaDb != nullptr) {
+        UNUSED_RESULT(oaDb->calc_margins(start_NEU * 0.01f, _batch_ends_NEU, count, margins));
+    }
+
+    if (proximity_only) {
+        // only need margin from proximity data
+        return;
+    }
+
+    // alt fence is not needed as paths are horizontal
+    UNUSED_RESULT(calc_margin_from_circular_fence(start_NE, _batch_ends_NE, count, margins));
+    UNUSED_RESULT(calc_margin_from_inclusion_and_exclusion_polygons(start_NE, _batch_ends_NE, count, margins));
+    UNUSED_RESULT(calc_margin_from_inclusion_and_exclusion_circles(start_NE, _batch_ends_NE, count, margins));
+}
+
 // calculate minimum distance between a path and the circular fence (centered on home)
 // on success returns true and updates margin
 bool AP_OABendyRuler::calc_margin_from_circular_fence(const Location &start, const Location &end, float &margin) const
+{
+    // convert start and end to offsets from EKF origin
+    Vector2f start_NE, end_NE;
+    if (!start.get_vector_xy_from_origin_NE(start_NE) || !end.get_vector_xy_from_origin_NE(end_NE)) {
+        return false;
+    }
+    float margin_new = FLT_MAX;
+    if (!calc_margin_from_circular_fence(start_NE, &end_NE, 1, &margin_new)) {
+        return false;
+    }
+    margin = margin_new;
+    return true;
+}
+
+// batched version for paths from start_NE to each of ends_NE, all offsets in cm from the EKF origin
+// margins are lowered to the margin from the circular fence (centered on home), returns true if any were updated
+bool AP_OABendyRuler::calc_margin_from_circular_fence(const Vector2f &start_NE, const Vector2f *ends_NE, uint8_t count, float *margins) const
 {
 #if AP_FENCE_ENABLED
     // exit immediately if polygon fence is not enabled
@@ -471,16 +545,22 @@ bool AP_OABendyRuler::calc_margin_from_circular_fence(const Location &start, con
         return false;
     }
 
-    // calculate start and end point's distance from home
-    const Location &ahrs_home = AP::ahrs().get_home();
-    const float start_dist_sq = ahrs_home.get_distance_NE(start).length_squared();
-    const float end_dist_sq = ahrs_home.get_distance_NE(end).length_squared();
+    // calculate start point's distance from home
+    Vector2f home_NE;
+    if (!AP::ahrs().get_home().get_vector_xy_from_origin_NE(home_NE)) {
+        return false;
+    }
+    const float start_dist_sq = (start_NE - home_NE).length_squared();
 
     // get circular fence radius + margin
     const float fence_radius_plus_margin = fence->get_radius() - fence->get_margin();
 
-    // margin is fence radius minus the longer of start or end distance
-    margin = fence_radius_plus_margin - sqrtf(MAX(start_dist_sq, end_dist_sq));
+    for (uint8_t i = 0; i < count; i++) {
+        // margin is fence radius minus the longer of start or end distance
+        const float end_dist_sq = (ends_NE[i] - home_NE).length_squared();
+        const float margin_new = fence_radius_plus_margin - sqrtf(MAX(start_dist_sq, end_dist_sq)) * 0.01f;
+        margins[i] = MIN(margins[i], margin_new);
+    }
     return true;
 #else
     return false;
@@ -526,6 +606,23 @@ bool AP_OABendyRuler::calc_margin_from_alt_fence(const Location &start, const Lo
 // calculate minimum distance between a path and all inclusion and exclusion polygons
 // on success returns true and updates margin
 bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_polygons(const Location &start, const Location &end, float &margin) const
+{
+    // convert start and end to offsets from EKF origin
+    Vector2f start_NE, end_NE;
+    if (!start.get_vector_xy_from_origin_NE(start_NE) || !end.get_vector_xy_from_origin_NE(end_NE)) {
+        return false;
+    }
+    float margin_new = FLT_MAX;
+    if (!calc_margin_from_inclusion_and_exclusion_polygons(start_NE, &end_NE, 1, &margin_new)) {
+        return false;
+    }
+    margin = margin_new;
+    return true;
+}
+
+// batched version for paths from start_NE to each of ends_NE, all offsets in cm from the EKF origin
+// margins are lowered to the margin from all inclusion and exclusion polygons, returns true if any were updated
+bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_polygons(const Vector2f &start_NE, const Vector2f *ends_NE, uint8_t count, float *margins) const
 {
 #if AP_FENCE_ENABLED
     const AC_Fence *fence = AC_Fence::get_singleton();
@@ -545,46 +642,44 @@ bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_polygons(const Lo
         return false;
     }
 
-    // convert start and end to offsets from EKF origin
-    Vector2f start_NE, end_NE;
-    if (!start.get_vector_xy_from_origin_NE(start_NE) || !end.get_vector_xy_from_origin_NE(end_NE)) {
-        return false;
-    }
-
     // get fence margin
     const float fence_margin = fence->get_margin();
 
     // iterate through inclusion polygons and calculate minimum margin
     bool margin_updated = false;
     for (uint8_t i = 0; i < num_inclusion_polygons; i++) {
-        uint16_t num_points;
-        const Vector2f* boundary = fence->polyfence().get_inclusion_polygon(i, num_points);
+        const AP_PolygonIndex<float>* boundary = fence->polyfence().get_inclusion_polygon_index(i);
+        if (boundary == nullptr) {
+            continue;
+        }
      
         // if outside the fence margin is the closest distance but with negative sign
-        const float sign = Polygon_outside(start_NE, boundary, num_points) ? -1.0f : 1.0f;
+        const float sign = boundary->outside(start_NE) ? -1.0f : 1.0f;
 
-        // calculate min distance (in meters) from line to polygon
-        float margin_new = (sign * Polygon_closest_distance_line(boundary, num_points, start_NE, end_NE) * 0.01f) - fence_margin;
-        if (!margin_updated || (margin_new < margin)) {
-            margin_updated = true;
-            margin = margin_new;
+        // calculate min distance (in meters) from each line to polygon
+        for (uint8_t j = 0; j < count; j++) {
+            const float margin_new = (sign * boundary->closest_distance_line(start_NE, ends_NE[j]) * 0.01f) - fence_margin;
+            margins[j] = MIN(margins[j], margin_new);
         }
+        margin_updated = true;
     }
 
     // iterate through exclusion polygons and calculate minimum margin
     for (uint8_t i = 0; i < num_exclusion_polygons; i++) {
-        uint16_t num_points;
-        const Vector2f* boundary = fence->polyfence().get_exclusion_polygon(i, num_points);
+        const AP_PolygonIndex<float>* boundary = fence->polyfence().get_exclusion_polygon_index(i);
+        if (boundary == nullptr) {
+            continue;
+        }
    
         // if start is inside the polygon the margin's sign is reversed
-        const float sign = Polygon_outside(start_NE, boundary, num_points) ? 1.0f : -1.0f;
+        const float sign = boundary->outside(start_NE) ? 1.0f : -1.0f;
 
-        // calculate min distance (in meters) from line to polygon
-        float margin_new = (sign * Polygon_closest_distance_line(boundary, num_points, start_NE, end_NE) * 0.01f) - fence_margin;
-        if (!margin_updated || (margin_new < margin)) {
-            margin_updated = true;
-            margin = margin_new;
+        // calculate min distance (in meters) from each line to polygon
+        for (uint8_t j = 0; j < count; j++) {
+            const float margin_new = (sign * boundary->closest_distance_line(start_NE, ends_NE[j]) * 0.01f) - fence_margin;
+            margins[j] = MIN(margins[j], margin_new);
         }
+        margin_updated = true;
     }
 
     return margin_updated;
@@ -596,6 +691,23 @@ bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_polygons(const Lo
 // calculate minimum distance between a path and all inclusion and exclusion circles
 // on success returns true and updates margin
 bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_circles(const Location &start, const Location &end, float &margin) const
+{
+    // convert start and end to offsets from EKF origin
+    Vector2f start_NE, end_NE;
+    if (!start.get_vector_xy_from_origin_NE(start_NE) || !end.get_vector_xy_from_origin_NE(end_NE)) {
+        return false;
+    }
+    float margin_new = FLT_MAX;
+    if (!calc_margin_from_inclusion_and_exclusion_circles(start_NE, &end_NE, 1, &margin_new)) {
+        return false;
+    }
+    margin = margin_new;
+    return true;
+}
+
+// batched version for paths from start_NE to each of ends_NE, all offsets in cm from the EKF origin
+// margins are lowered to the margin from all inclusion and exclusion circles, returns true if any were updated
+bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_circles(const Vector2f &start_NE, const Vector2f *ends_NE, uint8_t count, float *margins) const
 {
 #if AP_FENCE_ENABLED
     // exit immediately if fence is not enabled
@@ -616,12 +728,6 @@ bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_circles(const Loc
         return false;
     }
 
-    // convert start and end to offsets from EKF origin
-    Vector2f start_NE, end_NE;
-    if (!start.get_vector_xy_from_origin_NE(start_NE) || !end.get_vector_xy_from_origin_NE(end_NE)) {
-        return false;
-    }
-
     // get fence margin
     const float fence_margin = fence->get_margin();
 
@@ -634,16 +740,14 @@ bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_circles(const Loc
 
             // calculate start and ends distance from the center of the circle
             const float start_dist_sq = (start_NE - center_pos_cm).length_squared();
-            const float end_dist_sq = (end_NE - center_pos_cm).length_squared();
-
-            // margin is fence radius minus the longer of start or end distance
-            const float margin_new = (radius + fence_margin) - (sqrtf(MAX(start_dist_sq, end_dist_sq)) * 0.01f);
+            for (uint8_t j = 0; j < count; j++) {
+                const float end_dist_sq = (ends_NE[j] - center_pos_cm).length_squared();
 
-            // update margin with lowest value so far
-            if (!margin_updated || (margin_new < margin)) {
-                margin_updated = true;
-                margin = margin_new;
+                // margin is fence radius minus the longer of start or end distance
+                const float margin_new = (radius + fence_margin) - (sqrtf(MAX(start_dist_sq, end_dist_sq)) * 0.01f);
+                margins[j] = MIN(margins[j], margin_new);
             }
+            margin_updated = true;
         }
     }
 
@@ -652,18 +756,15 @@ bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_circles(const Loc
         Vector2f center_pos_cm;
         float radius;
         if (fence->polyfence().get_exclusion_circle(i, center_pos_cm, radius)) {
+            for (uint8_t j = 0; j < count; j++) {
+                // first calculate distance between circle's center and segment
+                const float dist_cm = Vector2f::closest_distance_between_line_and_point(start_NE, ends_NE[j], center_pos_cm);
 
-            // first calculate distance between circle's center and segment
-            const float dist_cm = Vector2f::closest_distance_between_line_and_point(start_NE, end_NE, center_pos_cm);
-
-            // margin is distance to the center minus the radius
-            const float margin_new = (dist_cm * 0.01f) - (radius + fence_margin);
-
-            // update margin with lowest value so far
-            if (!margin_updated || (margin_new < margin)) {
-                margin_updated = true;
-                margin = margin_new;
+                // margin is distance to the center minus the radius
+                const float margin_new = (dist_cm * 0.01f) - (radius + fence_margin);
+                margins[j] = MIN(margins[j], margin_new);
             }
+            margin_updated = true;
         }
     }
 
@@ -692,25 +793,9 @@ bool AP_OABendyRuler::calc_margin_from_object_database(const Location &start, co
         return false;
     }
 
-    // check each obstacle's distance from segment
-    float smallest_margin = FLT_MAX;
-    for (uint16_t i=0; i<oaDb->database_count(); i++) {
-        const AP_OADatabase::OA_DbItem& item = oaDb->get_item(i);
-        const Vector3f point_cm = item.pos * 100.0f;
-        // margin is distance between line segment and obstacle minus obstacle's radius
-        const float m = Vector3f::closest_distance_between_line_and_point(start_NEU, end_NEU, point_cm) * 0.01f - item.radius;
-        if (m < smallest_margin) {
-            smallest_margin = m;
-        }
-    }
-
-    // return smallest margin
-    if (smallest_margin < FLT_MAX) {
-        margin = smallest_margin;
-        return true;
-    }
-
-    return false;
+    // find smallest distance from segment to the obstacles' edges
+    // database positions are in meters
+    return oaDb->calc_margin(start_NEU * 0.01f, end_NEU * 0.01f, margin);
 }
 
 #endif  // AP_OAPATHPLANNER_BENDYRULER_ENABLED
@@ -9,6 +9,18 @@
 #include <AP_Math/AP_Math.h>
 #include <AP_Logger/AP_Logger_config.h>
 
+// horizontal search checks bearings this many degrees apart around the vehicle
+// 360 must be a multiple of this
+#ifndef AP_OABENDYRULER_BEARING_INC_XY
+#define AP_OABENDYRULER_BEARING_INC_XY 5
+#endif
+
+// horizontal search scores the margins of this many bearings at a time
+// once the bearing straight towards the destination is blocked
+#ifndef AP_OABENDYRULER_MARGIN_CHUNK_XY
+#define AP_OABENDYRULER_MARGIN_CHUNK_XY 8
+#endif
+
 /*
  * BendyRuler avoidance algorithm for avoiding the polygon and circular fence and dynamic objects detected by the proximity sensor
  */
@@ -48,12 +60,20 @@ private:
     // calculate minimum distance between a path and any obstacle
     float calc_avoidance_margin(const Location &start, const Location &end, bool proximity_only) const;
 
+    // calculate minimum distance between any obstacle and each of the horizontal paths from start to start plus offsets_NE (in cm)
+    // margins (in meters) must be initialised by the caller and are lowered to the margin from the closest obstacle
+    // fence and obstacle preprocessing is shared between all paths so this is faster than checking each path separately
+    void calc_avoidance_margins(const Location &start, const Vector2f *offsets_NE, uint8_t count, float *margins, bool proximity_only);
+
     // determine if BendyRuler should accept the new bearing or try and resist it. Returns true if bearing is not changed  
     bool resist_bearing_change(const Location &destination, const Location &current_loc, bool active, float bearing_test, float lookahead_step1_dist, float margin, Location &prev_dest, float &prev_bearing, float &final_bearing, float &final_margin, bool proximity_only) const;    
 
     // calculate minimum distance between a path and the circular fence (centered on home)
     // on success returns true and updates margin
     bool calc_margin_from_circular_fence(const Location &start, const Location &end, float &margin) const;
+    // batched version for paths from start_NE to each of ends_NE, all offsets in cm from the EKF origin
+    // margins are lowered to the margin from the circular fence (centered on home), returns true if any were updated
+    bool calc_margin_from_circular_fence(const Vector2f &start_NE, const Vector2f *ends_NE, uint8_t count, float *margins) const;
 
     // calculate minimum distance between a path and the altitude fence
     // on success returns true and updates margin
@@ -62,10 +82,16 @@ private:
     // calculate minimum distance between a path and all inclusion and exclusion polygons
     // on success returns true and updates margin
     bool calc_margin_from_inclusion_and_exclusion_polygons(const Location &start, const Location &end, float &margin) const;
+    // batched version for paths from start_NE to each of ends_NE, all offsets in cm from the EKF origin
+    // margins are lowered to the margin from all inclusion and exclusion polygons, returns true if any were updated
+    bool calc_margin_from_inclusion_and_exclusion_polygons(const Vector2f &start_NE, const Vector2f *ends_NE, uint8_t count, float *margins) const;
 
     // calculate minimum distance between a path and all inclusion and exclusion circles
     // on success returns true and updates margin
     bool calc_margin_from_inclusion_and_exclusion_circles(const Location &start, const Location &end, float &margin) const;
+    // batched version for paths from start_NE to each of ends_NE, all offsets in cm from the EKF origin
+    // margins are lowered to the margin from all inclusion and exclusion circles, returns true if any were updated
+    bool calc_margin_from_inclusion_and_exclusion_circles(const Vector2f &start_NE, const Vector2f *ends_NE, uint8_t count, float *margins) const;
 
     // calculate minimum distance between a path and proximity sensor obstacles
     // on success returns true and updates margin
@@ -91,6 +117,14 @@ private:
     float _current_lookahead;       // distance (in meters) ahead of the vehicle we are looking for obstacles
     float _bearing_prev;            // stored bearing in degrees 
     Location _destination_prev;     // previous destination, to check if there has been a change in destination
+
+    // bearings checked by the horizontal search and their step1 margins, kept here rather than on the avoidance thread's stack
+    static const uint8_t OA_BENDYRULER_NUM_BEARINGS_XY = 2 * (170 / AP_OABENDYRULER_BEARING_INC_XY) + 1;
+    float _xy_bearings[OA_BENDYRULER_NUM_BEARINGS_XY];
+    Vector2f _xy_offsets_NE[OA_BENDYRULER_NUM_BEARINGS_XY];
+    float _xy_margins[OA_BENDYRULER_NUM_BEARINGS_XY];
+    Vector2f _batch_ends_NE[OA_BENDYRULER_NUM_BEARINGS_XY];
+    Vector3f _batch_ends_NEU[OA_BENDYRULER_NUM_BEARINGS_XY];
 };
 
 #endif  // AP_OAPATHPLANNER_BENDYRULER_ENABLED
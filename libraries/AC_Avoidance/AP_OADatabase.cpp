@@ -40,11 +40,15 @@ extern const AP_HAL::HAL& hal;
     #define AP_OADATABASE_DISTANCE_FROM_HOME 3
 #endif
 
+#ifndef AP_OADATABASE_HASH_CELL_SIZE
+    #define AP_OADATABASE_HASH_CELL_SIZE        2.0f    // size in meters of spatial hash grid cells
+#endif
+
 const AP_Param::GroupInfo AP_OADatabase::var_info[] = {
 
     // @Param: SIZE
     // @DisplayName: OADatabase maximum number of points
-    // @Description: OADatabase maximum number of points. Set to 0 to disable the OA Database. Larger means more points but is more cpu intensive to process
+    // @Description: OADatabase maximum number of points. Set to 0 to disable the OA Database. Larger means more points but uses more memory. Points are indexed by position so cpu use grows slowly with the number of points
     // @Range: 0 10000
     // @User: Advanced
     // @RebootRequired: True
@@ -206,6 +210,112 @@ void AP_OADatabase::init_database()
     }
 
     _database.items = NEW_NOTHROW OA_DbItem[_database.size];
+
+    hash_init();
+}
+
+// allocate spatial hash.  On failure the database is still usable but
+// searches check every item
+void AP_OADatabase::hash_init()
+{
+    if (_database.items == nullptr) {
+        return;
+    }
+
+    // aim for about one item per bucket
+    _hash.num_buckets = 16;
+    while (_hash.num_buckets < _database.size && _hash.num_buckets < 4096) {
+        _hash.num_buckets *= 2;
+    }
+    _hash.buckets = NEW_NOTHROW uint16_t[_hash.num_buckets];
+    _hash.links = NEW_NOTHROW HashLink[_database.size];
+    if (_hash.buckets == nullptr || _hash.links == nullptr) {
+        delete[] _hash.buckets;
+        delete[] _hash.links;
+        _hash.buckets = nullptr;
+        _hash.links = nullptr;
+        return;
+    }
+    for (uint16_t i=0; i<_hash.num_buckets; i++) {
+        _hash.buckets[i] = HASH_NONE;
+    }
+}
+
+// get grid cell holding a position
+void AP_OADatabase::hash_cell(const Vector3f &pos, int16_t &cell_n, int16_t &cell_e) const
+{
+    cell_n = constrain_float(floorf(pos.x / AP_OADATABASE_HASH_CELL_SIZE), INT16_MIN, INT16_MAX);
+    cell_e = constrain_float(floorf(pos.y / AP_OADATABASE_HASH_CELL_SIZE), INT16_MIN, INT16_MAX);
+}
+
+// get bucket holding items in a grid cell
+uint16_t AP_OADatabase::hash_bucket(int16_t cell_n, int16_t cell_e) const
+{
+    const uint32_t h = (uint32_t(uint16_t(cell_n)) * 73856093U) ^ (uint32_t(uint16_t(cell_e)) * 19349663U);
+    return (h ^ (h >> 16)) & (_hash.num_buckets - 1);
+}
+
+// add database item to the spatial hash
+void AP_OADatabase::hash_insert(const uint16_t index)
+{
+    if (_hash.buckets == nullptr) {
+        return;
+    }
+    HashLink &link = _hash.links[index];
+    hash_cell(_database.items[index].pos, link.cell_n, link.cell_e);
+    const uint16_t bucket = hash_bucket(link.cell_n, link.cell_e);
+    link.next = _hash.buckets[bucket];
+    _hash.buckets[bucket] = index;
+    _hash.max_radius = MAX(_hash.max_radius, _database.items[index].radius);
+}
+
+// remove database item from the spatial hash
+void AP_OADatabase::hash_remove(const uint16_t index)
+{
+    if (_hash.buckets == nullptr) {
+        return;
+    }
+    const HashLink &link = _hash.links[index];
+    uint16_t *prev_next = &_hash.buckets[hash_bucket(link.cell_n, link.cell_e)];
+    while (*prev_next != HASH_NONE) {
+        if (*prev_next == index) {
+            *prev_next = link.next;
+            return;
+        }
+        prev_next = &_hash.links[*prev_next].next;
+    }
+}
+
+// call fn for each database item within the grid cells covering the horizontal box from pos_min to pos_max
+// returns false without calling fn if the box covers too many cells, in which case all items should be checked
+template <typename Fn>
+bool AP_OADatabase::hash_foreach(const Vector2f &pos_min, const Vector2f &pos_max, Fn fn) const
+{
+    if (_hash.buckets == nullptr) {
+        return false;
+    }
+    int16_t n_min, e_min, n_max, e_max;
+    hash_cell(Vector3f{pos_min.x, pos_min.y, 0}, n_min, e_min);
+    hash_cell(Vector3f{pos_max.x, pos_max.y, 0}, n_max, e_max);
+
+    // if the box covers more cells than there are buckets, visiting
+    // every cell costs more than checking every item
+    const uint32_t num_cells = uint32_t(n_max - n_min + 1) * uint32_t(e_max - e_min + 1);
+    if (num_cells > _hash.num_buckets) {
+        return false;
+    }
+
+    for (int32_t n = n_min; n <= n_max; n++) {
+        for (int32_t e = e_min; e <= e_max; e++) {
+            // buckets may hold items from other cells, so check each item's cell
+            for (uint16_t i = _hash.buckets[hash_bucket(n, e)]; i < _database.count; i = _hash.links[i].next) {
+                if (_hash.links[i].cell_n == n && _hash.links[i].cell_e == e) {
+                    fn(i);
+                }
+            }
+        }
+    }
+    return true;
 }
 
 // get bitmask of gcs channels item should be sent to based on its importance
@@ -265,17 +375,11 @@ bool AP_OADatabase::process_queue()
 
         item.send_to_gcs = get_send_to_gcs_flags(item.importance);
 
-        // compare item to all items in database. If found a similar item, update the existing, else add it as a new one
-        bool found = false;
-        for (uint16_t i=0; i<_database.count; i++) {
-            if (is_close_to_item_in_database(i, item)) {
-                database_item_refresh(i, item.timestamp_ms, item.radius);
-                found = true;
-                break;
-            }
-        }
-
-        if (!found) {
+        // compare item to items in database. If found a similar item, update the existing, else add it as a new one
+        const uint16_t close_index = find_close_item_in_database(item);
+        if (close_index != HASH_NONE) {
+            database_item_refresh(close_index, item.timestamp_ms, item.radius);
+        } else {
             database_item_add(item);
         }
     }
@@ -290,6 +394,7 @@ void AP_OADatabase::database_item_add(const OA_DbItem &item)
     _database.items[_database.count] = item;
     _database.items[_database.count].send_to_gcs = get_send_to_gcs_flags(_database.items[_database.count].importance);
     _database.count++;
+    hash_insert(_database.count - 1);
 }
 
 void AP_OADatabase::database_item_remove(const uint16_t index)
@@ -302,6 +407,7 @@ void AP_OADatabase::database_item_remove(const uint16_t index)
     // radius of 0 tells the GCS we don't care about it any more (aka it expired)
     _database.items[index].radius = 0;
     _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
+    hash_remove(index);
 
     _database.count--;
     if (_database.count == 0) {
@@ -310,8 +416,10 @@ void AP_OADatabase::database_item_remove(const uint16_t index)
 
     if (index != _database.count) {
         // copy last object in array over expired object
+        hash_remove(_database.count);
         _database.items[index] = _database.items[_database.count];
         _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
+        hash_insert(index);
     }
 }
 
@@ -331,6 +439,7 @@ void AP_OADatabase::database_item_refresh(const uint16_t index, const uint32_t t
         // and trigger resending to GCS
         _database.items[index].timestamp_ms = timestamp_ms;
         _database.items[index].radius = radius;
+        _hash.max_radius = MAX(_hash.max_radius, radius);
         _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
     }
 }
@@ -348,13 +457,18 @@ void AP_OADatabase::database_items_remove_all_expired()
     const uint32_t now_ms = AP_HAL::millis();
     const uint32_t expiry_ms = (uint32_t)_database_expiry_seconds * 1000;
     uint16_t index = 0;
+    float max_radius = 0;
     while (index < _database.count) {
         if (now_ms - _database.items[index].timestamp_ms > expiry_ms) {
             database_item_remove(index);
         } else {
+            max_radius = MAX(max_radius, _database.items[index].radius);
             index++;
         }
     }
+
+    // shrink the hash's search radius to the remaining items
+    _hash.max_radius = max_radius;
 }
 
 // returns true if a similar object already exists in database. When true, the object timer is also reset
@@ -369,6 +483,126 @@ bool AP_OADatabase::is_close_to_item_in_database(const uint16_t index, const OA_
     return ((distance_sq < sq(item.radius)) || (distance_sq < sq(_database.items[index].radius)));
 }
 
+// returns the lowest index of the database items close to "item", or HASH_NONE if there are none
+uint16_t AP_OADatabase::find_close_item_in_database(const OA_DbItem &item) const
+{
+    // items can only be close if within the larger of the two radii
+    const float radius = MAX(item.radius, _hash.max_radius);
+    const Vector2f pos_min = item.pos.xy() - Vector2f{radius, radius};
+    const Vector2f pos_max = item.pos.xy() + Vector2f{radius, radius};
+    uint16_t close_index = HASH_NONE;
+    const bool searched = hash_foreach(pos_min, pos_max, [&](uint16_t i) {
+        if (i < close_index && is_close_to_item_in_database(i, item)) {
+            close_index = i;
+        }
+    });
+    if (searched) {
+        return close_index;
+    }
+
+    for (uint16_t i=0; i<_database.count; i++) {
+        if (is_close_to_item_in_database(i, item)) {
+            return i;
+        }
+    }
+    return HASH_NONE;
+}
+
+// calculate minimum distance between a line segment and the edges of the database's objects
+// start and end are offsets in meters from the EKF origin in the same frame as the objects' positions
+// returns true and updates margin (in meters) on success, false if the database is empty
+bool AP_OADatabase::calc_margin(const Vector3f &start, const Vector3f &end, float &margin) const
+{
+    float smallest_margin = FLT_MAX;
+    if (!calc_margins(start, &end, 1, &smallest_margin)) {
+        return false;
+    }
+    margin = smallest_margin;
+    return true;
+}
+
+// batched version of calc_margin for line segments from start to each of ends
+// margins (in meters) are lowered to the margin from the closest object, returns false if the database is empty
+bool AP_OADatabase::calc_margins(const Vector3f &start, const Vector3f *ends, uint8_t count, float *margins) const
+{
+    if (!healthy() || _database.count == 0) {
+        return false;
+    }
+
+    // segments are checked in blocks sharing one search of the hash.
+    // Each item's offset from the shared start is calculated once per
+    // block, and the distance to each segment uses the segments'
+    // precomputed directions in arrays the compiler can vectorise
+    const uint8_t BLOCK_SIZE = 16;
+    for (uint8_t first = 0; first < count; first += BLOCK_SIZE) {
+        const uint8_t num = MIN(count - first, BLOCK_SIZE);
+        float dir_x[BLOCK_SIZE], dir_y[BLOCK_SIZE], dir_z[BLOCK_SIZE], inv_len_sq[BLOCK_SIZE];
+        float smallest_margin[BLOCK_SIZE];
+        Vector2f seg_min = start.xy();
+        Vector2f seg_max = start.xy();
+        for (uint8_t k=0; k<num; k++) {
+            const Vector3f &end = ends[first + k];
+            dir_x[k] = end.x - start.x;
+            dir_y[k] = end.y - start.y;
+            dir_z[k] = end.z - start.z;
+            const float len_sq = sq(dir_x[k], dir_y[k], dir_z[k]);
+            inv_len_sq[k] = is_positive(len_sq) ? 1.0f / len_sq : 0.0f;
+            seg_min.x = MIN(seg_min.x, end.x);
+            seg_min.y = MIN(seg_min.y, end.y);
+            seg_max.x = MAX(seg_max.x, end.x);
+            seg_max.y = MAX(seg_max.y, end.y);
+        }
+
+        // margin is distance between line segment and object minus object's radius
+        auto check_item = [&](uint16_t i) {
+            const OA_DbItem &item = _database.items[i];
+            const Vector3f ofs = item.pos - start;
+            for (uint8_t k=0; k<num; k++) {
+                float t = (ofs.x * dir_x[k] + ofs.y * dir_y[k] + ofs.z * dir_z[k]) * inv_len_sq[k];
+                t = MIN(MAX(t, 0.0f), 1.0f);
+                const float m = sqrtf(sq(ofs.x - t * dir_x[k], ofs.y - t * dir_y[k], ofs.z - t * dir_z[k])) - item.radius;
+                smallest_margin[k] = MIN(smallest_margin[k], m);
+            }
+        };
+
+        // search a growing box around the segments.  Items outside the
+        // box are more than range from every segment, so once every
+        // segment's margin is below range less the largest radius these
+        // are the smallest margins
+        bool found = false;
+        for (float range = AP_OADATABASE_HASH_CELL_SIZE; !found; range *= 4) {
+            for (uint8_t k=0; k<num; k++) {
+                smallest_margin[k] = FLT_MAX;
+            }
+            if (!hash_foreach(seg_min - Vector2f{range, range}, seg_max + Vector2f{range, range}, check_item)) {
+                break;
+            }
+            found = true;
+            for (uint8_t k=0; k<num; k++) {
+                if (smallest_margin[k] > range - _hash.max_radius) {
+                    found = false;
+                    break;
+                }
+            }
+        }
+
+        if (!found) {
+            // box covers too many grid cells so check all items
+            for (uint8_t k=0; k<num; k++) {
+                smallest_margin[k] = FLT_MAX;
+            }
+            for (uint16_t i=0; i<_database.count; i++) {
+                check_item(i);
+            }
+        }
+
+        for (uint8_t k=0; k<num; k++) {
+            margins[first + k] = MIN(margins[first + k], smallest_margin[k]);
+        }
+    }
+    return true;
+}
+
 #if HAL_GCS_ENABLED
 // send ADSB_VEHICLE mavlink messages
 void AP_OADatabase::send_adsb_vehicle(mavlink_channel_t chan, uint16_t interval_ms)
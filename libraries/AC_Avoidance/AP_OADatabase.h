@@ -53,6 +53,15 @@ public:
     // empty queue and try and put into database. Return true if there's more work to do
     bool process_queue();
 
+    // calculate minimum distance between a line segment and the edges of the database's objects
+    // start and end are offsets in meters from the EKF origin in the same frame as the objects' positions
+    // returns true and updates margin (in meters) on success, false if the database is empty
+    bool calc_margin(const Vector3f &start, const Vector3f &end, float &margin) const;
+
+    // batched version of calc_margin for line segments from start to each of ends
+    // margins (in meters) are lowered to the margin from the closest object, returns false if the database is empty
+    bool calc_margins(const Vector3f &start, const Vector3f *ends, uint8_t count, float *margins) const;
+
     // send ADSB_VEHICLE mavlink messages
     void send_adsb_vehicle(mavlink_channel_t chan, uint16_t interval_ms);
 
@@ -77,6 +86,21 @@ private:
     // returns true if database item "index" is close to "item"
     bool is_close_to_item_in_database(const uint16_t index, const OA_DbItem &item) const;
 
+    // returns the lowest index of the database items close to "item", or HASH_NONE if there are none
+    uint16_t find_close_item_in_database(const OA_DbItem &item) const;
+
+    // spatial hash methods
+    void hash_init();
+    void hash_cell(const Vector3f &pos, int16_t &cell_n, int16_t &cell_e) const;
+    uint16_t hash_bucket(int16_t cell_n, int16_t cell_e) const;
+    void hash_insert(const uint16_t index);
+    void hash_remove(const uint16_t index);
+
+    // call fn for each database item within the grid cells covering the horizontal box from pos_min to pos_max
+    // returns false without calling fn if the box covers too many cells, in which case all items should be checked
+    template <typename Fn>
+    bool hash_foreach(const Vector2f &pos_min, const Vector2f &pos_max, Fn fn) const;
+
     // enum for use with _OUTPUT parameter
     enum class OutputLevel {
         NONE = 0,
@@ -108,6 +132,22 @@ private:
         uint16_t        size;                               // cached value of _database_size_param that sticks after initialized
     } _database;
 
+    // spatial hash of the database items' horizontal positions, used
+    // to find nearby items without checking the whole database.  Items
+    // are chained from the bucket of the grid cell holding them
+    static const uint16_t HASH_NONE = UINT16_MAX;
+    struct HashLink {
+        int16_t cell_n;                                     // grid cell holding the item
+        int16_t cell_e;
+        uint16_t next;                                      // index of next item in the same bucket or HASH_NONE
+    };
+    struct {
+        uint16_t        *buckets;                           // index of first item in each bucket or HASH_NONE.  nullptr if the hash could not be allocated
+        uint16_t        num_buckets;                        // number of buckets, always a power of two
+        HashLink        *links;                             // links for each item in the database
+        float           max_radius;                         // largest radius of items in the database
+    } _hash;
+
     uint16_t _next_index_to_send[MAVLINK_COMM_NUM_BUFFERS]; // index of next object in _database to send to GCS
     uint16_t _highest_index_sent[MAVLINK_COMM_NUM_BUFFERS]; // highest index in _database sent to GCS
     uint32_t _last_send_to_gcs_ms[MAVLINK_COMM_NUM_BUFFERS];// system time that send_adsb_vehicle was last called
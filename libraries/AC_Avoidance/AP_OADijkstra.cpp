@@ -29,7 +29,6 @@
 #include <GCS_MAVLink/GCS.h>
 
 #define OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK  32      // expanding arrays for fence points and paths to destination will grow in increments of 20 elements
-#define OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX        255     // index use to indicate we do not have a tentative short path for a node
 #define OA_DIJKSTRA_ERROR_REPORTING_INTERVAL_MS         5000    // failure messages sent to GCS every 5 seconds
 
 /// Constructor
@@ -37,7 +36,6 @@ AP_OADijkstra::AP_OADijkstra(AP_Int16 &options) :
         _inclusion_polygon_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _exclusion_polygon_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _exclusion_circle_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
-        _short_path_data(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _path(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _options(options)
 {
@@ -618,63 +616,165 @@ bool AP_OADijkstra::intersects_fence(const Vector2f &seg_start, const Vector2f &
     }
 
     // determine if segment crosses any of the inclusion polygons
-    uint16_t num_points = 0;
     for (uint8_t i = 0; i < fence->polyfence().get_inclusion_polygon_count(); i++) {
-        const Vector2f* boundary = fence->polyfence().get_inclusion_polygon(i, num_points);
-        if (boundary != nullptr) {
-            Vector2f intersection;
-            if (Polygon_intersects(boundary, num_points, seg_start, seg_end, intersection)) {
-                return true;
-            }
+        if (intersects_fence_shape(FenceShapeType::INCLUSION_POLYGON, i, seg_start, seg_end)) {
+            return true;
         }
     }
 
     // determine if segment crosses any of the exclusion polygons
     for (uint8_t i = 0; i < fence->polyfence().get_exclusion_polygon_count(); i++) {
-        const Vector2f* boundary = fence->polyfence().get_exclusion_polygon(i, num_points);
-        if (boundary != nullptr) {
-            Vector2f intersection;
-            if (Polygon_intersects(boundary, num_points, seg_start, seg_end, intersection)) {
-                return true;
-            }
+        if (intersects_fence_shape(FenceShapeType::EXCLUSION_POLYGON, i, seg_start, seg_end)) {
+            return true;
         }
     }
 
     // determine if segment crosses any of the inclusion circles
     for (uint8_t i = 0; i < fence->polyfence().get_inclusion_circle_count(); i++) {
-        Vector2f center_pos_cm;
-        float radius;
-        if (fence->polyfence().get_inclusion_circle(i, center_pos_cm, radius)) {
-            // intersects circle if either start or end is further from the center than the radius
-            const float radius_cm_sq = sq(radius * 100.0f) ;
-            if ((seg_start - center_pos_cm).length_squared() > radius_cm_sq) {
-                return true;
-            }
-            if ((seg_end - center_pos_cm).length_squared() > radius_cm_sq) {
-                return true;
-            }
+        if (intersects_fence_shape(FenceShapeType::INCLUSION_CIRCLE, i, seg_start, seg_end)) {
+            return true;
         }
     }
 
     // determine if segment crosses any of the exclusion circles
     for (uint8_t i = 0; i < fence->polyfence().get_exclusion_circle_count(); i++) {
+        if (intersects_fence_shape(FenceShapeType::EXCLUSION_CIRCLE, i, seg_start, seg_end)) {
+            return true;
+        }
+    }
+
+    // if we got this far then no intersection
+    return false;
+}
+
+// returns true if line segment intersects a single fence shape
+bool AP_OADijkstra::intersects_fence_shape(FenceShapeType type, uint8_t index, const Vector2f &seg_start, const Vector2f &seg_end) const
+{
+    const AC_Fence *fence = AC_Fence::get_singleton();
+    if (fence == nullptr) {
+        return false;
+    }
+
+    switch (type) {
+    case FenceShapeType::INCLUSION_POLYGON:
+    case FenceShapeType::EXCLUSION_POLYGON: {
+        const bool inclusion = (type == FenceShapeType::INCLUSION_POLYGON);
+        uint16_t num_points = 0;
+        const Vector2f* boundary = inclusion ? fence->polyfence().get_inclusion_polygon(index, num_points) :
+                                               fence->polyfence().get_exclusion_polygon(index, num_points);
+        if (boundary == nullptr) {
+            return false;
+        }
+        // use the fence's spatial index to only check edges near the segment
+        const AP_PolygonIndex<float> *polygon_index = inclusion ? fence->polyfence().get_inclusion_polygon_index(index) :
+                                                                  fence->polyfence().get_exclusion_polygon_index(index);
+        Vector2f intersection;
+        if (polygon_index != nullptr && polygon_index->valid()) {
+            return polygon_index->intersects(seg_start, seg_end, intersection);
+        }
+        return Polygon_intersects(boundary, num_points, seg_start, seg_end, intersection);
+    }
+
+    case FenceShapeType::INCLUSION_CIRCLE: {
         Vector2f center_pos_cm;
         float radius;
-        if (fence->polyfence().get_exclusion_circle(i, center_pos_cm, radius)) {
-            // calculate distance between circle's center and segment
-            const float dist_cm = Vector2f::closest_distance_between_line_and_point(seg_start, seg_end, center_pos_cm);
+        if (!fence->polyfence().get_inclusion_circle(index, center_pos_cm, radius)) {
+            return false;
+        }
+        // intersects circle if either start or end is further from the center than the radius
+        const float radius_cm_sq = sq(radius * 100.0f);
+        return ((seg_start - center_pos_cm).length_squared() > radius_cm_sq) ||
+               ((seg_end - center_pos_cm).length_squared() > radius_cm_sq);
+    }
 
-            // intersects if distance is less than radius
-            if (dist_cm <= (radius * 100.0f)) {
-                return true;
-            }
+    case FenceShapeType::EXCLUSION_CIRCLE: {
+        Vector2f center_pos_cm;
+        float radius;
+        if (!fence->polyfence().get_exclusion_circle(index, center_pos_cm, radius)) {
+            return false;
         }
+        // intersects if distance between circle's center and segment is less than radius
+        const float dist_cm = Vector2f::closest_distance_between_line_and_point(seg_start, seg_end, center_pos_cm);
+        return (dist_cm <= (radius * 100.0f));
+    }
     }
 
-    // if we got this far then no intersection
+    // we should never reach here but just in case
     return false;
 }
 
+// create array of all current fence shapes and their signatures
+// returns nullptr if out of memory or there are no shapes
+AP_OAFenceBlockers::Shape *AP_OADijkstra::create_fence_shapes(uint8_t &num_shapes) const
+{
+    num_shapes = 0;
+    const AC_Fence *fence = AC_Fence::get_singleton();
+    if (fence == nullptr) {
+        return nullptr;
+    }
+
+    const uint8_t counts[] {
+        fence->polyfence().get_inclusion_polygon_count(),
+        fence->polyfence().get_exclusion_polygon_count(),
+        fence->polyfence().get_inclusion_circle_count(),
+        fence->polyfence().get_exclusion_circle_count(),
+    };
+    uint16_t total = 0;
+    for (const uint8_t count : counts) {
+        total += count;
+    }
+    if (total == 0 || total >= AP_OAFenceBlockers::VISIBLE) {
+        return nullptr;
+    }
+    AP_OAFenceBlockers::Shape *shapes = NEW_NOTHROW AP_OAFenceBlockers::Shape[total];
+    if (shapes == nullptr) {
+        return nullptr;
+    }
+
+    for (uint8_t t = 0; t < ARRAY_SIZE(counts); t++) {
+        const FenceShapeType type = FenceShapeType(t);
+        for (uint8_t i = 0; i < counts[t]; i++) {
+            AP_OAFenceBlockers::Shape &shape = shapes[num_shapes++];
+            shape.type = t;
+            shape.index = i;
+            shape.signature = crc_crc32(0, &t, sizeof(t));
+            switch (type) {
+            case FenceShapeType::INCLUSION_POLYGON:
+            case FenceShapeType::EXCLUSION_POLYGON: {
+                uint16_t num_points = 0;
+                const Vector2f* boundary = (type == FenceShapeType::INCLUSION_POLYGON) ?
+                                           fence->polyfence().get_inclusion_polygon(i, num_points) :
+                                           fence->polyfence().get_exclusion_polygon(i, num_points);
+                if (boundary != nullptr) {
+                    shape.signature = crc_crc32(shape.signature, (const uint8_t *)boundary, num_points * sizeof(Vector2f));
+                }
+                break;
+            }
+            case FenceShapeType::INCLUSION_CIRCLE:
+            case FenceShapeType::EXCLUSION_CIRCLE: {
+                Vector2f center_pos_cm;
+                float radius;
+                if ((type == FenceShapeType::INCLUSION_CIRCLE) ?
+                    fence->polyfence().get_inclusion_circle(i, center_pos_cm, radius) :
+                    fence->polyfence().get_exclusion_circle(i, center_pos_cm, radius)) {
+                    const float circle[] { center_pos_cm.x, center_pos_cm.y, radius };
+                    shape.signature = crc_crc32(shape.signature, (const uint8_t *)circle, sizeof(circle));
+                }
+                break;
+            }
+            }
+        }
+    }
+
+    return shapes;
+}
+
+// returns true if line segment intersects a fence shape, for _fence_blockers
+bool AP_OADijkstra::intersects_blocker_shape(const AP_OAFenceBlockers::Shape &shape, const Vector2f &seg_start, const Vector2f &seg_end)
+{
+    return intersects_fence_shape(FenceShapeType(shape.type), shape.index, seg_start, seg_end);
+}
+
 // create visibility graph for all fence (with margin) points
 // returns true on success.  returns false on failure and err_id is updated
 // requires these functions to have been run create_inclusion_polygon_with_margin, create_exclusion_polygon_with_margin, create_exclusion_circle_with_margin
@@ -688,37 +788,69 @@ bool AP_OADijkstra::create_fence_visgraph(AP_OADijkstra_Error &err_id)
     }
 
     // fail if more fence points than algorithm can handle
-    if (total_numpoints() >= OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX) {
+    if (total_numpoints() + 2 > AP_OAAStar::NOTSET_IDX) {
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_TOO_MANY_FENCE_POINTS;
         return false;
     }
+    const uint8_t numpoints = total_numpoints();
+
+    // update the table of shapes blocking each line between points.
+    // If it can't be built the graph is checked against the whole
+    // fence without reusing results from the previous build
+    uint8_t num_shapes = 0;
+    AP_OAFenceBlockers::Shape *shapes = create_fence_shapes(num_shapes);
+    Vector2f *points = NEW_NOTHROW Vector2f[MAX(numpoints, 1)];
+    bool use_blockers = false;
+    if (shapes != nullptr && points != nullptr) {
+        for (uint8_t i = 0; i < numpoints; i++) {
+            UNUSED_RESULT(get_point(i, points[i]));
+        }
+        use_blockers = _fence_blockers.update(points, numpoints, shapes, num_shapes,
+                                              FUNCTOR_BIND_MEMBER(&AP_OADijkstra::intersects_blocker_shape, bool, const AP_OAFenceBlockers::Shape&, const Vector2f&, const Vector2f&));
+    } else {
+        delete[] shapes;
+        delete[] points;
+        _fence_blockers.clear();
+    }
 
     // clear fence points visibility graph
     _fence_visgraph.clear();
 
     // calculate distance from each point to all other points
-    for (uint8_t i = 0; i < total_numpoints() - 1; i++) {
-        Vector2f start_seg;
-        if (get_point(i, start_seg)) {
-            for (uint8_t j = i + 1; j < total_numpoints(); j++) {
-                Vector2f end_seg;
-                if (get_point(j, end_seg)) {
-                    // if line segment does not intersect with any inclusion or exclusion zones add to visgraph
-                    if (!intersects_fence(start_seg, end_seg)) {
-                        if (!_fence_visgraph.add_item({AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i},
-                                                      {AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, j},
-                                                      (start_seg - end_seg).length())) {
-                            // failure to add a point can only be caused by out-of-memory
-                            err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
-                            return false;
-                        }
-                    }
+    bool ret = true;
+    for (uint8_t j = 1; j < numpoints && ret; j++) {
+        Vector2f end_seg;
+        if (!get_point(j, end_seg)) {
+            continue;
+        }
+        for (uint8_t i = 0; i < j; i++) {
+            Vector2f start_seg;
+            if (!get_point(i, start_seg)) {
+                continue;
+            }
+
+            // if line segment does not intersect with any inclusion or exclusion zones add to visgraph
+            const bool visible = use_blockers ? _fence_blockers.visible(i, j) : !intersects_fence(start_seg, end_seg);
+            if (visible) {
+                if (!_fence_visgraph.add_item({AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i},
+                                              {AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, j},
+                                              (start_seg - end_seg).length())) {
+                    // failure to add a point can only be caused by out-of-memory
+                    err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+                    ret = false;
+                    break;
                 }
             }
         }
     }
 
-    return true;
+    // build adjacency lists for the search
+    if (ret && !_astar.set_intermediate_graph(_fence_visgraph, numpoints)) {
+        err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+        ret = false;
+    }
+
+    return ret;
 }
 
 // updates visibility graph for a given position which is an offset (in cm) from the ekf origin
@@ -755,123 +887,6 @@ bool AP_OADijkstra::update_visgraph(AP_OAVisGraph& visgraph, const AP_OAVisGraph
     return true;
 }
 
-// update total distance for all nodes visible from current node
-// curr_node_idx is an index into the _short_path_data array
-void AP_OADijkstra::update_visible_node_distances(node_index curr_node_idx)
-{
-    // sanity check
-    if (curr_node_idx >= _short_path_data_numpoints) {
-        return;
-    }
-
-    // get current node for convenience
-    const ShortPathNode &curr_node = _short_path_data[curr_node_idx];
-
-    // for each visibility graph
-    const AP_OAVisGraph* visgraphs[] = {&_fence_visgraph, &_destination_visgraph};
-    for (uint8_t v=0; v<ARRAY_SIZE(visgraphs); v++) {
-
-        // skip if empty
-        const AP_OAVisGraph &curr_visgraph = *visgraphs[v];
-        if (curr_visgraph.num_items() == 0) {
-            continue;
-        }
-
-        // search visibility graph for items visible from current_node
-        for (uint16_t i = 0; i < curr_visgraph.num_items(); i++) {
-            const AP_OAVisGraph::VisGraphItem &item = curr_visgraph[i];
-            // match if current node's id matches either of the id's in the graph (i.e. either end of the vector)
-            if ((curr_node.id == item.id1) || (curr_node.id == item.id2)) {
-                AP_OAVisGraph::OAItemID matching_id = (curr_node.id == item.id1) ? item.id2 : item.id1;
-                // find item's id in node array
-                node_index item_node_idx;
-                if (find_node_from_id(matching_id, item_node_idx)) {
-                    // if current node's distance + distance to item is less than item's current distance, update item's distance
-                    const float dist_to_item_via_current_node = _short_path_data[curr_node_idx].distance_cm + item.distance_cm;
-                    if (dist_to_item_via_current_node < _short_path_data[item_node_idx].distance_cm) {
-                        // update item's distance and set "distance_from_idx" to current node's index
-                        _short_path_data[item_node_idx].distance_cm = dist_to_item_via_current_node;
-                        _short_path_data[item_node_idx].distance_from_idx = curr_node_idx;
-                    }
-                }
-            }
-        }
-    }
-}
-
-// find a node's index into _short_path_data array from it's id (i.e. id type and id number)
-// returns true if successful and node_idx is updated
-bool AP_OADijkstra::find_node_from_id(const AP_OAVisGraph::OAItemID &id, node_index &node_idx) const
-{
-    switch (id.id_type) {
-    case AP_OAVisGraph::OATYPE_SOURCE:
-        // source node is always the first node
-        if (_short_path_data_numpoints > 0) {
-            node_idx = 0;
-            return true;
-        }
-        break;
-    case AP_OAVisGraph::OATYPE_DESTINATION:
-        // destination is always the 2nd node
-        if (_short_path_data_numpoints > 1) {
-            node_idx = 1;
-            return true;
-        }
-        break;
-    case AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT:
-        // intermediate nodes start from 3rd node
-        if (_short_path_data_numpoints > id.id_num + 2) {
-            node_idx = id.id_num + 2;
-            return true;
-        }
-        break;
-    }
-
-    // could not find node
-    return false;
-}
-
-// find index of node with lowest tentative distance (ignore visited nodes)
-// returns true if successful and node_idx argument is updated
-bool AP_OADijkstra::find_closest_node_idx(node_index &node_idx) const
-{
-    node_index lowest_idx = 0;
-    float lowest_dist = FLT_MAX;
-
-    // scan through all nodes looking for closest
-    for (node_index i=0; i<_short_path_data_numpoints; i++) {
-        const ShortPathNode &node = _short_path_data[i];
-        if (node.visited || is_equal(_short_path_data[i].distance_cm, FLT_MAX)) {
-            // if node is already visited OR cannot be reached yet, we can't use it
-            continue;
-        }
-        // figure out the pos of this node
-        Vector2f node_pos;
-        float dist_with_heuristics = FLT_MAX;
-        if (convert_node_to_point(node.id, node_pos)) {
-            // heuristics is is simple Euclidean distance from the node to the destination
-            // This should be admissible, therefore optimal path is guaranteed
-            const float heuristics = (node_pos-_path_destination).length();
-            dist_with_heuristics = node.distance_cm + heuristics;
-        } else {
-            // shouldn't happen
-            return false;
-        }
-        if (dist_with_heuristics < lowest_dist) {
-            // for NOW, this is the closest node
-            lowest_idx = i;
-            lowest_dist = dist_with_heuristics;
-        }
-    }
-
-    if (lowest_dist < FLT_MAX) {
-        // found the closest node
-        node_idx = lowest_idx;
-        return true;
-    }
-    return false;
-}
-
 // calculate shortest path from origin to destination
 // returns true on success.  returns false on failure and err_id is updated
 // requires these functions to have been run: create_inclusion_polygon_with_margin, create_exclusion_polygon_with_margin, create_exclusion_circle_with_margin, create_polygon_fence_visgraph
@@ -894,84 +909,49 @@ bool AP_OADijkstra::calc_shortest_path(const Location &origin, const Location &d
         return false;
     }
 
-    // expand _short_path_data if necessary
-    if (!_short_path_data.expand_to_hold(2 + total_numpoints())) {
-        err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
-        return false;
-    }
-
-    // add origin and destination (node_type, id, visited, distance_from_idx, distance_cm) to short_path_data array
-    _short_path_data[0] = {{AP_OAVisGraph::OATYPE_SOURCE, 0}, false, 0, 0};
-    _short_path_data[1] = {{AP_OAVisGraph::OATYPE_DESTINATION, 0}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX};
-    _short_path_data_numpoints = 2;
-
-    // add all inclusion and exclusion fence points to short_path_data array (node_type, id, visited, distance_from_idx, distance_cm)
+    // heuristic is the straight line distance from each point to the destination
+    // This is admissible, therefore optimal path is guaranteed
     for (uint8_t i=0; i<total_numpoints(); i++) {
-        _short_path_data[_short_path_data_numpoints++] = {{AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX};
-    }
-
-    // start algorithm from source point
-    node_index current_node_idx = 0;
-
-    // update nodes visible from source point
-    for (uint16_t i = 0; i < _source_visgraph.num_items(); i++) {
-        node_index node_idx;
-        if (find_node_from_id(_source_visgraph[i].id2, node_idx)) {
-            _short_path_data[node_idx].distance_cm = _source_visgraph[i].distance_cm;
-            _short_path_data[node_idx].distance_from_idx = current_node_idx;
-        } else {
-            err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_COULD_NOT_FIND_PATH;
-            return false;
+        Vector2f point;
+        if (get_point(i, point)) {
+            _astar.set_heuristic(i, (point - _path_destination).length());
         }
     }
-    // mark source node as visited
-    _short_path_data[current_node_idx].visited = true;
 
-    // move current_node_idx to node with lowest distance
-    while (find_closest_node_idx(current_node_idx)) {
-        node_index dest_node;
-        // See if this next "closest" node is actually the destination
-        if (find_node_from_id({AP_OAVisGraph::OATYPE_DESTINATION,0}, dest_node) && current_node_idx == dest_node) {
-            // We have discovered destination.. Don't bother with the rest of the graph
-            break;
-        }
-        // update distances to all neighbours of current node
-        update_visible_node_distances(current_node_idx);
-
-        // mark current node as visited
-        _short_path_data[current_node_idx].visited = true;
+    switch (_astar.search(_source_visgraph, _destination_visgraph)) {
+    case AP_OAAStar::Result::SUCCESS:
+        break;
+    case AP_OAAStar::Result::OUT_OF_MEMORY:
+        err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+        return false;
+    case AP_OAAStar::Result::NO_PATH:
+        err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_COULD_NOT_FIND_PATH;
+        return false;
     }
 
     // extract path starting from destination
     bool success = false;
-    node_index nidx;
-    if (!find_node_from_id({AP_OAVisGraph::OATYPE_DESTINATION,0}, nidx)) {
-        err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_COULD_NOT_FIND_PATH;
-        return false;
-    }
+    AP_OAAStar::node_index nidx = AP_OAAStar::DESTINATION_IDX;
     _path_numpoints = 0;
     while (true) {
         if (!_path.expand_to_hold(_path_numpoints + 1)) {
             err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
             return false;
         }
-        // fail if newest node has invalid distance_from_index
-        if ((_short_path_data[nidx].distance_from_idx == OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX) ||
-            (_short_path_data[nidx].distance_cm >= FLT_MAX)) {
+        // add node's id to path array
+        _path[_path_numpoints] = AP_OAAStar::node_id(nidx);
+        _path_numpoints++;
+
+        // we are done if node is the source
+        if (nidx == AP_OAAStar::SOURCE_IDX) {
+            success = true;
             break;
-        } else {
-            // add node's id to path array
-            _path[_path_numpoints] = _short_path_data[nidx].id;
-            _path_numpoints++;
+        }
 
-            // we are done if node is the source
-            if (_short_path_data[nidx].id.id_type == AP_OAVisGraph::OATYPE_SOURCE) {
-                success = true;
-                break;
-            } else {
-                // follow node's "distance_from_idx" to previous node on path
-                nidx = _short_path_data[nidx].distance_from_idx;
-            }
+        // follow node's previous node on path, failing if it has none
+        nidx = _astar.prev_node(nidx);
+        if (nidx == AP_OAAStar::NOTSET_IDX) {
+            break;
         }
     }
     // report error in case path not found
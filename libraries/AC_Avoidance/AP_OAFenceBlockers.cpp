@@ -0,0 +1,174 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AC_Avoidance_config.h"
+
+#if AP_OAPATHPLANNER_DIJKSTRA_ENABLED
+
+#include "AP_OAFenceBlockers.h"
+
+// rebuild the table for new points and shapes, reusing results from the previous update
+// returns false if out of memory or the table would be too large
+bool AP_OAFenceBlockers::update(Vector2f *points, uint8_t numpoints, Shape *shapes, uint8_t num_shapes, intersects_fn_t intersects)
+{
+    const uint16_t table_size = MAX(pair_index(0, numpoints), 1);
+    if ((points == nullptr && numpoints > 0) ||
+        (shapes == nullptr && num_shapes > 0) ||
+        (num_shapes >= VISIBLE) ||
+        (table_size > AP_OAFENCEBLOCKERS_MAX_BYTES)) {
+        delete[] points;
+        delete[] shapes;
+        clear();
+        return false;
+    }
+
+    // match old shapes to unchanged new shapes, anything unmatched is new
+    bool *new_shape = NEW_NOTHROW bool[MAX(num_shapes, 1)];
+    uint8_t *old_shape_to_new = NEW_NOTHROW uint8_t[MAX(_num_shapes, 1)];
+    bool reuse = false;
+    if (new_shape != nullptr && old_shape_to_new != nullptr) {
+        for (uint8_t i = 0; i < num_shapes; i++) {
+            new_shape[i] = true;
+        }
+        for (uint8_t i = 0; i < _num_shapes; i++) {
+            old_shape_to_new[i] = VISIBLE;
+            for (uint8_t j = 0; j < num_shapes; j++) {
+                if (new_shape[j] &&
+                    shapes[j].type == _shapes[i].type &&
+                    shapes[j].signature == _shapes[i].signature) {
+                    old_shape_to_new[i] = j;
+                    new_shape[j] = false;
+                    reuse = true;
+                    break;
+                }
+            }
+        }
+    }
+    if (!reuse) {
+        // every line must be checked against every shape, so free the
+        // old table before allocating the new one
+        clear();
+    }
+
+    uint8_t *point_to_old = NEW_NOTHROW uint8_t[MAX(numpoints, 1)];
+    uint8_t *blocker = NEW_NOTHROW uint8_t[table_size];
+    const bool ret = (new_shape != nullptr) && (old_shape_to_new != nullptr) &&
+                     (point_to_old != nullptr) && (blocker != nullptr);
+
+    if (ret) {
+        // match points to the points of the previous update.  Points of
+        // unchanged shapes are usually in the same order so try the
+        // point after the last match first
+        uint8_t hint = 0;
+        for (uint8_t i = 0; i < numpoints; i++) {
+            point_to_old[i] = VISIBLE;
+            for (uint8_t k = 0; k < _numpoints; k++) {
+                const uint8_t j = (hint + k) % _numpoints;
+                if (_points[j] == points[i]) {
+                    point_to_old[i] = j;
+                    hint = j + 1;
+                    break;
+                }
+            }
+        }
+
+        for (uint8_t j = 1; j < numpoints; j++) {
+            for (uint8_t i = 0; i < j; i++) {
+                uint8_t first_blocker;
+                const uint8_t old_i = point_to_old[i];
+                const uint8_t old_j = point_to_old[j];
+                if (_blocker != nullptr && old_i != VISIBLE && old_j != VISIBLE && old_i != old_j) {
+                    // same line as in the previous update
+                    const uint8_t old_blocker = _blocker[pair_index(MIN(old_i, old_j), MAX(old_i, old_j))];
+                    if (old_blocker == VISIBLE) {
+                        // was clear so only new shapes can block it
+                        first_blocker = find_blocker(shapes, num_shapes, new_shape, points[i], points[j], intersects);
+                    } else if (old_shape_to_new[old_blocker] != VISIBLE) {
+                        // still blocked by the same unchanged shape
+                        first_blocker = old_shape_to_new[old_blocker];
+                    } else {
+                        // blocking shape has changed
+                        first_blocker = find_blocker(shapes, num_shapes, nullptr, points[i], points[j], intersects);
+                    }
+                } else {
+                    first_blocker = find_blocker(shapes, num_shapes, nullptr, points[i], points[j], intersects);
+                }
+                blocker[pair_index(i, j)] = first_blocker;
+            }
+        }
+    }
+
+    // keep this update's results for the next update
+    clear();
+    if (ret) {
+        _shapes = shapes;
+        _num_shapes = num_shapes;
+        _points = points;
+        _numpoints = numpoints;
+        _blocker = blocker;
+    } else {
+        delete[] shapes;
+        delete[] points;
+        delete[] blocker;
+    }
+    delete[] new_shape;
+    delete[] old_shape_to_new;
+    delete[] point_to_old;
+
+    return ret;
+}
+
+// returns true if no shape blocks the line between points i and j
+bool AP_OAFenceBlockers::visible(uint8_t i, uint8_t j) const
+{
+    if (i == j) {
+        return true;
+    }
+    if (_blocker == nullptr || i >= _numpoints || j >= _numpoints) {
+        return false;
+    }
+    return _blocker[pair_index(MIN(i, j), MAX(i, j))] == VISIBLE;
+}
+
+// free the table so the next update starts from scratch
+void AP_OAFenceBlockers::clear()
+{
+    delete[] _shapes;
+    delete[] _points;
+    delete[] _blocker;
+    _shapes = nullptr;
+    _points = nullptr;
+    _blocker = nullptr;
+    _num_shapes = 0;
+    _numpoints = 0;
+}
+
+// returns index of first shape which blocks the line between two points, or VISIBLE
+// if new_shape is not nullptr only shapes flagged as new in it are checked
+uint8_t AP_OAFenceBlockers::find_blocker(const Shape *shapes, uint8_t num_shapes, const bool *new_shape,
+                                         const Vector2f &seg_start, const Vector2f &seg_end, intersects_fn_t intersects)
+{
+    for (uint8_t i = 0; i < num_shapes; i++) {
+        if (new_shape != nullptr && !new_shape[i]) {
+            continue;
+        }
+        if (intersects(shapes[i], seg_start, seg_end)) {
+            return i;
+        }
+    }
+    return VISIBLE;
+}
+
+#endif  // AP_OAPATHPLANNER_DIJKSTRA_ENABLED
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "AC_Avoidance_config.h"
+
+#if AP_OAPATHPLANNER_DIJKSTRA_ENABLED
+
+#include <AP_Common/AP_Common.h>
+#include <AP_HAL/AP_HAL_Boards.h>
+#include <AP_HAL/utility/functor.h>
+#include <AP_Math/AP_Math.h>
+
+// largest blocker table kept between fence visibility graph builds.
+// A full table for 254 points is just under 32k
+#ifndef AP_OAFENCEBLOCKERS_MAX_BYTES
+#if HAL_MEM_CLASS >= HAL_MEM_CLASS_1000
+#define AP_OAFENCEBLOCKERS_MAX_BYTES    32768
+#elif HAL_MEM_CLASS >= HAL_MEM_CLASS_500
+#define AP_OAFENCEBLOCKERS_MAX_BYTES    8192
+#else
+#define AP_OAFENCEBLOCKERS_MAX_BYTES    0
+#endif
+#endif
+
+/*
+ * Table of the first fence shape blocking the line between each pair
+ * of fence points, used to rebuild Dijkstra's fence visibility graph
+ * incrementally.
+ *
+ * After a fence change only lines which have a moved end point, or
+ * which were blocked by a shape which has changed, need to be checked
+ * against the whole fence.  Other lines are only checked against the
+ * new shapes.  Shapes are matched between builds by type and a
+ * signature of their points.
+ */
+class AP_OAFenceBlockers {
+public:
+    AP_OAFenceBlockers() {}
+    ~AP_OAFenceBlockers() { clear(); }
+
+    CLASS_NO_COPY(AP_OAFenceBlockers);  /* Do not allow copies */
+
+    // a fence shape which may block lines between points
+    struct Shape {
+        uint8_t type;               // caller defined type of shape
+        uint8_t index;              // index of shape amongst shapes of the same type
+        uint32_t signature;         // crc of shape's points, used to find unchanged shapes
+    };
+
+    static const uint8_t VISIBLE = UINT8_MAX;   // no shape blocks the line, so at most 255 shapes
+
+    // returns true if the line between two points crosses a shape
+    FUNCTOR_TYPEDEF(intersects_fn_t, bool, const Shape&, const Vector2f&, const Vector2f&);
+
+    // rebuild the table for numpoints points and num_shapes shapes,
+    // reusing results from the previous update.  Takes ownership of
+    // points and shapes which must have been allocated with new[].
+    // returns false if out of memory or the table would be larger
+    // than AP_OAFENCEBLOCKERS_MAX_BYTES, in which case the table is
+    // cleared and visible() must not be used
+    bool update(Vector2f *points, uint8_t numpoints, Shape *shapes, uint8_t num_shapes, intersects_fn_t intersects);
+
+    // returns true if no shape blocks the line between points i and j
+    // of the last successful update
+    bool visible(uint8_t i, uint8_t j) const;
+
+    // free the table so the next update starts from scratch
+    void clear();
+
+private:
+
+    // returns index of first shape which blocks the line between two points, or VISIBLE
+    // if new_shape is not nullptr only shapes flagged as new in it are checked
+    static uint8_t find_blocker(const Shape *shapes, uint8_t num_shapes, const bool *new_shape,
+                                const Vector2f &seg_start, const Vector2f &seg_end, intersects_fn_t intersects);
+
+    // index into _blocker for the pair of points i and j, i must be less than j
+    static uint16_t pair_index(uint8_t i, uint8_t j) { return (uint16_t(j) * (j - 1)) / 2 + i; }
+
+    Shape *_shapes = nullptr;       // shapes the table was built against
+    uint8_t _num_shapes = 0;        // number of shapes in above array
+    Vector2f *_points = nullptr;    // points the table was built with
+    uint8_t _numpoints = 0;         // number of points in above array
+    uint8_t *_blocker = nullptr;    // index of first shape blocking line between each pair of points, or VISIBLE
+};
+
+#endif  // AP_OAPATHPLANNER_DIJKSTRA_ENABLED
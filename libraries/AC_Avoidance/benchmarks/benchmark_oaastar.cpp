@@ -0,0 +1,172 @@
+#include <AP_gbenchmark.h>
+
+#include <AC_Avoidance/AP_OAAStar.h>
+
+#if AP_OAPATHPLANNER_DIJKSTRA_ENABLED
+
+#include <AP_Math/AP_Math.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  planning time against the number of fence points, for a grid of
+  square exclusion zones inside the boundary of the 2010 outback
+  challenge.  The visibility graphs are built the same way as
+  AP_OADijkstra builds them, with each exclusion zone's points
+  placed a margin away from its corners
+ */
+
+#define OBSTACLE_SIZE_CM    2000.0f
+#define OBSTACLE_MARGIN_CM  500.0f
+
+// boundary of the 2010 outback challenge as latitude and longitude in
+// degrees*1e7, converted below to offsets in cm from the first point
+static const Vector2l OBC_boundary[] = {
+    Vector2l(-265695640, 1518373730),
+    Vector2l(-265699560, 1518394050),
+    Vector2l(-265768230, 1518411420),
+    Vector2l(-265773080, 1518403440),
+    Vector2l(-265815110, 1518419500),
+    Vector2l(-265784860, 1518474690),
+    Vector2l(-265994890, 1518528860),
+    Vector2l(-266092110, 1518747420),
+    Vector2l(-266454780, 1518820530),
+    Vector2l(-266435720, 1518303500),
+    Vector2l(-265875990, 1518344050),
+};
+
+class OAAStarFixture {
+public:
+    OAAStarFixture(uint8_t num_obstacles);
+
+    uint8_t num_points;
+    Vector2f points[252];
+    Vector2f obstacles[64][5];
+    uint8_t num_obstacles;
+    Vector2f boundary[ARRAY_SIZE(OBC_boundary)+1];
+    Vector2f source;
+    Vector2f destination;
+    AP_OAVisGraph fence_visgraph;
+    AP_OAVisGraph source_visgraph;
+    AP_OAVisGraph destination_visgraph;
+
+private:
+    bool intersects(const Vector2f &p1, const Vector2f &p2) const;
+    void update_visgraph(AP_OAVisGraph &visgraph, const AP_OAVisGraph::OAItemID &oaid, const Vector2f &position, bool add_destination);
+};
+
+OAAStarFixture::OAAStarFixture(uint8_t _num_obstacles) :
+    num_points(0),
+    num_obstacles(MIN(_num_obstacles, 63))
+{
+    const float lon_scale = cosf(radians(OBC_boundary[0].x * 1.0e-7f));
+    for (uint8_t i=0; i<ARRAY_SIZE(OBC_boundary); i++) {
+        boundary[i].x = (OBC_boundary[i].x - OBC_boundary[0].x) * LATLON_TO_CM;
+        boundary[i].y = (OBC_boundary[i].y - OBC_boundary[0].y) * LATLON_TO_CM * lon_scale;
+    }
+    boundary[ARRAY_SIZE(OBC_boundary)] = boundary[0];
+
+    // grid of obstacles in the south of the boundary
+    const Vector2f grid_origin {-500000, 50000};
+    const float spacing = 3 * OBSTACLE_SIZE_CM;
+    for (uint8_t i=0; i<num_obstacles; i++) {
+        const Vector2f corner = grid_origin + Vector2f{(i / 8) * spacing, (i % 8) * spacing};
+        const Vector2f square[] {{0,0}, {OBSTACLE_SIZE_CM,0}, {OBSTACLE_SIZE_CM,OBSTACLE_SIZE_CM}, {0,OBSTACLE_SIZE_CM}};
+        const Vector2f margin[] {{-1,-1}, {1,-1}, {1,1}, {-1,1}};
+        for (uint8_t j=0; j<4; j++) {
+            obstacles[i][j] = corner + square[j];
+            points[num_points++] = corner + square[j] + margin[j] * OBSTACLE_MARGIN_CM;
+        }
+        obstacles[i][4] = obstacles[i][0];
+    }
+
+    // from the north west of the grid to the south east
+    source = grid_origin - Vector2f{spacing, spacing};
+    destination = grid_origin + Vector2f{8 * spacing, 8 * spacing};
+
+    for (uint8_t i=0; i<num_points; i++) {
+        for (uint8_t j=i+1; j<num_points; j++) {
+            if (!intersects(points[i], points[j])) {
+                UNUSED_RESULT(fence_visgraph.add_item({AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i},
+                                                      {AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, j},
+                                                      (points[i] - points[j]).length()));
+            }
+        }
+    }
+    update_visgraph(source_visgraph, {AP_OAVisGraph::OATYPE_SOURCE, 0}, source, true);
+    update_visgraph(destination_visgraph, {AP_OAVisGraph::OATYPE_DESTINATION, 0}, destination, false);
+}
+
+bool OAAStarFixture::intersects(const Vector2f &p1, const Vector2f &p2) const
+{
+    Vector2f intersection;
+    if (Polygon_intersects(boundary, ARRAY_SIZE(boundary), p1, p2, intersection)) {
+        return true;
+    }
+    for (uint8_t i=0; i<num_obstacles; i++) {
+        if (Polygon_intersects(obstacles[i], 5, p1, p2, intersection)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void OAAStarFixture::update_visgraph(AP_OAVisGraph &visgraph, const AP_OAVisGraph::OAItemID &oaid, const Vector2f &position, bool add_destination)
+{
+    for (uint8_t i=0; i<num_points; i++) {
+        if (!intersects(position, points[i])) {
+            UNUSED_RESULT(visgraph.add_item(oaid, {AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i}, (position - points[i]).length()));
+        }
+    }
+    if (add_destination && !intersects(position, destination)) {
+        UNUSED_RESULT(visgraph.add_item(oaid, {AP_OAVisGraph::OATYPE_DESTINATION, 0}, (position - destination).length()));
+    }
+}
+
+// search for a path, as run for each new destination
+static void BM_OAAStarSearch(benchmark::State& state)
+{
+    // allocated so they are zeroed, as they would be in AP_OADijkstra
+    OAAStarFixture *fixture = NEW_NOTHROW OAAStarFixture(state.range(0));
+    AP_OAAStar *astar = NEW_NOTHROW AP_OAAStar();
+    if (!astar->set_intermediate_graph(fixture->fence_visgraph, fixture->num_points)) {
+        state.SkipWithError("out of memory");
+    }
+
+    while (state.KeepRunning()) {
+        for (uint8_t i=0; i<fixture->num_points; i++) {
+            astar->set_heuristic(i, (fixture->points[i] - fixture->destination).length());
+        }
+        AP_OAAStar::Result result = astar->search(fixture->source_visgraph, fixture->destination_visgraph);
+        gbenchmark_escape(&result);
+    }
+    state.counters["points"] = fixture->num_points;
+    state.counters["edges"] = fixture->fence_visgraph.num_items();
+
+    delete astar;
+    delete fixture;
+}
+
+// build the adjacency lists, as run for each change to the fence
+static void BM_OAAStarSetGraph(benchmark::State& state)
+{
+    OAAStarFixture *fixture = NEW_NOTHROW OAAStarFixture(state.range(0));
+    AP_OAAStar *astar = NEW_NOTHROW AP_OAAStar();
+
+    while (state.KeepRunning()) {
+        bool ret = astar->set_intermediate_graph(fixture->fence_visgraph, fixture->num_points);
+        gbenchmark_escape(&ret);
+    }
+    state.counters["points"] = fixture->num_points;
+    state.counters["edges"] = fixture->fence_visgraph.num_items();
+
+    delete astar;
+    delete fixture;
+}
+
+BENCHMARK(BM_OAAStarSearch)->RangeMultiplier(2)->Range(1, 63);
+BENCHMARK(BM_OAAStarSetGraph)->RangeMultiplier(2)->Range(1, 63);
+
+#endif  // AP_OAPATHPLANNER_DIJKSTRA_ENABLED
+
+BENCHMARK_MAIN();
@@ -0,0 +1,134 @@
+#include <AP_gtest.h>
+#include <AP_Common/AP_Common.h>
+
+#include <AC_Avoidance/AP_OAFenceBlockers.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_OAPATHPLANNER_DIJKSTRA_ENABLED
+
+/*
+  an incremental update of the blocker table should give the same
+  visibility as building it from scratch, and as checking every line
+  against every shape
+ */
+
+#define NUM_POINTS  60
+#define NUM_SHAPES  20
+
+// exclusion circles standing in for fence shapes
+class Circles {
+public:
+    Vector2f center[NUM_SHAPES];
+    float radius[NUM_SHAPES];
+
+    void randomise(uint8_t i) {
+        center[i] = Vector2f((rand() % 20000) - 10000, (rand() % 20000) - 10000);
+        radius[i] = 300 + rand() % 1500;
+    }
+
+    bool intersects(const AP_OAFenceBlockers::Shape &shape, const Vector2f &seg_start, const Vector2f &seg_end) {
+        return Vector2f::closest_distance_between_line_and_point(seg_start, seg_end, center[shape.index]) <= radius[shape.index];
+    }
+
+    // shapes for the current circles, signed with their position and radius
+    AP_OAFenceBlockers::Shape *shapes() const {
+        AP_OAFenceBlockers::Shape *ret = NEW_NOTHROW AP_OAFenceBlockers::Shape[NUM_SHAPES];
+        for (uint8_t i=0; i<NUM_SHAPES; i++) {
+            const float circle[] { center[i].x, center[i].y, radius[i] };
+            ret[i].type = 0;
+            ret[i].index = i;
+            ret[i].signature = crc_crc32(0, (const uint8_t *)circle, sizeof(circle));
+        }
+        return ret;
+    }
+
+    AP_OAFenceBlockers::intersects_fn_t intersects_fn() {
+        return FUNCTOR_BIND_MEMBER(&Circles::intersects, bool, const AP_OAFenceBlockers::Shape&, const Vector2f&, const Vector2f&);
+    }
+};
+
+static Vector2f random_point(void)
+{
+    return Vector2f((rand() % 24000) - 12000, (rand() % 24000) - 12000);
+}
+
+static Vector2f *copy_points(const Vector2f *points, uint8_t n)
+{
+    Vector2f *ret = NEW_NOTHROW Vector2f[n];
+    memcpy(ret, points, n * sizeof(Vector2f));
+    return ret;
+}
+
+TEST(OAFenceBlockers, incremental_matches_full)
+{
+    srand(1);
+    Circles circles;
+    Vector2f points[NUM_POINTS];
+    for (uint8_t i=0; i<NUM_SHAPES; i++) {
+        circles.randomise(i);
+    }
+    for (uint8_t i=0; i<NUM_POINTS; i++) {
+        points[i] = random_point();
+    }
+
+    AP_OAFenceBlockers incremental;
+    EXPECT_TRUE(incremental.update(copy_points(points, NUM_POINTS), NUM_POINTS, circles.shapes(), NUM_SHAPES, circles.intersects_fn()));
+
+    for (uint8_t iteration=0; iteration<10; iteration++) {
+        // move a few shapes and points, and swap two points over
+        for (uint8_t k=0; k<3; k++) {
+            circles.randomise(rand() % NUM_SHAPES);
+            points[rand() % NUM_POINTS] = random_point();
+        }
+        const uint8_t a = rand() % NUM_POINTS;
+        const uint8_t b = rand() % NUM_POINTS;
+        const Vector2f tmp = points[a];
+        points[a] = points[b];
+        points[b] = tmp;
+
+        EXPECT_TRUE(incremental.update(copy_points(points, NUM_POINTS), NUM_POINTS, circles.shapes(), NUM_SHAPES, circles.intersects_fn()));
+        AP_OAFenceBlockers full;
+        EXPECT_TRUE(full.update(copy_points(points, NUM_POINTS), NUM_POINTS, circles.shapes(), NUM_SHAPES, circles.intersects_fn()));
+
+        for (uint8_t j=1; j<NUM_POINTS; j++) {
+            for (uint8_t i=0; i<j; i++) {
+                bool blocked = false;
+                for (uint8_t s=0; s<NUM_SHAPES; s++) {
+                    const AP_OAFenceBlockers::Shape shape {0, s, 0};
+                    blocked |= circles.intersects(shape, points[i], points[j]);
+                }
+                EXPECT_EQ(full.visible(i, j), incremental.visible(i, j));
+                EXPECT_EQ(!blocked, incremental.visible(i, j));
+                EXPECT_EQ(incremental.visible(i, j), incremental.visible(j, i));
+            }
+        }
+    }
+}
+
+TEST(OAFenceBlockers, clear)
+{
+    srand(2);
+    Circles circles;
+    Vector2f points[NUM_POINTS];
+    for (uint8_t i=0; i<NUM_SHAPES; i++) {
+        circles.randomise(i);
+    }
+    for (uint8_t i=0; i<NUM_POINTS; i++) {
+        points[i] = random_point();
+    }
+
+    AP_OAFenceBlockers blockers;
+    EXPECT_TRUE(blockers.update(copy_points(points, NUM_POINTS), NUM_POINTS, circles.shapes(), NUM_SHAPES, circles.intersects_fn()));
+    blockers.clear();
+    EXPECT_FALSE(blockers.visible(0, 1));
+    EXPECT_TRUE(blockers.visible(1, 1));
+
+    // missing shapes fail and leave the table empty
+    EXPECT_FALSE(blockers.update(copy_points(points, NUM_POINTS), NUM_POINTS, nullptr, NUM_SHAPES, circles.intersects_fn()));
+    EXPECT_FALSE(blockers.visible(0, 1));
+}
+
+#endif // AP_OAPATHPLANNER_DIJKSTRA_ENABLED
+
+AP_GTEST_MAIN()
@@ -20,6 +20,11 @@
 
 #define POLYFENCE_LOADER_DEBUGGING 0
 
+// number of fence points loaded per update while armed
+#ifndef AC_POLYFENCE_LOAD_SLICE_POINTS
+#define AC_POLYFENCE_LOAD_SLICE_POINTS 32
+#endif
+
 #if POLYFENCE_LOADER_DEBUGGING
 #define Debug(fmt, args ...)  do { GCS_SEND_TEXT(MAV_SEVERITY_INFO, fmt, ## args); } while (0)
 #else
@@ -235,27 +240,27 @@ bool AC_PolyFence_loader::breached(const Location& loc) const
     pos.x = loc.lat;
     pos.y = loc.lng;
 
-    const uint16_t num_inclusion = _num_loaded_circle_inclusion_boundaries + _num_loaded_inclusion_boundaries;
+    const uint16_t num_inclusion = _loaded->num_circle_inclusion_boundaries + _loaded->num_inclusion_boundaries;
     uint16_t num_inclusion_outside = 0;
 
     // check we are inside each inclusion zone:
-    for (uint8_t i=0; i<_num_loaded_inclusion_boundaries; i++) {
-        const InclusionBoundary &boundary = _loaded_inclusion_boundary[i];
-        if (Polygon_outside(pos, boundary.points_lla, boundary.count)) {
+    for (uint8_t i=0; i<_loaded->num_inclusion_boundaries; i++) {
+        const InclusionBoundary &boundary = _loaded->inclusion_boundary[i];
+        if (boundary.index_lla.outside(pos)) {
             num_inclusion_outside++;
         }
     }
 
     // check we are outside each exclusion zone:
-    for (uint8_t i=0; i<_num_loaded_exclusion_boundaries; i++) {
-        const ExclusionBoundary &boundary = _loaded_exclusion_boundary[i];
-        if (!Polygon_outside(pos, boundary.points_lla, boundary.count)) {
+    for (uint8_t i=0; i<_loaded->num_exclusion_boundaries; i++) {
+        const ExclusionBoundary &boundary = _loaded->exclusion_boundary[i];
+        if (!boundary.index_lla.outside(pos)) {
             return true;
         }
     }
 
-    for (uint8_t i=0; i<_num_loaded_circle_exclusion_boundaries; i++) {
-        const ExclusionCircle &circle = _loaded_circle_exclusion_boundary[i];
+    for (uint8_t i=0; i<_loaded->num_circle_exclusion_boundaries; i++) {
+        const ExclusionCircle &circle = _loaded->circle_exclusion_boundary[i];
         Location circle_center;
         circle_center.lat = circle.point.x;
         circle_center.lng = circle.point.y;
@@ -265,8 +270,8 @@ bool AC_PolyFence_loader::breached(const Location& loc) const
         }
     }
 
-    for (uint8_t i=0; i<_num_loaded_circle_inclusion_boundaries; i++) {
-        const InclusionCircle &circle = _loaded_circle_inclusion_boundary[i];
+    for (uint8_t i=0; i<_loaded->num_circle_inclusion_boundaries; i++) {
+        const InclusionCircle &circle = _loaded->circle_inclusion_boundary[i];
         Location circle_center;
         circle_center.lat = circle.point.x;
         circle_center.lng = circle.point.y;
@@ -330,21 +335,39 @@ bool AC_PolyFence_loader::scale_latlon_from_origin(const Location &origin, const
     return true;
 }
 
-bool AC_PolyFence_loader::read_polygon_from_storage(const Location &origin, uint16_t &read_offset, const uint8_t vertex_count, Vector2f *&next_storage_point, Vector2l *&next_storage_point_lla)
+bool AC_PolyFence_loader::read_polygon_from_storage(const Location &origin, const AC_PolyFenceType type, uint16_t &read_offset, const uint8_t vertex_count, Vector2f *&next_storage_point, Vector2l *&next_storage_point_lla, AP_PolygonIndex<float> &index, AP_PolygonIndex<int32_t> &index_lla)
 {
+    // read from storage to lat/lon
     for (uint8_t i=0; i<vertex_count; i++) {
-        // read from storage to lat/lon
-        if (!read_latlon_from_storage(read_offset, *next_storage_point_lla)) {
+        if (!read_latlon_from_storage(read_offset, next_storage_point_lla[i])) {
             return false;
         }
+    }
+
+    // polygons which have not changed since the last load keep their
+    // offsets and spatial indexes, so only changed polygons are
+    // transformed and indexed
+    const LoadedPolygon *loaded = find_loaded_polygon(type, next_storage_point_lla, vertex_count, origin);
+    if (loaded != nullptr) {
+        memcpy(next_storage_point, loaded->points, vertex_count*sizeof(Vector2f));
+    } else {
         // convert lat/lon to position in cm from origin
-        if (!scale_latlon_from_origin(origin, *next_storage_point_lla, *next_storage_point)) {
-            return false;
+        for (uint8_t i=0; i<vertex_count; i++) {
+            if (!scale_latlon_from_origin(origin, next_storage_point_lla[i], next_storage_point[i])) {
+                return false;
+            }
         }
-        
-        next_storage_point_lla++;
-        next_storage_point++;
     }
+    if (loaded == nullptr ||
+        !index.copy_from(loaded->index, next_storage_point) ||
+        !index_lla.copy_from(loaded->index_lla, next_storage_point_lla)) {
+        // a failed allocation leaves the index scanning every edge
+        index.init(next_storage_point, vertex_count);
+        index_lla.init(next_storage_point_lla, vertex_count);
+    }
+
+    next_storage_point_lla += vertex_count;
+    next_storage_point += vertex_count;
     return true;
 }
 
@@ -499,6 +522,7 @@ bool AC_PolyFence_loader::index_eeprom()
     if (_eeprom_fence_count == 0) {
         _num_fences = 0;
         _load_attempted = false;
+        _load_in_progress = false;
         return true;
     }
 
@@ -522,6 +546,7 @@ bool AC_PolyFence_loader::index_eeprom()
 #endif
 
     _load_attempted = false;
+    _load_in_progress = false;
 
     return true;
 }
@@ -535,33 +560,33 @@ bool AC_PolyFence_loader::check_indexed()
     return _indexed;
 }
 
-void AC_PolyFence_loader::unload()
+void AC_PolyFence_loader::LoadedFences::free()
 {
-    delete[] _loaded_offsets_from_origin;
-    _loaded_offsets_from_origin = nullptr;
+    delete[] offsets_from_origin;
+    offsets_from_origin = nullptr;
 
-    delete[] _loaded_points_lla;
-    _loaded_points_lla = nullptr;
+    delete[] points_lla;
+    points_lla = nullptr;
 
-    delete[] _loaded_inclusion_boundary;
-    _loaded_inclusion_boundary = nullptr;
-    _num_loaded_inclusion_boundaries = 0;
+    delete[] inclusion_boundary;
+    inclusion_boundary = nullptr;
+    num_inclusion_boundaries = 0;
 
-    delete[] _loaded_exclusion_boundary;
-    _loaded_exclusion_boundary = nullptr;
-    _num_loaded_exclusion_boundaries = 0;
+    delete[] exclusion_boundary;
+    exclusion_boundary = nullptr;
+    num_exclusion_boundaries = 0;
 
-    delete[] _loaded_circle_inclusion_boundary;
-    _loaded_circle_inclusion_boundary = nullptr;
-    _num_loaded_circle_inclusion_boundaries = 0;
+    delete[] circle_inclusion_boundary;
+    circle_inclusion_boundary = nullptr;
+    num_circle_inclusion_boundaries = 0;
 
-    delete[] _loaded_circle_exclusion_boundary;
-    _loaded_circle_exclusion_boundary = nullptr;
-    _num_loaded_circle_exclusion_boundaries = 0;
+    delete[] circle_exclusion_boundary;
+    circle_exclusion_boundary = nullptr;
+    num_circle_exclusion_boundaries = 0;
 
-    _loaded_return_point = nullptr;
-    _loaded_return_point_lla = nullptr;
-    _load_time_ms = 0;
+    return_point = nullptr;
+    return_point_lla = nullptr;
+    load_time_ms = 0;
 }
 
 // return the number of fences of type type in the index:
@@ -609,28 +634,64 @@ bool AC_PolyFence_loader::load_from_eeprom()
         return false;
     }
 
-    if (_load_attempted) {
-        return _load_time_ms != 0;
+    if (_swap_pending) {
+        return swap_loaded_fences();
     }
 
-    Location ekf_origin{};
-    if (!AP::ahrs().get_origin(ekf_origin)) {
-//        Debug("fence load requires origin");
-        return false;
+    if (_load_attempted && !_load_in_progress) {
+        return _loaded->load_time_ms != 0;
     }
 
-    // find indexes of each fence:
-    if (!get_loaded_fence_semaphore().take_nonblocking()) {
+    // build the new fences in the set not being used for fence
+    // checks, so the active fences stay in force while we load
+    LoadedFences &fences = (_loaded == &_fences[0]) ? _fences[1] : _fences[0];
+
+    if (!_load_in_progress) {
+        Location ekf_origin{};
+        if (!AP::ahrs().get_origin(ekf_origin)) {
+//            Debug("fence load requires origin");
+            return false;
+        }
+        _load_attempted = true;
+        if (!start_load(fences, ekf_origin)) {
+            return load_failed(fences);
+        }
+    }
+
+    // while armed the set is built a slice per call so a large fence
+    // doesn't stall the main loop.  On the ground the whole set is
+    // built at once so pre-arm checks see the result straight away
+    const uint16_t max_points = hal.util->get_soft_armed() ? AC_POLYFENCE_LOAD_SLICE_POINTS : UINT16_MAX;
+    if (!load_fences(fences, max_points)) {
+        _load_in_progress = false;
+        return load_failed(fences);
+    }
+    if (_load_next_fence < _eeprom_fence_count) {
+        // more to build on the next call
         return false;
     }
+    _load_in_progress = false;
 
-    _load_attempted = true;
+    fences.load_time_ms = AP_HAL::millis();
 
-    unload();
+    _swap_pending = true;
+    return swap_loaded_fences();
+}
+
+/*
+  allocate a new set of fences sized from the index, ready for
+  load_fences() to fill in
+ */
+bool AC_PolyFence_loader::start_load(LoadedFences &fences, const Location &ekf_origin)
+{
+    fences.free();
+    fences.origin = ekf_origin;
+    _load_next_fence = 0;
+    _load_next_point = 0;
 
     if (_eeprom_item_count == 0) {
-        get_loaded_fence_semaphore().give();
-        _load_time_ms = AP_HAL::millis();
+        // nothing to build, swap in the empty set
+        _load_in_progress = true;
         return true;
     }
 
@@ -638,11 +699,9 @@ bool AC_PolyFence_loader::load_from_eeprom()
         const uint16_t count = sum_of_polygon_point_counts_and_returnpoint();
         Debug("Fence: Allocating %u bytes for points",
               (unsigned)(count * sizeof(Vector2f)));
-        _loaded_offsets_from_origin = NEW_NOTHROW Vector2f[count];
-        _loaded_points_lla = NEW_NOTHROW Vector2l[count];
-        if (_loaded_offsets_from_origin == nullptr || _loaded_points_lla == nullptr) {
-            unload();
-            get_loaded_fence_semaphore().give();
+        fences.offsets_from_origin = NEW_NOTHROW Vector2f[count];
+        fences.points_lla = NEW_NOTHROW Vector2l[count];
+        if (fences.offsets_from_origin == nullptr || fences.points_lla == nullptr) {
             return false;
         }
     }
@@ -653,10 +712,8 @@ bool AC_PolyFence_loader::load_from_eeprom()
         const uint8_t count = index_fence_count(AC_PolyFenceType::POLYGON_INCLUSION);
         Debug("Fence: Allocating %u bytes for inc. fences",
               (unsigned)(count * sizeof(InclusionBoundary)));
-        _loaded_inclusion_boundary = NEW_NOTHROW InclusionBoundary[count];
-        if (_loaded_inclusion_boundary == nullptr) {
-            unload();
-            get_loaded_fence_semaphore().give();
+        fences.inclusion_boundary = NEW_NOTHROW InclusionBoundary[count];
+        if (fences.inclusion_boundary == nullptr) {
             return false;
         }
     }
@@ -665,10 +722,8 @@ bool AC_PolyFence_loader::load_from_eeprom()
         const uint8_t count = index_fence_count(AC_PolyFenceType::POLYGON_EXCLUSION);
         Debug("Fence: Allocating %u bytes for exc. fences",
               (unsigned)(count * sizeof(ExclusionBoundary)));
-        _loaded_exclusion_boundary = NEW_NOTHROW ExclusionBoundary[count];
-        if (_loaded_exclusion_boundary == nullptr) {
-            unload();
-            get_loaded_fence_semaphore().give();
+        fences.exclusion_boundary = NEW_NOTHROW ExclusionBoundary[count];
+        if (fences.exclusion_boundary == nullptr) {
             return false;
         }
     }
@@ -678,10 +733,8 @@ bool AC_PolyFence_loader::load_from_eeprom()
         count += index_fence_count(AC_PolyFenceType::CIRCLE_INCLUSION_INT)
         Debug("Fence: Allocating %u bytes for circ. inc. fences",
               (unsigned)(count * sizeof(InclusionCircle)));
-        _loaded_circle_inclusion_boundary = NEW_NOTHROW InclusionCircle[count];
-        if (_loaded_circle_inclusion_boundary == nullptr) {
-            unload();
-            get_loaded_fence_semaphore().give();
+        fences.circle_inclusion_boundary = NEW_NOTHROW InclusionCircle[count];
+        if (fences.circle_inclusion_boundary == nullptr) {
             return false;
         }
     }
@@ -691,24 +744,40 @@ bool AC_PolyFence_loader::load_from_eeprom()
         count += index_fence_count(AC_PolyFenceType::CIRCLE_EXCLUSION_INT)
         Debug("Fence: Allocating %u bytes for circ. exc. fences",
               (unsigned)(count * sizeof(ExclusionCircle)));
-        _loaded_circle_exclusion_boundary = NEW_NOTHROW ExclusionCircle[count];
-        if (_loaded_circle_exclusion_boundary == nullptr) {
-            unload();
-            get_loaded_fence_semaphore().give();
+        fences.circle_exclusion_boundary = NEW_NOTHROW ExclusionCircle[count];
+        if (fences.circle_exclusion_boundary == nullptr) {
             return false;
         }
     }
 
-    Vector2f *next_storage_point = _loaded_offsets_from_origin;
-    Vector2l *next_storage_point_lla = _loaded_points_lla;
+    _load_in_progress = true;
+    return true;
+}
+
+/*
+  load fences from eeprom into fences, starting at _load_next_fence
+  and stopping once at least max_points points have been read.
+  Returns false if storage is invalid
+ */
+bool AC_PolyFence_loader::load_fences(LoadedFences &fences, const uint16_t max_points)
+{
+    if (_load_next_fence >= _eeprom_fence_count) {
+        return true;
+    }
+
+    const Location &ekf_origin = fences.origin;
+    Vector2f *next_storage_point = &fences.offsets_from_origin[_load_next_point];
+    Vector2l *next_storage_point_lla = &fences.points_lla[_load_next_point];
+    uint16_t points_read = 0;
 
     // use index to load fences from eeprom
     bool storage_valid = true;
-    for (uint8_t i=0; i<_eeprom_fence_count; i++) {
+    while (_load_next_fence < _eeprom_fence_count && points_read < max_points) {
         if (!storage_valid) {
             break;
         }
-        const FenceIndex &index = _index[i];
+        const FenceIndex &index = _index[_load_next_fence++];
+        points_read += index.count;
         uint16_t storage_offset = index.storage_offset;
         storage_offset += 1; // skip type
         switch (index.type) {
@@ -720,7 +789,7 @@ bool AC_PolyFence_loader::load_from_eeprom()
             break;
         case AC_PolyFenceType::POLYGON_INCLUSION: {
             // FIXME: consider factoring this with the EXCLUSION case
-            InclusionBoundary &boundary = _loaded_inclusion_boundary[_num_loaded_inclusion_boundaries];
+            InclusionBoundary &boundary = fences.inclusion_boundary[fences.num_inclusion_boundaries];
             boundary.points = next_storage_point;
             boundary.points_lla = next_storage_point_lla;
             boundary.count = index.count;
@@ -730,16 +799,16 @@ bool AC_PolyFence_loader::load_from_eeprom()
                 break;
             }
             storage_offset += 1; // skip vertex count
-            if (!read_polygon_from_storage(ekf_origin, storage_offset, index.count, next_storage_point, next_storage_point_lla)) {
+            if (!read_polygon_from_storage(ekf_origin, index.type, storage_offset, index.count, next_storage_point, next_storage_point_lla, boundary.index, boundary.index_lla)) {
                 GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "AC_Fence: polygon read failed");
                 storage_valid = false;
                 break;
             }
-            _num_loaded_inclusion_boundaries++;
+            fences.num_inclusion_boundaries++;
             break;
         }
         case AC_PolyFenceType::POLYGON_EXCLUSION: {
-            ExclusionBoundary &boundary = _loaded_exclusion_boundary[_num_loaded_exclusion_boundaries];
+            ExclusionBoundary &boundary = fences.exclusion_boundary[fences.num_exclusion_boundaries];
             boundary.points = next_storage_point;
             boundary.points_lla = next_storage_point_lla;
             boundary.count = index.count;
@@ -749,17 +818,17 @@ bool AC_PolyFence_loader::load_from_eeprom()
                 break;
             }
             storage_offset += 1; // skip vertex count
-            if (!read_polygon_from_storage(ekf_origin, storage_offset, index.count, next_storage_point, next_storage_point_lla)) {
+            if (!read_polygon_from_storage(ekf_origin, index.type, storage_offset, index.count, next_storage_point, next_storage_point_lla, boundary.index, boundary.index_lla)) {
                 GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "AC_Fence: polygon read failed");
                 storage_valid = false;
                 break;
             }
-            _num_loaded_exclusion_boundaries++;
+            fences.num_exclusion_boundaries++;
             break;
         }
         case AC_PolyFenceType::CIRCLE_EXCLUSION_INT:
         case AC_PolyFenceType::CIRCLE_EXCLUSION: {
-            ExclusionCircle &circle = _loaded_circle_exclusion_boundary[_num_loaded_circle_exclusion_boundaries];
+            ExclusionCircle &circle = fences.circle_exclusion_boundary[fences.num_circle_exclusion_boundaries];
             if (!read_latlon_from_storage(storage_offset, circle.point)) {
                 GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "AC_Fence: latlon read failed");
                 storage_valid = false;
@@ -781,12 +850,12 @@ bool AC_PolyFence_loader::load_from_eeprom()
                 storage_valid = false;
                 break;
             }
-            _num_loaded_circle_exclusion_boundaries++;
+            fences.num_circle_exclusion_boundaries++;
             break;
         }
         case AC_PolyFenceType::CIRCLE_INCLUSION_INT:
         case AC_PolyFenceType::CIRCLE_INCLUSION: {
-            InclusionCircle &circle = _loaded_circle_inclusion_boundary[_num_loaded_circle_inclusion_boundaries];
+            InclusionCircle &circle = fences.circle_inclusion_boundary[fences.num_circle_inclusion_boundaries];
             if (!read_latlon_from_storage(storage_offset, circle.point)) {
                 GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "AC_Fence: latlon read failed");
                 storage_valid = false;
@@ -808,22 +877,22 @@ bool AC_PolyFence_loader::load_from_eeprom()
                 storage_valid = false;
                 break;
             }
-            _num_loaded_circle_inclusion_boundaries++;
+            fences.num_circle_inclusion_boundaries++;
             break;
         }
         case AC_PolyFenceType::RETURN_POINT:
-            if (_loaded_return_point != nullptr) {
+            if (fences.return_point != nullptr) {
                 GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "PolyFence: Multiple return points found");
                 storage_valid = false;
                 break;
             }
-            _loaded_return_point = next_storage_point;
-            if (_loaded_return_point_lla != nullptr) {
+            fences.return_point = next_storage_point;
+            if (fences.return_point_lla != nullptr) {
                 GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "PolyFence: Multiple return points found");
                 storage_valid = false;
                 break;
             }
-            _loaded_return_point_lla = next_storage_point_lla;
+            fences.return_point_lla = next_storage_point_lla;
             // Read the point from storage
             if (!read_latlon_from_storage(storage_offset, *next_storage_point_lla)) {
                 storage_valid = false;
@@ -841,55 +910,146 @@ bool AC_PolyFence_loader::load_from_eeprom()
         }
     }
 
-    if (!storage_valid) {
-        unload();
-        get_loaded_fence_semaphore().give();
+    _load_next_point = next_storage_point - fences.offsets_from_origin;
+
+    return storage_valid;
+}
+
+/*
+  handle a failure to build a new set of fences
+ */
+bool AC_PolyFence_loader::load_failed(LoadedFences &fences)
+{
+    fences.free();
+    if (_loaded->load_time_ms != 0 && hal.util->get_soft_armed()) {
+        // keep checking against the previous fences rather than
+        // leaving the vehicle without a fence in flight.  The load
+        // is retried once disarmed
+        if (!_keep_failed_load) {
+            GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "PolyFence: load failed, using previous fence");
+        }
+        _keep_failed_load = true;
         return false;
     }
+    _keep_failed_load = false;
 
-    _load_time_ms = AP_HAL::millis();
+    // swap in the empty set so the fences are unloaded
+    _swap_pending = true;
+    UNUSED_RESULT(swap_loaded_fences());
+    return false;
+}
 
+/*
+  swap the newly built set of fences in for fence checks
+ */
+bool AC_PolyFence_loader::swap_loaded_fences()
+{
+    if (!get_loaded_fence_semaphore().take_nonblocking()) {
+        // another thread is using the active set; retry on the next update
+        return false;
+    }
+    LoadedFences *old_fences = _loaded;
+    _loaded = (_loaded == &_fences[0]) ? &_fences[1] : &_fences[0];
+    _swap_pending = false;
+    _keep_failed_load = false;
     get_loaded_fence_semaphore().give();
-    return true;
+
+    old_fences->free();
+
+    return _loaded->load_time_ms != 0;
+}
+
+/*
+  find a polygon in the active set of fences with the same type and
+  points, whose offsets were calculated from origin
+ */
+const AC_PolyFence_loader::LoadedPolygon *AC_PolyFence_loader::find_loaded_polygon(const AC_PolyFenceType type,
+                                                                                    const Vector2l *points_lla,
+                                                                                    uint8_t count,
+                                                                                    const Location &origin) const
+{
+    if (_loaded->load_time_ms == 0 ||
+        _loaded->origin.lat != origin.lat ||
+        _loaded->origin.lng != origin.lng) {
+        return nullptr;
+    }
+    if (type == AC_PolyFenceType::POLYGON_INCLUSION) {
+        for (uint8_t i=0; i<_loaded->num_inclusion_boundaries; i++) {
+            const InclusionBoundary &boundary = _loaded->inclusion_boundary[i];
+            if (boundary.count == count &&
+                memcmp(boundary.points_lla, points_lla, count*sizeof(Vector2l)) == 0) {
+                return &boundary;
+            }
+        }
+    } else if (type == AC_PolyFenceType::POLYGON_EXCLUSION) {
+        for (uint8_t i=0; i<_loaded->num_exclusion_boundaries; i++) {
+            const ExclusionBoundary &boundary = _loaded->exclusion_boundary[i];
+            if (boundary.count == count &&
+                memcmp(boundary.points_lla, points_lla, count*sizeof(Vector2l)) == 0) {
+                return &boundary;
+            }
+        }
+    }
+    return nullptr;
 }
 
+
+
 /// returns pointer to array of exclusion polygon points and num_points is filled in with the number of points in the polygon
 /// points are offsets in cm from EKF origin in NE frame
 Vector2f* AC_PolyFence_loader::get_exclusion_polygon(uint16_t index, uint16_t &num_points) const
 {
-    if (index >= _num_loaded_exclusion_boundaries) {
+    if (index >= _loaded->num_exclusion_boundaries) {
         num_points = 0;
         return nullptr;
     }
-    const ExclusionBoundary &boundary = _loaded_exclusion_boundary[index];
+    const ExclusionBoundary &boundary = _loaded->exclusion_boundary[index];
     num_points = boundary.count;
 
     return boundary.points;
 }
 
+/// returns the spatial index over the points of an exclusion polygon, or nullptr if index is invalid
+const AP_PolygonIndex<float>* AC_PolyFence_loader::get_exclusion_polygon_index(uint16_t index) const
+{
+    if (index >= _loaded->num_exclusion_boundaries) {
+        return nullptr;
+    }
+    return &_loaded->exclusion_boundary[index].index;
+}
+
 /// returns pointer to array of inclusion polygon points and num_points is filled in with the number of points in the polygon
 /// points are offsets in cm from EKF origin in NE frame
 Vector2f* AC_PolyFence_loader::get_inclusion_polygon(uint16_t index, uint16_t &num_points) const
 {
-    if (index >= _num_loaded_inclusion_boundaries) {
+    if (index >= _loaded->num_inclusion_boundaries) {
         num_points = 0;
         return nullptr;
     }
-    const InclusionBoundary &boundary = _loaded_inclusion_boundary[index];
+    const InclusionBoundary &boundary = _loaded->inclusion_boundary[index];
     num_points = boundary.count;
 
     return boundary.points;
 }
 
+/// returns the spatial index over the points of an inclusion polygon, or nullptr if index is invalid
+const AP_PolygonIndex<float>* AC_PolyFence_loader::get_inclusion_polygon_index(uint16_t index) const
+{
+    if (index >= _loaded->num_inclusion_boundaries) {
+        return nullptr;
+    }
+    return &_loaded->inclusion_boundary[index].index;
+}
+
 /// returns the specified exclusion circle
 /// circle center offsets in cm from EKF origin in NE frame, radius is in meters
 bool AC_PolyFence_loader::get_exclusion_circle(uint8_t index, Vector2f &center_pos_cm, float &radius) const
 {
-    if (index >= _num_loaded_circle_exclusion_boundaries) {
+    if (index >= _loaded->num_circle_exclusion_boundaries) {
         return false;
     }
-    center_pos_cm = _loaded_circle_exclusion_boundary[index].pos_cm;
-    radius =  _loaded_circle_exclusion_boundary[index].radius;
+    center_pos_cm = _loaded->circle_exclusion_boundary[index].pos_cm;
+    radius =  _loaded->circle_exclusion_boundary[index].radius;
     return true;
 }
 
@@ -897,19 +1057,19 @@ bool AC_PolyFence_loader::get_exclusion_circle(uint8_t index, Vector2f &center_p
 /// circle centre offsets in cm from EKF origin in NE frame, radius is in meters
 bool AC_PolyFence_loader::get_inclusion_circle(uint8_t index, Vector2f &center_pos_cm, float &radius) const
 {
-    if (index >= _num_loaded_circle_inclusion_boundaries) {
+    if (index >= _loaded->num_circle_inclusion_boundaries) {
         return false;
     }
-    center_pos_cm = _loaded_circle_inclusion_boundary[index].pos_cm;
-    radius =  _loaded_circle_inclusion_boundary[index].radius;
+    center_pos_cm = _loaded->circle_inclusion_boundary[index].pos_cm;
+    radius =  _loaded->circle_inclusion_boundary[index].radius;
     return true;
 }
 
 bool AC_PolyFence_loader::check_inclusion_circle_margin(float margin) const
 {
     // check circular includes
-    for (uint8_t i=0; i<_num_loaded_circle_inclusion_boundaries; i++) {
-        const InclusionCircle &circle = _loaded_circle_inclusion_boundary[i];
+    for (uint8_t i=0; i<_loaded->num_circle_inclusion_boundaries; i++) {
+        const InclusionCircle &circle = _loaded->circle_inclusion_boundary[i];
         if (circle.radius < margin) {
             // circle radius should never be less than margin
             return false;
@@ -1637,6 +1797,11 @@ void AC_PolyFence_loader::update()
         }
     }
 #endif
+    if (_keep_failed_load && !hal.util->get_soft_armed()) {
+        // a load failed in flight and we kept the previous fences;
+        // try again now we are disarmed
+        _load_attempted = false;
+    }
     if (!load_from_eeprom()) {
         return;
     }
@@ -1650,6 +1815,8 @@ bool AC_PolyFence_loader::get_item(const uint16_t seq, AC_PolyFenceItem &item) {
 
 Vector2f* AC_PolyFence_loader::get_exclusion_polygon(uint16_t index, uint16_t &num_points) const { return nullptr; }
 Vector2f* AC_PolyFence_loader::get_inclusion_polygon(uint16_t index, uint16_t &num_points) const { return nullptr; }
+const AP_PolygonIndex<float>* AC_PolyFence_loader::get_exclusion_polygon_index(uint16_t index) const { return nullptr; }
+const AP_PolygonIndex<float>* AC_PolyFence_loader::get_inclusion_polygon_index(uint16_t index) const { return nullptr; }
 
 bool AC_PolyFence_loader::get_exclusion_circle(uint8_t index, Vector2f &center_pos_cm, float &radius) const { return false; }
 bool AC_PolyFence_loader::get_inclusion_circle(uint8_t index, Vector2f &center_pos_cm, float &radius) const { return false; }
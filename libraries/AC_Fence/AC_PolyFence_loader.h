@@ -2,6 +2,7 @@
 
 #include "AC_Fence_config.h"
 #include <AP_Math/AP_Math.h>
+#include <AP_Math/AP_PolygonIndex.h>
 
 // CIRCLE_INCLUSION_INT stores the radius an a 32-bit integer in
 // metres.  This was a bug, and CIRCLE_INCLUSION was created to store
@@ -63,16 +64,19 @@ public:
     ///
     /// returns number of polygon exclusion zones defined
     uint8_t get_exclusion_polygon_count() const {
-        return _num_loaded_exclusion_boundaries;
+        return _loaded->num_exclusion_boundaries;
     }
 
     /// returns pointer to array of exclusion polygon points and num_points is filled in with the number of points in the polygon
     /// points are offsets in cm from EKF origin in NE frame
     Vector2f* get_exclusion_polygon(uint16_t index, uint16_t &num_points) const;
 
+    /// returns the spatial index over the points of an exclusion polygon, or nullptr if index is invalid
+    const AP_PolygonIndex<float>* get_exclusion_polygon_index(uint16_t index) const;
+
     /// return system time of last update to the exclusion polygon points
     uint32_t get_exclusion_polygon_update_ms() const {
-        return _load_time_ms;
+        return _loaded->load_time_ms;
     }
 
     ///
@@ -80,16 +84,19 @@ public:
     ///
     /// returns number of polygon inclusion zones defined
     uint8_t get_inclusion_polygon_count() const {
-        return _num_loaded_inclusion_boundaries;
+        return _loaded->num_inclusion_boundaries;
     }
 
     /// returns pointer to array of inclusion polygon points and num_points is filled in with the number of points in the polygon
     /// points are offsets in cm from EKF origin in NE frame
     Vector2f* get_inclusion_polygon(uint16_t index, uint16_t &num_points) const;
 
+    /// returns the spatial index over the points of an inclusion polygon, or nullptr if index is invalid
+    const AP_PolygonIndex<float>* get_inclusion_polygon_index(uint16_t index) const;
+
     /// return system time of last update to the inclusion polygon points
     uint32_t get_inclusion_polygon_update_ms() const {
-        return _load_time_ms;
+        return _loaded->load_time_ms;
     }
 
     ///
@@ -97,7 +104,7 @@ public:
     ///
     /// returns number of exclusion circles defined
     uint8_t get_exclusion_circle_count() const {
-        return _num_loaded_circle_exclusion_boundaries;
+        return _loaded->num_circle_exclusion_boundaries;
     }
 
     /// returns the specified exclusion circle
@@ -106,7 +113,7 @@ public:
 
     /// return system time of last update to the exclusion circles
     uint32_t get_exclusion_circle_update_ms() const {
-        return _load_time_ms;
+        return _loaded->load_time_ms;
     }
 
     ///
@@ -114,7 +121,7 @@ public:
     ///
     /// returns number of inclusion circles defined
     uint8_t get_inclusion_circle_count() const {
-        return _num_loaded_circle_inclusion_boundaries;
+        return _loaded->num_circle_inclusion_boundaries;
     }
 
     /// returns the specified inclusion circle
@@ -137,13 +144,13 @@ public:
 
     // returns true if a polygonal include fence could be returned
     bool inclusion_boundary_available() const WARN_IF_UNUSED {
-        return _num_loaded_inclusion_boundaries != 0;
+        return _loaded->num_inclusion_boundaries != 0;
     }
 
     // loaded - returns true if the fences have been loaded from
     // storage and are available for use
     bool loaded() const WARN_IF_UNUSED {
-        return _load_time_ms != 0;
+        return _loaded->load_time_ms != 0;
     };
 
     // maximum number of fence points we can store in eeprom
@@ -159,9 +166,10 @@ public:
      * locations are translated into offset-from-origin-in-metres
      */
 
-    // load polygon points stored in eeprom into
-    // _loaded_offsets_from_origin and perform validation.  returns
-    // true if load successfully completed
+    // load polygon points stored in eeprom into a new set of fences
+    // and perform validation, then swap the new set in for fence
+    // checks.  The active set is used until the swap.  returns true
+    // if load successfully completed
     bool load_from_eeprom() WARN_IF_UNUSED;
 
     // allow threads to lock against AHRS update
@@ -229,7 +237,7 @@ private:
 
     // find_index_for_seq - returns true if seq is contained within a
     // fence.  If it is, entry will be the relevant FenceIndex.  i
-    // will be the offset within _loaded_offsets_from_origin where the
+    // will be the offset within offsets_from_origin where the
     // first point in the fence is found
     bool find_index_for_seq(const uint16_t seq, const FenceIndex *&entry, uint16_t &i) const WARN_IF_UNUSED;
     // find_storage_offset_for_seq - uses the index to return an
@@ -270,44 +278,20 @@ private:
      * locations are translated into offset-from-origin-in-metres
      */
 
-    // remove resources dedicated to the transformed fences - for
-    // example, in _loaded_offsets_from_origin
-    void unload();
-
-    // pointer into _loaded_offsets_from_origin where the return point
-    // can be found:
-    Vector2f *_loaded_return_point;
-
-    // pointer into _loaded_points_lla where the return point
-    // can be found:
-    Vector2l *_loaded_return_point_lla;
-
-    class InclusionBoundary {
+    class LoadedPolygon {
     public:
-        Vector2f *points; // pointer into the _loaded_offsets_from_origin array
-        Vector2l *points_lla; // pointer into the _loaded_points_lla array
+        Vector2f *points; // pointer into the offsets_from_origin array
+        Vector2l *points_lla; // pointer into the points_lla array
         uint8_t count; // count of points in the boundary
+        AP_PolygonIndex<float> index; // spatial index over points
+        AP_PolygonIndex<int32_t> index_lla; // spatial index over points_lla
     };
-    InclusionBoundary *_loaded_inclusion_boundary;
-
-    uint8_t _num_loaded_inclusion_boundaries;
 
-    class ExclusionBoundary {
-    public:
-        Vector2f *points; // pointer into the _loaded_offsets_from_origin array
-        Vector2l *points_lla; // pointer into the _loaded_points_lla_lla array
-        uint8_t count; // count of points in the boundary
+    class InclusionBoundary : public LoadedPolygon {
     };
-    ExclusionBoundary *_loaded_exclusion_boundary;
-
-    uint8_t _num_loaded_exclusion_boundaries;
 
-    // _loaded_offsets_from_origin - stores x/y offset-from-origin
-    // coordinate pairs.  Various items store their locations in this
-    // allocation - the polygon boundaries and the return point, for
-    // example.
-    Vector2f *_loaded_offsets_from_origin;
-    Vector2l *_loaded_points_lla;
+    class ExclusionBoundary : public LoadedPolygon {
+    };
 
     class ExclusionCircle {
     public:
@@ -315,9 +299,6 @@ private:
         Vector2l point;  // lat/lng of zone
         float radius;
     };
-    ExclusionCircle *_loaded_circle_exclusion_boundary;
-    
-    uint8_t _num_loaded_circle_exclusion_boundaries;
 
     class InclusionCircle {
     public:
@@ -325,19 +306,107 @@ private:
         Vector2l point;       // lat/lng of zone
         float radius;
     };
-    InclusionCircle *_loaded_circle_inclusion_boundary;
 
-    uint8_t _num_loaded_circle_inclusion_boundaries;
+    // LoadedFences - a complete set of fences loaded from storage.
+    // Two sets are kept so a new set can be built while the active
+    // set is still being used for fence checks, then swapped in
+    class LoadedFences {
+    public:
+        LoadedFences() {}
+        ~LoadedFences() { free(); }
+
+        /* Do not allow copies */
+        CLASS_NO_COPY(LoadedFences);
+
+        // remove resources dedicated to the transformed fences
+        void free();
+
+        InclusionBoundary *inclusion_boundary;
+        uint8_t num_inclusion_boundaries;
+
+        ExclusionBoundary *exclusion_boundary;
+        uint8_t num_exclusion_boundaries;
+
+        ExclusionCircle *circle_exclusion_boundary;
+        uint8_t num_circle_exclusion_boundaries;
+
+        InclusionCircle *circle_inclusion_boundary;
+        uint8_t num_circle_inclusion_boundaries;
+
+        // offsets_from_origin - stores x/y offset-from-origin
+        // coordinate pairs.  Various items store their locations in
+        // this allocation - the polygon boundaries and the return
+        // point, for example.
+        Vector2f *offsets_from_origin;
+        Vector2l *points_lla;
+
+        // pointer into offsets_from_origin where the return point
+        // can be found:
+        Vector2f *return_point;
+
+        // pointer into points_lla where the return point can be
+        // found:
+        Vector2l *return_point_lla;
+
+        // origin the offsets were calculated from
+        Location origin;
+
+        // load_time_ms - from millis(), system time when fence load
+        // succeeded.  Will be zero if fences are not loaded
+        uint32_t load_time_ms;
+    };
+    LoadedFences _fences[2];
+
+    // _loaded - the set of fences used for fence checks
+    LoadedFences *_loaded = &_fences[0];
+
+    // _swap_pending - true if the other set has been built and is
+    // waiting for the loaded fence semaphore to be swapped in
+    bool _swap_pending;
+
+    // _keep_failed_load - true if a load failed while armed and
+    // _loaded is the previous set of fences, kept so the vehicle is
+    // never left without a fence in flight
+    bool _keep_failed_load;
+
+    // _load_in_progress - true while a new set of fences is being
+    // built a slice at a time by load_from_eeprom
+    bool _load_in_progress;
+    // index of the next fence in _index to be loaded into the new set
+    uint8_t _load_next_fence;
+    // offset into offsets_from_origin/points_lla of the new set where
+    // the next polygon or return point goes
+    uint16_t _load_next_point;
+
+    // start_load - free and reallocate fences ready to be built from
+    // the index.  Returns false if allocation failed
+    bool start_load(LoadedFences &fences, const Location &ekf_origin) WARN_IF_UNUSED;
+
+    // load_fences - load fences from storage into fences starting at
+    // _load_next_fence, stopping once max_points points have been
+    // read.  Returns false if storage is invalid
+    bool load_fences(LoadedFences &fences, uint16_t max_points) WARN_IF_UNUSED;
+
+    // load_failed - free a partly built set of fences.  Unloads the
+    // active fences unless armed.  Always returns false
+    bool load_failed(LoadedFences &fences);
+
+    // swap the newly built set of fences in for fence checks.
+    // Returns false if the swap must be retried later
+    bool swap_loaded_fences() WARN_IF_UNUSED;
+
+    // find_loaded_polygon - returns a polygon in the active set with
+    // the same type and points as points_lla, if its offsets were
+    // calculated from origin
+    const LoadedPolygon *find_loaded_polygon(const AC_PolyFenceType type,
+                                        const Vector2l *points_lla,
+                                        uint8_t count,
+                                        const Location &origin) const;
 
     // _load_attempted - true if we have attempted to load the fences
-    // from storage into _loaded_circle_exclusion_boundary,
-    // _loaded_offsets_from_origin etc etc
+    // from storage into _fences
     bool _load_attempted;
 
-    // _load_time_ms - from millis(), system time when fence load last
-    // succeeded.  Will be zero if fences are not loaded
-    uint32_t _load_time_ms;
-
     // scale_latlon_from_origin - given a latitude/longitude
     // transforms the point to an offset-from-origin and deposits
     // the result into pos_cm.
@@ -348,12 +417,17 @@ private:
     // read_polygon_from_storage - reads vertex_count
     // latitude/longitude points from offset in permanent storage,
     // transforms them into an offset-from-origin and deposits the
-    // results into next_storage_point.
+    // results into next_storage_point, then builds the spatial
+    // indexes over them.  Offsets and indexes are copied from the
+    // active set of fences if it holds the same polygon.
     bool read_polygon_from_storage(const Location &origin,
+                                   const AC_PolyFenceType type,
                                    uint16_t &read_offset,
                                    const uint8_t vertex_count,
                                    Vector2f *&next_storage_point,
-                                   Vector2l *&next_storage_point_lla) WARN_IF_UNUSED;
+                                   Vector2l *&next_storage_point_lla,
+                                   AP_PolygonIndex<float> &index,
+                                   AP_PolygonIndex<int32_t> &index_lla) WARN_IF_UNUSED;
 
 #if AC_POLYFENCE_FENCE_POINT_PROTOCOL_SUPPORT
     /*
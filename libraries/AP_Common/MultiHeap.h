@@ -3,6 +3,9 @@
   multiple underlying heaps to cope with multiple memory regions on
   STM32 boards
  */
+#pragma once
+
+#include <stdint.h>
 
 class MultiHeap {
 public:
@@ -0,0 +1,154 @@
+/*
+  size class pool allocator layered on a MultiHeap
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+#include <string.h>
+
+#include "PoolHeap.h"
+
+#ifndef HAL_BOOTLOADER_BUILD
+
+/*
+  carve a new slab from the heap into free blocks of a size class
+ */
+bool PoolHeap::add_slab(uint8_t cls)
+{
+    if (slab_bytes + slab_size > max_slab_bytes) {
+        return false;
+    }
+    Slab *slab = (Slab *)heap.allocate(slab_size);
+    if (slab == nullptr) {
+        return false;
+    }
+    slab->next = slabs[cls];
+    slabs[cls] = slab;
+    slab_bytes += slab_size;
+
+    const uint32_t block_size = class_size(cls);
+    uint8_t *block = slab->blocks();
+    const uint8_t *end = (const uint8_t *)slab + slab_size;
+    while (block + block_size <= end) {
+        FreeBlock *b = (FreeBlock *)block;
+        b->next = free_list[cls];
+        free_list[cls] = b;
+        block += block_size;
+    }
+    return true;
+}
+
+// return true if ptr is in one of the slabs of a size class
+bool PoolHeap::in_slab(const void *ptr, uint8_t cls) const
+{
+    const uint8_t *p = (const uint8_t *)ptr;
+    for (const Slab *slab = slabs[cls]; slab != nullptr; slab = slab->next) {
+        if (p >= (const uint8_t *)slab && p < (const uint8_t *)slab + slab_size) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void *PoolHeap::allocate_small(uint8_t cls)
+{
+    if (free_list[cls] == nullptr && !add_slab(cls)) {
+        // the pool is full, fall back to the heap, allocating the
+        // whole block so the size stays consistent with the class
+        void *ptr = heap.allocate(class_size(cls));
+        if (ptr != nullptr) {
+            heap_small_allocations++;
+        }
+        return ptr;
+    }
+    FreeBlock *b = free_list[cls];
+    free_list[cls] = b->next;
+    stats.pool_allocations++;
+    return b;
+}
+
+void PoolHeap::free_small(void *ptr, uint8_t cls)
+{
+    if (heap_small_allocations > 0 && !in_slab(ptr, cls)) {
+        heap.deallocate(ptr);
+        heap_small_allocations--;
+        return;
+    }
+    FreeBlock *b = (FreeBlock *)ptr;
+    b->next = free_list[cls];
+    free_list[cls] = b;
+}
+
+/*
+  change size of an allocation
+ */
+void *PoolHeap::change_size(void *ptr, uint32_t old_size, uint32_t new_size)
+{
+    if (ptr == nullptr) {
+        // old_size may carry other information, as with Lua
+        old_size = 0;
+    }
+
+    if (new_size == 0) {
+        if (ptr != nullptr) {
+            stats.frees++;
+            if (old_size <= max_pool_size) {
+                free_small(ptr, size_class(old_size));
+            } else {
+                heap.deallocate(ptr);
+            }
+        }
+        return nullptr;
+    }
+
+    stats.allocations++;
+    stats.bytes_allocated += new_size;
+
+    if (old_size > max_pool_size && new_size > max_pool_size) {
+        return heap.change_size(ptr, old_size, new_size);
+    }
+    if (old_size == 0 && new_size > max_pool_size) {
+        return heap.allocate(new_size);
+    }
+    if (old_size != 0 && size_class(old_size) == size_class(new_size)) {
+        // fits in the same block
+        return ptr;
+    }
+
+    void *new_ptr;
+    if (new_size <= max_pool_size) {
+        new_ptr = allocate_small(size_class(new_size));
+    } else {
+        new_ptr = heap.allocate(new_size);
+    }
+    if (new_ptr == nullptr || ptr == nullptr) {
+        return new_ptr;
+    }
+
+    memcpy(new_ptr, ptr, MIN(old_size, new_size));
+    if (old_size <= max_pool_size) {
+        free_small(ptr, size_class(old_size));
+    } else {
+        heap.deallocate(ptr);
+    }
+    return new_ptr;
+}
+
+/*
+  return the slabs to the heap
+ */
+void PoolHeap::reset(void)
+{
+    for (uint8_t cls=0; cls<num_classes; cls++) {
+        while (slabs[cls] != nullptr) {
+            Slab *slab = slabs[cls];
+            slabs[cls] = slab->next;
+            heap.deallocate(slab);
+        }
+        free_list[cls] = nullptr;
+    }
+    slab_bytes = 0;
+    heap_small_allocations = 0;
+}
+
+#endif // HAL_BOOTLOADER_BUILD
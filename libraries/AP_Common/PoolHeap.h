@@ -0,0 +1,88 @@
+/*
+  size class pool allocator layered on a MultiHeap. Small allocations
+  come from free lists of fixed size blocks carved out of slabs taken
+  from the heap, which is much quicker than the heap and has no per
+  allocation overhead. Larger allocations go to the heap.
+
+  Slabs are only returned to the heap by reset(), once every pooled
+  allocation has been freed, so the memory in slabs is limited.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "MultiHeap.h"
+
+class PoolHeap {
+public:
+    PoolHeap(MultiHeap &_heap) :
+        heap(_heap),
+        slab_bytes(0),
+        max_slab_bytes(0),
+        heap_small_allocations(0) {}
+
+    // largest allocation which comes from the pool
+    static const uint8_t max_pool_size = 64;
+
+    // limit the memory in slabs, beyond which small allocations go
+    // to the heap
+    void set_slab_limit(uint32_t bytes) { max_slab_bytes = bytes; }
+
+    // allocate, free or change the size of an allocation. As with
+    // MultiHeap this requires the old size
+    void *change_size(void *ptr, uint32_t old_size, uint32_t new_size);
+
+    void *allocate(uint32_t size) { return change_size(nullptr, 0, size); }
+    void deallocate(void *ptr, uint32_t size) { change_size(ptr, size, 0); }
+
+    // return the slabs to the heap and forget all allocations. Any
+    // still outstanding must not be used or freed afterwards
+    void reset(void);
+
+    struct Stats {
+        uint32_t allocations;       // allocations and changes of size
+        uint32_t pool_allocations;  // allocations from the pool
+        uint32_t frees;
+        uint32_t bytes_allocated;
+    };
+    const Stats &get_stats(void) const { return stats; }
+
+    // memory held in slabs
+    uint32_t get_slab_bytes(void) const { return slab_bytes; }
+
+private:
+    MultiHeap &heap;
+
+    static const uint8_t granularity = 8;
+    static const uint8_t num_classes = max_pool_size / granularity;
+    static const uint16_t slab_size = 1024;
+
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+    struct Slab {
+        Slab *next;
+        // followed by blocks of the slab's size class
+        uint8_t *blocks() { return (uint8_t *)this + slab_header_size; }
+    };
+    static const uint8_t slab_header_size = (sizeof(Slab) + granularity - 1) & ~(granularity - 1);
+
+    FreeBlock *free_list[num_classes] {};
+    Slab *slabs[num_classes] {};
+    uint32_t slab_bytes;
+    uint32_t max_slab_bytes;
+
+    // small allocations taken from the heap because the pool was
+    // full. While there are none every small block is in a slab
+    uint32_t heap_small_allocations;
+
+    Stats stats {};
+
+    static uint8_t size_class(uint32_t size) { return (size - 1) / granularity; }
+    static uint32_t class_size(uint8_t cls) { return (cls + 1) * granularity; }
+
+    void *allocate_small(uint8_t cls);
+    void free_small(void *ptr, uint8_t cls);
+    bool add_slab(uint8_t cls);
+    bool in_slab(const void *ptr, uint8_t cls) const;
+};
@@ -0,0 +1,140 @@
+#include <AP_gtest.h>
+#include <AP_HAL/AP_HAL.h>
+
+#include <AP_Common/PoolHeap.h>
+#include <AP_Math/AP_Math.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#define HEAP_SIZE 65536
+
+struct Allocation {
+    uint8_t *ptr;
+    uint32_t size;
+    uint8_t fill;
+};
+
+static bool check_fill(const Allocation &a)
+{
+    for (uint32_t i=0; i<a.size; i++) {
+        if (a.ptr[i] != a.fill) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+  allocate, resize and free at random, checking the contents of every
+  allocation survive
+ */
+static void random_allocations(PoolHeap &pool)
+{
+    Allocation allocs[200] {};
+    for (uint32_t step=0; step<20000; step++) {
+        Allocation &a = allocs[get_random16() % ARRAY_SIZE(allocs)];
+        // mostly small sizes, as Lua uses
+        const uint32_t new_size = (get_random16() % 8) == 0 ? 65 + get_random16() % 200 : 1 + get_random16() % PoolHeap::max_pool_size;
+        switch (get_random16() % 3) {
+        case 0:
+            if (a.ptr != nullptr) {
+                ASSERT_TRUE(check_fill(a));
+                pool.deallocate(a.ptr, a.size);
+                a.ptr = nullptr;
+            }
+            break;
+        case 1: {
+            if (a.ptr != nullptr) {
+                break;
+            }
+            a.ptr = (uint8_t *)pool.allocate(new_size);
+            ASSERT_NE(a.ptr, nullptr);
+            a.size = new_size;
+            a.fill = step;
+            memset(a.ptr, a.fill, a.size);
+            break;
+        }
+        case 2:
+            if (a.ptr == nullptr) {
+                break;
+            }
+            ASSERT_TRUE(check_fill(a));
+            a.ptr = (uint8_t *)pool.change_size(a.ptr, a.size, new_size);
+            ASSERT_NE(a.ptr, nullptr);
+            a.size = MIN(a.size, new_size);
+            ASSERT_TRUE(check_fill(a));
+            a.size = new_size;
+            a.fill = step;
+            memset(a.ptr, a.fill, a.size);
+            break;
+        }
+    }
+    for (Allocation &a : allocs) {
+        if (a.ptr != nullptr) {
+            ASSERT_TRUE(check_fill(a));
+            pool.deallocate(a.ptr, a.size);
+        }
+    }
+}
+
+TEST(PoolHeap, RandomAllocations)
+{
+    MultiHeap heap;
+    ASSERT_TRUE(heap.create(HEAP_SIZE, 1));
+    PoolHeap pool(heap);
+    pool.set_slab_limit(HEAP_SIZE / 4);
+
+    random_allocations(pool);
+
+    const PoolHeap::Stats &stats = pool.get_stats();
+    EXPECT_GT(stats.pool_allocations, 0U);
+    EXPECT_LE(pool.get_slab_bytes(), uint32_t(HEAP_SIZE / 4));
+
+    // with the slabs returned the whole heap is available again
+    pool.reset();
+    EXPECT_EQ(pool.get_slab_bytes(), 0U);
+    void *all = heap.allocate(HEAP_SIZE);
+    EXPECT_NE(all, nullptr);
+    heap.deallocate(all);
+
+    heap.destroy();
+}
+
+// small allocations go to the heap once the slabs are full
+TEST(PoolHeap, SlabLimit)
+{
+    MultiHeap heap;
+    ASSERT_TRUE(heap.create(HEAP_SIZE, 1));
+    PoolHeap pool(heap);
+    pool.set_slab_limit(2048);
+
+    random_allocations(pool);
+
+    const PoolHeap::Stats &stats = pool.get_stats();
+    EXPECT_LT(stats.pool_allocations, stats.allocations);
+    EXPECT_LE(pool.get_slab_bytes(), 2048U);
+
+    pool.reset();
+    void *all = heap.allocate(HEAP_SIZE);
+    EXPECT_NE(all, nullptr);
+    heap.deallocate(all);
+
+    heap.destroy();
+}
+
+// with no slabs allowed everything goes to the heap
+TEST(PoolHeap, NoSlabs)
+{
+    MultiHeap heap;
+    ASSERT_TRUE(heap.create(HEAP_SIZE, 1));
+    PoolHeap pool(heap);
+
+    random_allocations(pool);
+
+    EXPECT_EQ(pool.get_stats().pool_allocations, 0U);
+    EXPECT_EQ(pool.get_slab_bytes(), 0U);
+
+    heap.destroy();
+}
+
+AP_GTEST_MAIN()
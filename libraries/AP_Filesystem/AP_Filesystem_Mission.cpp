@@ -416,31 +416,42 @@ bool AP_Filesystem_Mission::finish_upload_mission(const struct header &hdr, cons
     if ((hdr.options & unsigned(Options::NO_CLEAR)) == 0) {
         mission->clear();
     }
-    for (uint32_t i=0; i<hdr.num_items; i++) {
-        mavlink_mission_item_int_t m {};
-        AP_Mission::Mission_Command cmd;
-        const uint8_t item_size = MAVLINK_MSG_ID_MISSION_ITEM_INT_LEN;
-        memcpy(&m, &b[sizeof(hdr)+i*item_size], item_size);
-        const MAV_MISSION_RESULT res = AP_Mission::mavlink_int_to_mission_cmd(m, cmd);
-        if (res != MAV_MISSION_ACCEPTED) {
-            return false;
-        }
-        if (cmd.id == MAV_CMD_DO_JUMP &&
-            (cmd.content.jump.target >= hdr.num_items || cmd.content.jump.target == 0)) {
-            return false;
-        }
-        uint16_t idx = i + hdr.start;
-        if (idx == mission->num_commands()) {
-            if (!mission->add_cmd(cmd)) {
-                return false;
+    // decode the items in chunks and write each chunk with a single
+    // call, so the number of commands is only saved once per chunk
+    const uint8_t chunk_size = 16;
+    AP_Mission::Mission_Command *cmds = NEW_NOTHROW AP_Mission::Mission_Command[chunk_size];
+    if (cmds == nullptr) {
+        return false;
+    }
+    bool ret = true;
+    for (uint32_t i=0; i<hdr.num_items && ret; i+=chunk_size) {
+        const uint16_t count = MIN(uint32_t(chunk_size), hdr.num_items - i);
+        uint16_t num_valid = 0;
+        for (; num_valid<count; num_valid++) {
+            mavlink_mission_item_int_t m {};
+            AP_Mission::Mission_Command &cmd = cmds[num_valid];
+            const uint8_t item_size = MAVLINK_MSG_ID_MISSION_ITEM_INT_LEN;
+            memcpy(&m, &b[sizeof(hdr)+(i+num_valid)*item_size], item_size);
+            const MAV_MISSION_RESULT res = AP_Mission::mavlink_int_to_mission_cmd(m, cmd);
+            if (res != MAV_MISSION_ACCEPTED) {
+                ret = false;
+                break;
             }
-        } else {
-            if (!mission->replace_cmd(idx, cmd)) {
-                return false;
+            if (cmd.id == MAV_CMD_DO_JUMP &&
+                (cmd.content.jump.target >= hdr.num_items || cmd.content.jump.target == 0)) {
+                ret = false;
+                break;
             }
         }
+        // items before an invalid item are kept, as they are when
+        // items are written one at a time. A chunk may overwrite
+        // existing commands and extend the mission
+        if (num_valid > 0 && !mission->write_cmds(i + hdr.start, cmds, num_valid)) {
+            ret = false;
+        }
     }
-    return true;
+    delete[] cmds;
+    return ret;
 }
 #endif  // AP_MISSION_ENABLED
 
@@ -26,6 +26,7 @@
 #include <AP_CANManager/AP_CANManager.h>
 #include <AP_Scheduler/AP_Scheduler.h>
 #include <AP_Common/ExpandingString.h>
+#include <StorageManager/StorageManager.h>
 
 extern const AP_HAL::HAL& hal;
 
@@ -83,6 +84,7 @@ int AP_Filesystem_Sys::open(const char *fname, int flags, bool allow_absolute_pa
         return -1;
     }
     struct rfile &r = file[idx];
+    r.storage = false;
     r.str = NEW_NOTHROW ExpandingString;
     if (r.str == nullptr) {
         errno = ENOMEM;
@@ -153,6 +155,7 @@ int AP_Filesystem_Sys::open(const char *fname, int flags, bool allow_absolute_pa
         size_t size = 0;
         if (hal.storage->get_storage_ptr(ptr, size)) {
             r.str->set_buffer((char*)ptr, size, size);
+            r.storage = true;
         }
     }
 #if AP_FILESYSTEM_SYS_FLASH_ENABLED
@@ -196,6 +199,10 @@ int32_t AP_Filesystem_Sys::read(int fd, void *buf, uint32_t count)
     struct rfile &r = file[fd];
     count = MIN(count, r.str->get_length() - r.file_ofs);
     memcpy(buf, &r.str->get_string()[r.file_ofs], count);
+    if (r.storage) {
+        // keys such as the MAVLink signing key must stay secret
+        StorageManager::redact_keys(r.file_ofs, (uint8_t *)buf, count);
+    }
 
     r.file_ofs += count;
     return count;
@@ -50,6 +50,7 @@ private:
         bool open;
         uint32_t file_ofs;
         ExpandingString *str;
+        bool storage;   // str is storage, which holds keys
     } file[max_open_file];
 };
 
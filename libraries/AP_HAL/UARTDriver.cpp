@@ -91,6 +91,22 @@ size_t AP_HAL::UARTDriver::write(const uint8_t *buffer, size_t size)
     return _write(buffer, size);
 }
 
+/*
+   reserve space in the write buffer to be filled in directly
+*/
+uint8_t AP_HAL::UARTDriver::reserve_write(ByteBuffer::IoVec vec[2], uint32_t len)
+{
+    if (lock_write_key != 0 || len == 0) {
+        return 0;
+    }
+    return _reserve_write(vec, len);
+}
+
+bool AP_HAL::UARTDriver::commit_write(uint32_t len)
+{
+    return _commit_write(len);
+}
+
 size_t AP_HAL::UARTDriver::write(uint8_t c)
 {
     return write(&c, 1);
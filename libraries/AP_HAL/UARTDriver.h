@@ -4,6 +4,7 @@
 
 #include "AP_HAL_Namespace.h"
 #include "utility/BetterStream.h"
+#include "utility/RingBuffer.h"
 #include <AP_Logger/AP_Logger_config.h>
 
 #ifndef HAL_UART_STATS_ENABLED
@@ -15,7 +16,6 @@
 #endif
 
 class ExpandingString;
-class ByteBuffer;
 
 /* Pure virtual UARTDriver class */
 class AP_HAL::UARTDriver : public AP_HAL::BetterStream {
@@ -79,6 +79,20 @@ public:
     // read buffer from a locked port. If port is locked and key is not correct then -1 is returned
     ssize_t read_locked(uint8_t *buf, size_t count, uint32_t key) WARN_IF_UNUSED;
 
+    /*
+      reserve len bytes of the write buffer to be filled in directly,
+      rather than assembled elsewhere and copied in with write().
+      Returns the number of parts of vec filled in, or zero if the
+      backend doesn't support reserved writes, the port is write
+      locked or there is less than len bytes of space. After a
+      successful reserve, commit_write() must be called before any
+      other write to the port
+     */
+    uint8_t reserve_write(ByteBuffer::IoVec vec[2], uint32_t len) WARN_IF_UNUSED;
+
+    // make len bytes of the reserved space available to be sent
+    bool commit_write(uint32_t len);
+
     // get current parity for passthrough use
     uint8_t get_parity(void);
     
@@ -100,6 +114,7 @@ public:
         OPTION_MAVLINK_NO_FORWARD = (1U<<10), // don't forward MAVLink data to or from this device
         OPTION_NOFIFO             = (1U<<11), // disable hardware FIFO
         OPTION_NOSTREAMOVERRIDE   = (1U<<12), // don't allow GCS to override streamrates
+        OPTION_MAVLINK_STREAM_BUDGET = (1U<<13), // limit MAVLink streams to the measured link throughput
     };
 
     enum flow_control {
@@ -231,6 +246,13 @@ protected:
      */
     virtual size_t _write(const uint8_t *buffer, size_t size) = 0;
 
+    /*
+      backend reserved write methods. Backends holding a lock while
+      space is reserved release it in _commit_write()
+     */
+    virtual uint8_t _reserve_write(ByteBuffer::IoVec vec[2], uint32_t len) { return 0; }
+    virtual bool _commit_write(uint32_t len) { return false; }
+
     /*
       backend read method
      */
@@ -785,6 +785,33 @@ size_t UARTDriver::_write(const uint8_t *buffer, size_t size)
     return ret;
 }
 
+/*
+  reserve space in the write buffer. The write mutex is held until
+  _commit_write()
+ */
+uint8_t UARTDriver::_reserve_write(ByteBuffer::IoVec vec[2], uint32_t len)
+{
+    if (!_tx_initialised) {
+        return 0;
+    }
+    _write_mutex.take_blocking();
+    if (_writebuf.space() < len) {
+        _write_mutex.give();
+        return 0;
+    }
+    return _writebuf.reserve(vec, len);
+}
+
+bool UARTDriver::_commit_write(uint32_t len)
+{
+    const bool ret = _writebuf.commit(len);
+    _write_mutex.give();
+    if (unbuffered_writes) {
+        chEvtSignal(uart_thread_ctx, EVT_TRANSMIT_DATA_READY);
+    }
+    return ret;
+}
+
 /*
   wait for data to arrive, or a timeout. Return true if data has
   arrived, false on timeout
@@ -298,6 +298,32 @@ size_t UARTDriver::_write(const uint8_t *buffer, size_t size)
     return ret;
 }
 
+/*
+  reserve len bytes of the write buffer. The write mutex is held
+  until _commit_write()
+ */
+uint8_t UARTDriver::_reserve_write(ByteBuffer::IoVec vec[2], uint32_t len)
+{
+    if (!_initialised) {
+        return 0;
+    }
+    if (!_write_mutex.take_nonblocking()) {
+        return 0;
+    }
+    if (_writebuf.space() < len) {
+        _write_mutex.give();
+        return 0;
+    }
+    return _writebuf.reserve(vec, len);
+}
+
+bool UARTDriver::_commit_write(uint32_t len)
+{
+    const bool ret = _writebuf.commit(len);
+    _write_mutex.give();
+    return ret;
+}
+
 /*
   try writing n bytes, handling an unresponsive port
  */
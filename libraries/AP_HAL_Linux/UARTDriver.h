@@ -98,6 +98,8 @@ protected:
     void _flush() override;
     uint32_t _available() override;
     size_t _write(const uint8_t *buffer, size_t size) override;
+    uint8_t _reserve_write(ByteBuffer::IoVec vec[2], uint32_t len) override;
+    bool _commit_write(uint32_t len) override;
     ssize_t _read(uint8_t *buffer, uint16_t count) override WARN_IF_UNUSED;
 };
 
@@ -288,6 +288,10 @@ void HAL_SITL::run(int argc, char * const argv[], Callbacks* callbacks) const
         }
         callbacks->loop();
         HALSITL::Scheduler::_run_io_procs();
+#if !defined(HAL_BUILD_AP_PERIPH)
+        // the main thread holds no semaphores here, so it is safe to fork
+        _sitl_state->snapshot_update();
+#endif
 
         uint32_t now = AP_HAL::millis();
         if (now - last_watchdog_save >= 100 && using_watchdog) {
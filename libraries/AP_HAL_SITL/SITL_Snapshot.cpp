@@ -0,0 +1,158 @@
+/*
+  snapshot and restore of a running SITL vehicle
+
+  SIGUSR1 takes a snapshot. At the end of a main loop, where the main
+  thread holds no semaphores, the other threads are paused where they
+  wait without holding a semaphore, and the process forks. The parent
+  keeps the complete state at the time of the snapshot and waits with
+  its other threads paused, so they don't act on the file descriptors
+  it shares with the child, while the child carries on. SIGUSR2
+  restores the snapshot: the running child exits, and the parent forks
+  a new child which carries on from the snapshot. Any number of
+  scenarios can be branched from one converged, airborne snapshot this
+  way.
+
+  Signals are sent to the original process. Only the main thread takes
+  them, the other threads block them. A process holding a snapshot
+  passes them on to its child, so snapshots nest, and SIGUSR2 goes back
+  to the most recent snapshot.
+
+  Only the main thread is copied by fork(), so each branch starts the
+  other threads again from the beginning of their thread functions,
+  with their original priorities.
+  File descriptors, including the GCS connections, are shared with the
+  process holding the snapshot, so links stay up across a restore.
+ */
+#include <AP_HAL/AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL && !defined(HAL_BUILD_AP_PERIPH)
+
+#include "AP_HAL_SITL.h"
+#include "AP_HAL_SITL_Namespace.h"
+#include "HAL_SITL_Class.h"
+#include "Scheduler.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+extern const AP_HAL::HAL& hal;
+
+using namespace HALSITL;
+
+// exit status of a branch which asks for the snapshot to be restored
+#define SITL_SNAPSHOT_RESTORE_EXIT 97
+
+// wall clock time allowed for the other threads to pause
+#define SITL_SNAPSHOT_PAUSE_TIMEOUT_MS 2000
+
+static volatile sig_atomic_t snapshot_requested;
+static volatile sig_atomic_t restore_requested;
+
+static void snapshot_signal_handler(int signum)
+{
+    if (signum == SIGUSR1) {
+        snapshot_requested = 1;
+    } else {
+        restore_requested = 1;
+    }
+}
+
+void SITL_State::_snapshot_init(void)
+{
+    // no SA_RESTART, so the signals interrupt waitpid() in a process
+    // holding a snapshot
+    struct sigaction sa = {};
+    sa.sa_handler = snapshot_signal_handler;
+    sigaction(SIGUSR1, &sa, nullptr);
+    sigaction(SIGUSR2, &sa, nullptr);
+}
+
+/*
+  take or restore a snapshot if one has been requested. Called from
+  the main loop
+ */
+void SITL_State::snapshot_update(void)
+{
+    if (restore_requested) {
+        restore_requested = 0;
+        if (_snapshot_branch) {
+            // the process holding the snapshot starts a new branch.
+            // Skip exit handlers, they would act on shared state
+            ::printf("SITL: restoring snapshot\n");
+            fflush(stdout);
+            _exit(SITL_SNAPSHOT_RESTORE_EXIT);
+        }
+        ::printf("SITL: no snapshot to restore\n");
+    }
+    if (snapshot_requested) {
+        snapshot_requested = 0;
+        _snapshot_hold();
+    }
+}
+
+/*
+  fork, returning in the child, which carries on from the snapshot. The
+  parent holds the snapshot, forking a new child each time a restore
+  is requested, until a child exits for another reason
+ */
+void SITL_State::_snapshot_hold(void)
+{
+    // a thread stopped anywhere else could hold a lock, such as a
+    // semaphore or the malloc lock, which the child would inherit
+    // locked
+    if (!_scheduler->pause_threads(SITL_SNAPSHOT_PAUSE_TIMEOUT_MS)) {
+        _scheduler->resume_threads();
+        ::printf("SITL: snapshot failed: threads did not pause\n");
+        return;
+    }
+
+    ::printf("SITL: snapshot at %.3fs\n", AP_HAL::micros64() * 1.0e-6);
+
+    while (true) {
+        // don't leave buffered output to be written by both processes
+        fflush(stdout);
+        const pid_t child = fork();
+        if (child == -1) {
+            _scheduler->resume_threads();
+            ::printf("SITL: snapshot failed: %s\n", strerror(errno));
+            return;
+        }
+        if (child == 0) {
+            _snapshot_branch = true;
+            _parent_pid = getppid();
+            _scheduler->restart_threads();
+            return;
+        }
+
+        int status;
+        while (waitpid(child, &status, 0) != child) {
+            if (errno != EINTR) {
+                AP_HAL::panic("SITL: lost snapshot branch: %s", strerror(errno));
+            }
+            if (snapshot_requested) {
+                snapshot_requested = 0;
+                kill(child, SIGUSR1);
+            }
+            if (restore_requested) {
+                restore_requested = 0;
+                kill(child, SIGUSR2);
+            }
+            if (Scheduler::_should_exit) {
+                kill(child, SIGTERM);
+            }
+        }
+
+        if (WIFEXITED(status) && WEXITSTATUS(status) == SITL_SNAPSHOT_RESTORE_EXIT) {
+            continue;
+        }
+        // the branch has finished, and so have we
+        _exit(WIFEXITED(status) ? WEXITSTATUS(status) : 1);
+    }
+}
+
+#endif // CONFIG_HAL_BOARD == HAL_BOARD_SITL && !defined(HAL_BUILD_AP_PERIPH)
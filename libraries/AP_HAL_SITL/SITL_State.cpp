@@ -12,6 +12,7 @@
 #include <stdio.h>
 #include <signal.h>
 #include <unistd.h>
+#include <time.h>
 #include <stdlib.h>
 #include <errno.h>
 #include <sys/types.h>
@@ -73,6 +74,8 @@ void SITL_State::_sitl_setup()
 
     fprintf(stdout, "Starting SITL input\n");
 
+    _snapshot_init();
+
     // find the barometer object if it exists
     _sitl = AP::sitl();
 
@@ -118,10 +121,15 @@ void SITL_State::_sitl_setup()
  */
 void SITL_State::_fdm_input_step(void)
 {
+    if (_swarm != nullptr) {
+        _swarm_wait();
+    }
+
     _fdm_input_local();
 
-    /* make sure we die if our parent dies */
-    if (kill(_parent_pid, 0) != 0) {
+    /* make sure we die if our parent dies. This is a system call,
+       so only check every few hundred steps */
+    if ((_update_count & 0xFF) == 0 && kill(_parent_pid, 0) != 0) {
         exit(1);
     }
 
@@ -160,6 +168,7 @@ void SITL_State::wait_clock(uint64_t wait_time_usec)
             Scheduler::from(hal.scheduler)->semaphore_wait_hack_required()) {
             _fdm_input_step();
         } else {
+            Scheduler::pause_point();
 #ifdef CYGWIN_BUILD
             if (speedup > 2 && hal.util->get_soft_armed()) {
                 const char *current_thread = Scheduler::from(hal.scheduler)->get_current_thread_name();
@@ -183,7 +192,7 @@ void SITL_State::wait_clock(uint64_t wait_time_usec)
     // MAVProxy/pymavlink take too long to process packets and it ends
     // up seeing traffic well into our past and hits time-out
     // conditions.
-    if (speedup > 1 && hal.scheduler->in_main_thread()) {
+    if (speedup > 1 && !_max_speed && hal.scheduler->in_main_thread()) {
         while (true) {
             const int queue_length = ((HALSITL::UARTDriver*)hal.serial(0))->get_system_outqueue_length();
             // ::fprintf(stderr, "queue_length=%d\n", (signed)queue_length);
@@ -284,6 +293,37 @@ void SITL_State::_fdm_input_local(void)
 
     _synthetic_clock_mode = true;
     _update_count++;
+
+    if (_max_speed) {
+        _report_max_speed();
+    }
+}
+
+/*
+  in max speed mode, periodically report how many simulated seconds
+  we are running per wall clock second
+ */
+void SITL_State::_report_max_speed(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    const uint64_t now_wall_us = ts.tv_sec*1000000ULL + ts.tv_nsec/1000U;
+    const uint64_t now_sim_us = AP_HAL::micros64();
+    if (_max_speed_report_wall_us == 0) {
+        _max_speed_report_wall_us = now_wall_us;
+        _max_speed_report_sim_us = now_sim_us;
+        return;
+    }
+    const uint64_t dt_wall_us = now_wall_us - _max_speed_report_wall_us;
+    if (dt_wall_us < 10000000ULL) {
+        return;
+    }
+    const uint64_t dt_sim_us = now_sim_us - _max_speed_report_sim_us;
+    ::printf("SITL: %.1f simulated seconds per wall second (sim time %.1fs)\n",
+             double(dt_sim_us) / dt_wall_us,
+             now_sim_us * 1.0e-6);
+    _max_speed_report_wall_us = now_wall_us;
+    _max_speed_report_sim_us = now_sim_us;
 }
 
 /*
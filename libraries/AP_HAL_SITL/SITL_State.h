@@ -13,6 +13,10 @@
 
 class HAL_SITL;
 
+#ifndef SITL_SWARM_MAX_VEHICLES
+#define SITL_SWARM_MAX_VEHICLES 128
+#endif
+
 class HALSITL::SITL_State : public SITL_State_Common {
     friend class HALSITL::Scheduler;
     friend class HALSITL::Util;
@@ -21,6 +25,9 @@ public:
     void init(int argc, char * const argv[]) override;
 
     void loop_hook(void);
+
+    // take or restore a snapshot if one has been requested
+    void snapshot_update(void);
     uint16_t base_port(void) const {
         return _base_port;
     }
@@ -89,6 +96,26 @@ private:
 
     bool _synthetic_clock_mode;
 
+    // run as fast as possible without TCP serial ports, reporting
+    // the achieved speedup
+    bool _max_speed;
+    uint64_t _max_speed_report_wall_us;
+    uint64_t _max_speed_report_sim_us;
+    void _report_max_speed(void);
+
+    // swarm of vehicles forked from this process, stepping on a
+    // common simulated clock
+    struct SwarmClock;
+    SwarmClock *_swarm;
+    uint8_t _swarm_index;
+    uint8_t _swarm_start(uint8_t count);
+    void _swarm_wait(void);
+
+    // snapshots of the running vehicle, held by forked processes
+    bool _snapshot_branch;
+    void _snapshot_init(void);
+    void _snapshot_hold(void);
+
     bool _use_rtscts;
     bool _use_fg_view;
     
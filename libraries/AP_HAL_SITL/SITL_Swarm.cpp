@@ -0,0 +1,243 @@
+/*
+  run a swarm of vehicles from one SITL command line
+
+  The first vehicle forks the others before any threads or sockets are
+  created. Each vehicle runs in its own directory, named after its
+  instance as sim_vehicle.py does, with its own ports and system ID,
+  and all of them step on a common simulated clock kept in memory
+  shared between the processes: a vehicle only steps its physics once
+  every other vehicle has caught up with it.
+
+  A vehicle which is ahead sleeps on a futex on the clock's sequence
+  number, which each vehicle increments when it advances its time.
+  Without futexes vehicles poll.
+ */
+#include <AP_HAL/AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL && !defined(HAL_BUILD_AP_PERIPH)
+
+#include "AP_HAL_SITL.h"
+#include "AP_HAL_SITL_Namespace.h"
+#include "HAL_SITL_Class.h"
+
+#include <atomic>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+extern const AP_HAL::HAL& hal;
+
+using namespace HALSITL;
+
+// environment variable which lets a vehicle rejoin its swarm after a
+// reboot, which re-executes the process
+#define SITL_SWARM_ENV "SITL_SWARM"
+
+// how long a waiting vehicle sleeps before checking the swarm is alive
+#define SITL_SWARM_CHECK_MS 100
+
+// wakes vehicles waiting for another vehicle's time to advance
+struct SwarmWake {
+    // incremented whenever a vehicle's time changes
+    std::atomic<uint32_t> seq;
+    // number of vehicles sleeping on seq
+    std::atomic<uint32_t> waiting;
+};
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex needs a plain 32 bit word");
+
+struct SITL_State::SwarmClock {
+    uint8_t count;
+    SwarmWake wake;
+    struct {
+        pid_t pid;
+        // simulated time this vehicle has reached
+        std::atomic<uint64_t> time_us;
+    } vehicle[SITL_SWARM_MAX_VEHICLES];
+};
+
+// this vehicle's time, marked as finished when it exits
+static std::atomic<uint64_t> *swarm_exit_time_us;
+static SwarmWake *swarm_exit_wake;
+// offset from this process's clock to swarm time, non-zero after a reboot
+static uint64_t swarm_time_offset_us;
+
+/*
+  tell the vehicles waiting on the swarm that a vehicle's time has changed
+ */
+static void swarm_notify(SwarmWake &wake)
+{
+    wake.seq++;
+    if (wake.waiting.load() != 0) {
+#ifdef __linux__
+        // each waiter is waiting for a different vehicle, so wake them all
+        syscall(SYS_futex, &wake.seq, FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+#endif
+    }
+}
+
+/*
+  sleep until the sequence number moves on from seq, returning true
+  if timeout_ms passed first
+ */
+static bool swarm_sleep(SwarmWake &wake, uint32_t seq, uint32_t timeout_ms)
+{
+#ifdef __linux__
+    const struct timespec ts {
+        time_t(timeout_ms / 1000),
+        long((timeout_ms % 1000) * 1000000UL)
+    };
+    wake.waiting++;
+    // returns at once if seq has already moved on
+    const long ret = syscall(SYS_futex, &wake.seq, FUTEX_WAIT, seq, &ts, nullptr, 0);
+    const bool timed_out = (ret == -1 && errno == ETIMEDOUT);
+    wake.waiting--;
+    return timed_out;
+#else
+    // poll every 50us
+    static uint32_t polls;
+    usleep(50);
+    return (++polls % (timeout_ms * 20)) == 0;
+#endif
+}
+
+static void swarm_exit(void)
+{
+    *swarm_exit_time_us = UINT64_MAX;
+    swarm_notify(*swarm_exit_wake);
+}
+
+/*
+  start a swarm of count vehicles, returning the index of this
+  process's vehicle within the swarm. On return the current directory
+  is the one the swarm was started in
+ */
+uint8_t SITL_State::_swarm_start(uint8_t count)
+{
+    count = MIN(count, SITL_SWARM_MAX_VEHICLES);
+
+    uint8_t index = 0;
+    bool rejoining = false;
+    int fd;
+    const char *env = getenv(SITL_SWARM_ENV);
+    if (env != nullptr) {
+        // we have rebooted, the swarm already exists
+        unsigned env_fd, env_index;
+        if (sscanf(env, "%u,%u", &env_fd, &env_index) != 2) {
+            printf("Bad %s environment variable (%s)\n", SITL_SWARM_ENV, env);
+            exit(1);
+        }
+        fd = env_fd;
+        index = env_index;
+        rejoining = true;
+        // go back to the directory the swarm was started in
+        if (chdir("..") != 0) {
+            printf("Failed to leave swarm directory: %s\n", strerror(errno));
+            exit(1);
+        }
+    } else {
+        // the file is unlinked and only reachable through the
+        // descriptor, which forked and re-executed processes inherit
+        char path[] = "/tmp/sitl_swarm_XXXXXX";
+        fd = mkstemp(path);
+        if (fd == -1 || unlink(path) != 0 ||
+            ftruncate(fd, sizeof(SwarmClock)) != 0) {
+            printf("Failed to create swarm clock: %s\n", strerror(errno));
+            exit(1);
+        }
+    }
+
+    _swarm = (SwarmClock *)mmap(nullptr, sizeof(SwarmClock), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    if (_swarm == MAP_FAILED) {
+        printf("Failed to map swarm clock: %s\n", strerror(errno));
+        exit(1);
+    }
+
+    if (rejoining) {
+        // carry on from the swarm time we had reached
+        swarm_time_offset_us = _swarm->vehicle[index].time_us;
+    } else {
+        _swarm->count = count;
+        _swarm->vehicle[0].pid = getpid();
+        for (uint8_t i=1; i<count; i++) {
+            const pid_t pid = fork();
+            if (pid == -1) {
+                printf("Failed to fork swarm vehicle %u: %s\n", unsigned(i), strerror(errno));
+                exit(1);
+            }
+            if (pid == 0) {
+                index = i;
+                break;
+            }
+            _swarm->vehicle[i].pid = pid;
+        }
+
+        char env_value[16];
+        snprintf(env_value, sizeof(env_value), "%d,%u", fd, unsigned(index));
+        setenv(SITL_SWARM_ENV, env_value, 1);
+    }
+
+    _swarm_index = index;
+    swarm_exit_time_us = &_swarm->vehicle[index].time_us;
+    swarm_exit_wake = &_swarm->wake;
+    atexit(swarm_exit);
+
+    printf("Swarm vehicle %u of %u\n", unsigned(index+1), unsigned(_swarm->count));
+
+    return index;
+}
+
+/*
+  publish our simulated time and wait for the rest of the swarm to
+  catch up with it
+ */
+void SITL_State::_swarm_wait(void)
+{
+    const uint64_t now_us = AP_HAL::micros64() + swarm_time_offset_us;
+    SwarmWake &wake = _swarm->wake;
+    _swarm->vehicle[_swarm_index].time_us = now_us;
+    swarm_notify(wake);
+
+    for (uint8_t i=0; i<_swarm->count; i++) {
+        while (true) {
+            // read the sequence number before the time, so an advance
+            // after the check wakes us
+            const uint32_t seq = wake.seq.load();
+            if (_swarm->vehicle[i].time_us >= now_us) {
+                break;
+            }
+            if (!swarm_sleep(wake, seq, SITL_SWARM_CHECK_MS)) {
+                continue;
+            }
+            // nothing has moved for a while
+            if (_swarm_index == 0) {
+                // vehicles which died without marking themselves
+                // finished would hold up the swarm forever
+                for (uint8_t j=1; j<_swarm->count; j++) {
+                    int status;
+                    if (_swarm->vehicle[j].time_us != UINT64_MAX &&
+                        waitpid(_swarm->vehicle[j].pid, &status, WNOHANG) == _swarm->vehicle[j].pid) {
+                        printf("Swarm vehicle %u exited\n", unsigned(j+1));
+                        _swarm->vehicle[j].time_us = UINT64_MAX;
+                        swarm_notify(wake);
+                    }
+                }
+            } else if (kill(_parent_pid, 0) != 0) {
+                exit(1);
+            }
+        }
+    }
+}
+
+#endif // CONFIG_HAL_BOARD == HAL_BOARD_SITL && !defined(HAL_BUILD_AP_PERIPH)
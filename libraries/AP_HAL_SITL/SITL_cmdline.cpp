@@ -37,6 +37,7 @@
 #include <SITL/SIM_Webots.h>
 #include <SITL/SIM_Webots_Python.h>
 #include <SITL/SIM_JSON.h>
+#include <SITL/SIM_JSON_SHM.h>
 #include <SITL/SIM_Blimp.h>
 #include <SITL/SIM_NoVehicle.h>
 #include <SITL/SIM_StratoBlimp.h>
@@ -49,6 +50,9 @@
 #include <stdio.h>
 #include <time.h>
 #include <sys/time.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <limits.h>
 
 #define FORCE_VERSION_H_INCLUDE
 #include "ap_version.h"
@@ -88,6 +92,11 @@ void SITL_State::_usage(void)
            "\t--instance|-I N          set instance of SITL (adds 10*instance to all port numbers)\n"
            // "\t--param|-P NAME=VALUE    set some param\n"  CURRENTLY BROKEN!
            "\t--synthetic-clock|-S     set synthetic clock mode\n"
+           "\t--max-speed              run as fast as possible. Unless set with --serialN,\n"
+           "\t                         SERIAL0 listens on unix socket sitlN_serial0.sock\n"
+           "\t                         and other TCP serial ports discard their output.\n"
+           "\t                         Simulated seconds per wall second are printed\n"
+           "\t                         every 10 seconds\n"
            "\t--home|-O HOME           set start location (lat,lng,alt,yaw) or location name\n"
            "\t--model|-M MODEL         set simulation model\n"
            "\t--config string          set additional simulation config string\n"
@@ -116,7 +125,12 @@ void SITL_State::_usage(void)
            "\t--irlock-port PORT       set port num for irlock\n"
            "\t--start-time TIMESTR     set simulation start time in UNIX timestamp\n"
            "\t--sysid ID               set SYSID_THISMAV\n"
+           "\t--seed SEED              seed the simulated sensor noise\n"
            "\t--slave number           set the number of JSON slaves\n"
+           "\t--swarm N                run N vehicles on a common simulated clock, each\n"
+           "\t                         in a directory named after its instance\n"
+           "\t--swarm-offset BEARING,DISTANCE  start each swarm vehicle DISTANCE meters\n"
+           "\t                         along BEARING from the previous one\n"
         );
 }
 
@@ -176,6 +190,7 @@ static const struct {
     { "scrimmage",          Scrimmage::create },
     { "webots-python",      WebotsPython::create },
     { "webots",             Webots::create },
+    { "JSON-SHM",           JSON_SHM::create },
     { "JSON",               JSON::create },
     { "blimp",              Blimp::create },
     { "novehicle",          NoVehicle::create },
@@ -203,6 +218,40 @@ void SITL_State::_set_signal_handlers(void) const
 
 }
 
+/*
+  make each path in a comma separated list of paths absolute
+ */
+static char *absolute_paths(const char *paths)
+{
+    char cwd[PATH_MAX];
+    if (paths == nullptr || getcwd(cwd, sizeof(cwd)) == nullptr) {
+        return paths == nullptr ? nullptr : strdup(paths);
+    }
+    // worst case every path gets the prefix
+    size_t len = strlen(paths) + 1;
+    for (const char *p = paths; p != nullptr; p = strchr(p+1, ',')) {
+        len += strlen(cwd) + 1;
+    }
+    char *ret = (char *)calloc(1, len);
+    if (ret == nullptr) {
+        AP_HAL::panic("out of memory");
+    }
+    char *dup = strdup(paths);
+    char *saveptr = nullptr;
+    for (char *p = strtok_r(dup, ",", &saveptr); p != nullptr; p = strtok_r(nullptr, ",", &saveptr)) {
+        if (ret[0] != 0) {
+            strcat(ret, ",");
+        }
+        if (p[0] != '/') {
+            strcat(ret, cwd);
+            strcat(ret, "/");
+        }
+        strcat(ret, p);
+    }
+    free(dup);
+    return ret;
+}
+
 void SITL_State::_parse_command_line(int argc, char * const argv[])
 {
     int opt;
@@ -276,7 +325,11 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         CMDLINE_IRLOCK_PORT,
         CMDLINE_START_TIME,
         CMDLINE_SYSID,
+        CMDLINE_SEED,
         CMDLINE_SLAVE,
+        CMDLINE_MAX_SPEED,
+        CMDLINE_SWARM,
+        CMDLINE_SWARM_OFFSET,
 #if STORAGE_USE_FLASH
         CMDLINE_SET_STORAGE_FLASH_ENABLED,
 #endif
@@ -336,7 +389,11 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         {"irlock-port",     true,   0, CMDLINE_IRLOCK_PORT},
         {"start-time",      true,   0, CMDLINE_START_TIME},
         {"sysid",           true,   0, CMDLINE_SYSID},
+        {"seed",            true,   0, CMDLINE_SEED},
         {"slave",           true,   0, CMDLINE_SLAVE},
+        {"max-speed",       false,  0, CMDLINE_MAX_SPEED},
+        {"swarm",           true,   0, CMDLINE_SWARM},
+        {"swarm-offset",    true,   0, CMDLINE_SWARM_OFFSET},
 #if STORAGE_USE_FLASH
         {"set-storage-flash-enabled", true,   0, CMDLINE_SET_STORAGE_FLASH_ENABLED},
 #endif
@@ -371,6 +428,14 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
 
     bool wiping_storage = false;
 
+    // serial ports given on the command line
+    uint16_t serial_path_set = 0;
+
+    int32_t sysid = 0;
+    uint8_t swarm_count = 1;
+    float swarm_offset_bearing = 0;
+    float swarm_offset_m = 0;
+
     GetOptLong gopt(argc, argv, "hwus:r:CI:P:SO:M:F:c:v:",
                     options);
     while (!is_example && (opt = gopt.getoption()) != -1) {
@@ -483,6 +548,7 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         case CMDLINE_SERIAL8:
         case CMDLINE_SERIAL9:
             _serial_path[opt - CMDLINE_SERIAL0] = gopt.optarg;
+            serial_path_set |= 1U << (opt - CMDLINE_SERIAL0);
             break;
         case CMDLINE_RTSCTS:
             _use_rtscts = true;
@@ -508,17 +574,13 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         case CMDLINE_START_TIME:
             start_time_UTC = atoi(gopt.optarg);
             break;
-        case CMDLINE_SYSID: {
-            const int32_t sysid = atoi(gopt.optarg);
+        case CMDLINE_SYSID:
+            sysid = atoi(gopt.optarg);
             if (sysid < 1 || sysid > 255) {
                 fprintf(stderr, "You must specify a SYSID greater than 0 and less than 256\n");
                 exit(1);
             }
-            temp_cmdline_param = {"SYSID_THISMAV", static_cast<float>(sysid)};
-            cmdline_param.push(temp_cmdline_param);
-            printf("Setting SYSID_THISMAV=%d\n", sysid);
             break;
-        }
 #if STORAGE_USE_POSIX
         case CMDLINE_SET_STORAGE_POSIX_ENABLED:
             storage_posix_enabled = atoi(gopt.optarg);
@@ -537,6 +599,28 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         case 'h':
             _usage();
             exit(0);
+        case CMDLINE_MAX_SPEED:
+            _max_speed = true;
+            break;
+        case CMDLINE_SEED:
+            // the simulated sensors draw their noise from random()
+            srandom(strtoul(gopt.optarg, nullptr, 0));
+            break;
+        case CMDLINE_SWARM: {
+            const int32_t count = atoi(gopt.optarg);
+            if (count < 1 || count > SITL_SWARM_MAX_VEHICLES) {
+                fprintf(stderr, "You must specify a swarm of 1 to %u vehicles\n", unsigned(SITL_SWARM_MAX_VEHICLES));
+                exit(1);
+            }
+            swarm_count = count;
+            break;
+        }
+        case CMDLINE_SWARM_OFFSET:
+            if (sscanf(gopt.optarg, "%f,%f", &swarm_offset_bearing, &swarm_offset_m) != 2) {
+                fprintf(stderr, "Swarm offset should be BEARING,DISTANCE e.g. 90,5\n");
+                exit(1);
+            }
+            break;
         case CMDLINE_SLAVE: {
 #if HAL_SIM_JSON_MASTER_ENABLED
             const int32_t slaves = atoi(gopt.optarg);
@@ -552,6 +636,73 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         }
     }
 
+    uint8_t swarm_index = 0;
+    if (swarm_count > 1) {
+        swarm_index = _swarm_start(swarm_count);
+        if (swarm_index > 0) {
+            // each vehicle gets its own, still reproducible, noise
+            srandom(random() + swarm_index);
+        }
+
+        // vehicles run in their own directories, so paths relative to
+        // this one must be made absolute first
+        defaults_path = absolute_paths(defaults_path);
+        autotest_dir = absolute_paths(autotest_dir);
+
+        _instance += swarm_index;
+        _base_port += swarm_index * 10;
+        _rcin_port += swarm_index * 10;
+        _fg_view_port += swarm_index * 10;
+        simulator_port_in += swarm_index * 10;
+        simulator_port_out += swarm_index * 10;
+        _irlock_port += swarm_index * 10;
+
+        // vehicles need distinct system IDs to share a network
+        if (sysid == 0) {
+            sysid = 1;
+        }
+        sysid += swarm_index;
+        if (sysid > 255) {
+            fprintf(stderr, "Swarm SYSID %d is greater than 255\n", int(sysid));
+            exit(1);
+        }
+
+        char dir[4];
+        snprintf(dir, sizeof(dir), "%u", unsigned(_instance));
+        if ((mkdir(dir, 0755) != 0 && errno != EEXIST) || chdir(dir) != 0) {
+            printf("Failed to use swarm directory %s: %s\n", dir, strerror(errno));
+            exit(1);
+        }
+    }
+
+    if (sysid != 0) {
+        temp_cmdline_param = {"SYSID_THISMAV", static_cast<float>(sysid)};
+        cmdline_param.push(temp_cmdline_param);
+        printf("Setting SYSID_THISMAV=%d\n", int(sysid));
+    }
+
+    if (_max_speed) {
+        // keep TCP off the simulation's critical path. SERIAL0 is the
+        // harness link and listens on a unix socket, other TCP ports
+        // nobody asked for drop their output
+        for (uint8_t i=0; i<ARRAY_SIZE(_serial_path); i++) {
+            if ((serial_path_set & (1U<<i)) != 0 ||
+                strncmp(_serial_path[i], "tcp:", 4) != 0) {
+                continue;
+            }
+            if (i == 0) {
+                char *path = nullptr;
+                if (asprintf(&path, "unix:sitl%u_serial0.sock%s", unsigned(_instance),
+                             strstr(_serial_path[i], ":wait") != nullptr ? ":wait" : "") <= 0) {
+                    AP_HAL::panic("out of memory");
+                }
+                _serial_path[i] = path;
+            } else {
+                _serial_path[i] = "discard:";
+            }
+        }
+    }
+
     if (!model_str) {
         printf("You must specify a vehicle model.  Options are:\n");
         for (uint8_t i=0; i < ARRAY_SIZE(model_constructors); i++) {
@@ -579,6 +730,9 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
                     ::printf("Failed to parse home string (%s).  Should be LAT,LON,ALT,HDG e.g. 37.4003371,-122.0800351,0,353\n", home_str);
                     exit(1);
                 }
+                if (swarm_index > 0) {
+                    home.offset_bearing(swarm_offset_bearing, swarm_index * swarm_offset_m);
+                }
                 sitl_model->set_start_location(home, home_yaw);
             }
             sitl_model->set_interface_ports(simulator_address, simulator_port_in, simulator_port_out);
@@ -586,6 +740,7 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
             sitl_model->set_instance(_instance);
             sitl_model->set_autotest_dir(autotest_dir);
             sitl_model->set_config(config);
+            sitl_model->set_max_speed(_max_speed);
             _synthetic_clock_mode = true;
             break;
         }
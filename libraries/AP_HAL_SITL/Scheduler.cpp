@@ -3,9 +3,12 @@
 #include "AP_HAL_SITL.h"
 #include <AP_HAL_SITL/I2CDevice.h>
 #include "Scheduler.h"
+#include "Semaphores.h"
 #include "UARTDriver.h"
 #include <sys/time.h>
 #include <fenv.h>
+#include <signal.h>
+#include <unistd.h>
 #include <AP_BoardConfig/AP_BoardConfig.h>
 #if defined (__clang__) || (defined (__APPLE__) && defined (__MACH__))
 #include <stdlib.h>
@@ -45,6 +48,8 @@ bool Scheduler::_in_semaphore_take_wait = false;
 
 Scheduler::thread_attr *Scheduler::threads;
 HAL_Semaphore Scheduler::_thread_sem;
+thread_local Scheduler::thread_attr *Scheduler::_current_thread;
+std::atomic<bool> Scheduler::_pause_threads;
 
 Scheduler::Scheduler(SITL_State *sitlState) :
     _sitlState(sitlState),
@@ -314,6 +319,7 @@ void *Scheduler::thread_create_trampoline(void *ctx)
 {
     struct thread_attr *a = (struct thread_attr *)ctx;
     a->thread = pthread_self();
+    _current_thread = a;
     a->f[0]();
     
     WITH_SEMAPHORE(_thread_sem);
@@ -344,9 +350,9 @@ bool Scheduler::thread_create(AP_HAL::MemberProc proc, const char *name, uint32_
 {
     WITH_SEMAPHORE(_thread_sem);
 
-    // even an empty thread takes 2500 bytes on Linux, so always add 2300, giving us 200 bytes
-    // safety margin
-    stack_size += 2300;
+    // even an empty thread takes 2500 bytes on Linux, so always add
+    // stack_overhead, giving us 200 bytes safety margin
+    stack_size += stack_overhead;
     
     pthread_t thread {};
     const uint32_t alloc_stack = MAX(size_t(PTHREAD_STACK_MIN),stack_size);
@@ -372,6 +378,9 @@ bool Scheduler::thread_create(AP_HAL::MemberProc proc, const char *name, uint32_
     a->stack_size = stack_size;
     a->f[0] = proc;
     a->name = name;
+    a->base = base;
+    a->priority = priority;
+    a->paused = false;
 
     if (pthread_attr_init(&a->attr) != 0) {
         goto failed;
@@ -381,8 +390,19 @@ bool Scheduler::thread_create(AP_HAL::MemberProc proc, const char *name, uint32_
         AP_HAL::panic("Failed to set stack of size %u for thread %s", alloc_stack, name);
     }
 #endif
-    if (pthread_create(&thread, &a->attr, thread_create_trampoline, a) != 0) {
-        goto failed;
+    {
+        // the snapshot signals are handled by the main thread, see
+        // SITL_Snapshot.cpp. The new thread inherits the blocked mask
+        sigset_t snapshot_signals, old_signals;
+        sigemptyset(&snapshot_signals);
+        sigaddset(&snapshot_signals, SIGUSR1);
+        sigaddset(&snapshot_signals, SIGUSR2);
+        pthread_sigmask(SIG_BLOCK, &snapshot_signals, &old_signals);
+        const int ret = pthread_create(&thread, &a->attr, thread_create_trampoline, a);
+        pthread_sigmask(SIG_SETMASK, &old_signals, nullptr);
+        if (ret != 0) {
+            goto failed;
+        }
     }
 
 #if !defined(__APPLE__)
@@ -404,6 +424,78 @@ failed:
     return false;
 }
 
+/*
+  stop the other threads ready for fork(). A thread stops in
+  pause_point() the next time it waits without holding a semaphore.
+  The simulated clock does not move while the main thread is here, so
+  a thread which waits while holding a semaphore never stops
+ */
+bool Scheduler::pause_threads(uint32_t timeout_ms)
+{
+    _pause_threads = true;
+    for (uint32_t i=0; i<timeout_ms; i++) {
+        const char *running = nullptr;
+        {
+            WITH_SEMAPHORE(_thread_sem);
+            for (struct thread_attr *p=threads; p; p=p->next) {
+                if (!p->paused) {
+                    running = p->name;
+                    break;
+                }
+            }
+        }
+        if (running == nullptr) {
+            return true;
+        }
+        if (i == timeout_ms-1) {
+            ::printf("SITL: thread %s did not pause\n", running);
+        }
+        usleep(1000);
+    }
+    return false;
+}
+
+void Scheduler::resume_threads(void)
+{
+    _pause_threads = false;
+}
+
+void Scheduler::pause_point(void)
+{
+    struct thread_attr *a = _current_thread;
+    if (a == nullptr || !_pause_threads || Semaphore::num_held() != 0) {
+        return;
+    }
+    a->paused = true;
+    while (_pause_threads) {
+        usleep(1000);
+    }
+    a->paused = false;
+}
+
+/*
+  start the threads again in a forked child. Each thread starts from
+  the beginning of its thread function, so a library whose thread
+  keeps state across its loop frees what the previous thread left when
+  its thread function starts
+ */
+void Scheduler::restart_threads(void)
+{
+    _pause_threads = false;
+    struct thread_attr *old = threads;
+    threads = nullptr;
+    while (old != nullptr) {
+        struct thread_attr *a = old;
+        old = a->next;
+        if (!thread_create(a->f[0], a->name, a->stack_size - stack_overhead, a->base, a->priority)) {
+            AP_HAL::panic("Failed to restart thread %s", a->name);
+        }
+        free(a->stack);
+        free(a->f);
+        delete a;
+    }
+}
+
 /*
   check for stack overflow
  */
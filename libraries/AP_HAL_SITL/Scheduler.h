@@ -5,6 +5,7 @@
 #include "AP_HAL_SITL_Namespace.h"
 #include <sys/time.h>
 #include <pthread.h>
+#include <atomic>
 
 #define SITL_SCHEDULER_MAX_TIMER_PROCS 8
 
@@ -58,6 +59,28 @@ public:
     bool thread_create(AP_HAL::MemberProc, const char *name,
                        uint32_t stack_size, priority_base base, int8_t priority) override;
 
+    /*
+      stop the other threads at a point where they hold no semaphores
+      and are not in the middle of a library call, ready for fork().
+      Returns false if a thread does not stop within timeout_ms of
+      wall clock time, in which case resume_threads() must be called
+     */
+    bool pause_threads(uint32_t timeout_ms);
+
+    // let the threads stopped by pause_threads() carry on
+    void resume_threads(void);
+
+    // stop the calling thread while pause_threads() is in effect.
+    // Called by threads while they wait
+    static void pause_point(void);
+
+    /*
+      start the threads again in a forked child, which only has the
+      thread which called fork(). Each thread starts from the
+      beginning of its thread function, with its original priority
+     */
+    void restart_threads(void);
+
     void set_in_semaphore_take_wait(bool value) { _in_semaphore_take_wait = value; }
     /*
      * semaphore_wait_hack_required - possibly move time input step
@@ -109,8 +132,19 @@ private:
         const uint8_t *stack_min;
         const char *name;
         pthread_t thread;
+        priority_base base;
+        int8_t priority;
+        std::atomic<bool> paused;
     };
     static struct thread_attr *threads;
+
+    // the calling thread, or nullptr if not created by thread_create()
+    static thread_local struct thread_attr *_current_thread;
+
+    // set while pause_threads() is in effect
+    static std::atomic<bool> _pause_threads;
     static const uint8_t stackfill = 0xEB;
+    // added to every thread's requested stack size
+    static const uint16_t stack_overhead = 2300;
 };
 #endif  // CONFIG_HAL_BOARD
@@ -9,6 +9,8 @@ extern const AP_HAL::HAL& hal;
 
 using namespace HALSITL;
 
+thread_local uint16_t Semaphore::_num_held;
+
 // construct a semaphore
 Semaphore::Semaphore()
 {
@@ -21,6 +23,7 @@ Semaphore::Semaphore()
 
 bool Semaphore::give()
 {
+    _num_held--;
     take_count--;
     if (pthread_mutex_unlock(&_lock) != 0) {
         AP_HAL::panic("Bad semaphore usage");
@@ -45,6 +48,7 @@ bool Semaphore::take(uint32_t timeout_ms)
         if (pthread_mutex_lock(&_lock) == 0) {
             owner = pthread_self();
             take_count++;
+            _num_held++;
             return true;
         }
         return false;
@@ -71,6 +75,7 @@ bool Semaphore::take_nonblocking()
     if (pthread_mutex_trylock(&_lock) == 0) {
         owner = pthread_self();
         take_count++;
+        _num_held++;
         return true;
     }
     return false;
@@ -90,6 +95,7 @@ BinarySemaphore::BinarySemaphore(bool initial_state) :
 
 bool BinarySemaphore::wait(uint32_t timeout_us)
 {
+    Scheduler::pause_point();
     WITH_SEMAPHORE(mtx);
     if (!pending) {
         if (hal.scheduler->in_main_thread() ||
@@ -130,6 +136,7 @@ bool BinarySemaphore::wait(uint32_t timeout_us)
 
 bool BinarySemaphore::wait_blocking(void)
 {
+    Scheduler::pause_point();
     WITH_SEMAPHORE(mtx);
     if (!pending) {
         if (pthread_cond_wait(&cond, &mtx._lock) != 0) {
@@ -17,6 +17,9 @@ public:
 
     void check_owner() const;  // asserts that current thread owns semaphore
 
+    // number of semaphores held by the calling thread
+    static uint16_t num_held(void) { return _num_held; }
+
 protected:
     pthread_mutex_t _lock;
     pthread_t owner;
@@ -24,6 +27,8 @@ protected:
     // keep track the recursion level to ensure we only disown the
     // semaphore once we're done with it
     uint8_t take_count;
+
+    static thread_local uint16_t _num_held;
 };
 
 
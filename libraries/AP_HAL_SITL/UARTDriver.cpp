@@ -33,6 +33,7 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <sys/un.h>
 #include <sys/select.h>
 #include <termios.h>
 #include <sys/time.h>
@@ -96,6 +97,8 @@ void UARTDriver::_begin(uint32_t baud, uint16_t rxSpace, uint16_t txSpace)
              sim:ParticleSensor_SDS021:
              file:/tmp/my-device-capture.BIN
              logic_async_csv:/tmp/logic_async.csv:
+             unix:sitl0.sock:wait   // unix domain socket listen on sitl0.sock
+             discard:         // in-memory, bytes written are dropped
          */
         char *saveptr = nullptr;
         char *s = strdup(path);
@@ -150,6 +153,18 @@ void UARTDriver::_begin(uint32_t baud, uint16_t rxSpace, uint16_t txSpace)
                 ::printf("UDP multicast connection %s:%u\n", ip, port);
                 _udp_start_multicast(ip, port);
             }
+        } else if (strcmp(devtype, "unix") == 0) {
+            if (args1 == nullptr) {
+                AP_HAL::panic("Invalid unix socket path: %s", path);
+            }
+            bool wait = (args2 && strcmp(args2, "wait") == 0);
+            _unix_start_connection(args1, wait);
+        } else if (strcmp(devtype, "discard") == 0) {
+            if (!_connected) {
+                ::printf("Discarding output on SERIAL%u\n", _portNumber);
+                _connected = true;
+                _discard = true;
+            }
         } else if (strcmp(devtype,"none") == 0) {
             // skipping port
             ::printf("Skipping port %s\n", args1);
@@ -297,6 +312,30 @@ size_t UARTDriver::_write(const uint8_t *buffer, size_t size)
     return ret;
 }
 
+uint8_t UARTDriver::_reserve_write(ByteBuffer::IoVec vec[2], uint32_t len)
+{
+    if (txspace() < len) {
+        return 0;
+    }
+#if !defined(HAL_BUILD_AP_PERIPH)
+    // byte loss is simulated in _write()
+    SITL::SIM *_sitl = AP::sitl();
+    if (_sitl && _sitl->uart_byte_loss_pct > 0) {
+        return 0;
+    }
+#endif
+    return _writebuffer.reserve(vec, len);
+}
+
+bool UARTDriver::_commit_write(uint32_t len)
+{
+    const bool ret = _writebuffer.commit(len);
+    if (_unbuffered_writes) {
+        handle_writing_from_writebuffer_to_device();
+    }
+    return ret;
+}
+
     
 /*
   start a TCP connection for the serial port. If wait_for_connection
@@ -397,6 +436,72 @@ void UARTDriver::_tcp_start_connection(uint16_t port, bool wait_for_connection)
 }
 
 
+/*
+  start a unix domain socket connection for the serial port. If
+  wait_for_connection is true then block until a client connects.
+  This avoids the TCP stack for a local harness or GCS
+ */
+void UARTDriver::_unix_start_connection(const char *path, bool wait_for_connection)
+{
+    if (_connected) {
+        return;
+    }
+
+    _use_send_recv = true;
+
+    if (_fd != -1) {
+        close(_fd);
+    }
+
+    if (_listen_fd == -1) {
+        struct sockaddr_un sockaddr {};
+        if (strlen(path) >= sizeof(sockaddr.sun_path)) {
+            fprintf(stderr, "unix socket path too long - %s\n", path);
+            exit(1);
+        }
+        sockaddr.sun_family = AF_UNIX;
+        strncpy(sockaddr.sun_path, path, sizeof(sockaddr.sun_path)-1);
+
+        _listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (_listen_fd == -1) {
+            fprintf(stderr, "socket failed - %s\n", strerror(errno));
+            exit(1);
+        }
+        if (fcntl(_listen_fd, F_SETFD, FD_CLOEXEC) == -1) {
+            fprintf(stderr, "fcntl failed on setting FD_CLOEXEC - %s\n", strerror(errno));
+            exit(1);
+        }
+
+        // remove the socket of a previous run
+        unlink(path);
+
+        if (bind(_listen_fd, (struct sockaddr *)&sockaddr, sizeof(sockaddr)) == -1) {
+            fprintf(stderr, "bind failed on %s - %s\n", path, strerror(errno));
+            exit(1);
+        }
+        if (listen(_listen_fd, 5) == -1) {
+            fprintf(stderr, "listen failed - %s\n", strerror(errno));
+            exit(1);
+        }
+
+        fprintf(stderr, "SERIAL%u on unix socket %s\n", _portNumber, path);
+        fflush(stdout);
+    }
+
+    if (wait_for_connection) {
+        fprintf(stdout, "Waiting for connection ....\n");
+        fflush(stdout);
+        _fd = accept(_listen_fd, nullptr, nullptr);
+        if (_fd == -1) {
+            fprintf(stderr, "accept() error - %s", strerror(errno));
+            exit(1);
+        }
+        fcntl(_fd, F_SETFD, FD_CLOEXEC);
+        _connected = true;
+        fprintf(stdout, "Connection on unix socket %s\n", path);
+    }
+}
+
 /*
   start a TCP client connection for the serial port. 
  */
@@ -835,7 +940,12 @@ void UARTDriver::handle_writing_from_writebuffer_to_device()
         }
     }
 #endif
-    if (_packetise) {
+    if (_discard) {
+        // nobody is listening on this port
+        nwritten = MIN(_writebuffer.available(), max_bytes);
+        _writebuffer.advance(nwritten);
+        _tx_stats_bytes += nwritten;
+    } else if (_packetise) {
         uint16_t n = _writebuffer.available();
         n = MIN(n, max_bytes);
 #if HAL_GCS_ENABLED
@@ -884,6 +994,10 @@ void UARTDriver::handle_reading_from_device_to_readbuffer()
         _check_reconnect();
         return;
     }
+    if (_discard) {
+        // never any input
+        return;
+    }
 
     uint32_t space = _readbuffer.space();
     if (space == 0) {
@@ -82,6 +82,7 @@ private:
 
     uint8_t _portNumber;
     bool _connected = false; // true if a client has connected
+    bool _discard; // in-memory port, bytes written are dropped
     bool _use_send_recv = false;
     int _listen_fd;  // socket we are listening on
     int _serial_port;
@@ -97,6 +98,7 @@ private:
     uint32_t _uart_baudrate;
 
     void _tcp_start_connection(uint16_t port, bool wait_for_connection);
+    void _unix_start_connection(const char *path, bool wait_for_connection);
     void _uart_start_connection(void);
     void _check_reconnect();
     void _tcp_start_client(const char *address, uint16_t port);
@@ -142,6 +144,8 @@ private:
 protected:
     void _begin(uint32_t b, uint16_t rxS, uint16_t txS) override;
     size_t _write(const uint8_t *buffer, size_t size) override;
+    uint8_t _reserve_write(ByteBuffer::IoVec vec[2], uint32_t len) override;
+    bool _commit_write(uint32_t len) override;
     ssize_t _read(uint8_t *buffer, uint16_t count) override;
     uint32_t _available() override;
     void _end() override;
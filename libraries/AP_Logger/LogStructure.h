@@ -314,6 +314,18 @@ struct PACKED log_MAV {
     uint16_t times_full;
 };
 
+struct PACKED log_MAVB {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t chan;
+    uint8_t bucket;
+    uint8_t num_msgs;
+    uint16_t interval_ms;
+    uint16_t sched_ms;
+    float rate;
+    float link_rate;
+};
+
 struct PACKED log_RSSI {
     LOG_PACKET_HEADER;
     uint64_t time_us;
@@ -834,6 +846,17 @@ struct PACKED log_VER {
 // @Field: ss: stream slowdown is the number of ms being added to each message to fit within bandwidth
 // @Field: tf: times buffer was full when a message was going to be sent
 
+// @LoggerMessage: MAVB
+// @Description: GCS MAVLink stream statistics, one per stream bucket
+// @Field: TimeUS: Time since system startup
+// @Field: chan: mavlink channel number
+// @Field: B: bucket number
+// @Field: N: number of messages in bucket
+// @Field: Int: requested interval between sends of the bucket
+// @Field: SInt: interval the bucket is currently scheduled at, after slowdown for the link
+// @Field: Rate: achieved rate of sending the bucket
+// @Field: LRate: estimated link throughput available to streams
+
 // @LoggerMessage: MAVC
 // @Description: MAVLink command we have just executed
 // @Field: TimeUS: Time since system startup
@@ -1281,6 +1304,8 @@ LOG_STRUCTURE_FROM_FENCE \
       "RALY", "QBBLLhB", "TimeUS,Tot,Seq,Lat,Lng,Alt,Flags", "s--DUm-", "F--GGB-" },  \
     { LOG_MAV_MSG, sizeof(log_MAV),   \
       "MAV", "QBHHHBHH",   "TimeUS,chan,txp,rxp,rxdp,flags,ss,tf", "s#----s-", "F-000-C-" },   \
+    { LOG_MAVB_MSG, sizeof(log_MAVB),   \
+      "MAVB", "QBBBHHff",   "TimeUS,chan,B,N,Int,SInt,Rate,LRate", "s#--ssz-", "F---CC0-" },   \
 LOG_STRUCTURE_FROM_VISUALODOM \
     { LOG_OPTFLOW_MSG, sizeof(log_Optflow), \
       "OF",   "QBffff",   "TimeUS,Qual,flowX,flowY,bodyX,bodyY", "s-EEEE", "F-0000" , true }, \
@@ -1394,6 +1419,7 @@ enum LogMessages : uint8_t {
     LOG_RCOUT3_MSG,
     LOG_IDS_FROM_FENCE,
     LOG_IDS_FROM_HAL,
+    LOG_MAVB_MSG,
 
     _LOG_LAST_MSG_
 };
@@ -0,0 +1,337 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_PolygonIndex.h"
+#include "AP_Math.h"
+
+#include <new>
+
+// maximum number of bands. Each edge is listed once in each band it
+// overlaps, so this bounds the memory used by long north/south edges
+#ifndef AP_POLYGONINDEX_MAX_BANDS
+#define AP_POLYGONINDEX_MAX_BANDS 64
+#endif
+
+/*
+  build the index over polygon V of n points
+ */
+template <typename T>
+bool AP_PolygonIndex<T>::init(const Vector2<T> *V, uint16_t n)
+{
+    clear();
+
+    if (V == nullptr || n < 3) {
+        return false;
+    }
+    if (Polygon_complete(V, n)) {
+        // the last point is the same as the first point; treat as if
+        // the last point wasn't passed in
+        n--;
+    }
+
+    _points = V;
+    _num_edges = n;
+
+    _min = _max = V[0];
+    for (uint16_t i=1; i<n; i++) {
+        _min.x = MIN(_min.x, V[i].x);
+        _min.y = MIN(_min.y, V[i].y);
+        _max.x = MAX(_max.x, V[i].x);
+        _max.y = MAX(_max.y, V[i].y);
+    }
+
+    // aim for a few edges per band
+    _num_bands = constrain_int16(n / 4, 1, AP_POLYGONINDEX_MAX_BANDS);
+    if (std::is_floating_point<T>::value) {
+        _band_height = (_max.y - _min.y) / _num_bands;
+    } else {
+        _band_height = (int64_t(_max.y) - int64_t(_min.y)) / _num_bands + 1;
+    }
+
+    // count the edges in each band, then fill them in
+    _band_start = NEW_NOTHROW uint16_t[_num_bands+1]();
+    uint16_t *fill = NEW_NOTHROW uint16_t[_num_bands];
+    if (_band_start == nullptr || fill == nullptr) {
+        delete[] fill;
+        free_bands();
+        return false;
+    }
+    for (uint16_t i=0; i<n; i++) {
+        const uint16_t j = (i+1 < n) ? i+1 : 0;
+        const uint8_t b1 = band_for(MIN(V[i].y, V[j].y));
+        const uint8_t b2 = band_for(MAX(V[i].y, V[j].y));
+        for (uint8_t b=b1; b<=b2; b++) {
+            _band_start[b+1]++;
+        }
+    }
+    for (uint8_t b=0; b<_num_bands; b++) {
+        _band_start[b+1] += _band_start[b];
+        fill[b] = _band_start[b];
+    }
+
+    _band_edges = NEW_NOTHROW uint16_t[_band_start[_num_bands]];
+    if (_band_edges == nullptr) {
+        delete[] fill;
+        free_bands();
+        return false;
+    }
+    for (uint16_t i=0; i<n; i++) {
+        const uint16_t j = (i+1 < n) ? i+1 : 0;
+        const uint8_t b1 = band_for(MIN(V[i].y, V[j].y));
+        const uint8_t b2 = band_for(MAX(V[i].y, V[j].y));
+        for (uint8_t b=b1; b<=b2; b++) {
+            _band_edges[fill[b]++] = i;
+        }
+    }
+    delete[] fill;
+
+    return true;
+}
+
+/*
+  copy the index of an identical polygon held elsewhere
+ */
+template <typename T>
+bool AP_PolygonIndex<T>::copy_from(const AP_PolygonIndex<T> &other, const Vector2<T> *V)
+{
+    clear();
+
+    if (V == nullptr || other._band_start == nullptr || other._band_edges == nullptr) {
+        return false;
+    }
+
+    const uint16_t num_band_edges = other._band_start[other._num_bands];
+    _band_start = NEW_NOTHROW uint16_t[other._num_bands+1];
+    _band_edges = NEW_NOTHROW uint16_t[num_band_edges];
+    if (_band_start == nullptr || _band_edges == nullptr) {
+        free_bands();
+        return false;
+    }
+    memcpy(_band_start, other._band_start, (other._num_bands+1)*sizeof(uint16_t));
+    memcpy(_band_edges, other._band_edges, num_band_edges*sizeof(uint16_t));
+
+    _points = V;
+    _num_edges = other._num_edges;
+    _min = other._min;
+    _max = other._max;
+    _band_height = other._band_height;
+    _num_bands = other._num_bands;
+
+    return true;
+}
+
+/*
+  free the index
+ */
+template <typename T>
+void AP_PolygonIndex<T>::clear()
+{
+    free_bands();
+    _points = nullptr;
+    _num_edges = 0;
+}
+
+/*
+  free the bands, leaving queries to scan every edge
+ */
+template <typename T>
+void AP_PolygonIndex<T>::free_bands()
+{
+    delete[] _band_start;
+    _band_start = nullptr;
+    delete[] _band_edges;
+    _band_edges = nullptr;
+}
+
+/*
+  band holding a given y coordinate, clamped to the valid bands
+ */
+template <typename T>
+uint8_t AP_PolygonIndex<T>::band_for(T y) const
+{
+    if (y <= _min.y || _band_height <= 0) {
+        return 0;
+    }
+    if (y >= _max.y) {
+        return _num_bands-1;
+    }
+    int32_t b;
+    if (std::is_floating_point<T>::value) {
+        b = int32_t((y - _min.y) / _band_height);
+    } else {
+        b = int32_t((int64_t(y) - int64_t(_min.y)) / int64_t(_band_height));
+    }
+    return MIN(b, int32_t(_num_bands-1));
+}
+
+/*
+  true if P is outside the polygon
+ */
+template <typename T>
+bool AP_PolygonIndex<T>::outside(const Vector2<T> &P) const
+{
+    if (_points == nullptr) {
+        return true;
+    }
+    if (P.x < _min.x || P.x > _max.x || P.y < _min.y || P.y > _max.y) {
+        return true;
+    }
+    if (_band_edges == nullptr) {
+        return Polygon_outside(P, _points, _num_edges);
+    }
+
+    // only edges in P's band can straddle P.y, and the crossing test
+    // ignores edges that don't
+    const uint8_t b = band_for(P.y);
+    bool outside = true;
+    for (uint16_t k=_band_start[b]; k<_band_start[b+1]; k++) {
+        const uint16_t i = _band_edges[k];
+        const uint16_t j = (i+1 < _num_edges) ? i+1 : 0;
+        if (Polygon_edge_crossing(P, _points[i], _points[j])) {
+            outside = !outside;
+        }
+    }
+    return outside;
+}
+
+/*
+  true if the line from p1 to p2 crosses an edge of the polygon. The
+  intersection closest to p1 is returned
+ */
+template <>
+bool AP_PolygonIndex<float>::intersects(const Vector2f &p1, const Vector2f &p2, Vector2f &intersection) const
+{
+    if (_points == nullptr) {
+        return false;
+    }
+    if (_band_edges == nullptr) {
+        return Polygon_intersects(_points, _num_edges, p1, p2, intersection);
+    }
+    if (MAX(p1.x, p2.x) < _min.x || MIN(p1.x, p2.x) > _max.x ||
+        MAX(p1.y, p2.y) < _min.y || MIN(p1.y, p2.y) > _max.y) {
+        return false;
+    }
+
+    const uint8_t first = band_for(MIN(p1.y, p2.y));
+    const uint8_t last = band_for(MAX(p1.y, p2.y));
+    float intersect_dist_sq = FLT_MAX;
+    for (uint16_t k=_band_start[first]; k<_band_start[last+1]; k++) {
+        const uint16_t i = _band_edges[k];
+        const uint16_t j = (i+1 < _num_edges) ? i+1 : 0;
+        Vector2f intersect_tmp;
+        if (Vector2f::segment_intersection(_points[i], _points[j], p1, p2, intersect_tmp)) {
+            const float dist_sq = (intersect_tmp - p1).length_squared();
+            if (dist_sq < intersect_dist_sq) {
+                intersect_dist_sq = dist_sq;
+                intersection = intersect_tmp;
+            }
+        }
+    }
+    return (intersect_dist_sq < FLT_MAX);
+}
+
+/*
+  closest distance from the line p1 to p2 to an edge of the
+  polygon. Negative if the line crosses an edge, with the size being
+  the distance from p2 to the intersection closest to p1
+ */
+template <>
+float AP_PolygonIndex<float>::closest_distance_line(const Vector2f &p1, const Vector2f &p2) const
+{
+    if (_points == nullptr) {
+        return FLT_MAX;
+    }
+    Vector2f intersection;
+    if (intersects(p1, p2, intersection)) {
+        return -(intersection - p2).length();
+    }
+    if (_band_edges == nullptr) {
+        return Polygon_closest_distance_line(_points, _num_edges, p1, p2);
+    }
+
+    // search outwards from the bands the line covers until the
+    // remaining bands are further away than the closest edge
+    float closest_sq = FLT_MAX;
+    auto search = [&](uint8_t b1, uint8_t b2) {
+        for (uint16_t k=_band_start[b1]; k<_band_start[b2+1]; k++) {
+            const uint16_t i = _band_edges[k];
+            const uint16_t j = (i+1 < _num_edges) ? i+1 : 0;
+            const float dist_sq = Vector2f::closest_distance_between_lines_squared(_points[i], _points[j], p1, p2);
+            if (dist_sq < closest_sq) {
+                closest_sq = dist_sq;
+            }
+        }
+    };
+    const uint8_t first = band_for(MIN(p1.y, p2.y));
+    const uint8_t last = band_for(MAX(p1.y, p2.y));
+    search(first, last);
+    for (uint8_t step=1; step<_num_bands; step++) {
+        // there are step-1 whole bands between the line and the
+        // bands step away from it
+        if (sq((step-1) * _band_height) >= closest_sq) {
+            break;
+        }
+        if (first >= step) {
+            search(first-step, first-step);
+        }
+        if (last + step < _num_bands) {
+            search(last+step, last+step);
+        }
+    }
+    return sqrtf(closest_sq);
+}
+
+/*
+  closest distance from point p to an edge of the polygon
+ */
+template <>
+float AP_PolygonIndex<float>::closest_distance_point(const Vector2f &p) const
+{
+    if (_points == nullptr) {
+        return FLT_MAX;
+    }
+    if (_band_edges == nullptr) {
+        return Polygon_closest_distance_point(_points, _num_edges, p);
+    }
+
+    float closest_sq = FLT_MAX;
+    auto search = [&](uint8_t b) {
+        for (uint16_t k=_band_start[b]; k<_band_start[b+1]; k++) {
+            const uint16_t i = _band_edges[k];
+            const uint16_t j = (i+1 < _num_edges) ? i+1 : 0;
+            const float dist_sq = Vector2f::closest_distance_between_line_and_point_squared(_points[i], _points[j], p);
+            if (dist_sq < closest_sq) {
+                closest_sq = dist_sq;
+            }
+        }
+    };
+    const uint8_t home = band_for(p.y);
+    search(home);
+    for (uint8_t step=1; step<_num_bands; step++) {
+        if (sq((step-1) * _band_height) >= closest_sq) {
+            break;
+        }
+        if (home >= step) {
+            search(home-step);
+        }
+        if (home + step < _num_bands) {
+            search(home+step);
+        }
+    }
+    return sqrtf(closest_sq);
+}
+
+template class AP_PolygonIndex<int32_t>;
+template class AP_PolygonIndex<float>;
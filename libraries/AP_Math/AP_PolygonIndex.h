@@ -0,0 +1,108 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*
+  spatial index over the edges of a polygon.
+
+  The polygon's bounding box is split into horizontal bands, and each
+  band holds a list of the edges whose y range overlaps it. A point
+  query only needs to look at the edges in the point's band, and a
+  distance query walks outwards from the nearest band, stopping once
+  the remaining bands are further away than the best edge found.
+
+  Results are the same as the brute force Polygon_* functions, except
+  that the distance functions also consider the edge closing the
+  polygon from the last point back to the first.
+ */
+
+#include <AP_Common/AP_Common.h>
+#include "vector2.h"
+
+template <typename T>
+class AP_PolygonIndex {
+public:
+    AP_PolygonIndex() {}
+    ~AP_PolygonIndex() { clear(); }
+
+    /* Do not allow copies */
+    CLASS_NO_COPY(AP_PolygonIndex);
+
+    // build the index over polygon V of n points. V must remain
+    // valid while the index is used. Returns false if memory for
+    // the bands could not be allocated, in which case queries scan
+    // every edge
+    bool init(const Vector2<T> *V, uint16_t n);
+
+    // build the index as a copy of other, over V which must hold the
+    // same points as the polygon other was built over. Cheaper than
+    // init() for an unchanged polygon. Returns false if other has no
+    // bands or memory could not be allocated, in which case init()
+    // should be used
+    bool copy_from(const AP_PolygonIndex<T> &other, const Vector2<T> *V);
+
+    // free the index
+    void clear();
+
+    // true if init() has been called with a polygon
+    bool valid() const { return _points != nullptr; }
+
+    // true if P is outside the polygon, as per Polygon_outside()
+    bool outside(const Vector2<T> &P) const WARN_IF_UNUSED;
+
+    // bounding box of the polygon
+    const Vector2<T> &bbox_min() const { return _min; }
+    const Vector2<T> &bbox_max() const { return _max; }
+
+    /*
+      the functions below are only available for float polygons
+     */
+
+    // true if the line from p1 to p2 crosses an edge, as per
+    // Polygon_intersects(). intersection is the crossing closest to p1
+    bool intersects(const Vector2<T> &p1, const Vector2<T> &p2, Vector2<T> &intersection) const WARN_IF_UNUSED;
+
+    // closest distance from the line p1 to p2 to an edge, as per
+    // Polygon_closest_distance_line()
+    T closest_distance_line(const Vector2<T> &p1, const Vector2<T> &p2) const;
+
+    // closest distance from point p to an edge, as per
+    // Polygon_closest_distance_point()
+    T closest_distance_point(const Vector2<T> &p) const;
+
+private:
+    // band holding a given y coordinate, clamped to the valid bands
+    uint8_t band_for(T y) const;
+
+    // free the bands, leaving queries to scan every edge
+    void free_bands();
+
+    const Vector2<T> *_points = nullptr;
+    uint16_t _num_edges;
+    Vector2<T> _min;
+    Vector2<T> _max;
+    T _band_height;
+
+    // edges of band b are _band_edges[_band_start[b]] to
+    // _band_edges[_band_start[b+1]-1]
+    uint8_t _num_bands;
+    uint16_t *_band_start = nullptr;
+    uint16_t *_band_edges = nullptr;
+};
+
+// distance functions are only implemented for float polygons
+template <> bool AP_PolygonIndex<float>::intersects(const Vector2f &p1, const Vector2f &p2, Vector2f &intersection) const;
+template <> float AP_PolygonIndex<float>::closest_distance_line(const Vector2f &p1, const Vector2f &p2) const;
+template <> float AP_PolygonIndex<float>::closest_distance_point(const Vector2f &p) const;
@@ -0,0 +1,79 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Math/AP_PolygonIndex.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#define NUM_POINTS 70
+
+// irregular fence of NUM_POINTS points, in cm
+static void make_polygon(Vector2f *V, uint16_t n)
+{
+    for (uint16_t i=0; i<n; i++) {
+        const float angle = i * M_2PI / n;
+        const float radius = 50000.0f + (i * 7919) % 20000;
+        V[i] = Vector2f(radius * cosf(angle), radius * sinf(angle));
+    }
+}
+
+static void BM_PolygonOutside(benchmark::State& state)
+{
+    Vector2f V[NUM_POINTS];
+    make_polygon(V, NUM_POINTS);
+    const Vector2f p(12345.0f, -2345.0f);
+
+    while (state.KeepRunning()) {
+        bool outside = Polygon_outside(p, V, NUM_POINTS);
+        gbenchmark_escape(&outside);
+    }
+}
+
+static void BM_PolygonIndexOutside(benchmark::State& state)
+{
+    Vector2f V[NUM_POINTS];
+    make_polygon(V, NUM_POINTS);
+    AP_PolygonIndex<float> index;
+    index.init(V, NUM_POINTS);
+    const Vector2f p(12345.0f, -2345.0f);
+
+    while (state.KeepRunning()) {
+        bool outside = index.outside(p);
+        gbenchmark_escape(&outside);
+    }
+}
+
+static void BM_PolygonClosestDistanceLine(benchmark::State& state)
+{
+    Vector2f V[NUM_POINTS];
+    make_polygon(V, NUM_POINTS);
+    const Vector2f p1(12345.0f, -2345.0f);
+    const Vector2f p2(14345.0f, -2045.0f);
+
+    while (state.KeepRunning()) {
+        float dist = Polygon_closest_distance_line(V, NUM_POINTS, p1, p2);
+        gbenchmark_escape(&dist);
+    }
+}
+
+static void BM_PolygonIndexClosestDistanceLine(benchmark::State& state)
+{
+    Vector2f V[NUM_POINTS];
+    make_polygon(V, NUM_POINTS);
+    AP_PolygonIndex<float> index;
+    index.init(V, NUM_POINTS);
+    const Vector2f p1(12345.0f, -2345.0f);
+    const Vector2f p2(14345.0f, -2045.0f);
+
+    while (state.KeepRunning()) {
+        float dist = index.closest_distance_line(p1, p2);
+        gbenchmark_escape(&dist);
+    }
+}
+
+BENCHMARK(BM_PolygonOutside);
+BENCHMARK(BM_PolygonIndexOutside);
+BENCHMARK(BM_PolygonClosestDistanceLine);
+BENCHMARK(BM_PolygonIndexClosestDistanceLine);
+
+BENCHMARK_MAIN();
@@ -21,6 +21,9 @@
 
 template <typename T>
 bool        Polygon_outside(const Vector2<T> &P, const Vector2<T> *V, unsigned n) WARN_IF_UNUSED;
+template <typename T>
+bool        Polygon_edge_crossing(const Vector2<T> &P, const Vector2<T> &V1, const Vector2<T> &V2) WARN_IF_UNUSED;
+
 template <typename T>
 bool        Polygon_complete(const Vector2<T> *V, unsigned n) WARN_IF_UNUSED;
 
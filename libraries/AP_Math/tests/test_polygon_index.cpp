@@ -0,0 +1,145 @@
+#include <AP_gtest.h>
+#include <AP_Common/AP_Common.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Math/AP_PolygonIndex.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  the index should give the same answers as the brute force Polygon_*
+  functions, given a closed copy of the polygon for the distance
+  functions
+ */
+
+#define MAX_POINTS 200
+
+// irregular star shaped polygon of n points around the origin
+static void make_polygon(Vector2f *V, uint16_t n)
+{
+    for (uint16_t i=0; i<n; i++) {
+        const float angle = i * M_2PI / n;
+        const float radius = 1000.0f + (i * 7919) % 800;
+        V[i] = Vector2f(radius * cosf(angle), radius * sinf(angle));
+    }
+}
+
+static Vector2f random_point(void)
+{
+    return Vector2f((rand() % 4400) - 2200, (rand() % 4400) - 2200);
+}
+
+TEST(PolygonIndex, outside)
+{
+    srand(1);
+    for (uint16_t n=3; n<MAX_POINTS; n+=13) {
+        Vector2f V[MAX_POINTS];
+        make_polygon(V, n);
+        AP_PolygonIndex<float> index;
+        EXPECT_TRUE(index.init(V, n));
+        for (uint16_t i=0; i<500; i++) {
+            const Vector2f p = random_point();
+            EXPECT_EQ(Polygon_outside(p, V, n), index.outside(p));
+        }
+        // vertices themselves
+        for (uint16_t i=0; i<n; i++) {
+            EXPECT_EQ(Polygon_outside(V[i], V, n), index.outside(V[i]));
+        }
+    }
+}
+
+TEST(PolygonIndex, outside_long)
+{
+    srand(2);
+    for (uint16_t n=3; n<MAX_POINTS; n+=13) {
+        Vector2f V[MAX_POINTS];
+        make_polygon(V, n);
+        Vector2l L[MAX_POINTS];
+        for (uint16_t i=0; i<n; i++) {
+            L[i] = Vector2l(V[i].x * 1000 - 350000000, V[i].y * 1000 + 1490000000);
+        }
+        AP_PolygonIndex<int32_t> index;
+        EXPECT_TRUE(index.init(L, n));
+        for (uint16_t i=0; i<500; i++) {
+            const Vector2f r = random_point();
+            const Vector2l p(r.x * 1000 - 350000000, r.y * 1000 + 1490000000);
+            EXPECT_EQ(Polygon_outside(p, L, n), index.outside(p));
+        }
+    }
+}
+
+TEST(PolygonIndex, closest_distance)
+{
+    srand(3);
+    for (uint16_t n=3; n<MAX_POINTS; n+=13) {
+        Vector2f V[MAX_POINTS+1];
+        make_polygon(V, n);
+        AP_PolygonIndex<float> index;
+        EXPECT_TRUE(index.init(V, n));
+        V[n] = V[0]; // close it for the brute force functions
+        for (uint16_t i=0; i<500; i++) {
+            const Vector2f p1 = random_point();
+            const Vector2f p2 = random_point();
+            EXPECT_NEAR(Polygon_closest_distance_point(V, n+1, p1),
+                        index.closest_distance_point(p1), 1e-2);
+            EXPECT_NEAR(Polygon_closest_distance_line(V, n+1, p1, p2),
+                        index.closest_distance_line(p1, p2), 1e-2);
+            Vector2f intersection1, intersection2;
+            const bool intersects = Polygon_intersects(V, n+1, p1, p2, intersection1);
+            EXPECT_EQ(intersects, index.intersects(p1, p2, intersection2));
+            if (intersects) {
+                EXPECT_NEAR(intersection1.x, intersection2.x, 1e-2);
+                EXPECT_NEAR(intersection1.y, intersection2.y, 1e-2);
+            }
+        }
+    }
+}
+
+TEST(PolygonIndex, copy_from)
+{
+    srand(4);
+    Vector2f V[MAX_POINTS];
+    make_polygon(V, 57);
+    AP_PolygonIndex<float> index;
+    EXPECT_TRUE(index.init(V, 57));
+
+    // the copy is bound to its own copy of the points and must
+    // outlive the original index
+    Vector2f V2[MAX_POINTS];
+    memcpy(V2, V, sizeof(V));
+    AP_PolygonIndex<float> copy;
+    EXPECT_TRUE(copy.copy_from(index, V2));
+    index.clear();
+    for (uint16_t i=0; i<500; i++) {
+        const Vector2f p = random_point();
+        EXPECT_EQ(Polygon_outside(p, V, 57), copy.outside(p));
+    }
+
+    // nothing to copy from an empty index
+    AP_PolygonIndex<float> empty;
+    EXPECT_FALSE(copy.copy_from(empty, V2));
+    EXPECT_FALSE(copy.valid());
+}
+
+TEST(PolygonIndex, closed_polygon)
+{
+    // passing the closing point should give the same index
+    Vector2f V[5] = {{0,0}, {0,10}, {10,10}, {10,0}, {0,0}};
+    AP_PolygonIndex<float> index;
+    EXPECT_TRUE(index.init(V, 5));
+    EXPECT_FALSE(index.outside(Vector2f{5,5}));
+    EXPECT_TRUE(index.outside(Vector2f{15,5}));
+    EXPECT_NEAR(5.0f, index.closest_distance_point(Vector2f{5,5}), 1e-5);
+}
+
+TEST(PolygonIndex, invalid)
+{
+    AP_PolygonIndex<float> index;
+    EXPECT_FALSE(index.valid());
+    EXPECT_TRUE(index.outside(Vector2f{0,0}));
+    const Vector2f V[2] = {{0,0}, {1,1}};
+    EXPECT_FALSE(index.init(V, 2));
+    EXPECT_FALSE(index.valid());
+}
+
+AP_GTEST_MAIN()
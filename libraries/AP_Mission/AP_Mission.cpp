@@ -39,9 +39,9 @@ const AP_Param::GroupInfo AP_Mission::var_info[] = {
     // @Param: OPTIONS
     // @DisplayName: Mission options bitmask
     // @Description: Bitmask of what options to use in missions.
-    // @Bitmask: 0:Clear Mission on reboot, 1:Use distance to land calc on battery failsafe,2:ContinueAfterLand
-    // @Bitmask{Copter}: 0:Clear Mission on reboot, 2:ContinueAfterLand
-    // @Bitmask{Rover, Sub}: 0:Clear Mission on reboot
+    // @Bitmask: 0:Clear Mission on reboot, 1:Use distance to land calc on battery failsafe,2:ContinueAfterLand,3:Pipelined mission upload
+    // @Bitmask{Copter}: 0:Clear Mission on reboot, 2:ContinueAfterLand, 3:Pipelined mission upload
+    // @Bitmask{Rover, Sub}: 0:Clear Mission on reboot, 3:Pipelined mission upload
     // @User: Advanced
     AP_GROUPINFO("OPTIONS",  2, AP_Mission, _options, AP_MISSION_OPTIONS_DEFAULT),
 
@@ -86,6 +86,9 @@ void AP_Mission::init()
         _cmd_total.set(0);
     }
 
+#if AP_MISSION_CMD_CACHE_ENABLED
+    cmd_cache_init();
+#endif
 
     // check_eeprom_version - checks version of missions stored in eeprom matches this library
     // command list will be cleared if they do not match
@@ -508,6 +511,36 @@ bool AP_Mission::replace_cmd(uint16_t index, const Mission_Command& cmd)
     return write_cmd_to_storage(index, cmd);
 }
 
+/// write_cmds - writes count commands to consecutive positions in the command list starting at start_index
+///     commands past the end of the list are added to it, and the number of commands is saved once for the whole batch
+///     returns true if all commands were written, false on failure
+bool AP_Mission::write_cmds(uint16_t start_index, const Mission_Command *cmds, uint16_t count)
+{
+    WITH_SEMAPHORE(_rsem);
+
+    // commands must replace or directly follow existing commands
+    const uint16_t cmd_total = _cmd_total;
+    if (start_index > cmd_total) {
+        return false;
+    }
+
+    uint16_t written = 0;
+    while (written < count) {
+        if (!write_cmd_to_storage(start_index + written, cmds[written])) {
+            break;
+        }
+        written++;
+    }
+
+    // save the new number of commands once rather than per command
+    const uint16_t new_total = MAX(cmd_total, uint16_t(start_index + written));
+    if (new_total != cmd_total) {
+        _cmd_total.set_and_save(new_total);
+    }
+
+    return written == count;
+}
+
 /// is_nav_cmd - returns true if the command's id is a "navigation" command, false if "do" or "conditional" command
 bool AP_Mission::is_nav_cmd(const Mission_Command& cmd)
 {
@@ -796,6 +829,13 @@ bool AP_Mission::read_cmd_from_storage(uint16_t index, Mission_Command& cmd) con
         return false;
     }
 
+#if AP_MISSION_CMD_CACHE_ENABLED
+    if (cmd_cache_valid(index)) {
+        cmd = _cmd_cache.cmds[index];
+        return true;
+    }
+#endif
+
     // ensure all bytes of cmd are zeroed
     cmd = {};
 
@@ -854,6 +894,13 @@ bool AP_Mission::read_cmd_from_storage(uint16_t index, Mission_Command& cmd) con
     // set command's index to it's position in eeprom
     cmd.index = index;
 
+#if AP_MISSION_CMD_CACHE_ENABLED
+    if (index < _cmd_cache.size) {
+        _cmd_cache.cmds[index] = cmd;
+        _cmd_cache.valid[index/32] |= 1U<<(index%32);
+    }
+#endif
+
     // return success
     return true;
 }
@@ -897,6 +944,17 @@ bool AP_Mission::write_cmd_to_storage(uint16_t index, const Mission_Command& cmd
         return false;
     }
 
+    // cached copy and command index no longer match storage
+#if AP_MISSION_CMD_CACHE_ENABLED
+    if (index < _cmd_cache.size) {
+        _cmd_cache.valid[index/32] &= ~(1U<<(index%32));
+    }
+#endif
+    _cmd_index.valid = false;
+#if AP_MISSION_LEG_CACHE_ENABLED
+    _legs.valid = false;
+#endif
+
     PackedContent packed {};
     if (stored_in_location(cmd.id)) {
         // Location is not PACKED; field-wise copy it:
@@ -2128,6 +2186,7 @@ bool AP_Mission::get_next_cmd(uint16_t start_index, Mission_Command& cmd, bool i
         // check for do-jump-tag command and convert target tag to do-jump target index and do-jump to it
         if (temp_cmd.id == MAV_CMD_DO_JUMP_TAG) {
             // convert tmp_cmd target from a target tag to a target index
+            update_cmd_index();
             temp_cmd.content.jump.target = get_index_of_jump_tag(temp_cmd.content.jump.target);
             temp_cmd.id = MAV_CMD_DO_JUMP;
         }
@@ -2216,6 +2275,7 @@ bool AP_Mission::get_next_do_cmd(uint16_t start_index, Mission_Command& cmd)
 // Returns true on success, else false if no appropriate JUMP_TAG match can be found or if setting the index failed
 bool AP_Mission::jump_to_tag(const uint16_t tag)
 {
+    update_cmd_index();
     const uint16_t index = get_index_of_jump_tag(tag);
     if (index == 0) {
         return false;
@@ -2227,11 +2287,7 @@ bool AP_Mission::jump_to_tag(const uint16_t tag)
 // Returns 0 if no appropriate JUMP_TAG match can be found.
 uint16_t AP_Mission::get_index_of_jump_tag(const uint16_t tag) const
 {
-    const auto count = num_commands();
-    for (uint16_t i = 1; i < count; i++) {
-        if (get_command_id(i) != uint16_t(MAV_CMD_JUMP_TAG)) {
-            continue;
-        }
+    for (uint16_t i = find_next_cmd_with_id(MAV_CMD_JUMP_TAG, 1); i != 0; i = find_next_cmd_with_id(MAV_CMD_JUMP_TAG, i+1)) {
         Mission_Command tmp;
         if (!read_cmd_from_storage(i, tmp)) {
             continue;
@@ -2347,11 +2403,8 @@ uint16_t AP_Mission::get_landing_sequence_start(const Location &current_loc)
     float min_distance = -1;
 
     // Go through mission looking for nearest landing start command
-    const auto count = num_commands();
-    for (uint16_t i = 1; i < count; i++) {
-        if (get_command_id(i) != uint16_t(MAV_CMD_DO_LAND_START)) {
-            continue;
-        }
+    update_cmd_index();
+    for (uint16_t i = find_next_cmd_with_id(MAV_CMD_DO_LAND_START, 1); i != 0; i = find_next_cmd_with_id(MAV_CMD_DO_LAND_START, i+1)) {
         Mission_Command tmp;
         if (!read_cmd_from_storage(i, tmp)) {
             continue;
@@ -2417,7 +2470,8 @@ bool AP_Mission::jump_to_closest_mission_leg(const Location &current_loc)
     float min_distance = -1;
 
     // Go through mission and check each DO_RETURN_PATH_START
-    for (uint16_t i = 1; i < num_commands(); i++) {
+    update_cmd_index();
+    for (uint16_t i = find_next_cmd_with_id(MAV_CMD_DO_RETURN_PATH_START, 1); i != 0; i = find_next_cmd_with_id(MAV_CMD_DO_RETURN_PATH_START, i+1)) {
         Mission_Command tmp;
         if (read_cmd_from_storage(i, tmp) && (tmp.id == MAV_CMD_DO_RETURN_PATH_START)) {
             uint16_t tmp_index;
@@ -2451,11 +2505,8 @@ bool AP_Mission::jump_to_abort_landing_sequence(const Location &current_loc)
     uint16_t abort_index = 0;
     float min_distance = FLT_MAX;
 
-    const auto count = num_commands();
-    for (uint16_t i = 1; i < count; i++) {
-        if (get_command_id(i) != uint16_t(MAV_CMD_DO_GO_AROUND)) {
-            continue;
-        }
+    update_cmd_index();
+    for (uint16_t i = find_next_cmd_with_id(MAV_CMD_DO_GO_AROUND, 1); i != 0; i = find_next_cmd_with_id(MAV_CMD_DO_GO_AROUND, i+1)) {
         Mission_Command tmp;
         if (!read_cmd_from_storage(i, tmp)) {
             continue;
@@ -2542,6 +2593,13 @@ bool AP_Mission::is_best_land_sequence(const Location &current_loc)
 // Approximate the distance travelled to get to a landing.  DO_JUMP commands are observed in look forward.
 bool AP_Mission::distance_to_landing(uint16_t index, float &tot_distance, Location prev_loc)
 {
+#if AP_MISSION_LEG_CACHE_ENABLED
+    bool landing_found;
+    if (legs_distance_to_landing(index, prev_loc, landing_found, tot_distance)) {
+        return landing_found;
+    }
+#endif
+
     Mission_Command temp_cmd;
     tot_distance = 0.0f;
     bool ret = false;  // reached end of loop without getting to a landing
@@ -2598,6 +2656,13 @@ reset_do_jump_tracking:
 // Stop searching once reaching a landing or do-land-start
 bool AP_Mission::distance_to_mission_leg(uint16_t start_index, float &rejoin_distance, uint16_t &rejoin_index, const Location& current_loc)
 {
+#if AP_MISSION_LEG_CACHE_ENABLED
+    bool found;
+    if (legs_distance_to_mission_leg(start_index, current_loc, found, rejoin_distance, rejoin_index)) {
+        return found;
+    }
+#endif
+
     Location prev_loc;
     Mission_Command temp_cmd;
     rejoin_distance = -1;
@@ -2849,6 +2914,11 @@ const char *AP_Mission::Mission_Command::type() const
  */
 uint16_t AP_Mission::get_command_id(uint16_t index) const
 {
+#if AP_MISSION_CMD_CACHE_ENABLED
+    if (cmd_cache_valid(index)) {
+        return _cmd_cache.cmds[index].id;
+    }
+#endif
     const uint16_t pos_in_storage = 4 + (index * AP_MISSION_EEPROM_COMMAND_SIZE);
     uint8_t b[3] {};
     if (!_storage.read_block(b, pos_in_storage, sizeof(b))) {
@@ -2868,11 +2938,7 @@ uint16_t AP_Mission::get_command_id(uint16_t index) const
  */
 bool AP_Mission::contains_item(MAV_CMD command) const
 {
-    const auto count = num_commands();
-    for (uint16_t i = 1; i < count; i++) {
-        if (get_command_id(i) != uint16_t(command)) {
-            continue;
-        }
+    for (uint16_t i = find_next_cmd_with_id(command, 1); i != 0; i = find_next_cmd_with_id(command, i+1)) {
         // confirm with full read
         Mission_Command tmp;
         if (!read_cmd_from_storage(i, tmp)) {
@@ -2885,6 +2951,364 @@ bool AP_Mission::contains_item(MAV_CMD command) const
     return false;
 }
 
+/*
+  return true if commands with this id are held in the command index
+ */
+bool AP_Mission::is_indexed_cmd(uint16_t id)
+{
+    switch (id) {
+    case MAV_CMD_DO_LAND_START:
+    case MAV_CMD_DO_RETURN_PATH_START:
+    case MAV_CMD_DO_GO_AROUND:
+    case MAV_CMD_DO_JUMP:
+    case MAV_CMD_DO_JUMP_TAG:
+    case MAV_CMD_JUMP_TAG:
+    case MAV_CMD_NAV_LAND:
+    case MAV_CMD_NAV_VTOL_LAND:
+    case MAV_CMD_DO_PARACHUTE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/*
+  rebuild the command index if the mission has changed. Writes only
+  mark the index invalid, it is rebuilt here the next time a search
+  needs it, so an upload doesn't rebuild it once per item
+ */
+void AP_Mission::update_cmd_index()
+{
+    WITH_SEMAPHORE(_rsem);
+
+    if (_cmd_index.valid && _cmd_index.cmd_total == _cmd_total) {
+        return;
+    }
+
+    _cmd_index.count = 0;
+    const auto count = num_commands();
+    for (uint16_t i = 1; i < count; i++) {
+        const uint16_t id = get_command_id(i);
+        if (!is_indexed_cmd(id)) {
+            continue;
+        }
+        if (_cmd_index.count >= _cmd_index.space) {
+            // grow the index, keeping the entries found so far
+            const uint16_t new_space = MAX(_cmd_index.space * 2U, AP_MISSION_CMD_INDEX_CHUNK);
+            CmdIndexEntry *new_entries = NEW_NOTHROW CmdIndexEntry[new_space];
+            if (new_entries == nullptr) {
+                // searches will read the id of each command
+                _cmd_index.valid = false;
+                return;
+            }
+            if (_cmd_index.count > 0) {
+                memcpy(new_entries, _cmd_index.entries, _cmd_index.count * sizeof(CmdIndexEntry));
+            }
+            delete[] _cmd_index.entries;
+            _cmd_index.entries = new_entries;
+            _cmd_index.space = new_space;
+        }
+        _cmd_index.entries[_cmd_index.count++] = { i, id };
+    }
+    _cmd_index.cmd_total = _cmd_total;
+    _cmd_index.valid = true;
+}
+
+/*
+  returns the position of the first command with this id at or after
+  start_index, or 0 if there is none
+ */
+uint16_t AP_Mission::find_next_cmd_with_id(uint16_t id, uint16_t start_index) const
+{
+    WITH_SEMAPHORE(_rsem);
+
+    if (_cmd_index.valid && _cmd_index.cmd_total == _cmd_total && is_indexed_cmd(id)) {
+        for (uint16_t i = 0; i < _cmd_index.count; i++) {
+            const CmdIndexEntry &entry = _cmd_index.entries[i];
+            if (entry.index >= start_index && entry.id == id) {
+                return entry.index;
+            }
+        }
+        return 0;
+    }
+
+    const auto count = num_commands();
+    for (uint16_t i = MAX(start_index, 1U); i < count; i++) {
+        if (get_command_id(i) == id) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+#if AP_MISSION_LEG_CACHE_ENABLED
+/*
+  returns true if commands with this id are held in the leg cache
+ */
+bool AP_Mission::is_leg_cmd(uint16_t id)
+{
+    Mission_Command cmd {};
+    cmd.id = id;
+    return stored_in_location(id) ||
+           is_nav_cmd(cmd) ||
+           id == MAV_CMD_CONDITION_DELAY ||
+           id == MAV_CMD_DO_JUMP ||
+           id == MAV_CMD_DO_JUMP_TAG;
+}
+
+/*
+  rebuild the leg cache if the mission has changed. Returns true if
+  the leg cache can be used
+ */
+bool AP_Mission::update_leg_cache()
+{
+    WITH_SEMAPHORE(_rsem);
+
+    if (_legs.valid && _legs.cmd_total == _cmd_total) {
+        return true;
+    }
+
+    // count legs so the cache is allocated once
+    const auto count = num_commands();
+    uint16_t needed = 0;
+    for (uint16_t i = 1; i < count; i++) {
+        if (is_leg_cmd(get_command_id(i))) {
+            needed++;
+        }
+    }
+    if (needed > _legs.space) {
+        delete[] _legs.entries;
+        _legs.space = 0;
+        _legs.count = 0;
+        _legs.entries = NEW_NOTHROW MissionLeg[needed];
+        if (_legs.entries == nullptr) {
+            // distance queries will walk the mission in storage
+            _legs.valid = false;
+            return false;
+        }
+        _legs.space = needed;
+    }
+
+    _legs.count = 0;
+    _legs.origin = {};
+    Location prev_route_loc {};
+    float route_dist = 0;
+    for (uint16_t i = 1; i < count && _legs.count < needed; i++) {
+        Mission_Command cmd;
+        if (!is_leg_cmd(get_command_id(i)) || !read_cmd_from_storage(i, cmd)) {
+            continue;
+        }
+        MissionLeg &leg = _legs.entries[_legs.count++];
+        leg.index = i;
+        leg.id = cmd.id;
+        leg.is_nav = is_nav_cmd(cmd);
+        leg.loc = stored_in_location(cmd.id) ? cmd.content.location : Location{};
+        if (leg.loc.lat != 0 || leg.loc.lng != 0) {
+            if (_legs.origin.lat == 0 && _legs.origin.lng == 0) {
+                _legs.origin = leg.loc;
+            }
+            leg.ne = _legs.origin.get_distance_NE(leg.loc);
+            // distance along the points distance_to_landing adds up
+            if (cmd.id == MAV_CMD_NAV_WAYPOINT || cmd.id == MAV_CMD_NAV_SPLINE_WAYPOINT || is_landing_type_cmd(cmd.id)) {
+                if (prev_route_loc.lat != 0 || prev_route_loc.lng != 0) {
+                    route_dist += prev_route_loc.get_distance(leg.loc);
+                }
+                prev_route_loc = leg.loc;
+            }
+        } else {
+            leg.ne.zero();
+        }
+        leg.route_dist = route_dist;
+    }
+    _legs.cmd_total = _cmd_total;
+    _legs.valid = true;
+    return true;
+}
+
+/*
+  returns the position in the leg cache of the first leg at or after
+  the command at index
+ */
+uint16_t AP_Mission::leg_at_or_after(uint16_t index) const
+{
+    uint16_t lo = 0;
+    uint16_t hi = _legs.count;
+    while (lo < hi) {
+        const uint16_t mid = (lo + hi) / 2;
+        if (_legs.entries[mid].index < index) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/*
+  distance_to_landing using the leg cache. Returns false if the walk
+  would follow a jump, or the leg cache is unavailable
+ */
+bool AP_Mission::legs_distance_to_landing(uint16_t index, const Location &current_loc, bool &landing_found, float &tot_distance)
+{
+    WITH_SEMAPHORE(_rsem);
+
+    // the home command is not in the leg cache
+    if (index == 0 || !update_leg_cache()) {
+        return false;
+    }
+
+    landing_found = false;
+    tot_distance = 0.0f;
+    const MissionLeg *first = nullptr;
+    const MissionLeg *last = nullptr;
+    uint16_t route_points = 0;
+    for (uint16_t i = leg_at_or_after(index); i < _legs.count; i++) {
+        const MissionLeg &leg = _legs.entries[i];
+        if (leg.id == MAV_CMD_DO_JUMP || leg.id == MAV_CMD_DO_JUMP_TAG) {
+            return false;
+        }
+        if (leg.id == MAV_CMD_NAV_WAYPOINT || leg.id == MAV_CMD_NAV_SPLINE_WAYPOINT || is_landing_type_cmd(leg.id)) {
+            // the walk over storage looks at no more than UINT8_MAX of these
+            if (++route_points > UINT8_MAX) {
+                break;
+            }
+            if (leg.loc.lat != 0 || leg.loc.lng != 0) {
+                if (first == nullptr) {
+                    first = &leg;
+                }
+                last = &leg;
+            }
+            if (is_landing_type_cmd(leg.id)) {
+                landing_found = true;
+                break;
+            }
+        } else if (leg.is_nav || leg.id == MAV_CMD_CONDITION_DELAY) {
+            // can't measure the distance through other navigation commands
+            break;
+        }
+    }
+
+    if (first != nullptr) {
+        tot_distance = current_loc.get_distance(first->loc) + (last->route_dist - first->route_dist);
+    }
+    return true;
+}
+
+/*
+  distance_to_mission_leg using the leg cache. Returns false if the
+  walk would follow a jump, or the leg cache is unavailable
+ */
+bool AP_Mission::legs_distance_to_mission_leg(uint16_t start_index, const Location &current_loc, bool &found, float &rejoin_distance, uint16_t &rejoin_index)
+{
+    WITH_SEMAPHORE(_rsem);
+
+    // the home command is not in the leg cache
+    if (start_index == 0 || !update_leg_cache()) {
+        return false;
+    }
+
+    found = false;
+    rejoin_distance = -1;
+    rejoin_index = -1;
+
+    // horizontal offsets are all taken from the cache's shared NE
+    // origin rather than from each leg's previous location as the walk
+    // over storage does. The difference is negligible over the size of
+    // a mission
+    const Vector2f pos_ne = _legs.origin.get_distance_NE(current_loc);
+    int32_t current_alt;
+    const bool current_alt_ok = current_loc.get_alt_cm(Location::AltFrame::ABSOLUTE, current_alt);
+
+    const MissionLeg *prev = nullptr;
+    int32_t prev_alt = 0;
+    bool prev_alt_ok = false;
+    for (uint16_t i = leg_at_or_after(start_index); i < _legs.count; i++) {
+        const MissionLeg &leg = _legs.entries[i];
+        // the walk over storage looks at no more than UINT8_MAX
+        // commands and reports no leg found if it reaches that limit
+        // without a landing
+        if (leg.index - start_index >= UINT8_MAX) {
+            found = false;
+            break;
+        }
+        if (leg.id == MAV_CMD_DO_JUMP || leg.id == MAV_CMD_DO_JUMP_TAG) {
+            return false;
+        }
+
+        if (stored_in_location(leg.id) && leg.loc.initialised()) {
+            int32_t alt;
+            const bool alt_ok = leg.loc.get_alt_cm(Location::AltFrame::ABSOLUTE, alt);
+            if (prev == nullptr || (prev->loc.lat == 0 && prev->loc.lng == 0)) {
+                // single point dist calc
+                prev = &leg;
+                prev_alt = alt;
+                prev_alt_ok = alt_ok;
+                rejoin_distance = leg.loc.get_distance_NED_alt_frame(current_loc).length();
+                rejoin_index = leg.index;
+                found = true;
+
+            } else {
+                // NED offsets as given by Location::get_distance_NED_alt_frame
+                const Vector3f mission_vector {leg.ne - prev->ne, (prev_alt_ok && alt_ok) ? (prev_alt - alt) * 0.01f : 0.0f};
+                if (!mission_vector.is_zero()) {
+                    const Vector3f pos {pos_ne - prev->ne, (prev_alt_ok && current_alt_ok) ? (prev_alt - current_alt) * 0.01f : 0.0f};
+
+                    // project pos vector on to mission vector
+                    Vector3f p = pos.projected(mission_vector);
+
+                    // constrain to mission line
+                    p.x = constrain_float(p.x, MIN(0,mission_vector.x), MAX(0,mission_vector.x));
+                    p.y = constrain_float(p.y, MIN(0,mission_vector.y), MAX(0,mission_vector.y));
+                    p.z = constrain_float(p.z, MIN(0,mission_vector.z), MAX(0,mission_vector.z));
+
+                    const float disttemp = (p - pos).length();
+
+                    prev = &leg;
+                    prev_alt = alt;
+                    prev_alt_ok = alt_ok;
+
+                    if (disttemp < rejoin_distance || is_negative(rejoin_distance)) {
+                        rejoin_distance = disttemp;
+                        rejoin_index = leg.index;
+                    }
+                    found = true;
+                }
+            }
+        }
+
+        if (is_landing_type_cmd(leg.id) || (leg.id == MAV_CMD_DO_LAND_START)) {
+            break;
+        }
+    }
+    return true;
+}
+#endif  // AP_MISSION_LEG_CACHE_ENABLED
+
+#if AP_MISSION_CMD_CACHE_ENABLED
+/*
+  allocate the command cache. available_memory() is a fixed value on
+  SITL and Linux rather than the free memory, so the size comes from
+  the board's memory class
+ */
+void AP_Mission::cmd_cache_init()
+{
+    const uint16_t size = MIN(uint32_t(_commands_max), uint32_t(AP_MISSION_CMD_CACHE_SIZE));
+    if (size == 0) {
+        return;
+    }
+    _cmd_cache.cmds = NEW_NOTHROW Mission_Command[size];
+    _cmd_cache.valid = NEW_NOTHROW uint32_t[(size+31)/32]();
+    if (_cmd_cache.cmds == nullptr || _cmd_cache.valid == nullptr) {
+        delete[] _cmd_cache.cmds;
+        delete[] _cmd_cache.valid;
+        _cmd_cache.cmds = nullptr;
+        _cmd_cache.valid = nullptr;
+        return;
+    }
+    _cmd_cache.size = size;
+}
+#endif  // AP_MISSION_CMD_CACHE_ENABLED
+
 /*
   return true if the mission item has a location
 */
@@ -47,6 +47,9 @@
 #define AP_MISSION_OPTIONS_DEFAULT          0       // Do not clear the mission when rebooting
 
 #define AP_MISSION_MAX_WP_HISTORY           7       // The maximum number of previous wp commands that will be stored from the active missions history
+
+#define AP_MISSION_CMD_INDEX_CHUNK          8       // command index grows in increments of 8 entries
+
 #define LAST_WP_PASSED (AP_MISSION_MAX_WP_HISTORY-2)
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_CHIBIOS
@@ -551,6 +554,12 @@ public:
     ///     returns true if successfully replaced, false on failure
     bool replace_cmd(uint16_t index, const Mission_Command& cmd);
 
+    /// write_cmds - writes count commands to consecutive positions in the command list starting at start_index
+    ///     commands past the end of the list are added to it, and the number of commands is saved once for the whole batch
+    ///     start_index must not be past the end of the command list
+    ///     returns true if all commands were written, false on failure (commands before the failing one will have been written)
+    bool write_cmds(uint16_t start_index, const Mission_Command *cmds, uint16_t count);
+
     /// is_nav_cmd - returns true if the command's id is a "navigation" command, false if "do" or "conditional" command
     static bool is_nav_cmd(const Mission_Command& cmd);
 
@@ -738,6 +747,7 @@ public:
         CLEAR_ON_BOOT            =  0,  // clear mission on vehicle boot
         FAILSAFE_TO_BEST_LANDING =  1,  // on failsafe, find fastest path along mission home
         CONTINUE_AFTER_LAND      =  2,  // continue running mission (do not disarm) after land if takeoff is next waypoint
+        PIPELINED_UPLOAD         =  3,  // request several mission items at once during upload and write them to storage in batches
     };
     bool option_is_set(Option option) const {
         return (_options.get() & (uint16_t)option) != 0;
@@ -747,6 +757,9 @@ public:
     bool continue_after_land(void) const {
         return option_is_set(Option::CONTINUE_AFTER_LAND);
     }
+    bool pipelined_upload(void) const {
+        return option_is_set(Option::PIPELINED_UPLOAD);
+    }
 
     // user settable parameters
     static const struct AP_Param::GroupInfo var_info[];
@@ -927,6 +940,87 @@ private:
     uint32_t _last_contains_relative_calculated_ms;  // will be equal to _last_change_time_ms if _contains_terrain_alt_items is up-to-date
     bool calculate_contains_terrain_alt_items(void) const;
 
+    // positions of the commands searched for when jumping to a
+    // landing sequence, return path, landing abort or jump tag, so
+    // those searches don't need to read the whole mission
+    struct CmdIndexEntry {
+        uint16_t index;     // position of command in mission
+        uint16_t id;        // command id
+    };
+    struct {
+        CmdIndexEntry *entries;
+        uint16_t count;     // number of valid entries
+        uint16_t space;     // number of entries allocated
+        uint16_t cmd_total; // _cmd_total when the index was built
+        bool valid;         // true if entries matches the mission in storage
+    } _cmd_index;
+
+    // returns true if commands with this id are held in the command index
+    static bool is_indexed_cmd(uint16_t id);
+
+    // rebuild the command index if the mission has changed
+    void update_cmd_index();
+
+    // returns the position of the first command with this id at or after start_index, or 0 if there is none
+    // uses the command index if it is up to date, otherwise reads the id of each command
+    uint16_t find_next_cmd_with_id(uint16_t id, uint16_t start_index) const;
+
+#if AP_MISSION_LEG_CACHE_ENABLED
+    // the mission's location, navigation and jump commands in mission
+    // order, so the distance to landing and closest mission leg can
+    // be found without reading and decoding the whole mission.  Jumps
+    // are not followed; walks which reach a jump fall back to
+    // walking the mission in storage
+    struct MissionLeg {
+        Location loc;       // command's location
+        Vector2f ne;        // horizontal offset of loc from _legs.origin in meters
+        float route_dist;   // distance in meters along the waypoints, spline waypoints and landings (with locations) from the first of them to this command
+        uint16_t index;     // position of command in mission
+        uint16_t id;        // command id
+        bool is_nav;        // true if this is a navigation command
+    };
+    struct {
+        MissionLeg *entries;
+        uint16_t count;     // number of valid entries
+        uint16_t space;     // number of entries allocated
+        uint16_t cmd_total; // _cmd_total when the legs were built
+        Location origin;    // first location in the mission, all ne offsets are from here
+        bool valid;         // true if entries matches the mission in storage
+    } _legs;
+
+    // returns true if commands with this id are held in the leg cache
+    static bool is_leg_cmd(uint16_t id);
+
+    // rebuild the leg cache if the mission has changed, returns true if the leg cache can be used
+    bool update_leg_cache();
+
+    // returns the position in the leg cache of the first leg at or after the command at index
+    uint16_t leg_at_or_after(uint16_t index) const;
+
+    // leg cache versions of distance_to_landing and distance_to_mission_leg
+    // return false if the leg cache can't answer the query and the mission in storage must be walked instead
+    bool legs_distance_to_landing(uint16_t index, const Location &current_loc, bool &landing_found, float &tot_distance);
+    bool legs_distance_to_mission_leg(uint16_t start_index, const Location &current_loc, bool &found, float &rejoin_distance, uint16_t &rejoin_index);
+#endif
+
+#if AP_MISSION_CMD_CACHE_ENABLED
+    // decoded copies of commands read from storage, filled as they
+    // are read and invalidated as they are written
+    struct {
+        Mission_Command *cmds;
+        uint32_t *valid;    // bitmask of entries in cmds which match storage
+        uint16_t size;      // number of entries in cmds
+    } _cmd_cache;
+
+    // allocate the command cache, sized for the mission storage up to AP_MISSION_CMD_CACHE_SIZE
+    void cmd_cache_init();
+
+    // returns true if the cached copy of the command at index matches storage
+    bool cmd_cache_valid(uint16_t index) const {
+        return index < _cmd_cache.size && (_cmd_cache.valid[index/32] & (1U<<(index%32))) != 0;
+    }
+#endif
+
     // multi-thread support. This is static so it can be used from
     // const functions
     static HAL_Semaphore _rsem;
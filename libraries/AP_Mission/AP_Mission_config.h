@@ -7,3 +7,24 @@
 #ifndef AP_MISSION_NAV_PAYLOAD_PLACE_ENABLED
 #define AP_MISSION_NAV_PAYLOAD_PLACE_ENABLED 1
 #endif
+
+// keep decoded copies of mission commands in RAM on boards with plenty of memory
+#ifndef AP_MISSION_CMD_CACHE_ENABLED
+#define AP_MISSION_CMD_CACHE_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
+// maximum number of decoded commands held by the command cache
+#ifndef AP_MISSION_CMD_CACHE_SIZE
+#if HAL_MEM_CLASS >= HAL_MEM_CLASS_1000
+#define AP_MISSION_CMD_CACHE_SIZE 2048
+#elif HAL_MEM_CLASS >= HAL_MEM_CLASS_500
+#define AP_MISSION_CMD_CACHE_SIZE 512
+#else
+#define AP_MISSION_CMD_CACHE_SIZE 0
+#endif
+#endif
+
+// keep the geometry of the mission's legs in RAM for distance to landing and closest leg queries
+#ifndef AP_MISSION_LEG_CACHE_ENABLED
+#define AP_MISSION_LEG_CACHE_ENABLED (HAL_MEM_CLASS >= HAL_MEM_CLASS_500)
+#endif
@@ -0,0 +1,106 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Mission/AP_Mission.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  throughput of storing an uploaded survey mission, writing each item
+  as it arrives (as a non-pipelined MISSION_ITEM_INT upload does)
+  against writing the items in batches (as pipelined uploads and FTP
+  uploads do).  The link round trips saved by pipelined uploads are
+  not included
+ */
+
+class DummyVehicle {
+public:
+    bool start_cmd(const AP_Mission::Mission_Command& cmd) { return true; };
+    bool verify_cmd(const AP_Mission::Mission_Command& cmd) { return true; };
+    void mission_complete() { };
+
+    AP_Mission mission{
+        FUNCTOR_BIND_MEMBER(&DummyVehicle::start_cmd, bool, const AP_Mission::Mission_Command &),
+        FUNCTOR_BIND_MEMBER(&DummyVehicle::verify_cmd, bool, const AP_Mission::Mission_Command &),
+        FUNCTOR_BIND_MEMBER(&DummyVehicle::mission_complete, void)};
+};
+
+const struct AP_Param::GroupInfo        GCS_MAVLINK_Parameters::var_info[] = {
+    AP_GROUPEND
+};
+GCS_Dummy _gcs;
+
+static DummyVehicle vehicle;
+
+#define BATCH_SIZE 16
+
+// lawnmower pattern of waypoints 20m apart
+static void make_survey(AP_Mission::Mission_Command *cmds, uint16_t count)
+{
+    const Location origin{-353632620, 1491652370, 58400, Location::AltFrame::ABOVE_HOME};
+    for (uint16_t i=0; i<count; i++) {
+        AP_Mission::Mission_Command &cmd = cmds[i];
+        cmd = {};
+        cmd.index = i;
+        cmd.id = MAV_CMD_NAV_WAYPOINT;
+        cmd.content.location = origin;
+        const uint16_t row = i / 20;
+        const uint16_t col = (row % 2 == 0) ? (i % 20) : (19 - i % 20);
+        cmd.content.location.offset(row * 20.0f, col * 20.0f);
+    }
+}
+
+static void BM_MissionUploadPerItem(benchmark::State& state)
+{
+    AP_Mission &mission = vehicle.mission;
+    const uint16_t count = MIN(uint32_t(state.range(0)), uint32_t(mission.num_commands_max()));
+    AP_Mission::Mission_Command *cmds = NEW_NOTHROW AP_Mission::Mission_Command[count];
+    if (cmds == nullptr) {
+        state.SkipWithError("out of memory");
+        return;
+    }
+    make_survey(cmds, count);
+
+    while (state.KeepRunning()) {
+        mission.truncate(0);
+        for (uint16_t i=0; i<count; i++) {
+            if (!mission.add_cmd(cmds[i])) {
+                state.SkipWithError("add_cmd failed");
+                break;
+            }
+        }
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * count);
+
+    delete[] cmds;
+}
+
+static void BM_MissionUploadBatched(benchmark::State& state)
+{
+    AP_Mission &mission = vehicle.mission;
+    const uint16_t count = MIN(uint32_t(state.range(0)), uint32_t(mission.num_commands_max()));
+    AP_Mission::Mission_Command *cmds = NEW_NOTHROW AP_Mission::Mission_Command[count];
+    if (cmds == nullptr) {
+        state.SkipWithError("out of memory");
+        return;
+    }
+    make_survey(cmds, count);
+
+    while (state.KeepRunning()) {
+        mission.truncate(0);
+        for (uint16_t i=0; i<count; i+=BATCH_SIZE) {
+            if (!mission.write_cmds(i, &cmds[i], MIN(BATCH_SIZE, count - i))) {
+                state.SkipWithError("write_cmds failed");
+                break;
+            }
+        }
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * count);
+
+    delete[] cmds;
+}
+
+BENCHMARK(BM_MissionUploadPerItem)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK(BM_MissionUploadBatched)->RangeMultiplier(4)->Range(16, 1024);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,146 @@
+#include <AP_gtest.h>
+
+#include <AP_Mission/AP_Mission.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+class DummyVehicle {
+public:
+    bool start_cmd(const AP_Mission::Mission_Command& cmd) { return true; };
+    bool verify_cmd(const AP_Mission::Mission_Command& cmd) { return true; };
+    void mission_complete() { };
+
+    AP_Mission mission{
+        FUNCTOR_BIND_MEMBER(&DummyVehicle::start_cmd, bool, const AP_Mission::Mission_Command &),
+        FUNCTOR_BIND_MEMBER(&DummyVehicle::verify_cmd, bool, const AP_Mission::Mission_Command &),
+        FUNCTOR_BIND_MEMBER(&DummyVehicle::mission_complete, void)};
+};
+
+const struct AP_Param::GroupInfo        GCS_MAVLINK_Parameters::var_info[] = {
+    AP_GROUPEND
+};
+GCS_Dummy _gcs;
+
+static DummyVehicle vehicle;
+
+static const Location origin{-353632620, 1491652370, 58400, Location::AltFrame::ABOVE_HOME};
+
+// waypoint north_m metres north of origin
+static AP_Mission::Mission_Command waypoint(float north_m)
+{
+    AP_Mission::Mission_Command cmd {};
+    cmd.id = MAV_CMD_NAV_WAYPOINT;
+    cmd.content.location = origin;
+    cmd.content.location.offset(north_m, 0);
+    return cmd;
+}
+
+// DO_LAND_START north_m metres north of origin
+static AP_Mission::Mission_Command land_start(float north_m)
+{
+    AP_Mission::Mission_Command cmd = waypoint(north_m);
+    cmd.id = MAV_CMD_DO_LAND_START;
+    return cmd;
+}
+
+static AP_Mission::Mission_Command jump_tag(uint16_t tag)
+{
+    AP_Mission::Mission_Command cmd {};
+    cmd.id = MAV_CMD_JUMP_TAG;
+    cmd.content.jump.target = tag;
+    return cmd;
+}
+
+// index of the first JUMP_TAG with this tag, found by reading every command
+static uint16_t scan_jump_tag(AP_Mission &mission, uint16_t tag)
+{
+    for (uint16_t i=1; i<mission.num_commands(); i++) {
+        AP_Mission::Mission_Command cmd;
+        if (mission.read_cmd_from_storage(i, cmd) &&
+            cmd.id == MAV_CMD_JUMP_TAG && cmd.content.jump.target == tag) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+// index of the DO_LAND_START closest to loc, found by reading every command
+static uint16_t scan_land_start(AP_Mission &mission, const Location &loc)
+{
+    uint16_t ret = 0;
+    float min_distance = -1;
+    for (uint16_t i=1; i<mission.num_commands(); i++) {
+        AP_Mission::Mission_Command cmd;
+        if (!mission.read_cmd_from_storage(i, cmd) || cmd.id != MAV_CMD_DO_LAND_START) {
+            continue;
+        }
+        const float distance = cmd.content.location.get_distance(loc);
+        if (min_distance < 0 || distance < min_distance) {
+            min_distance = distance;
+            ret = i;
+        }
+    }
+    return ret;
+}
+
+// check index backed searches against a read of every command
+static void check_searches(AP_Mission &mission)
+{
+    for (uint16_t tag=0; tag<5; tag++) {
+        EXPECT_EQ(mission.get_index_of_jump_tag(tag), scan_jump_tag(mission, tag));
+    }
+    for (float north_m=-100; north_m<=2100; north_m+=100) {
+        Location loc = origin;
+        loc.offset(north_m, 0);
+        EXPECT_EQ(mission.get_landing_sequence_start(loc), scan_land_start(mission, loc));
+    }
+    EXPECT_EQ(mission.contains_item(MAV_CMD_DO_LAND_START), scan_land_start(mission, origin) != 0);
+}
+
+TEST(AP_Mission, cmd_index)
+{
+    AP_Mission &mission = vehicle.mission;
+    mission.init();
+    mission.clear();
+
+    // home, then waypoints with landing sequences and tags spread through
+    AP_Mission::Mission_Command home = waypoint(0);
+    ASSERT_TRUE(mission.add_cmd(home));
+    for (uint16_t i=1; i<=40; i++) {
+        AP_Mission::Mission_Command cmd = waypoint(i * 50);
+        if (i % 10 == 0) {
+            cmd = land_start(i * 50);
+        } else if (i % 7 == 0) {
+            cmd = jump_tag(i / 7);
+        }
+        ASSERT_TRUE(mission.add_cmd(cmd));
+    }
+    check_searches(mission);
+
+    // replacing commands must be seen by the next search
+    AP_Mission::Mission_Command cmd = jump_tag(1);
+    ASSERT_TRUE(mission.replace_cmd(3, cmd));
+    EXPECT_EQ(mission.get_index_of_jump_tag(1), 3U);
+    cmd = waypoint(500);
+    ASSERT_TRUE(mission.replace_cmd(10, cmd));
+    cmd = land_start(25);
+    ASSERT_TRUE(mission.replace_cmd(12, cmd));
+    check_searches(mission);
+
+    // as must adding and removing commands
+    cmd = land_start(2100);
+    ASSERT_TRUE(mission.add_cmd(cmd));
+    check_searches(mission);
+    mission.truncate(20);
+    check_searches(mission);
+
+    // and an index which grows past its first allocation
+    while (mission.num_commands() < 60) {
+        cmd = jump_tag(mission.num_commands() % 5);
+        ASSERT_TRUE(mission.add_cmd(cmd));
+    }
+    check_searches(mission);
+}
+
+AP_GTEST_MAIN()
@@ -94,6 +94,7 @@ const AP_Param::GroupInfo AP_Scripting::var_info[] = {
     // @Bitmask: 3: log runtime memory usage and execution time
     // @Bitmask: 4: Disable pre-arm check
     // @Bitmask: 5: Save CRC of current scripts to loaded and running checksum parameters enabling pre-arm
+    // @Bitmask: 6: Cache compiled scripts on the filesystem for faster loading
     // @User: Advanced
     AP_GROUPINFO("DEBUG_OPTS", 4, AP_Scripting, _debug_options, 0),
 
@@ -132,7 +133,7 @@ const AP_Param::GroupInfo AP_Scripting::var_info[] = {
     // @Description: General purpose user variable input for scripts
     // @User: Standard
     AP_GROUPINFO("USER6", 11, AP_Scripting, _user[5], 0.0),
-    
+
     // @Param: DIR_DISABLE
     // @DisplayName: Directory disable
     // @Description: This will stop scripts being loaded from the given locations
@@ -197,7 +198,7 @@ const AP_Param::GroupInfo AP_Scripting::var_info[] = {
 
     // WARNING: additional parameters must be listed before SDEV_EN (but have an
     // index after SDEV3_PROTO) so they are not disabled by it!
-    
+
     AP_GROUPEND
 };
 
@@ -300,14 +301,20 @@ MAV_RESULT AP_Scripting::handle_command_int_packet(const mavlink_command_int_t &
 #pragma GCC optimize ("O0")
 
 void AP_Scripting::thread(void) {
+    if (_lua != nullptr) {
+        // the thread has been started again while the previous one
+        // was running scripts, as in a SITL snapshot branch
+        free_scripts();
+    }
+
     while (true) {
         // reset flags
         _stop = false;
         _restart = false;
         _init_failed = false;
 
-        lua_scripts *lua = NEW_NOTHROW lua_scripts(_script_vm_exec_count, _script_heap_size, _debug_options);
-        if (lua == nullptr || !lua->heap_allocated()) {
+        _lua = NEW_NOTHROW lua_scripts(_script_vm_exec_count, _script_heap_size, _debug_options);
+        if (_lua == nullptr || !_lua->heap_allocated()) {
             GCS_SEND_TEXT(MAV_SEVERITY_CRITICAL, "Scripting: %s", "Unable to allocate memory");
             _init_failed = true;
         } else {
@@ -317,54 +324,12 @@ void AP_Scripting::thread(void) {
             _serialdevice.clear();
 #endif
             // run won't return while scripting is still active
-            lua->run();
+            _lua->run();
 
             // only reachable if the lua backend has died for any reason
             GCS_SEND_TEXT(MAV_SEVERITY_CRITICAL, "Scripting: %s", "stopped");
         }
-        delete lua;
-        lua = nullptr;
-
-        // clear allocated i2c devices
-        for (uint8_t i=0; i<SCRIPTING_MAX_NUM_I2C_DEVICE; i++) {
-            delete _i2c_dev[i];
-            _i2c_dev[i] = nullptr;
-        }
-        num_i2c_devices = 0;
-
-        // clear allocated PWM sources
-        for (uint8_t i=0; i<SCRIPTING_MAX_NUM_PWM_SOURCE; i++) {
-            if (_pwm_source[i] != nullptr) {
-                delete _pwm_source[i];
-                _pwm_source[i] = nullptr;
-            }
-        }
-        num_pwm_source = 0;
-
-#if AP_NETWORKING_ENABLED
-        // clear allocated sockets
-        for (uint8_t i=0; i<SCRIPTING_MAX_NUM_NET_SOCKET; i++) {
-            if (_net_sockets[i] != nullptr) {
-                delete _net_sockets[i];
-                _net_sockets[i] = nullptr;
-            }
-        }
-#endif // AP_NETWORKING_ENABLED
-
-#if AP_SCRIPTING_SERIALDEVICE_ENABLED
-        // clear data in serial buffers that hasn't been transmitted
-        _serialdevice.clear();
-#endif
-        
-        // Clear blocked commands
-        {
-            WITH_SEMAPHORE(mavlink_command_block_list_sem);
-            while (mavlink_command_block_list != nullptr) {
-                command_block_list *next_item = mavlink_command_block_list->next;
-                delete mavlink_command_block_list;
-                mavlink_command_block_list = next_item;
-            }
-        }
+        free_scripts();
 
         bool cleared = false;
         while(true) {
@@ -388,6 +353,54 @@ void AP_Scripting::thread(void) {
 }
 #pragma GCC pop_options
 
+// free the running scripts and everything they allocated
+void AP_Scripting::free_scripts(void)
+{
+    delete _lua;
+    _lua = nullptr;
+
+    // clear allocated i2c devices
+    for (uint8_t i=0; i<SCRIPTING_MAX_NUM_I2C_DEVICE; i++) {
+        delete _i2c_dev[i];
+        _i2c_dev[i] = nullptr;
+    }
+    num_i2c_devices = 0;
+
+    // clear allocated PWM sources
+    for (uint8_t i=0; i<SCRIPTING_MAX_NUM_PWM_SOURCE; i++) {
+        if (_pwm_source[i] != nullptr) {
+            delete _pwm_source[i];
+            _pwm_source[i] = nullptr;
+        }
+    }
+    num_pwm_source = 0;
+
+#if AP_NETWORKING_ENABLED
+    // clear allocated sockets
+    for (uint8_t i=0; i<SCRIPTING_MAX_NUM_NET_SOCKET; i++) {
+        if (_net_sockets[i] != nullptr) {
+            delete _net_sockets[i];
+            _net_sockets[i] = nullptr;
+        }
+    }
+#endif // AP_NETWORKING_ENABLED
+
+#if AP_SCRIPTING_SERIALDEVICE_ENABLED
+    // clear data in serial buffers that hasn't been transmitted
+    _serialdevice.clear();
+#endif
+
+    // Clear blocked commands
+    {
+        WITH_SEMAPHORE(mavlink_command_block_list_sem);
+        while (mavlink_command_block_list != nullptr) {
+            command_block_list *next_item = mavlink_command_block_list->next;
+            delete mavlink_command_block_list;
+            mavlink_command_block_list = next_item;
+        }
+    }
+}
+
 void AP_Scripting::handle_mission_command(const AP_Mission::Mission_Command& cmd_in)
 {
 #if AP_MISSION_ENABLED
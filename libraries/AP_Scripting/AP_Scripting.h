@@ -34,6 +34,8 @@
 
 #define SCRIPTING_MAX_NUM_PWM_SOURCE 4
 
+class lua_scripts;
+
 #if AP_NETWORKING_ENABLED
 #ifndef SCRIPTING_MAX_NUM_NET_SOCKET
 #define SCRIPTING_MAX_NUM_NET_SOCKET 50
@@ -156,6 +158,9 @@ private:
 
     void thread(void); // main script execution thread
 
+    // free the running scripts and everything they allocated
+    void free_scripts(void);
+
     // Check if DEBUG_OPTS bit has been set to save current checksum values to params
     void save_checksum();
 
@@ -189,6 +194,7 @@ private:
     bool _init_failed;  // true if memory allocation failed
     bool _restart; // true if scripts should be restarted
     bool _stop; // true if scripts should be stopped
+    lua_scripts *_lua; // scripts run by the thread
 
     static AP_Scripting *_singleton;
     int current_env_ref;
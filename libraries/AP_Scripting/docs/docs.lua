@@ -1647,13 +1647,15 @@ function ins:calibrating() end
 
 -- Get the value of a specific gyroscope
 ---@param instance integer -- the 0-based index of the gyroscope instance to return.
+---@param result? Vector3f_ud -- filled in and returned instead of a new Vector3f
 ---@return Vector3f_ud
-function ins:get_gyro(instance) end
+function ins:get_gyro(instance, result) end
 
 -- Get the value of a specific accelerometer
 ---@param instance integer -- the 0-based index of the accelerometer instance to return.
+---@param result? Vector3f_ud -- filled in and returned instead of a new Vector3f
 ---@return Vector3f_ud
-function ins:get_accel(instance) end
+function ins:get_accel(instance, result) end
 
 -- desc
 Motors_dynamic = {}
@@ -3062,8 +3064,9 @@ function gps:ground_speed(instance) end
 -- Returns a Vector3f that contains the velocity as observed by the GPS.
 -- You must check the status to know if the velocity is still current.
 ---@param instance integer -- instance number
+---@param result? Vector3f_ud -- filled in and returned instead of a new Vector3f
 ---@return Vector3f_ud -- 3D velocity in m/s, in NED format
-function gps:velocity(instance) end
+function gps:velocity(instance, result) end
 
 -- desc
 ---@param instance integer -- instance number
@@ -3082,8 +3085,9 @@ function gps:speed_accuracy(instance) end
 
 -- eturns a Location userdata for the last GPS position. You must check the status to know if the location is still current, if it is NO_GPS, or NO_FIX then it will be returning old data.
 ---@param instance integer -- instance number
+---@param result? Location_ud -- filled in and returned instead of a new Location
 ---@return Location_ud --gps location
-function gps:location(instance) end
+function gps:location(instance, result) end
 
 -- Returns the GPS fix status. Compare this to one of the GPS fix types.
 -- Posible status are provided as values on the gps object. eg: gps.GPS_OK_FIX_3D
@@ -3295,8 +3299,9 @@ ahrs = {}
 function ahrs:handle_external_position_estimate(location, accuracy, timestamp_ms) end
 
 -- desc
+---@param result? Quaternion_ud -- filled in and returned instead of a new Quaternion
 ---@return Quaternion_ud|nil
-function ahrs:get_quaternion() end
+function ahrs:get_quaternion(result) end
 
 -- desc
 ---@return integer
@@ -3312,8 +3317,9 @@ function ahrs:initialised() end
 function ahrs:set_origin(loc) end
 
 -- desc
+---@param result? Location_ud -- filled in and returned instead of a new Location
 ---@return Location_ud|nil
-function ahrs:get_origin() end
+function ahrs:get_origin(result) end
 
 -- desc
 ---@param loc Location_ud
@@ -3347,17 +3353,20 @@ function ahrs:get_EAS2TAS() end
 
 -- desc
 ---@param vector Vector3f_ud
+---@param result? Vector3f_ud -- filled in and returned instead of a new Vector3f
 ---@return Vector3f_ud
-function ahrs:body_to_earth(vector) end
+function ahrs:body_to_earth(vector, result) end
 
 -- desc
 ---@param vector Vector3f_ud
+---@param result? Vector3f_ud -- filled in and returned instead of a new Vector3f
 ---@return Vector3f_ud
-function ahrs:earth_to_body(vector) end
+function ahrs:earth_to_body(vector, result) end
 
 -- desc
+---@param result? Vector3f_ud -- filled in and returned instead of a new Vector3f
 ---@return Vector3f_ud
-function ahrs:get_vibration() end
+function ahrs:get_vibration(result) end
 
 -- Return the estimated airspeed of the vehicle if available
 ---@return number|nil -- airspeed in meters / second if available
@@ -3376,24 +3385,29 @@ function ahrs:home_is_set() end
 function ahrs:get_relative_position_D_home() end
 
 -- desc
+---@param result? Vector3f_ud -- filled in and returned instead of a new Vector3f
 ---@return Vector3f_ud|nil
-function ahrs:get_relative_position_NED_origin() end
+function ahrs:get_relative_position_NED_origin(result) end
 
 -- desc
+---@param result? Vector3f_ud -- filled in and returned instead of a new Vector3f
 ---@return Vector3f_ud|nil
-function ahrs:get_relative_position_NED_home() end
+function ahrs:get_relative_position_NED_home(result) end
 
 -- Returns nil, or a Vector3f containing the current NED vehicle velocity in meters/second in north, east, and down components.
+---@param result? Vector3f_ud -- filled in and returned instead of a new Vector3f
 ---@return Vector3f_ud|nil -- North, east, down velcoity in meters / second if available
-function ahrs:get_velocity_NED() end
+function ahrs:get_velocity_NED(result) end
 
 -- Get current groundspeed vector in meter / second
+---@param result? Vector2f_ud -- filled in and returned instead of a new Vector2f
 ---@return Vector2f_ud -- ground speed vector, North East, meters / second
-function ahrs:groundspeed_vector() end
+function ahrs:groundspeed_vector(result) end
 
 -- Returns a Vector3f containing the current wind estimate for the vehicle.
+---@param result? Vector3f_ud -- filled in and returned instead of a new Vector3f
 ---@return Vector3f_ud -- wind estiamte North, East, Down meters / second
-function ahrs:wind_estimate() end
+function ahrs:wind_estimate(result) end
 
 -- Determine how aligned heading_deg is with the wind. Return result
 -- is 1.0 when perfectly aligned heading into wind, -1 when perfectly
@@ -3412,25 +3426,30 @@ function ahrs:head_wind() end
 function ahrs:get_hagl() end
 
 -- desc
+---@param result? Vector3f_ud -- filled in and returned instead of a new Vector3f
 ---@return Vector3f_ud
-function ahrs:get_accel() end
+function ahrs:get_accel(result) end
 
 -- Returns a Vector3f containing the current smoothed and filtered gyro rates (in radians/second)
+---@param result? Vector3f_ud -- filled in and returned instead of a new Vector3f
 ---@return Vector3f_ud -- roll, pitch, yaw gyro rates in radians / second
-function ahrs:get_gyro() end
+function ahrs:get_gyro(result) end
 
 -- Returns a Location that contains the vehicles current home waypoint.
+---@param result? Location_ud -- filled in and returned instead of a new Location
 ---@return Location_ud -- home location
-function ahrs:get_home() end
+function ahrs:get_home(result) end
 
 -- Returns nil or Location userdata that contains the vehicles current position.
 -- Note: This will only return a Location if the system considers the current estimate to be reasonable.
+---@param result? Location_ud -- filled in and returned instead of a new Location
 ---@return Location_ud|nil -- current location if available
-function ahrs:get_location() end
+function ahrs:get_location(result) end
 
 -- same as `get_location` will be removed
+---@param result? Location_ud -- filled in and returned instead of a new Location
 ---@return Location_ud|nil
-function ahrs:get_position() end
+function ahrs:get_position(result) end
 
 -- Returns the current vehicle euler yaw angle in radians.
 ---@return number -- yaw angle in radians.
@@ -27,6 +27,7 @@ char keyword_write[]               = "write";
 char keyword_literal[]             = "literal";
 char keyword_reference[]           = "reference";
 char keyword_deprecate[]           = "deprecate";
+char keyword_in_place[]            = "in_place";
 char keyword_manual[]              = "manual";
 char keyword_global[]              = "global";
 char keyword_creation[]            = "creation";
@@ -359,6 +360,7 @@ struct method {
   char *sanatized_name;  // sanatized name of the C++ singleton
   char *rename; // (optional) used for scripting access
   char *deprecate; // (optional) issue deprecateion warning string on first call
+  int in_place; // number of userdata results which may be passed in to be filled in place, rather than allocated
   int line; // line declared on
   struct type return_type;
   struct argument * arguments;
@@ -763,6 +765,19 @@ void handle_userdata_field(struct userdata *data) {
   field->access_flags = parse_access_flags(&(field->type));
 }
 
+// number of userdata a method returns to lua
+int count_userdata_results(const struct method *method) {
+  int count = (method->return_type.type == TYPE_USERDATA) ? 1 : 0;
+  const struct argument *arg = method->arguments;
+  while (arg != NULL) {
+    if ((arg->type.type == TYPE_USERDATA) && (arg->type.flags & (TYPE_FLAGS_NULLABLE | TYPE_FLAGS_REFERNCE))) {
+      count++;
+    }
+    arg = arg->next;
+  }
+  return count;
+}
+
 void handle_method(struct userdata *node) {
   trace(TRACE_USERDATA, "Adding a method");
   char * parent_name = node->name;
@@ -820,6 +835,13 @@ void handle_method(struct userdata *node) {
       string_copy(&(method->dependency), dependency);
       return;
 
+    } else if (strcmp(token, keyword_in_place) == 0) {
+      method->in_place = count_userdata_results(method);
+      if (method->in_place == 0) {
+        error(ERROR_USERDATA, "Method %s of %s has no userdata results to fill in place", name, parent_name);
+      }
+      return;
+
     }
     error(ERROR_USERDATA, "Method %s already exists for %s (declared on %d)", name, parent_name, method->line);
   }
@@ -1830,8 +1852,25 @@ void emit_singleton_fields() {
   }
 }
 
+// push a userdata result. If the method fills its results in place (first_in_place_arg is
+// the stack index of the first userdata which may be passed in) and the userdata for this
+// result was passed in, it is filled and pushed, otherwise a new userdata is allocated
+void emit_userdata_result(const char *sanatized_name, const char *value, int first_in_place_arg, int *in_place_slot, const char *tab) {
+  if (first_in_place_arg == 0) {
+    fprintf(source, "%s*new_%s(L) = %s;\n", tab, sanatized_name, value);
+    return;
+  }
+  fprintf(source, "%sif (in_place_%d != nullptr) {\n", tab, *in_place_slot);
+  fprintf(source, "%s    *in_place_%d = %s;\n", tab, *in_place_slot, value);
+  fprintf(source, "%s    lua_pushvalue(L, %d);\n", tab, first_in_place_arg + *in_place_slot);
+  fprintf(source, "%s} else {\n", tab);
+  fprintf(source, "%s    *new_%s(L) = %s;\n", tab, sanatized_name, value);
+  fprintf(source, "%s}\n", tab);
+  (*in_place_slot)++;
+}
+
 // emit refences functions for a call, return the number of arduments added
-int emit_references(const struct argument *arg, const char * tab) {
+int emit_references(const struct argument *arg, const char * tab, int first_in_place_arg, int *in_place_slot) {
   int arg_index = NULLABLE_ARG_COUNT_BASE + 2;
   int return_count = 0;
   // count arguments to return so we know if we need to check the stack
@@ -1869,9 +1908,12 @@ int emit_references(const struct argument *arg, const char * tab) {
         case TYPE_STRING:
           fprintf(source, "%slua_pushstring(L, data_%d);\n", tab, arg_index);
           break;
-        case TYPE_USERDATA:
-          fprintf(source, "%s*new_%s(L) = data_%d;\n", tab, arg->type.data.ud.sanatized_name, arg_index);
+        case TYPE_USERDATA: {
+          char value[20];
+          snprintf(value, sizeof(value), "data_%d", arg_index);
+          emit_userdata_result(arg->type.data.ud.sanatized_name, value, first_in_place_arg, in_place_slot, tab);
           break;
+        }
         case TYPE_NONE:
           error(ERROR_INTERNAL, "Attempted to emit a nullable or reference  argument of type none");
           break;
@@ -1917,7 +1959,13 @@ void emit_userdata_method(const struct userdata *data, const struct method *meth
     }
     arg = arg->next;
   }
-  fprintf(source, "    binding_argcheck(L, %d);\n", arg_count);
+  // userdata results may be passed in after the arguments
+  const int first_in_place_arg = method->in_place ? arg_count + 1 : 0;
+  if (method->in_place) {
+    fprintf(source, "    const int in_place_args = binding_argcheck_in_place(L, %d, %d);\n", arg_count, method->in_place);
+  } else {
+    fprintf(source, "    binding_argcheck(L, %d);\n", arg_count);
+  }
 
   switch (data->ud_type) {
     case UD_USERDATA:
@@ -1955,6 +2003,26 @@ void emit_userdata_method(const struct userdata *data, const struct method *meth
     arg = arg->next;
   }
 
+  // check the userdata to fill in place before the call, as an error can't be raised while holding a semaphore.
+  // They are in the order the results are pushed, references first. A missing or nil argument means a new one
+  // is allocated for the result
+  if (method->in_place) {
+    int slot = 0;
+    arg = method->arguments;
+    while (arg != NULL) {
+      if ((arg->type.type == TYPE_USERDATA) && (arg->type.flags & (TYPE_FLAGS_NULLABLE | TYPE_FLAGS_REFERNCE))) {
+        fprintf(source, "    %s * in_place_%d = (in_place_args > %d && !lua_isnil(L, %d)) ? check_%s(L, %d) : nullptr;\n",
+                arg->type.data.ud.name, slot, slot, first_in_place_arg + slot, arg->type.data.ud.sanatized_name, first_in_place_arg + slot);
+        slot++;
+      }
+      arg = arg->next;
+    }
+    if (method->return_type.type == TYPE_USERDATA) {
+      fprintf(source, "    %s * in_place_%d = (in_place_args > %d && !lua_isnil(L, %d)) ? check_%s(L, %d) : nullptr;\n",
+              method->return_type.data.ud.name, slot, slot, first_in_place_arg + slot, method->return_type.data.ud.sanatized_name, first_in_place_arg + slot);
+    }
+  }
+
   const char *ud_name = (data->flags & UD_FLAG_LITERAL)?data->name:"ud";
   const char *ud_access = (data->flags & UD_FLAG_REFERENCE)?".":"->";
 
@@ -2104,10 +2172,11 @@ void emit_userdata_method(const struct userdata *data, const struct method *meth
 
   // we need to emit out refernce arguments, iterate the args again, creating and copying objects, while keeping a new count
   int return_count = 1; 
+  int in_place_slot = 0;
   if (method->flags & TYPE_FLAGS_REFERNCE) {
     arg = method->arguments;
     // number of arguments to return
-    return_count += emit_references(arg,"    ");
+    return_count += emit_references(arg,"    ", first_in_place_arg, &in_place_slot);
   }
 
   switch (method->return_type.type) {
@@ -2116,7 +2185,7 @@ void emit_userdata_method(const struct userdata *data, const struct method *meth
         fprintf(source, "    if (data) {\n");
         // we need to emit out nullable arguments, iterate the args again, creating and copying objects, while keeping a new count
         arg = method->arguments;
-        return_count = emit_references(arg,"        ");
+        return_count = emit_references(arg,"        ", first_in_place_arg, &in_place_slot);
         fprintf(source, "        return %d;\n", return_count);
         fprintf(source, "    }\n");
         fprintf(source, "    return 0;\n");
@@ -2142,7 +2211,7 @@ void emit_userdata_method(const struct userdata *data, const struct method *meth
       fprintf(source, "    lua_pushstring(L, data);\n");
       break;
     case TYPE_USERDATA:
-      fprintf(source, "    *new_%s(L) = data;\n", method->return_type.data.ud.sanatized_name);
+      emit_userdata_result(method->return_type.data.ud.sanatized_name, "data", first_in_place_arg, &in_place_slot, "    ");
       break;
     case TYPE_AP_OBJECT:
       fprintf(source, "    if (data == NULL) {\n");
@@ -2485,6 +2554,23 @@ void emit_loaders(void) {
   emit_type_index(parsed_singletons, "singleton");
   emit_type_index(parsed_ap_objects, "ap_object");
 
+  // singleton methods are found by a search of the singleton's names, so the
+  // result of each search is cached in a table used as the singleton's __index
+  fprintf(source, "// __index of a singleton's cache table, finds a name with the singleton's\n");
+  fprintf(source, "// index function and caches it, so each name is only searched for once\n");
+  fprintf(source, "static int cached_index(lua_State *L) {\n");
+  fprintf(source, "    lua_pushvalue(L, lua_upvalueindex(1));\n");
+  fprintf(source, "    lua_pushvalue(L, 1);\n");
+  fprintf(source, "    lua_pushvalue(L, 2);\n");
+  fprintf(source, "    lua_call(L, 2, 1);\n");
+  fprintf(source, "    if (!lua_isnil(L, -1)) {\n");
+  fprintf(source, "        lua_pushvalue(L, 2);\n");
+  fprintf(source, "        lua_pushvalue(L, -2);\n");
+  fprintf(source, "        lua_rawset(L, 1);\n");
+  fprintf(source, "    }\n");
+  fprintf(source, "    return 1;\n");
+  fprintf(source, "}\n\n");
+
   fprintf(source, "static int binding_index(lua_State *L) {\n");
   fprintf(source, "    const char * name = luaL_checkstring(L, 2);\n");
   fprintf(source, "\n");
@@ -2493,7 +2579,12 @@ void emit_loaders(void) {
   fprintf(source, "        if (strcmp(name, singleton_fun[i].name) == 0) {\n");
   fprintf(source, "            lua_newuserdata(L, 0);\n");
   fprintf(source, "            if (luaL_newmetatable(L, name)) { // need to create metatable\n");
+  fprintf(source, "                lua_newtable(L); // cache of found names\n");
+  fprintf(source, "                lua_createtable(L, 0, 1);\n");
   fprintf(source, "                lua_pushcfunction(L, singleton_fun[i].func);\n");
+  fprintf(source, "                lua_pushcclosure(L, cached_index, 1);\n");
+  fprintf(source, "                lua_setfield(L, -2, \"__index\");\n");
+  fprintf(source, "                lua_setmetatable(L, -2);\n");
   fprintf(source, "                lua_setfield(L, -2, \"__index\");\n");
   fprintf(source, "            }\n");
   fprintf(source, "            lua_setmetatable(L, -2);\n");
@@ -2626,6 +2717,18 @@ void emit_argcheck_helper(void) {
   fprintf(source, "    return 0;\n");
   fprintf(source, "}\n\n");
 
+  fprintf(source, "// check the arguments of a method which may also be passed up to in_place_count userdata\n");
+  fprintf(source, "// to fill with its results, returning the number of those passed\n");
+  fprintf(source, "int binding_argcheck_in_place(lua_State *L, int expected_arg_count, int in_place_count) {\n");
+  fprintf(source, "    const int args = lua_gettop(L);\n");
+  fprintf(source, "    if (args > expected_arg_count + in_place_count) {\n");
+  fprintf(source, "        return luaL_argerror(L, args, \"too many arguments\");\n");
+  fprintf(source, "    } else if (args < expected_arg_count) {\n");
+  fprintf(source, "        return luaL_argerror(L, args, \"too few arguments\");\n");
+  fprintf(source, "    }\n");
+  fprintf(source, "    return args - expected_arg_count;\n");
+  fprintf(source, "}\n\n");
+
   fprintf(source, "int field_argerror(lua_State *L) {\n");
   fprintf(source, "    return binding_argcheck(L, -1); // force too many args error\n");
   fprintf(source, "}\n\n");
@@ -2810,6 +2913,28 @@ void emit_docs_method(const char *name, const char *method_name, struct method *
     arg = arg->next;
   }
 
+  // optional userdata to fill with the results, in the order they are returned
+  if (method->in_place) {
+    arg = method->arguments;
+    while (arg != NULL) {
+      if ((arg->type.type == TYPE_USERDATA) && (arg->type.flags & (TYPE_FLAGS_NULLABLE | TYPE_FLAGS_REFERNCE))) {
+        char *param_name = (char *)allocate(20);
+        sprintf(param_name, "---@param param%i?", count);
+        emit_docs_param_type(arg->type, param_name, "\n");
+        free(param_name);
+        count++;
+      }
+      arg = arg->next;
+    }
+    if (method->return_type.type == TYPE_USERDATA) {
+      char *param_name = (char *)allocate(20);
+      sprintf(param_name, "---@param param%i?", count);
+      emit_docs_param_type(method->return_type, param_name, "\n");
+      free(param_name);
+      count++;
+    }
+  }
+
   // return type
   if ((method->flags & TYPE_FLAGS_NULLABLE) == 0) {
     emit_docs_return_type(method->return_type, FALSE);
@@ -3197,6 +3322,7 @@ int main(int argc, char **argv) {
   fprintf(header, "void load_generated_bindings(lua_State *L);\n");
   fprintf(header, "void load_generated_sandbox(lua_State *L);\n");
   fprintf(header, "int binding_argcheck(lua_State *L, int expected_arg_count);\n");
+  fprintf(header, "int binding_argcheck_in_place(lua_State *L, int expected_arg_count, int in_place_count);\n");
   fprintf(header, "int field_argerror(lua_State *L);\n");
   fprintf(header, "bool userdata_zero_arg_check(lua_State *L);\n");
   fprintf(header, "lua_Integer get_integer(lua_State *L, int arg_num, lua_Integer min_val, lua_Integer max_val);\n");
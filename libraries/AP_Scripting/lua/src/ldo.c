@@ -779,11 +779,14 @@ static void f_parser (lua_State *L, void *ud) {
 #if LUA_SUPPORT_LOAD_BINARY
   // support loading pre-compiled luac
   if (c == LUA_SIGNATURE[0]) {
+#else
+  // only load pre-compiled chunks from the cache of compiled scripts
+  if (c == LUA_SIGNATURE[0] && p->mode == lua_cached_binary_mode) {
+#endif
     checkmode(L, p->mode, "binary");
     cl = luaU_undump(L, p->z, p->name);
   }
   else
-#endif
   {
     checkmode(L, p->mode, "text");
     cl = luaY_parser(L, p->z, &p->buff, &p->dyd, p->name, c);
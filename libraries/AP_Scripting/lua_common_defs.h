@@ -14,3 +14,7 @@ int lua_get_current_env_ref();
 const char* lua_get_modules_path();
 void lua_abort(void) __attribute__((noreturn));
 
+// load mode for the cache of compiled scripts, the only binary chunks
+// which are loaded without LUA_SUPPORT_LOAD_BINARY
+extern const char lua_cached_binary_mode[];
+
@@ -21,11 +21,26 @@
 #include <AP_HAL/AP_HAL.h>
 #include "AP_Scripting.h"
 #include <AP_Logger/AP_Logger.h>
+#include <AP_Math/crc.h>
+#include <StorageManager/StorageManager.h>
+#include <AP_CheckFirmware/monocypher.h>
 
 #include <AP_Scripting/lua_generated_bindings.h>
 
 #define DISABLE_INTERRUPTS_FOR_SCRIPT_RUN 0
 
+// least time given to garbage collection after a script runs
+#define GC_MIN_BUDGET_US 200
+
+// period of logging the run time and garbage collection histograms
+#define HISTOGRAM_LOG_PERIOD_MS 10000
+
+// directory of the cache of compiled scripts
+#define SCRIPT_CACHE_DIRECTORY SCRIPTING_DIRECTORY "/cache"
+#define SCRIPT_CACHE_MAGIC 0x4D41554C // "LUAM"
+
+#define SCRIPT_CACHE_MAC_SIZE 16
+
 extern const AP_HAL::HAL& hal;
 #define ENABLE_DEBUG_MODULE 0
 
@@ -36,6 +51,8 @@ HAL_Semaphore lua_scripts::error_msg_buf_sem;
 uint8_t lua_scripts::print_error_count;
 uint32_t lua_scripts::last_print_ms;
 
+const char lua_cached_binary_mode[] = "b";
+
 uint32_t lua_scripts::loaded_checksum;
 uint32_t lua_scripts::running_checksum;
 HAL_Semaphore lua_scripts::crc_sem;
@@ -45,9 +62,12 @@ lua_scripts::lua_scripts(const AP_Int32 &vm_steps, const AP_Int32 &heap_size, co
       _debug_options(debug_options)
 {
     _heap.create(heap_size, 4);
+    _pool.set_slab_limit(heap_size / 4);
 }
 
 lua_scripts::~lua_scripts() {
+    // the pool is static and must not keep pointers into the heap
+    _pool.reset();
     _heap.destroy();
 }
 
@@ -127,13 +147,17 @@ int lua_scripts::atpanic(lua_State *L) {
 }
 
 // helper for print and log of runtime stats
-void lua_scripts::update_stats(const char *name, uint32_t run_time, int total_mem, int run_mem)
+void lua_scripts::update_stats(const char *name, uint32_t run_time, int total_mem, int run_mem,
+                               const PoolHeap::Stats &start_alloc)
 {
     if ((_debug_options.get() & uint8_t(DebugLevel::RUNTIME_MSG)) != 0) {
-        GCS_SEND_TEXT(MAV_SEVERITY_DEBUG, "Lua: Time: %u Mem: %d + %d",
+        GCS_SEND_TEXT(MAV_SEVERITY_DEBUG, "Lua: Time: %u Mem: %d + %d Alloc: %u (%u pooled) Free: %u",
                                             (unsigned int)run_time,
                                             (int)total_mem,
-                                            (int)run_mem);
+                                            (int)run_mem,
+                                            (unsigned int)(_pool.get_stats().allocations - start_alloc.allocations),
+                                            (unsigned int)(_pool.get_stats().pool_allocations - start_alloc.pool_allocations),
+                                            (unsigned int)(_pool.get_stats().frees - start_alloc.frees));
     }
 #if HAL_LOGGING_ENABLED
     if ((_debug_options.get() & uint8_t(DebugLevel::LOG_RUNTIME)) != 0) {
@@ -157,28 +181,43 @@ void lua_scripts::update_stats(const char *name, uint32_t run_time, int total_me
 }
 
 lua_scripts::script_info *lua_scripts::load_script(lua_State *L, char *filename) {
-    if (int error = luaL_loadfile(L, filename)) {
-        switch (error) {
-            case LUA_ERRSYNTAX:
-                set_and_print_new_error_message(MAV_SEVERITY_CRITICAL, "Error: %s", lua_tostring(L, -1));
-                lua_pop(L, lua_gettop(L));
-                return nullptr;
-            case LUA_ERRMEM:
-                set_and_print_new_error_message(MAV_SEVERITY_CRITICAL, "Insufficent memory loading %s", filename);
-                lua_pop(L, lua_gettop(L));
-                return nullptr;
-            case LUA_ERRFILE:
-                set_and_print_new_error_message(MAV_SEVERITY_CRITICAL, "Unable to load the file: %s", lua_tostring(L, -1));
-                lua_pop(L, lua_gettop(L));
-                return nullptr;
-            default:
-                set_and_print_new_error_message(MAV_SEVERITY_CRITICAL, "Unknown error (%d) loading %s", error, filename);
-                lua_pop(L, lua_gettop(L));
-                return nullptr;
+    // Get checksum of file
+    uint32_t crc = 0;
+    const bool have_crc = AP::FS().crc32(filename, crc);
+
+    const bool use_cache = have_crc && (_debug_options.get() & uint8_t(DebugLevel::CACHE_BYTECODE)) != 0;
+    if (use_cache && load_cached_script(L, filename, crc)) {
+        if ((_debug_options.get() & uint8_t(DebugLevel::RUNTIME_MSG)) != 0) {
+            GCS_SEND_TEXT(MAV_SEVERITY_DEBUG, "Lua: %s loaded from cache", filename);
+        }
+    } else {
+        if (int error = luaL_loadfile(L, filename)) {
+            switch (error) {
+                case LUA_ERRSYNTAX:
+                    set_and_print_new_error_message(MAV_SEVERITY_CRITICAL, "Error: %s", lua_tostring(L, -1));
+                    lua_pop(L, lua_gettop(L));
+                    return nullptr;
+                case LUA_ERRMEM:
+                    set_and_print_new_error_message(MAV_SEVERITY_CRITICAL, "Insufficent memory loading %s", filename);
+                    lua_pop(L, lua_gettop(L));
+                    return nullptr;
+                case LUA_ERRFILE:
+                    set_and_print_new_error_message(MAV_SEVERITY_CRITICAL, "Unable to load the file: %s", lua_tostring(L, -1));
+                    lua_pop(L, lua_gettop(L));
+                    return nullptr;
+                default:
+                    set_and_print_new_error_message(MAV_SEVERITY_CRITICAL, "Unknown error (%d) loading %s", error, filename);
+                    lua_pop(L, lua_gettop(L));
+                    return nullptr;
+            }
+        }
+        if (use_cache) {
+            save_cached_script(L, filename, crc);
         }
     }
 
     const int loadMem = lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
+    const PoolHeap::Stats loadAlloc = _pool.get_stats();
     const uint32_t loadStart = AP_HAL::micros();
 
     script_info *new_script = (script_info *)_heap.allocate(sizeof(script_info));
@@ -190,6 +229,9 @@ lua_scripts::script_info *lua_scripts::load_script(lua_State *L, char *filename)
     }
 
 
+    memset(new_script->run_histogram, 0, sizeof(new_script->run_histogram));
+    memset(new_script->gc_histogram, 0, sizeof(new_script->gc_histogram));
+
     create_sandbox(L);
     lua_pushvalue(L, -1); // duplicate environment for reference below
     lua_setupvalue(L, -3, 1);
@@ -197,16 +239,14 @@ lua_scripts::script_info *lua_scripts::load_script(lua_State *L, char *filename)
     const uint32_t loadEnd = AP_HAL::micros();
     const int endMem = lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
 
-    update_stats(filename, loadEnd-loadStart, endMem, loadMem);
+    update_stats(filename, loadEnd-loadStart, endMem, loadMem, loadAlloc);
 
     new_script->name = filename;
     new_script->env_ref = luaL_ref(L, LUA_REGISTRYINDEX); // store reference to script's environment
     new_script->run_ref = luaL_ref(L, LUA_REGISTRYINDEX); // store reference to function to run
     new_script->next_run_ms = AP_HAL::millis64() - 1; // force the script to be stale
 
-    // Get checksum of file
-    uint32_t crc = 0;
-    if (AP::FS().crc32(filename, crc)) {
+    if (have_crc) {
         // Record crc of this script
         new_script->crc = crc;
         {
@@ -220,6 +260,251 @@ lua_scripts::script_info *lua_scripts::load_script(lua_State *L, char *filename)
     return new_script;
 }
 
+/*
+  cache of compiled scripts. Each entry is a header followed by the
+  output of lua_dump for the script's main function, and is named by
+  a crc of the script's name and contents, so an edited script gets a
+  new entry. Debug information is kept so that errors still give the
+  script name and line.
+
+  Lua doesn't verify bytecode, and crafted bytecode can escape the
+  sandbox. The cache directory can be written over MAVFTP, so each
+  entry carries a keyed blake2b MAC. An entry is read into memory once
+  and only undumped from there after its MAC has been checked, so a
+  write to the file meanwhile can't change what Lua sees. The key is
+  made on first use and kept in the keys storage area, which is not
+  readable over MAVLink
+ */
+struct PACKED script_cache_header {
+    uint32_t magic;
+    uint32_t lua_version;
+    uint32_t crc;           // crc32 of the script
+    uint8_t mac[SCRIPT_CACHE_MAC_SIZE]; // MAC of the header, with this zeroed, and the bytecode
+};
+
+struct script_cache_reader {
+    const uint8_t *data;
+    uint32_t size;
+};
+
+struct script_cache_writer {
+    int fd;
+    crypto_blake2b_ctx mac;
+};
+
+// the key authenticating entries of the cache is kept after the
+// MAVLink signing key in the keys storage area
+static StorageAccess script_cache_key_storage(StorageManager::StorageKeys);
+
+/*
+  get the key of the cache, making it on first use. Returns false if
+  there is no storage for it
+ */
+static bool script_cache_key(uint8_t key[STORAGE_KEYS_SCRIPT_CACHE_SIZE])
+{
+    if ((script_cache_key_storage.size() < STORAGE_KEYS_SCRIPT_CACHE_OFFSET + STORAGE_KEYS_SCRIPT_CACHE_SIZE) ||
+        !script_cache_key_storage.read_block(key, STORAGE_KEYS_SCRIPT_CACHE_OFFSET, STORAGE_KEYS_SCRIPT_CACHE_SIZE)) {
+        return false;
+    }
+    // erased storage is all zeros or all ones
+    uint8_t ored = 0;
+    uint8_t anded = 0xFF;
+    for (uint8_t i=0; i<STORAGE_KEYS_SCRIPT_CACHE_SIZE; i++) {
+        ored |= key[i];
+        anded &= key[i];
+    }
+    if (ored != 0 && anded != 0xFF) {
+        return true;
+    }
+    return hal.util->get_random_vals(key, STORAGE_KEYS_SCRIPT_CACHE_SIZE) &&
+           script_cache_key_storage.write_block(STORAGE_KEYS_SCRIPT_CACHE_OFFSET, key, STORAGE_KEYS_SCRIPT_CACHE_SIZE);
+}
+
+// start the MAC of an entry with its header
+static void script_cache_mac_init(crypto_blake2b_ctx &mac, const uint8_t key[STORAGE_KEYS_SCRIPT_CACHE_SIZE], const script_cache_header &header)
+{
+    struct script_cache_header unsigned_header = header;
+    memset(unsigned_header.mac, 0, sizeof(unsigned_header.mac));
+    crypto_blake2b_general_init(&mac, SCRIPT_CACHE_MAC_SIZE, key, STORAGE_KEYS_SCRIPT_CACHE_SIZE);
+    crypto_blake2b_update(&mac, (const uint8_t *)&unsigned_header, sizeof(unsigned_header));
+}
+
+// returns true if the MAC in the header matches the bytecode following it
+static bool script_cache_authentic(const uint8_t key[STORAGE_KEYS_SCRIPT_CACHE_SIZE], const script_cache_header &header, const script_cache_reader &bytecode)
+{
+    crypto_blake2b_ctx mac;
+    script_cache_mac_init(mac, key, header);
+    crypto_blake2b_update(&mac, bytecode.data, bytecode.size);
+    uint8_t expected[SCRIPT_CACHE_MAC_SIZE];
+    crypto_blake2b_final(&mac, expected);
+    return crypto_verify16(expected, header.mac) == 0;
+}
+
+// give Lua the whole of the bytecode in one go
+static const char *script_cache_read(lua_State *L, void *ud, size_t *size)
+{
+    script_cache_reader *reader = (script_cache_reader *)ud;
+    *size = reader->size;
+    reader->size = 0;
+    return (const char *)reader->data;
+}
+
+static int script_cache_write(lua_State *L, const void *p, size_t sz, void *ud)
+{
+    script_cache_writer *writer = (script_cache_writer *)ud;
+    crypto_blake2b_update(&writer->mac, (const uint8_t *)p, sz);
+    return AP::FS().write(writer->fd, p, sz) == int32_t(sz) ? 0 : 1;
+}
+
+void lua_scripts::script_cache_path(char *path, size_t size, const char *filename, uint32_t crc)
+{
+    const uint32_t key = crc_crc32(crc, (const uint8_t *)filename, strlen(filename));
+    snprintf(path, size, SCRIPT_CACHE_DIRECTORY "/%08X.luac", unsigned(key));
+}
+
+bool lua_scripts::load_cached_script(lua_State *L, const char *filename, uint32_t crc)
+{
+    uint8_t key[STORAGE_KEYS_SCRIPT_CACHE_SIZE];
+    if (!script_cache_key(key)) {
+        return false;
+    }
+
+    char path[sizeof(SCRIPT_CACHE_DIRECTORY) + 16];
+    script_cache_path(path, sizeof(path), filename, crc);
+
+    struct stat st;
+    if (AP::FS().stat(path, &st) != 0) {
+        crypto_wipe(key, sizeof(key));
+        return false;
+    }
+    const uint32_t size = st.st_size;
+    uint8_t *entry = size > sizeof(script_cache_header) ? (uint8_t *)_heap.allocate(size) : nullptr;
+    if (entry == nullptr) {
+        crypto_wipe(key, sizeof(key));
+        if (size <= sizeof(script_cache_header)) {
+            // damaged, it will be replaced
+            AP::FS().unlink(path);
+        }
+        return false;
+    }
+
+    // read the entry once and check it in memory, so Lua only ever
+    // sees the bytes that were authenticated
+    bool ret = false;
+    const int fd = AP::FS().open(path, O_RDONLY);
+    if (fd != -1) {
+        uint32_t ofs = 0;
+        while (ofs < size) {
+            const int32_t len = AP::FS().read(fd, &entry[ofs], size - ofs);
+            if (len <= 0) {
+                break;
+            }
+            ofs += len;
+        }
+        AP::FS().close(fd);
+        ret = (ofs == size);
+    }
+
+    struct script_cache_header header;
+    memcpy(&header, entry, sizeof(header));
+    script_cache_reader reader { &entry[sizeof(header)], size - uint32_t(sizeof(header)) };
+    ret = ret &&
+          header.magic == SCRIPT_CACHE_MAGIC &&
+          header.lua_version == LUA_VERSION_NUM &&
+          header.crc == crc &&
+          script_cache_authentic(key, header, reader);
+    crypto_wipe(key, sizeof(key));
+    if (ret) {
+        // Lua checks the rest of the format, including the sizes of its types
+        if (lua_load(L, script_cache_read, &reader, filename, lua_cached_binary_mode) != LUA_OK) {
+            lua_pop(L, 1);
+            ret = false;
+        }
+    }
+    _heap.deallocate(entry);
+
+    if (!ret) {
+        // stale or damaged, it will be replaced
+        AP::FS().unlink(path);
+    }
+    return ret;
+}
+
+void lua_scripts::save_cached_script(lua_State *L, const char *filename, uint32_t crc)
+{
+    char path[sizeof(SCRIPT_CACHE_DIRECTORY) + 16];
+    char tmp_path[sizeof(path)];
+    script_cache_path(path, sizeof(path), filename, crc);
+    strncpy(tmp_path, path, sizeof(tmp_path));
+    memcpy(&tmp_path[strlen(tmp_path)-4], "tmp", 4);
+
+    uint8_t key[STORAGE_KEYS_SCRIPT_CACHE_SIZE];
+    if (!script_cache_key(key)) {
+        return;
+    }
+
+    AP::FS().mkdir(SCRIPT_CACHE_DIRECTORY);
+    script_cache_writer writer;
+    writer.fd = AP::FS().open(tmp_path, O_WRONLY|O_CREAT|O_TRUNC);
+    if (writer.fd == -1) {
+        crypto_wipe(key, sizeof(key));
+        return;
+    }
+
+    // write to a temporary file and rename it, so a power loss can't
+    // leave a partial entry. The MAC is filled in once the bytecode
+    // has been written
+    struct script_cache_header header {
+        SCRIPT_CACHE_MAGIC,
+        LUA_VERSION_NUM,
+        crc,
+        {}
+    };
+    script_cache_mac_init(writer.mac, key, header);
+    crypto_wipe(key, sizeof(key));
+    bool ok = AP::FS().write(writer.fd, &header, sizeof(header)) == sizeof(header) &&
+              lua_dump(L, script_cache_write, &writer, 0) == 0;
+    crypto_blake2b_final(&writer.mac, header.mac);
+    ok = ok &&
+         AP::FS().lseek(writer.fd, offsetof(script_cache_header, mac), SEEK_SET) == offsetof(script_cache_header, mac) &&
+         AP::FS().write(writer.fd, header.mac, sizeof(header.mac)) == sizeof(header.mac);
+    ok = (AP::FS().close(writer.fd) == 0) && ok;
+
+    if (!ok || AP::FS().rename(tmp_path, path) != 0) {
+        AP::FS().unlink(tmp_path);
+    }
+}
+
+void lua_scripts::prune_script_cache(void)
+{
+    auto *d = AP::FS().opendir(SCRIPT_CACHE_DIRECTORY);
+    if (d == nullptr) {
+        return;
+    }
+
+    char path[sizeof(SCRIPT_CACHE_DIRECTORY) + 16];
+    for (struct dirent *de=AP::FS().readdir(d); de; de=AP::FS().readdir(d)) {
+        if ((de->d_name[0] == '.') || (strlen(de->d_name) >= sizeof(path) - sizeof(SCRIPT_CACHE_DIRECTORY))) {
+            // hidden, or not a name we would have given an entry
+            continue;
+        }
+        bool used = false;
+        for (script_info *script = scripts; script != nullptr; script = script->next) {
+            char script_path[sizeof(path)];
+            script_cache_path(script_path, sizeof(script_path), script->name, script->crc);
+            if (strcmp(&script_path[sizeof(SCRIPT_CACHE_DIRECTORY)], de->d_name) == 0) {
+                used = true;
+                break;
+            }
+        }
+        if (!used) {
+            snprintf(path, sizeof(path), SCRIPT_CACHE_DIRECTORY "/%s", de->d_name);
+            AP::FS().unlink(path);
+        }
+    }
+    AP::FS().closedir(d);
+}
+
 void lua_scripts::create_sandbox(lua_State *L) {
     lua_newtable(L);
     luaopen_base_sandbox(L);
@@ -322,6 +607,7 @@ void lua_scripts::run_next_script(lua_State *L) {
     // strip the selected script out of the list
     script_info *script = scripts;
     scripts = script->next;
+    running_script = script;
 
     // reset the hook to clear the counter
     reset_loop_overtime(L);
@@ -393,6 +679,10 @@ void lua_scripts::remove_script(lua_State *L, script_info *script) {
         return;
     }
 
+    if (script == running_script) {
+        running_script = nullptr;
+    }
+
     // ensure that the script isn't in the loaded list for any reason
     if (scripts == nullptr) {
         // nothing to do, already not in the list
@@ -457,11 +747,78 @@ void lua_scripts::reschedule_script(script_info *script) {
     previous->next = script;
 }
 
+/*
+  run incremental garbage collection steps until a cycle finishes or
+  the time budget is used, returning the time taken
+ */
+uint32_t lua_scripts::collect_garbage(lua_State *L, uint32_t budget_us)
+{
+    const uint32_t start_us = AP_HAL::micros();
+    do {
+        if (lua_gc(L, LUA_GCSTEP, 0)) {
+            // finished a cycle
+            break;
+        }
+    } while (AP_HAL::micros() - start_us < budget_us);
+    return AP_HAL::micros() - start_us;
+}
+
+void lua_scripts::histogram_add(uint16_t histogram[histogram_buckets], uint32_t time_us)
+{
+    // upper bounds of all but the last bucket
+    static const uint16_t bounds_us[histogram_buckets-1] { 100, 200, 500, 1000, 2000, 5000, 10000 };
+    uint8_t i = 0;
+    while (i < ARRAY_SIZE(bounds_us) && time_us >= bounds_us[i]) {
+        i++;
+    }
+    if (histogram[i] < UINT16_MAX) {
+        histogram[i]++;
+    }
+}
+
+void lua_scripts::log_histograms(void)
+{
+    for (script_info *script = scripts; script != nullptr; script = script->next) {
+#if HAL_LOGGING_ENABLED
+        if ((_debug_options.get() & uint8_t(DebugLevel::LOG_RUNTIME)) != 0) {
+            char name[16] {};
+            const char *name_short = strrchr(script->name, '/');
+            strncpy_noterm(name, name_short != nullptr ? name_short+1 : script->name, sizeof(name));
+
+// @LoggerMessage: SCRH
+// @Description: Scripting run time and garbage collection time histograms
+// @Field: TimeUS: Time since system startup
+// @Field: Name: script name
+// @Field: Type: histogram type, 0 for run time, 1 for garbage collection time after a run
+// @Field: B0: number of times under 100us
+// @Field: B1: number of times from 100us to 200us
+// @Field: B2: number of times from 200us to 500us
+// @Field: B3: number of times from 500us to 1ms
+// @Field: B4: number of times from 1ms to 2ms
+// @Field: B5: number of times from 2ms to 5ms
+// @Field: B6: number of times from 5ms to 10ms
+// @Field: B7: number of times over 10ms
+            for (uint8_t type=0; type<2; type++) {
+                const uint16_t *h = type == 0 ? script->run_histogram : script->gc_histogram;
+                AP::logger().Write("SCRH", "TimeUS,Name,Type,B0,B1,B2,B3,B4,B5,B6,B7", "QNBHHHHHHHH",
+                                   AP_HAL::micros64(),
+                                   name,
+                                   type,
+                                   h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7]);
+            }
+        }
+#endif // HAL_LOGGING_ENABLED
+        memset(script->run_histogram, 0, sizeof(script->run_histogram));
+        memset(script->gc_histogram, 0, sizeof(script->gc_histogram));
+    }
+}
+
 MultiHeap lua_scripts::_heap;
+PoolHeap lua_scripts::_pool{_heap};
 
 void *lua_scripts::alloc(void *ud, void *ptr, size_t osize, size_t nsize) {
     (void)ud; /* not used */
-    return _heap.change_size(ptr, osize, nsize);
+    return _pool.change_size(ptr, osize, nsize);
 }
 
 void lua_scripts::run(void) {
@@ -479,6 +836,7 @@ void lua_scripts::run(void) {
         }
         if (lua_state != nullptr) {
             lua_close(lua_state); // shutdown the old state
+            _pool.reset();
         }
         // remove all the old scheduled scripts
         for (script_info *script = scripts; script != nullptr; script = scripts) {
@@ -534,6 +892,9 @@ void lua_scripts::run(void) {
     if (!loaded) {
         GCS_SEND_TEXT(MAV_SEVERITY_CRITICAL, "Lua: All directory's disabled see SCR_DIR_DISABLE");
     }
+    if ((_debug_options.get() & uint8_t(DebugLevel::CACHE_BYTECODE)) != 0) {
+        prune_script_cache();
+    }
 
 #ifndef __clang_analyzer__
     succeeded_initial_load = true;
@@ -578,6 +939,7 @@ void lua_scripts::run(void) {
 #endif
 
             const int startMem = lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
+            const PoolHeap::Stats startAlloc = _pool.get_stats();
             const uint32_t loadEnd = AP_HAL::micros();
 
             // NOTE!  the base pointer of our scripts linked list,
@@ -593,11 +955,27 @@ void lua_scripts::run(void) {
             hal.scheduler->restore_interrupts(istate);
 #endif
 
-            update_stats(script_name, runEnd - loadEnd, endMem, endMem - startMem);
-
-
-            // garbage collect after each script, this shouldn't matter, but seems to resolve a memory leak
-            lua_gc(L, LUA_GCCOLLECT, 0);
+            update_stats(script_name, runEnd - loadEnd, endMem, endMem - startMem, startAlloc);
+
+            // garbage collect after each script in incremental steps,
+            // rather than a full collection which can take many
+            // milliseconds. The budget is the time the script took,
+            // within the time the VM instruction limit would allow it
+            // at about 10 instructions per microsecond. The minimum
+            // never exceeds that limit
+            const uint32_t gc_max_us = MAX(_vm_steps, 1000) / 10;
+            const uint32_t gc_budget_us = constrain_uint32(runEnd - loadEnd, MIN(uint32_t(GC_MIN_BUDGET_US), gc_max_us), gc_max_us);
+            const uint32_t gc_time_us = collect_garbage(L, gc_budget_us);
+
+            if (running_script != nullptr) {
+                histogram_add(running_script->run_histogram, runEnd - loadEnd);
+                histogram_add(running_script->gc_histogram, gc_time_us);
+                running_script = nullptr;
+            }
+            if (AP_HAL::millis() - last_histogram_log_ms >= HISTOGRAM_LOG_PERIOD_MS) {
+                last_histogram_log_ms = AP_HAL::millis();
+                log_histograms();
+            }
 
         } else {
             if ((_debug_options.get() & uint8_t(DebugLevel::NO_SCRIPTS_TO_RUN)) != 0) {
@@ -623,6 +1001,7 @@ void lua_scripts::run(void) {
     if (lua_state != nullptr) {
         lua_close(lua_state); // shutdown the old state
         lua_state = nullptr;
+        _pool.reset();
     }
 
     error_msg_buf_sem.take_blocking();
@@ -27,6 +27,7 @@
 #include <GCS_MAVLink/GCS_MAVLink.h>
 #include <AP_HAL/Semaphores.h>
 #include <AP_Common/MultiHeap.h>
+#include <AP_Common/PoolHeap.h>
 #include "lua_common_defs.h"
 
 #include "lua/src/lua.hpp"
@@ -55,29 +56,57 @@ public:
         LOG_RUNTIME = 1U << 3,
         DISABLE_PRE_ARM = 1U << 4,
         SAVE_CHECKSUM = 1U << 5,
+        CACHE_BYTECODE = 1U << 6,
     };
 
 private:
 
     void create_sandbox(lua_State *L);
 
+    // buckets of the run time and garbage collection time histograms
+    static const uint8_t histogram_buckets = 8;
+
     typedef struct script_info {
        int env_ref;          // reference to the script's environment table
        int run_ref;          // reference to the function to run
        uint64_t next_run_ms; // time (in milliseconds) the script should next be run at
        uint32_t crc;         // crc32 checksum
        char *name;           // filename for the script // FIXME: This information should be available from Lua
+       uint16_t run_histogram[histogram_buckets]; // number of runs by run time
+       uint16_t gc_histogram[histogram_buckets];  // number of runs by garbage collection time after the run
        script_info *next;
     } script_info;
 
     script_info *load_script(lua_State *L, char *filename);
 
+    // name of the cache file holding a script's bytecode
+    static void script_cache_path(char *path, size_t size, const char *filename, uint32_t crc);
+
+    // load a script's bytecode from the cache, returning false if there is no valid cache entry
+    bool load_cached_script(lua_State *L, const char *filename, uint32_t crc);
+
+    // save the bytecode of the function on the top of the stack to the cache
+    void save_cached_script(lua_State *L, const char *filename, uint32_t crc);
+
+    // remove cache entries of scripts which are not loaded
+    void prune_script_cache(void);
+
     void reset_loop_overtime(lua_State *L);
 
     void load_all_scripts_in_dir(lua_State *L, const char *dirname);
 
     void run_next_script(lua_State *L);
 
+    // run incremental garbage collection steps for up to budget_us
+    uint32_t collect_garbage(lua_State *L, uint32_t budget_us);
+
+    // add a time to a histogram
+    static void histogram_add(uint16_t histogram[histogram_buckets], uint32_t time_us);
+
+    // log and reset the histograms of all scripts
+    void log_histograms(void);
+    uint32_t last_histogram_log_ms;
+
     void remove_script(lua_State *L, script_info *script);
 
     // reschedule the script for execution. It is assumed the script is not in the list already
@@ -85,6 +114,8 @@ private:
 
     script_info *scripts; // linked list of scripts to be run, sorted by next run time (soonest first)
 
+    script_info *running_script; // script being run, nullptr if it has been removed
+
     // hook will be run when CPU time for a script is exceeded
     // it must be static to be passed to the C API
     static void hook(lua_State *L, lua_Debug *ar);
@@ -102,8 +133,12 @@ private:
 
     static MultiHeap _heap;
 
+    // Lua's allocations, with small ones from pools
+    static PoolHeap _pool;
+
     // helper for print and log of runtime stats
-    void update_stats(const char *name, uint32_t run_time, int total_mem, int run_mem);
+    void update_stats(const char *name, uint32_t run_time, int total_mem, int run_mem,
+                      const PoolHeap::Stats &start_alloc);
 
     // must be static for use in atpanic
     static void print_error(MAV_SEVERITY severity);
@@ -0,0 +1,90 @@
+--[[
+  microbenchmarks of the operations scripts do most often, for
+  measuring changes to the scripting engine. Each benchmark runs in its
+  own update so the VM instruction limit isn't hit, and reports the
+  time per operation. Allocations per update are shown by the
+  scripting runtime debug output (SCR_DEBUG_OPTS bit 1)
+--]]
+
+local ITERATIONS = 1000
+local PASSES = 5
+
+local benchmarks = {
+  { "empty loop", function(n)
+      for _ = 1, n do
+      end
+    end },
+  { "small table", function(n)
+      for i = 1, n do
+        local _ = { x = i }
+      end
+    end },
+  { "Vector3f", function(n)
+      for _ = 1, n do
+        local _ = Vector3f()
+      end
+    end },
+  { "Location", function(n)
+      for _ = 1, n do
+        local _ = Location()
+      end
+    end },
+  { "Vector3f arithmetic", function(n)
+      local a = Vector3f()
+      local b = Vector3f()
+      b:x(1)
+      for _ = 1, n do
+        a = a + b
+      end
+    end },
+  { "string format", function(n)
+      for i = 1, n do
+        local _ = string.format("%d", i)
+      end
+    end },
+  { "method call", function(n)
+      local v = Vector3f()
+      for _ = 1, n do
+        local _ = v:x()
+      end
+    end },
+  { "ahrs:get_gyro", function(n)
+      for _ = 1, n do
+        local _ = ahrs:get_gyro()
+      end
+    end },
+  { "ahrs:get_gyro in place", function(n)
+      local gyro = Vector3f()
+      for _ = 1, n do
+        ahrs:get_gyro(gyro)
+      end
+    end },
+}
+
+local bench_index = 1
+local pass = 1
+local total_us = 0
+
+local function update()
+  local name, fn = table.unpack(benchmarks[bench_index])
+
+  local start_us = micros()
+  fn(ITERATIONS)
+  total_us = total_us + (micros() - start_us):tofloat()
+
+  pass = pass + 1
+  if pass > PASSES then
+    local ops = ITERATIONS * PASSES
+    gcs:send_text(6, string.format("Benchmark %s: %.3f us/op", name, total_us / ops))
+    pass = 1
+    total_us = 0
+    bench_index = bench_index + 1
+    if bench_index > #benchmarks then
+      gcs:send_text(6, "Benchmarks complete")
+      return
+    end
+  end
+  return update, 10
+end
+
+return update, 1000
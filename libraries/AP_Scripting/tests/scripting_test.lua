@@ -63,6 +63,39 @@ function test_uint64()
   return pass
 end
 
+function test_in_place()
+  local pass = true
+
+  -- a userdata passed in is filled and returned rather than a new one
+  local gyro = Vector3f()
+  gyro:x(1000)
+  local result = ahrs:get_gyro(gyro)
+  pass = pass and gyro:x() ~= 1000
+  result:y(42)
+  pass = pass and gyro:y() == 42
+
+  -- without one a new userdata is returned
+  result = ahrs:get_gyro()
+  result:y(7)
+  pass = pass and gyro:y() == 42
+
+  -- nor with nil
+  result = ahrs:get_gyro(nil)
+  result:y(7)
+  pass = pass and gyro:y() == 42
+
+  -- the result may be written over an argument
+  local vec = Vector3f()
+  vec:x(1)
+  local body = ahrs:earth_to_body(vec)
+  result = ahrs:earth_to_body(vec, vec)
+  pass = pass and is_equal(vec:x(), body:x()) and is_equal(vec:y(), body:y()) and is_equal(vec:z(), body:z())
+  result:z(3)
+  pass = pass and vec:z() == 3
+
+  return pass
+end
+
 function update()
   local all_tests_passed = true
   local require_test_local = require('test/nested')
@@ -82,6 +115,7 @@ function update()
   -- each test should run then and it's result with the previous ones
   all_tests_passed = test_offset(500, 200) and all_tests_passed
   all_tests_passed = test_uint64() and all_tests_passed
+  all_tests_passed = test_in_place() and all_tests_passed
 
   if all_tests_passed then
     gcs:send_text(3, "Internal tests passed")
@@ -58,7 +58,7 @@ const AP_Param::GroupInfo AP_Terrain::var_info[] = {
     // @Param: OPTIONS
     // @DisplayName: Terrain options
     // @Description: Options to change behaviour of terrain system
-    // @Bitmask: 0:Disable Download
+    // @Bitmask: 0:Disable Download, 1:Disable Prefetch, 2:Disable Memory Mapped IO
     // @User: Advanced
     AP_GROUPINFO("OPTIONS",   2, AP_Terrain, options, 0),
 
@@ -186,6 +186,157 @@ bool AP_Terrain::height_amsl(const Location &loc, float &height, bool corrected)
 }
 
 
+/*
+  return terrain heights in meters above sea level for an array of
+  locations. This does one cache lookup per run of locations in the
+  same grid block and then interpolates all of the heights in one
+  loop
+ */
+uint16_t AP_Terrain::height_amsl(const Location *locs, uint16_t count, float *heights, bool *valid, bool corrected)
+{
+    if (!allocate()) {
+        for (uint16_t i=0; i<count; i++) {
+            valid[i] = false;
+        }
+        return 0;
+    }
+
+    const AP_AHRS &ahrs = AP::ahrs();
+    uint16_t num_valid = 0;
+    const float offset = (corrected && have_reference_offset) ? reference_offset : 0;
+
+    for (uint16_t base=0; base<count; base += TERRAIN_BATCH_SIZE) {
+        const uint16_t n = MIN(count - base, TERRAIN_BATCH_SIZE);
+
+        // corner heights and fractions, laid out so the interpolation
+        // below is a simple loop over arrays
+        float h00[TERRAIN_BATCH_SIZE], h01[TERRAIN_BATCH_SIZE];
+        float h10[TERRAIN_BATCH_SIZE], h11[TERRAIN_BATCH_SIZE];
+        float frac_x[TERRAIN_BATCH_SIZE], frac_y[TERRAIN_BATCH_SIZE];
+
+        const struct grid_block *grid = nullptr;
+        struct grid_info last_info {};
+        for (uint16_t i=0; i<n; i++) {
+            const Location &loc = locs[base+i];
+
+            // quick access for home altitude
+            if (loc.lat == home_loc.lat &&
+                loc.lng == home_loc.lng) {
+                valid[base+i] = true;
+                h00[i] = h01[i] = h10[i] = h11[i] = home_height;
+                frac_x[i] = frac_y[i] = 0;
+                continue;
+            }
+
+            struct grid_info info;
+            calculate_grid_info(loc, info);
+            if (grid == nullptr ||
+                info.lat_degrees != last_info.lat_degrees ||
+                info.lon_degrees != last_info.lon_degrees ||
+                info.grid_idx_x != last_info.grid_idx_x ||
+                info.grid_idx_y != last_info.grid_idx_y) {
+                grid = &find_grid_cache(info).grid;
+                last_info = info;
+            }
+
+            ASSERT_RANGE(info.idx_x, 0, TERRAIN_GRID_BLOCK_SIZE_X-2);
+            ASSERT_RANGE(info.idx_y, 0, TERRAIN_GRID_BLOCK_SIZE_Y-2);
+
+            valid[base+i] = check_bitmap(*grid, info.idx_x,   info.idx_y) &&
+                            check_bitmap(*grid, info.idx_x,   info.idx_y+1) &&
+                            check_bitmap(*grid, info.idx_x+1, info.idx_y) &&
+                            check_bitmap(*grid, info.idx_x+1, info.idx_y+1);
+
+            h00[i] = grid->height[info.idx_x+0][info.idx_y+0];
+            h01[i] = grid->height[info.idx_x+0][info.idx_y+1];
+            h10[i] = grid->height[info.idx_x+1][info.idx_y+0];
+            h11[i] = grid->height[info.idx_x+1][info.idx_y+1];
+            frac_x[i] = info.frac_x;
+            frac_y[i] = info.frac_y;
+        }
+
+        // same dual linear interpolation as the single location call
+        for (uint16_t i=0; i<n; i++) {
+            const float avg1 = (1.0f-frac_x[i]) * h00[i] + frac_x[i] * h10[i];
+            const float avg2 = (1.0f-frac_x[i]) * h01[i] + frac_x[i] * h11[i];
+            heights[base+i] = (1.0f-frac_y[i]) * avg1 + frac_y[i] * avg2 + offset;
+        }
+
+        for (uint16_t i=0; i<n; i++) {
+            if (!valid[base+i]) {
+                continue;
+            }
+            num_valid++;
+            const Location &loc = locs[base+i];
+            if (loc.lat == ahrs.get_home().lat &&
+                loc.lng == ahrs.get_home().lng) {
+                // remember home altitude as a special case
+                home_height = heights[base+i] - offset;
+                home_loc = loc;
+                have_home_height = true;
+            }
+        }
+    }
+
+    return num_valid;
+}
+
+/*
+  return the maximum terrain height along a polyline, sampled at grid
+  spacing intervals including each vertex
+ */
+bool AP_Terrain::height_amsl_max_along_path(const Location *points, uint16_t npoints, float &max_height, bool corrected)
+{
+    if (npoints == 0 || !allocate() || grid_spacing <= 0) {
+        return false;
+    }
+
+    Location locs[TERRAIN_BATCH_SIZE];
+    float heights[TERRAIN_BATCH_SIZE];
+    bool valid[TERRAIN_BATCH_SIZE];
+    uint16_t n = 0;
+    bool all_valid = true;
+    bool have_max = false;
+
+    // flush the pending samples through the batch lookup
+    auto flush = [&]() {
+        if (n == 0) {
+            return;
+        }
+        if (height_amsl(locs, n, heights, valid, corrected) != n) {
+            all_valid = false;
+        }
+        for (uint16_t i=0; i<n; i++) {
+            if (valid[i] && (!have_max || heights[i] > max_height)) {
+                max_height = heights[i];
+                have_max = true;
+            }
+        }
+        n = 0;
+    };
+
+    locs[n++] = points[0];
+    for (uint16_t p=1; p<npoints; p++) {
+        const Vector2f ofs = points[p-1].get_distance_NE(points[p]);
+        const uint32_t nsteps = MAX(uint32_t(ofs.length() / grid_spacing), 1U);
+        for (uint32_t s=1; s<=nsteps; s++) {
+            if (n == TERRAIN_BATCH_SIZE) {
+                flush();
+            }
+            if (s == nsteps) {
+                locs[n++] = points[p];
+            } else {
+                Location loc = points[p-1];
+                loc.offset(ofs.x * s / nsteps, ofs.y * s / nsteps);
+                locs[n++] = loc;
+            }
+        }
+    }
+    flush();
+
+    return all_valid && have_max;
+}
+
 /* 
    find difference between home terrain height and the terrain
    height at the current location in meters. A positive result
@@ -337,16 +488,29 @@ float AP_Terrain::lookahead(float bearing, float distance, float climb_ratio)
     float climb = 0;
     float lookahead_estimate = 0;
 
-    // check for terrain at grid spacing intervals
+    // check for terrain at grid spacing intervals, looking up the
+    // heights a batch at a time
+    Location locs[TERRAIN_BATCH_SIZE];
+    float climbs[TERRAIN_BATCH_SIZE];
+    float heights[TERRAIN_BATCH_SIZE];
+    bool valid[TERRAIN_BATCH_SIZE];
     while (distance > 0) {
-        loc.offset_bearing(bearing, grid_spacing);
-        climb += climb_ratio * grid_spacing;
-        distance -= grid_spacing;
-        float height;
-        if (height_amsl(loc, height)) {
-            float rise = (height - base_height) - climb;
-            if (rise > lookahead_estimate) {
-                lookahead_estimate = rise;
+        uint16_t n = 0;
+        while (distance > 0 && n < TERRAIN_BATCH_SIZE) {
+            loc.offset_bearing(bearing, grid_spacing);
+            climb += climb_ratio * grid_spacing;
+            distance -= grid_spacing;
+            locs[n] = loc;
+            climbs[n] = climb;
+            n++;
+        }
+        height_amsl(locs, n, heights, valid);
+        for (uint16_t i=0; i<n; i++) {
+            if (valid[i]) {
+                float rise = (heights[i] - base_height) - climbs[i];
+                if (rise > lookahead_estimate) {
+                    lookahead_estimate = rise;
+                }
             }
         }
     }
@@ -392,6 +556,7 @@ void AP_Terrain::update(void)
     // update tiles surrounding our current location:
     if (pos_valid) {
         have_surrounding_tiles = update_surrounding_tiles(loc);
+        update_prefetch(loc);
     } else {
         have_surrounding_tiles = false;
     }
@@ -430,6 +595,88 @@ bool AP_Terrain::update_surrounding_tiles(const Location &loc)
     return ret;
 }
 
+/*
+  prefetch grid blocks ahead of the vehicle so that height_amsl()
+  does not miss when we fly into a new block. Blocks are touched along
+  the velocity vector and then along the upcoming mission legs, which
+  queues a disk read and, if needed, a request to the GCS.
+
+  The number of blocks touched is limited so that prefetching never
+  pushes the blocks surrounding the vehicle out of the cache
+ */
+void AP_Terrain::update_prefetch(const Location &loc)
+{
+    if ((options.get() & uint16_t(Options::DisablePrefetch)) != 0 ||
+        grid_spacing <= 0 ||
+        !allocate()) {
+        return;
+    }
+
+    const uint32_t now_ms = AP_HAL::millis();
+    if (now_ms - last_prefetch_ms < 1000) {
+        return;
+    }
+    last_prefetch_ms = now_ms;
+
+    // leave room for the 3x3 blocks around the vehicle
+    if (cache_size <= 9) {
+        return;
+    }
+    uint16_t budget = (cache_size - 9) / 2;
+
+    Vector3f vel;
+    if (AP::ahrs().get_velocity_NED(vel)) {
+        const Vector2f ahead = vel.xy() * TERRAIN_PREFETCH_TIME_S;
+        if (ahead.length() > grid_spacing) {
+            Location loc2 = loc;
+            loc2.offset(ahead.x, ahead.y);
+            prefetch_line(loc, loc2, budget);
+        }
+    }
+
+    update_mission_prefetch(loc, budget);
+}
+
+/*
+  touch each grid block along the line from start to end, stopping
+  when the block budget is used up
+ */
+void AP_Terrain::prefetch_line(const Location &start, const Location &end, uint16_t &budget)
+{
+    const Vector2f ofs = start.get_distance_NE(end);
+    const float length = ofs.length();
+    if (!is_positive(length)) {
+        return;
+    }
+
+    // step at half the block size so we can't step over a block
+    const float step = 0.5f * grid_spacing * MIN(TERRAIN_GRID_BLOCK_SPACING_X, TERRAIN_GRID_BLOCK_SPACING_Y);
+    const uint16_t nsteps = MIN(uint32_t(length / step) + 1, 1000U);
+
+    struct grid_info last_info {};
+    bool have_last = false;
+    for (uint16_t i=1; i<=nsteps && budget > 0; i++) {
+        Location loc2 = start;
+        const float frac = MIN(i * step / length, 1.0f);
+        loc2.offset(ofs.x * frac, ofs.y * frac);
+
+        struct grid_info info;
+        calculate_grid_info(loc2, info);
+        if (have_last &&
+            info.lat_degrees == last_info.lat_degrees &&
+            info.lon_degrees == last_info.lon_degrees &&
+            info.grid_idx_x == last_info.grid_idx_x &&
+            info.grid_idx_y == last_info.grid_idx_y) {
+            continue;
+        }
+        last_info = info;
+        have_last = true;
+
+        find_grid_cache(info);
+        budget--;
+    }
+}
+
 bool AP_Terrain::pre_arm_checks(char *failure_msg, uint8_t failure_msg_len) const
 {
     // check no outstanding requests for data:
@@ -502,6 +749,21 @@ bool AP_Terrain::allocate(void)
         return false;
     }
     cache_size = config_cache_size;
+
+    // use at least two hash buckets per cache block to keep chains short
+    cache_hash_size = 1;
+    while (cache_hash_size < 2*cache_size) {
+        cache_hash_size <<= 1;
+    }
+    cache_hash = (uint16_t *)calloc(cache_hash_size, sizeof(cache_hash[0]));
+    if (cache_hash == nullptr) {
+        free(cache);
+        cache = nullptr;
+        cache_size = 0;
+        GCS_SEND_TEXT(MAV_SEVERITY_CRITICAL, "Terrain: Allocation failed");
+        memory_alloc_failed = true;
+        return false;
+    }
     return true;
 }
 
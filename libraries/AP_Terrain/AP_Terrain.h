@@ -47,8 +47,40 @@
 
 // number of grid_blocks in the LRU memory cache
 #ifndef TERRAIN_GRID_BLOCK_CACHE_SIZE
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#define TERRAIN_GRID_BLOCK_CACHE_SIZE 64
+#else
 #define TERRAIN_GRID_BLOCK_CACHE_SIZE 12
 #endif
+#endif
+
+// how far ahead of the vehicle we prefetch grid_blocks, in seconds
+// of flight along the current velocity vector
+#ifndef TERRAIN_PREFETCH_TIME_S
+#define TERRAIN_PREFETCH_TIME_S 60
+#endif
+
+// maximum distance along upcoming mission legs to prefetch, in meters
+#ifndef TERRAIN_PREFETCH_MISSION_DIST
+#define TERRAIN_PREFETCH_MISSION_DIST 20000
+#endif
+
+// maximum number of upcoming mission legs to prefetch
+#ifndef TERRAIN_PREFETCH_MISSION_LEGS
+#define TERRAIN_PREFETCH_MISSION_LEGS 8
+#endif
+
+// number of locations handled per pass of a batch height lookup. The
+// scratch arrays for a pass live on the stack of the caller, so keep
+// this small enough for the IO and scripting thread stacks
+#ifndef TERRAIN_BATCH_SIZE
+#define TERRAIN_BATCH_SIZE 8
+#endif
+
+// number of degree files kept memory mapped at once
+#ifndef TERRAIN_MMAP_MAX_FILES
+#define TERRAIN_MMAP_MAX_FILES 4
+#endif
 
 // format of grid on disk
 #define TERRAIN_GRID_FORMAT_VERSION 1
@@ -122,6 +154,24 @@ public:
      */
     bool height_amsl(const Location &loc, float &height, bool corrected = true);
 
+    /*
+      find the terrain height in meters above sea level for an array
+      of locations. Consecutive locations in the same grid block share
+      one cache lookup, so callers should pass points in path order.
+
+      valid[i] is set to whether heights[i] is available. Returns the
+      number of locations with heights available
+     */
+    uint16_t height_amsl(const Location *locs, uint16_t count, float *heights, bool *valid, bool corrected = true);
+
+    /*
+      find the maximum terrain height in meters above sea level along
+      a polyline, sampled at the grid spacing.
+
+      return false if terrain is not available for every sample
+     */
+    bool height_amsl_max_along_path(const Location *points, uint16_t npoints, float &max_height, bool corrected = true);
+
     /* 
        find difference between home terrain height and the terrain
        height at the current location in meters. A positive result
@@ -264,6 +314,11 @@ private:
 
         // the last time access was requested to this block, used for LRU
         uint32_t last_access_ms;
+
+        // hash bucket this block is linked into and the 1-based index
+        // of the next block in the same bucket, 0 for end of chain
+        uint16_t hash_bucket;
+        uint16_t hash_next;
     };
 
     /*
@@ -303,6 +358,18 @@ private:
     */
     struct grid_cache &find_grid_cache(const struct grid_info &info);
 
+    /*
+      hashed index of cache blocks keyed on grid block position
+     */
+    uint16_t grid_hash(const struct grid_info &info) const;
+    void hash_insert(uint16_t idx, uint16_t bucket);
+    void hash_remove(uint16_t idx);
+
+    /*
+      find the least recently used cache block to replace
+     */
+    uint16_t find_lru_idx(void) const;
+
     /*
       calculate bit number in grid_block bitmap. This corresponds to a
       bit representing a 4x4 mavlink transmitted block
@@ -338,6 +405,7 @@ private:
      */
     int16_t find_io_idx(enum GridCacheState state);
     uint16_t get_block_crc(struct grid_block &block);
+    bool check_block(struct grid_block &block, int32_t lat, int32_t lon);
     void check_disk_read(void);
     void check_disk_write(void);
     void io_timer(void);
@@ -347,6 +415,32 @@ private:
     void write_block(void);
     void read_block(void);
 
+#if AP_TERRAIN_MMAP_ENABLED
+    /*
+      memory mapped read of grid blocks, done in the IO timer
+     */
+    enum class MmapState : uint8_t {
+        Unused  = 0,
+        Mapped  = 1,
+        Missing = 2,    // no file yet, all blocks are empty
+        Failed  = 3,    // could not be mapped, read() is used
+    };
+    struct mmap_file {
+        MmapState state;
+        int8_t lat_degrees;
+        int16_t lon_degrees;
+        uint8_t *data;
+        size_t length;
+        uint32_t opened_ms;
+        uint32_t last_access_ms;
+    };
+    bool mmap_read_block(void);
+    struct mmap_file *mmap_find_file(const struct grid_block &block);
+    void mmap_file_open(struct mmap_file &mfile, const struct grid_block &block);
+    void mmap_file_close(struct mmap_file &mfile);
+    void mmap_file_written(struct grid_block &block);
+#endif
+
     // check for missing data in squares surrounding loc:
     bool update_surrounding_tiles(const Location &loc);
 
@@ -360,6 +454,14 @@ private:
      */
     void update_rally_data(void);
 
+    /*
+      prefetch grid blocks ahead of the vehicle and along the
+      upcoming mission legs
+     */
+    void update_prefetch(const Location &loc);
+    void update_mission_prefetch(const Location &loc, uint16_t &budget);
+    void prefetch_line(const Location &start, const Location &end, uint16_t &budget);
+
     /*
       calculate reference offset if needed
      */
@@ -376,12 +478,22 @@ private:
 
     enum class Options {
         DisableDownload = (1U<<0),
+        DisablePrefetch = (1U<<1),
+        DisableMmap = (1U<<2),
     };
 
     // cache of grids in memory, LRU
     uint8_t cache_size = 0;
     struct grid_cache *cache = nullptr;
 
+    // hash buckets holding 1-based cache indexes, 0 for empty. The
+    // number of buckets is a power of 2
+    uint16_t cache_hash_size;
+    uint16_t *cache_hash = nullptr;
+
+    // last time we prefetched grids ahead of the vehicle
+    uint32_t last_prefetch_ms;
+
     // a grid_cache block waiting for disk IO
     enum DiskIoState {
         DiskIoIdle      = 0,
@@ -403,6 +515,11 @@ private:
     // open file handle on degree file
     int fd;
 
+#if AP_TERRAIN_MMAP_ENABLED
+    // memory mapped degree files
+    struct mmap_file mmap_files[TERRAIN_MMAP_MAX_FILES];
+#endif
+
     // has the timer been setup?
     bool timer_setup;
 
@@ -92,6 +92,8 @@ void AP_Terrain::schedule_disk_io(void)
             cache[cache_idx].last_access_ms = AP_HAL::millis();
         }
         disk_io_state = DiskIoIdle;
+        // hand the next waiting block straight to the IO timer
+        check_disk_read();
         break;
     }
 
@@ -298,12 +300,7 @@ void AP_Terrain::read_block(void)
 
     ssize_t ret = AP::FS().read(fd, &disk_block, sizeof(disk_block));
     if (ret != sizeof(disk_block) || 
-        !TERRAIN_LATLON_EQUAL(disk_block.block.lat,lat) ||
-        !TERRAIN_LATLON_EQUAL(disk_block.block.lon,lon) ||
-        disk_block.block.bitmap == 0 ||
-        disk_block.block.spacing != grid_spacing ||
-        disk_block.block.version != TERRAIN_GRID_FORMAT_VERSION ||
-        disk_block.block.crc != get_block_crc(disk_block.block)) {
+        !check_block(disk_block.block, lat, lon)) {
 #if TERRAIN_DEBUG
         printf("read empty block at %ld %ld ret=%d (%ld %ld %u 0x%08lx) 0x%04x:0x%04x\n",
                (long)lat,
@@ -365,9 +362,18 @@ void AP_Terrain::io_timer(void)
             return;
         }
         write_block();
+#if AP_TERRAIN_MMAP_ENABLED
+        mmap_file_written(disk_block.block);
+#endif
         break;
 
     case DiskIoWaitRead:
+#if AP_TERRAIN_MMAP_ENABLED
+        // copy the block out of the mapped file if we can
+        if (mmap_read_block()) {
+            break;
+        }
+#endif
         // need to read in the block
         open_file();
         if (fd == -1) {
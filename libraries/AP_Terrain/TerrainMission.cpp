@@ -114,6 +114,45 @@ void AP_Terrain::update_mission_data(void)
 #endif  // AP_MISSION_ENABLED
 }
 
+/*
+  prefetch grid blocks along the legs of the mission ahead of the
+  current navigation command. DO_JUMP commands are not followed, so
+  only the legs in storage order are covered
+ */
+void AP_Terrain::update_mission_prefetch(const Location &loc, uint16_t &budget)
+{
+#if AP_MISSION_ENABLED
+    const AP_Mission *mission = AP::mission();
+    if (mission == nullptr ||
+        mission->state() != AP_Mission::MISSION_RUNNING) {
+        return;
+    }
+
+    Location prev_loc = loc;
+    float total_dist = 0;
+    uint8_t legs = 0;
+    for (uint16_t index = mission->get_current_nav_index();
+         index != 0 && budget > 0 && legs < TERRAIN_PREFETCH_MISSION_LEGS;
+         index++) {
+        AP_Mission::Mission_Command cmd;
+        if (!mission->read_cmd_from_storage(index, cmd)) {
+            break;
+        }
+        if (!AP_Mission::is_nav_cmd(cmd) ||
+            (cmd.content.location.lat == 0 && cmd.content.location.lng == 0)) {
+            continue;
+        }
+        total_dist += prev_loc.get_distance(cmd.content.location);
+        prefetch_line(prev_loc, cmd.content.location, budget);
+        if (total_dist > TERRAIN_PREFETCH_MISSION_DIST) {
+            break;
+        }
+        prev_loc = cmd.content.location;
+        legs++;
+    }
+#endif  // AP_MISSION_ENABLED
+}
+
 #if HAL_RALLY_ENABLED
 /*
   check that we have fetched all rally terrain data
@@ -0,0 +1,228 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  memory mapped reads of terrain grid blocks for boards with a posix
+  filesystem. On these boards the terrain files usually sit in the
+  page cache, so copying a block out of a mapping is much cheaper than
+  a seek and read per block.
+
+  Like the rest of the disk IO this runs in the IO timer, serving the
+  DiskIoWaitRead request in disk_block. Writes of new data from the
+  GCS still go through write_block(), and the kernel keeps the mapping
+  coherent with those writes. Files that are missing or can't be
+  mapped are remembered and only retried every
+  TERRAIN_MMAP_RETRY_MS, a mapping failure falls back to read()
+ */
+
+#include "AP_Terrain.h"
+
+#if AP_TERRAIN_MMAP_ENABLED
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TERRAIN_MMAP_RETRY_MS 5000
+
+extern const AP_HAL::HAL& hal;
+
+/*
+  fill in disk_block from the mapped degree file. Returns false if the
+  file can't be mapped, in which case the caller reads the block with
+  read()
+ */
+bool AP_Terrain::mmap_read_block(void)
+{
+    if ((options.get() & uint16_t(Options::DisableMmap)) != 0) {
+        return false;
+    }
+    struct mmap_file *mfile = mmap_find_file(disk_block.block);
+    if (mfile == nullptr || mfile->state == MmapState::Failed) {
+        return false;
+    }
+
+    const int32_t lat = disk_block.block.lat;
+    const int32_t lon = disk_block.block.lon;
+    const uint32_t blocknum = east_blocks(disk_block.block) * disk_block.block.grid_idx_x + disk_block.block.grid_idx_y;
+    const size_t file_offset = blocknum * sizeof(union grid_io_block);
+
+    if (mfile->state == MmapState::Mapped &&
+        file_offset + sizeof(struct grid_block) > mfile->length) {
+        // the file may have grown through our own writes since we
+        // mapped it
+        mmap_file_close(*mfile);
+        mmap_file_open(*mfile, disk_block.block);
+        if (mfile->state == MmapState::Failed) {
+            return false;
+        }
+    }
+
+    if (mfile->state == MmapState::Mapped &&
+        file_offset + sizeof(struct grid_block) <= mfile->length) {
+        memcpy(&disk_block.block, &mfile->data[file_offset], sizeof(struct grid_block));
+    }
+    if (mfile->state != MmapState::Mapped ||
+        file_offset + sizeof(struct grid_block) > mfile->length ||
+        !check_block(disk_block.block, lat, lon)) {
+        // a block not in the file is not an error, just a missing
+        // block which we will request from the GCS
+        memset(&disk_block, 0, sizeof(disk_block));
+        disk_block.block.lat = lat;
+        disk_block.block.lon = lon;
+        disk_block.block.bitmap = 0;
+    }
+    disk_io_state = DiskIoDoneRead;
+    return true;
+}
+
+/*
+  find or map the degree file holding a block. Missing and failed
+  files keep their slot until the retry time so we don't reopen them
+  on every read
+ */
+AP_Terrain::mmap_file *AP_Terrain::mmap_find_file(const struct grid_block &block)
+{
+    const uint32_t now_ms = AP_HAL::millis();
+    struct mmap_file *oldest = &mmap_files[0];
+    for (auto &mfile : mmap_files) {
+        if (mfile.state != MmapState::Unused &&
+            mfile.lat_degrees == block.lat_degrees &&
+            mfile.lon_degrees == block.lon_degrees) {
+            if (mfile.state != MmapState::Mapped &&
+                now_ms - mfile.opened_ms > TERRAIN_MMAP_RETRY_MS) {
+                mmap_file_close(mfile);
+                mmap_file_open(mfile, block);
+            }
+            mfile.last_access_ms = now_ms;
+            return &mfile;
+        }
+        if (mfile.state == MmapState::Unused) {
+            oldest = &mfile;
+        } else if (oldest->state != MmapState::Unused &&
+                   now_ms - mfile.last_access_ms > now_ms - oldest->last_access_ms) {
+            oldest = &mfile;
+        }
+    }
+
+    mmap_file_close(*oldest);
+    mmap_file_open(*oldest, block);
+    return oldest;
+}
+
+/*
+  forget a missing or short mapping after we have written a block to
+  its file, so the next read maps the new data
+ */
+void AP_Terrain::mmap_file_written(struct grid_block &block)
+{
+    for (auto &mfile : mmap_files) {
+        if (mfile.state != MmapState::Unused &&
+            mfile.lat_degrees == block.lat_degrees &&
+            mfile.lon_degrees == block.lon_degrees) {
+            const uint32_t blocknum = east_blocks(block) * block.grid_idx_x + block.grid_idx_y;
+            const size_t file_offset = blocknum * sizeof(union grid_io_block);
+            if (mfile.state != MmapState::Mapped ||
+                file_offset + sizeof(struct grid_block) > mfile.length) {
+                mmap_file_close(mfile);
+            }
+        }
+    }
+}
+
+/*
+  map the degree file for a block read-only
+ */
+void AP_Terrain::mmap_file_open(struct mmap_file &mfile, const struct grid_block &block)
+{
+    const char *terrain_dir = hal.util->get_custom_terrain_directory();
+    if (terrain_dir == nullptr) {
+        terrain_dir = HAL_BOARD_TERRAIN_DIRECTORY;
+    }
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+    // match the posix filesystem, which keeps SITL paths relative to
+    // the current directory
+    if (*terrain_dir == '/') {
+        terrain_dir++;
+    }
+#endif
+
+    uint32_t lat_tmp = MIN(uint32_t(abs((int32_t)block.lat_degrees)), 99U);
+    uint32_t lon_tmp = MIN(uint32_t(abs((int32_t)block.lon_degrees)), 999U);
+    char path[128];
+    hal.util->snprintf(path, sizeof(path), "%s/%c%02u%c%03u.DAT",
+                       terrain_dir,
+                       block.lat_degrees<0?'S':'N',
+                       (unsigned)lat_tmp,
+                       block.lon_degrees<0?'W':'E',
+                       (unsigned)lon_tmp);
+
+    mfile.lat_degrees = block.lat_degrees;
+    mfile.lon_degrees = block.lon_degrees;
+    mfile.opened_ms = AP_HAL::millis();
+    mfile.last_access_ms = mfile.opened_ms;
+    mfile.data = nullptr;
+    mfile.length = 0;
+
+    const int mfd = ::open(path, O_RDONLY|O_CLOEXEC);
+    if (mfd == -1) {
+        // no file yet is not a failure, all blocks are missing
+        mfile.state = errno == ENOENT ? MmapState::Missing : MmapState::Failed;
+        return;
+    }
+    struct stat st;
+    if (fstat(mfd, &st) != 0) {
+        ::close(mfd);
+        mfile.state = MmapState::Failed;
+        return;
+    }
+    if (st.st_size == 0) {
+        ::close(mfd);
+        mfile.state = MmapState::Missing;
+        return;
+    }
+    void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, mfd, 0);
+    ::close(mfd);
+    if (p == MAP_FAILED) {
+        mfile.state = MmapState::Failed;
+        return;
+    }
+    // we walk the file along the flight path, so ask for readahead
+    madvise(p, st.st_size, MADV_WILLNEED);
+
+    mfile.data = (uint8_t *)p;
+    mfile.length = st.st_size;
+    mfile.state = MmapState::Mapped;
+}
+
+/*
+  unmap a degree file
+ */
+void AP_Terrain::mmap_file_close(struct mmap_file &mfile)
+{
+    if (mfile.data != nullptr) {
+        munmap(mfile.data, mfile.length);
+        mfile.data = nullptr;
+    }
+    mfile.length = 0;
+    mfile.state = MmapState::Unused;
+}
+
+#endif // AP_TERRAIN_MMAP_ENABLED
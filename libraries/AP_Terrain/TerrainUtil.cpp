@@ -106,23 +106,24 @@ void AP_Terrain::calculate_grid_info(const Location &loc, struct grid_info &info
  */
 AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info)
 {
-    uint16_t oldest_i = 0;
+    const uint16_t bucket = grid_hash(info);
 
     // see if we have that grid
-    for (uint16_t i=0; i<cache_size; i++) {
-        if (TERRAIN_LATLON_EQUAL(cache[i].grid.lat,info.grid_lat) &&
-            TERRAIN_LATLON_EQUAL(cache[i].grid.lon,info.grid_lon) &&
-            cache[i].grid.spacing == grid_spacing) {
-            cache[i].last_access_ms = AP_HAL::millis();
-            return cache[i];
-        }
-        if (cache[i].last_access_ms < cache[oldest_i].last_access_ms) {
-            oldest_i = i;
+    for (uint16_t i=cache_hash[bucket]; i != 0; i=cache[i-1].hash_next) {
+        struct grid_cache &grid = cache[i-1];
+        if (TERRAIN_LATLON_EQUAL(grid.grid.lat,info.grid_lat) &&
+            TERRAIN_LATLON_EQUAL(grid.grid.lon,info.grid_lon) &&
+            grid.grid.spacing == grid_spacing) {
+            grid.last_access_ms = AP_HAL::millis();
+            return grid;
         }
     }
 
-    // Not found. Use the oldest grid and make it this grid,
-    // initially unpopulated
+    // Not found. Use the least recently used grid and make it this
+    // grid, initially unpopulated
+    const uint16_t oldest_i = find_lru_idx();
+    hash_remove(oldest_i);
+
     struct grid_cache &grid = cache[oldest_i];
     memset(&grid, 0, sizeof(grid));
 
@@ -139,9 +140,84 @@ AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info
     // mark as waiting for disk read
     grid.state = GRID_CACHE_DISKWAIT;
 
+    hash_insert(oldest_i, bucket);
+
     return grid;
 }
 
+/*
+  calculate the hash bucket for a grid block. The key is the integer
+  block position, which is exact, unlike the block corner lat/lon
+  which may differ by up to the acceptance margin
+ */
+uint16_t AP_Terrain::grid_hash(const struct grid_info &info) const
+{
+    uint32_t h = uint32_t(int32_t(info.lat_degrees)) * 73856093U;
+    h ^= uint32_t(int32_t(info.lon_degrees)) * 19349663U;
+    h ^= uint32_t(info.grid_idx_x) * 83492791U;
+    h ^= uint32_t(info.grid_idx_y) * 2654435761U;
+    h ^= uint32_t(uint16_t(grid_spacing.get()));
+    h ^= h >> 16;
+    return h & (cache_hash_size - 1);
+}
+
+/*
+  link a cache block into a hash bucket
+ */
+void AP_Terrain::hash_insert(uint16_t idx, uint16_t bucket)
+{
+    cache[idx].hash_bucket = bucket;
+    cache[idx].hash_next = cache_hash[bucket];
+    cache_hash[bucket] = idx+1;
+}
+
+/*
+  unlink a cache block from its hash bucket. Blocks that have never
+  been used are not linked into any bucket
+ */
+void AP_Terrain::hash_remove(uint16_t idx)
+{
+    if (cache[idx].state == GRID_CACHE_INVALID) {
+        return;
+    }
+    uint16_t *link = &cache_hash[cache[idx].hash_bucket];
+    while (*link != 0) {
+        if (*link == idx+1) {
+            *link = cache[idx].hash_next;
+            break;
+        }
+        link = &cache[(*link)-1].hash_next;
+    }
+    cache[idx].hash_next = 0;
+}
+
+/*
+  find the cache block to replace. Unused blocks are taken first,
+  then the least recently used block that has no pending disk
+  write. A dirty block is only replaced if every block is dirty
+ */
+uint16_t AP_Terrain::find_lru_idx(void) const
+{
+    int16_t oldest_clean = -1;
+    uint16_t oldest = 0;
+    const uint32_t now_ms = AP_HAL::millis();
+    for (uint16_t i=0; i<cache_size; i++) {
+        const struct grid_cache &grid = cache[i];
+        if (grid.state == GRID_CACHE_INVALID) {
+            return i;
+        }
+        const uint32_t age_ms = now_ms - grid.last_access_ms;
+        if (age_ms > now_ms - cache[oldest].last_access_ms) {
+            oldest = i;
+        }
+        if (grid.state != GRID_CACHE_DIRTY &&
+            (oldest_clean == -1 || age_ms > now_ms - cache[oldest_clean].last_access_ms)) {
+            oldest_clean = i;
+        }
+    }
+    return oldest_clean != -1 ? oldest_clean : oldest;
+}
+
 /*
   find cache index of disk_block
  */
@@ -177,4 +253,18 @@ uint16_t AP_Terrain::get_block_crc(struct grid_block &block)
     return ret;
 }
 
+/*
+  check that a block read from disk is the block we asked for and
+  is intact
+ */
+bool AP_Terrain::check_block(struct grid_block &block, int32_t lat, int32_t lon)
+{
+    return TERRAIN_LATLON_EQUAL(block.lat,lat) &&
+        TERRAIN_LATLON_EQUAL(block.lon,lon) &&
+        block.bitmap != 0 &&
+        block.spacing == grid_spacing &&
+        block.version == TERRAIN_GRID_FORMAT_VERSION &&
+        block.crc == get_block_crc(block);
+}
+
 #endif // AP_TERRAIN_AVAILABLE
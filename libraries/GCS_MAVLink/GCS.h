@@ -826,6 +826,36 @@ private:
     // number of extra ms to add to slow things down for the radio
     uint16_t         stream_slowdown_ms;
 
+    // stream output budget, enabled per port with the
+    // OPTION_MAVLINK_STREAM_BUDGET serial option on ports with a real
+    // baud limit. Stream (bucket) messages are limited to an estimate
+    // of the link's throughput by a token bucket, so that they can't
+    // fill the UART and radio buffers ahead of the specially handled
+    // and pushed messages, which don't use the budget. The estimate
+    // is decreased when the link shows congestion, replacing the
+    // RADIO_STATUS stream_slowdown_ms backoff, and probed upwards
+    // while streams are held back. Stream intervals are stretched
+    // while the streams want more than the budget allows
+    struct {
+        bool enabled;
+        float link_rate;            // estimated link throughput in bytes/s, zero until initialised
+        float tokens;               // bytes streams may send now
+        uint32_t last_refill_us;
+        uint32_t last_adjust_ms;
+        uint16_t slowdown_pct;      // percentage added to stream intervals
+        uint16_t blocked_count;     // stream sends held back since last adjustment
+        uint16_t last_out_of_space_count;
+        uint32_t bytes_sent;        // stream bytes sent since last adjustment
+        bool radio_congested;       // RADIO_STATUS reported low buffer space since last adjustment
+    } stream_budget;
+
+    // refill the stream budget and adjust the link estimate
+    void update_stream_budget(uint32_t now_us);
+    // true if there is budget for a stream message
+    bool stream_budget_available() const { return !stream_budget.enabled || stream_budget.tokens > 0; }
+    // record bytes sent by a stream message
+    void stream_budget_consume(uint16_t bytes);
+
     // outbound ("deferred message") queue.
 
     // "special" messages such as heartbeat, next_param etc are stored
@@ -855,6 +885,7 @@ private:
         Bitmask<MSG_LAST> ap_message_ids;
         uint16_t interval_ms;
         uint16_t last_sent_ms; // from AP_HAL::millis16()
+        uint16_t send_count;   // times sent since stats were last logged
     };
     deferred_message_bucket_t deferred_message_bucket[10];
     static const uint8_t no_bucket_to_send = -1;
@@ -1112,6 +1143,7 @@ private:
 #endif
 
     uint32_t last_mavlink_stats_logged;
+    uint32_t last_bucket_stats_ms;
 
     uint8_t last_battery_status_idx;
 
@@ -114,6 +114,14 @@ extern AP_IOMCU iomcu;
 
 extern const AP_HAL::HAL& hal;
 
+// limits of the link throughput estimate used for the stream budget, in bytes/s
+#define GCS_STREAM_BUDGET_MIN_RATE 100
+#define GCS_STREAM_BUDGET_MAX_RATE 1000000
+// links at or above this rate, such as USB and network links, are not budgeted
+#define GCS_STREAM_BUDGET_UNLIMITED_RATE 100000
+// most the stream budget will stretch stream intervals by, in percent
+#define GCS_STREAM_BUDGET_MAX_SLOWDOWN_PCT 700
+
 struct GCS_MAVLINK::LastRadioStatus GCS_MAVLINK::last_radio_status;
 uint8_t GCS_MAVLINK::mavlink_active = 0;
 uint8_t GCS_MAVLINK::chan_is_streaming = 0;
@@ -863,24 +871,33 @@ void GCS_MAVLINK::handle_radio_status(const mavlink_message_t &msg)
 
     last_radio_status.txbuf = packet.txbuf;
 
-    // use the state of the transmit buffer in the radio to
-    // control the stream rate, giving us adaptive software
-    // flow control
-    if (packet.txbuf < 20 && stream_slowdown_ms < 2000) {
-        // we are very low on space - slow down a lot
-        stream_slowdown_ms += 60;
-    } else if (packet.txbuf < 50 && stream_slowdown_ms < 2000) {
-        // we are a bit low on space, slow down slightly
-        stream_slowdown_ms += 20;
-    } else if (packet.txbuf > 95 && stream_slowdown_ms > 200) {
-        // the buffer has plenty of space, speed up a lot
-        stream_slowdown_ms -= 40;
-    } else if (packet.txbuf > 90 && stream_slowdown_ms != 0) {
-        // the buffer has enough space, speed up a bit
-        if (stream_slowdown_ms > 20) {
-            stream_slowdown_ms -= 20;
-        } else {
-            stream_slowdown_ms = 0;
+    if (stream_budget.enabled) {
+        // the stream budget is the only response to the radio not
+        // keeping up with what we send it
+        if (packet.txbuf < 50) {
+            stream_budget.radio_congested = true;
+        }
+        stream_slowdown_ms = 0;
+    } else {
+        // use the state of the transmit buffer in the radio to
+        // control the stream rate, giving us adaptive software
+        // flow control
+        if (packet.txbuf < 20 && stream_slowdown_ms < 2000) {
+            // we are very low on space - slow down a lot
+            stream_slowdown_ms += 60;
+        } else if (packet.txbuf < 50 && stream_slowdown_ms < 2000) {
+            // we are a bit low on space, slow down slightly
+            stream_slowdown_ms += 20;
+        } else if (packet.txbuf > 95 && stream_slowdown_ms > 200) {
+            // the buffer has plenty of space, speed up a lot
+            stream_slowdown_ms -= 40;
+        } else if (packet.txbuf > 90 && stream_slowdown_ms != 0) {
+            // the buffer has enough space, speed up a bit
+            if (stream_slowdown_ms > 20) {
+                stream_slowdown_ms -= 20;
+            } else {
+                stream_slowdown_ms = 0;
+            }
         }
     }
 
@@ -1176,6 +1193,9 @@ uint16_t GCS_MAVLINK::get_reschedule_interval_ms(const deferred_message_bucket_t
 
     interval_ms += stream_slowdown_ms;
 
+    // stretch streams the link budget can't carry
+    interval_ms += interval_ms * stream_budget.slowdown_pct / 100;
+
     // slow most messages down if we're transfering parameters or
     // waypoints:
     if (_queued_parameter) {
@@ -1211,6 +1231,7 @@ void GCS_MAVLINK::find_next_bucket_to_send(uint16_t now16_ms)
     // all done sending this bucket... find another bucket...
     sending_bucket_id = no_bucket_to_send;
     uint16_t ms_before_send_next_bucket_to_send = UINT16_MAX;
+    uint16_t next_bucket_interval = UINT16_MAX;
     for (uint8_t i=0; i<ARRAY_SIZE(deferred_message_bucket); i++) {
         if (deferred_message_bucket[i].ap_message_ids.count() == 0) {
             // no entries
@@ -1225,9 +1246,14 @@ void GCS_MAVLINK::find_next_bucket_to_send(uint16_t now16_ms)
         } else {
             ms_before_send_this_bucket = interval - ms_since_last_sent;
         }
-        if (ms_before_send_this_bucket < ms_before_send_next_bucket_to_send) {
+        // when several buckets are due, as happens when the link is
+        // saturated, the fastest streams go first
+        if (ms_before_send_this_bucket < ms_before_send_next_bucket_to_send ||
+            (ms_before_send_this_bucket == ms_before_send_next_bucket_to_send &&
+             interval < next_bucket_interval)) {
             sending_bucket_id = i;
             ms_before_send_next_bucket_to_send = ms_before_send_this_bucket;
+            next_bucket_interval = interval;
         }
     }
     if (sending_bucket_id != no_bucket_to_send) {
@@ -1503,6 +1529,8 @@ void GCS_MAVLINK::update_send()
     // check for any in-progress tasks; check_tasks does its own rate-limiting
     GCS_MAVLINK_InProgress::check_tasks();
 
+    update_stream_budget(AP_HAL::micros());
+
     const uint32_t start = AP_HAL::millis();
     const uint16_t start16 = start & 0xFFFF;
     while (AP_HAL::millis() - start < 5) { // spend a max of 5ms sending messages.  This should never trigger - out_of_time() should become true
@@ -1567,9 +1595,16 @@ void GCS_MAVLINK::update_send()
 
         ap_message next = next_deferred_bucket_message_to_send(start16);
         if (next != no_message_to_send) {
+            if (!stream_budget_available()) {
+                // leave the link for higher priority messages
+                stream_budget.blocked_count++;
+                break;
+            }
+            const uint16_t space_before = txspace();
             if (!do_try_send_message(next)) {
                 break;
             }
+            stream_budget_consume(space_before - MIN(space_before, txspace()));
             bucket_message_ids_to_send.clear(next);
             if (bucket_message_ids_to_send.count() == 0) {
                 // we sent everything in the bucket.  Reschedule it.
@@ -1581,6 +1616,7 @@ void GCS_MAVLINK::update_send()
                 if (uint16_t(start16 - deferred_message_bucket[sending_bucket_id].last_sent_ms) > interval_ms) {
                     deferred_message_bucket[sending_bucket_id].last_sent_ms = start16;
                 }
+                deferred_message_bucket[sending_bucket_id].send_count++;
                 find_next_bucket_to_send(start16);
             }
 #if GCS_DEBUG_SEND_MESSAGE_TIMINGS
@@ -1611,6 +1647,96 @@ void GCS_MAVLINK::update_send()
     last_tx_seq = _channel_status.current_tx_seq;
 }
 
+/*
+  refill the stream budget for the time since the last refill, and
+  once a second adjust the estimate of the link throughput and the
+  stream slowdown
+ */
+void GCS_MAVLINK::update_stream_budget(uint32_t now_us)
+{
+    // links without a real baud limit, such as USB, SITL and network
+    // links, are never budgeted
+    const float line_rate = _port->bw_in_bytes_per_second();
+    const bool enabled = uartstate != nullptr &&
+        uartstate->option_enabled(AP_HAL::UARTDriver::OPTION_MAVLINK_STREAM_BUDGET) &&
+        line_rate < GCS_STREAM_BUDGET_UNLIMITED_RATE;
+
+    auto &budget = stream_budget;
+    if (!enabled) {
+        if (budget.enabled) {
+            budget = {};
+        }
+        return;
+    }
+    if (!budget.enabled) {
+        budget.enabled = true;
+        budget.link_rate = constrain_float(line_rate, GCS_STREAM_BUDGET_MIN_RATE, GCS_STREAM_BUDGET_MAX_RATE);
+        budget.tokens = MAVLINK_MAX_PACKET_LEN;
+        budget.last_refill_us = now_us;
+        budget.last_adjust_ms = AP_HAL::millis();
+        budget.last_out_of_space_count = out_of_space_to_send_count;
+        return;
+    }
+
+    // allow bursts of 100ms worth of data, and at least one message
+    const float burst = MAX(budget.link_rate * 0.1f, float(MAVLINK_MAX_PACKET_LEN));
+    const float dt = (now_us - budget.last_refill_us) * 1.0e-6f;
+    budget.last_refill_us = now_us;
+    budget.tokens = MIN(budget.tokens + budget.link_rate * dt, burst);
+
+    const uint32_t now_ms = AP_HAL::millis();
+    const uint32_t period_ms = now_ms - budget.last_adjust_ms;
+    if (period_ms < 1000) {
+        return;
+    }
+    budget.last_adjust_ms = now_ms;
+
+    // the link is congested if messages have not fitted in the UART
+    // or the radio says its buffer is filling.  Lowering the estimate
+    // is the only response to congestion
+    const bool congested = budget.radio_congested ||
+        out_of_space_to_send_count != budget.last_out_of_space_count;
+    budget.last_out_of_space_count = out_of_space_to_send_count;
+
+    if (congested) {
+        budget.link_rate *= 0.75f;
+    } else if (budget.blocked_count > 0) {
+        // streams want more than we are giving them; probe upwards,
+        // quickly while below the line rate of the port
+        if (budget.link_rate < line_rate) {
+            budget.link_rate = MIN(budget.link_rate * 1.5f, line_rate);
+        } else {
+            budget.link_rate += MAX(budget.link_rate * 0.1f, 100.0f);
+        }
+    }
+    budget.link_rate = constrain_float(budget.link_rate, GCS_STREAM_BUDGET_MIN_RATE, GCS_STREAM_BUDGET_MAX_RATE);
+
+    // stretch the streams while they don't fit in the budget, and
+    // bring them back once there is spare budget
+    const uint32_t scale = 100 + budget.slowdown_pct;
+    if (budget.blocked_count > 0) {
+        budget.slowdown_pct = MIN(scale * 5 / 4 - 100, uint32_t(GCS_STREAM_BUDGET_MAX_SLOWDOWN_PCT));
+    } else if (budget.bytes_sent < budget.link_rate * period_ms * 0.001f * 0.75f) {
+        budget.slowdown_pct = scale * 9 / 10 - MIN(scale * 9 / 10, 100U);
+    }
+
+    budget.blocked_count = 0;
+    budget.bytes_sent = 0;
+    budget.radio_congested = false;
+}
+
+/*
+  record bytes sent by a stream message
+ */
+void GCS_MAVLINK::stream_budget_consume(uint16_t bytes)
+{
+    if (!stream_budget.enabled) {
+        return;
+    }
+    stream_budget.tokens -= bytes;
+    stream_budget.bytes_sent += bytes;
+}
+
 void GCS_MAVLINK::remove_message_from_bucket(int8_t bucket, ap_message id)
 {
     deferred_message_bucket[bucket].ap_message_ids.clear(id);
@@ -1618,6 +1744,7 @@ void GCS_MAVLINK::remove_message_from_bucket(int8_t bucket, ap_message id)
         // bucket empty.  Free it:
         deferred_message_bucket[bucket].interval_ms = 0;
         deferred_message_bucket[bucket].last_sent_ms = 0;
+        deferred_message_bucket[bucket].send_count = 0;
     }
 
     if (bucket == sending_bucket_id) {
@@ -2013,6 +2140,30 @@ void GCS_MAVLINK::log_mavlink_stats()
     };
 
     AP::logger().WriteBlock(&pkt, sizeof(pkt));
+
+    // achieved rates of the streams
+    const uint32_t now_ms = AP_HAL::millis();
+    const uint32_t period_ms = now_ms - last_bucket_stats_ms;
+    last_bucket_stats_ms = now_ms;
+    for (uint8_t i=0; i<ARRAY_SIZE(deferred_message_bucket); i++) {
+        deferred_message_bucket_t &bucket = deferred_message_bucket[i];
+        if (bucket.ap_message_ids.count() == 0) {
+            continue;
+        }
+        const struct log_MAVB bpkt{
+            LOG_PACKET_HEADER_INIT(LOG_MAVB_MSG),
+            time_us     : AP_HAL::micros64(),
+            chan        : (uint8_t)chan,
+            bucket      : i,
+            num_msgs    : (uint8_t)bucket.ap_message_ids.count(),
+            interval_ms : bucket.interval_ms,
+            sched_ms    : get_reschedule_interval_ms(bucket),
+            rate        : (period_ms > 0) ? bucket.send_count * 1000.0f / period_ms : 0,
+            link_rate   : stream_budget.link_rate,
+        };
+        AP::logger().WriteBlock(&bpkt, sizeof(bpkt));
+        bucket.send_count = 0;
+    }
 }
 #endif
 
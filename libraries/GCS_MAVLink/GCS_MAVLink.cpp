@@ -76,6 +76,15 @@ bool gcs_alternative_active[MAVLINK_COMM_NUM_BUFFERS];
 static HAL_Semaphore chan_locks[MAVLINK_COMM_NUM_BUFFERS];
 static bool chan_discard[MAVLINK_COMM_NUM_BUFFERS];
 
+// space reserved in the port's write buffer for the message being
+// sent while the channel is locked, so the message's parts are
+// copied straight into the write buffer and committed together
+static struct {
+    ByteBuffer::IoVec vec[2];
+    uint8_t n_vec;      // number of parts of vec in use, zero if nothing is reserved
+    uint16_t ofs;       // bytes written into the reserved space so far
+} chan_reserved[MAVLINK_COMM_NUM_BUFFERS];
+
 mavlink_system_t mavlink_system = {7,1};
 
 // routing table
@@ -128,22 +137,57 @@ uint16_t comm_get_txspace(mavlink_channel_t chan)
 }
 
 /*
-  send a buffer out a MAVLink channel
+  return true if bytes may be sent on a MAVLink channel
  */
-void comm_send_buffer(mavlink_channel_t chan, const uint8_t *buf, uint8_t len)
+static bool comm_send_allowed(mavlink_channel_t chan)
 {
     if (!valid_channel(chan) || mavlink_comm_port[chan] == nullptr || chan_discard[chan]) {
-        return;
+        return false;
     }
 #if HAL_HIGH_LATENCY2_ENABLED
     // if it's a disabled high latency channel, don't send
     GCS_MAVLINK *link = gcs().chan(chan);
-    if (link->is_high_latency_link && !gcs().get_high_latency_status()) {
-        return;
+    if (link != nullptr && link->is_high_latency_link && !gcs().get_high_latency_status()) {
+        return false;
     }
 #endif
     if (gcs_alternative_active[chan]) {
         // an alternative protocol is active
+        return false;
+    }
+    return true;
+}
+
+/*
+  send a buffer out a MAVLink channel
+ */
+void comm_send_buffer(mavlink_channel_t chan, const uint8_t *buf, uint8_t len)
+{
+    if (!comm_send_allowed(chan)) {
+        return;
+    }
+    auto &reserved = chan_reserved[uint8_t(chan)];
+    if (reserved.n_vec != 0) {
+        // copy into the space reserved by comm_send_lock()
+        uint32_t ofs = reserved.ofs;
+        for (uint8_t i=0; i<reserved.n_vec && len > 0; i++) {
+            const auto &vec = reserved.vec[i];
+            if (ofs >= vec.len) {
+                ofs -= vec.len;
+                continue;
+            }
+            const uint32_t n = MIN(uint32_t(len), vec.len - ofs);
+            memcpy(&vec.data[ofs], buf, n);
+            reserved.ofs += n;
+            buf += n;
+            len -= n;
+            ofs = 0;
+        }
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+        if (len > 0) {
+            AP_HAL::panic("Short write on UART: %u bytes past reserved space", len);
+        }
+#endif
         return;
     }
     const size_t written = mavlink_comm_port[chan]->write(buf, len);
@@ -169,6 +213,15 @@ void comm_send_lock(mavlink_channel_t chan_m, uint16_t size)
     if (mavlink_comm_port[chan]->txspace() < size) {
         chan_discard[chan] = true;
         gcs_out_of_space_to_send(chan_m);
+        return;
+    }
+    // the whole message is sent while the channel is locked, so
+    // reserve space for it all now and commit it on unlock
+    auto &reserved = chan_reserved[chan];
+    reserved.ofs = 0;
+    reserved.n_vec = 0;
+    if (comm_send_allowed(chan_m)) {
+        reserved.n_vec = mavlink_comm_port[chan]->reserve_write(reserved.vec, size);
     }
 }
 
@@ -178,6 +231,11 @@ void comm_send_lock(mavlink_channel_t chan_m, uint16_t size)
 void comm_send_unlock(mavlink_channel_t chan_m)
 {
     const uint8_t chan = uint8_t(chan_m);
+    auto &reserved = chan_reserved[chan];
+    if (reserved.n_vec != 0) {
+        mavlink_comm_port[chan]->commit_write(reserved.ofs);
+        reserved.n_vec = 0;
+    }
     chan_discard[chan] = false;
     chan_locks[chan].give();
 }
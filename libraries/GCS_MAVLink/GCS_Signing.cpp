@@ -36,6 +36,8 @@ struct SigningKey {
     uint8_t secret_key[32];
 };
 
+static_assert(sizeof(SigningKey) <= STORAGE_KEYS_SIGNING_SIZE, "SigningKey overlaps scripting cache key");
+
 // shared signing_streams structure
 mavlink_signing_streams_t GCS_MAVLINK::signing_streams;
 
@@ -44,18 +46,18 @@ uint32_t GCS_MAVLINK::last_signing_save_ms;
 
 bool GCS_MAVLINK::signing_key_save(const struct SigningKey &key)
 {
-    if (_signing_storage.size() < sizeof(key)) {
+    if (_signing_storage.size() < STORAGE_KEYS_SIGNING_OFFSET + sizeof(key)) {
         return false;
     }
-    return _signing_storage.write_block(0, &key, sizeof(key));
+    return _signing_storage.write_block(STORAGE_KEYS_SIGNING_OFFSET, &key, sizeof(key));
 }
 
 bool GCS_MAVLINK::signing_key_load(struct SigningKey &key)
 {
-    if (_signing_storage.size() < sizeof(key)) {
+    if (_signing_storage.size() < STORAGE_KEYS_SIGNING_OFFSET + sizeof(key)) {
         return false;
     }
-    if (!_signing_storage.read_block(&key, 0, sizeof(key))) {
+    if (!_signing_storage.read_block(&key, STORAGE_KEYS_SIGNING_OFFSET, sizeof(key))) {
         return false;
     }
     if (key.magic != SIGNING_KEY_MAGIC) {
@@ -171,46 +171,52 @@ bool MAVLink_routing::check_and_forward(GCS_MAVLINK &in_link, const mavlink_mess
         return true;
     }
 
+    // find the channels matching the targets
+    uint8_t chan_mask;
+    if (broadcast_system) {
+        chan_mask = route_chan_mask;
+    } else if (broadcast_component || !match_system) {
+        chan_mask = system_chan_mask[target_system];
+    } else {
+        chan_mask = find_route_chan_mask(target_system, target_component);
+    }
+
+    // private channels only get messages for a sysid/compid seen on them
+    uint8_t exact_chan_mask = 0;
+    if (!broadcast_system && target_component >= 0) {
+        exact_chan_mask = find_route_chan_mask(target_system, target_component);
+    }
+    chan_mask &= ~GCS_MAVLINK::private_channel_mask() | exact_chan_mask;
+
+    // never send back on the incoming channel
+    chan_mask &= ~(1U<<(in_link.get_chan()-MAVLINK_COMM_0));
+
     // forward on any channels matching the targets
     bool forwarded = false;
-    bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS];
-    memset(sent_to_chan, 0, sizeof(sent_to_chan));
-    for (uint8_t i=0; i<num_routes; i++) {
-
-        // Skip if channel is private and the target system or component IDs do not match
-        GCS_MAVLINK *out_link = gcs().chan(routes[i].channel);
-        if (out_link == nullptr) {
-            // this is bad
+    uint8_t send_mask = 0;
+    for (uint8_t i=0; i<MAVLINK_COMM_NUM_BUFFERS; i++) {
+        if ((chan_mask & (1U<<i)) == 0) {
             continue;
         }
-        if (out_link->is_private() &&
-            (target_system != routes[i].sysid ||
-             target_component != routes[i].compid)) {
+        GCS_MAVLINK *out_link = gcs().chan(i);
+        if (out_link == nullptr) {
+            // this is bad
             continue;
         }
-
-        if (broadcast_system || (target_system == routes[i].sysid &&
-                                 (broadcast_component || 
-                                  target_component == routes[i].compid ||
-                                  !match_system))) {
-
-            if (&in_link != out_link && !sent_to_chan[routes[i].channel]) {
-                if (out_link->check_payload_size(msg.len)) {
+        if (out_link->check_payload_size(msg.len)) {
 #if ROUTING_DEBUG
-                    ::printf("fwd msg %u from chan %u on chan %u sysid=%d compid=%d\n",
-                             msg.msgid,
-                             (unsigned)in_link.get_chan(),
-                             (unsigned)routes[i].channel,
-                             (int)target_system,
-                             (int)target_component);
+            ::printf("fwd msg %u from chan %u on chan %u sysid=%d compid=%d\n",
+                     msg.msgid,
+                     (unsigned)in_link.get_chan(),
+                     (unsigned)i,
+                     (int)target_system,
+                     (int)target_component);
 #endif
-                    _mavlink_resend_uart(routes[i].channel, &msg);
-                }
-                sent_to_chan[routes[i].channel] = true;
-                forwarded = true;
-            }
+            send_mask |= 1U<<i;
         }
+        forwarded = true;
     }
+    send_to_channels(msg, send_mask);
 
     if ((!forwarded && match_system) ||
         broadcast_system) {
@@ -236,29 +242,24 @@ void MAVLink_routing::send_to_components(uint32_t msgid, const char *pkt, uint8_
 
 void MAVLink_routing::send_to_components(const char *pkt, const mavlink_msg_entry_t *entry, const uint8_t pkt_len)
 {
-    bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS] {};
+    // channels our system ID has been seen on
+    const uint8_t chan_mask = system_chan_mask[mavlink_system.sysid];
 
-    // check learned routes
-    for (uint8_t i=0; i<num_routes; i++) {
-        if (routes[i].sysid != mavlink_system.sysid) {
-            // our system ID hasn't been seen on this link
-            continue;
-        }
-        if (sent_to_chan[routes[i].channel]) {
-            // we've already send it on this link
+    for (uint8_t i=0; i<MAVLINK_COMM_NUM_BUFFERS; i++) {
+        if ((chan_mask & (1U<<i)) == 0) {
             continue;
         }
-        if (comm_get_txspace(routes[i].channel) <
-            ((uint16_t)entry->max_msg_len) + GCS_MAVLINK::packet_overhead_chan(routes[i].channel)) {
+        const mavlink_channel_t channel = (mavlink_channel_t)(MAVLINK_COMM_0 + i);
+        if (comm_get_txspace(channel) <
+            ((uint16_t)entry->max_msg_len) + GCS_MAVLINK::packet_overhead_chan(channel)) {
             // it doesn't fit on this channel
             continue;
         }
 #if ROUTING_DEBUG
-        ::printf("send msg %u on chan %u sysid=%u compid=%u\n",
+        ::printf("send msg %u on chan %u sysid=%u\n",
                  entry->msgid,
-                 (unsigned)routes[i].channel,
-                 (unsigned)routes[i].sysid,
-                 (unsigned)routes[i].compid);
+                 (unsigned)channel,
+                 (unsigned)mavlink_system.sysid);
 #endif
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
         if (entry->max_msg_len > pkt_len) {
@@ -266,13 +267,12 @@ void MAVLink_routing::send_to_components(const char *pkt, const mavlink_msg_entr
                           entry->max_msg_len, pkt_len);
         }
 #endif
-        _mav_finalize_message_chan_send(routes[i].channel,
+        _mav_finalize_message_chan_send(channel,
                                         entry->msgid,
                                         pkt,
                                         entry->min_msg_len,
                                         MIN(entry->max_msg_len, pkt_len),
                                         entry->crc_extra);
-        sent_to_chan[routes[i].channel] = true;
     }
 }
 
@@ -317,7 +317,6 @@ bool MAVLink_routing::find_by_mavtype_and_compid(uint8_t mavtype, uint8_t compid
 */
 void MAVLink_routing::learn_route(GCS_MAVLINK &in_link, const mavlink_message_t &msg)
 {
-    uint8_t i;
     if (msg.sysid == 0) {
         // don't learn routes to the broadcast system
         return;
@@ -335,33 +334,151 @@ void MAVLink_routing::learn_route(GCS_MAVLINK &in_link, const mavlink_message_t
         return;
     }
     const mavlink_channel_t in_channel = in_link.get_chan();
-    for (i=0; i<num_routes; i++) {
-        if (routes[i].sysid == msg.sysid &&
-            routes[i].compid == msg.compid &&
-            routes[i].channel == in_channel) {
-            if (routes[i].mavtype == 0 && msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-                routes[i].mavtype = mavlink_msg_heartbeat_get_type(&msg);
+    const uint8_t in_chan_bit = 1U<<(in_channel-MAVLINK_COMM_0);
+    route_hash_entry *slot = find_route_slot(msg.sysid, msg.compid);
+    if (slot != nullptr && (slot->chan_mask & in_chan_bit) != 0) {
+        // known route; only a heartbeat can tell us more about it
+        if (msg.msgid != MAVLINK_MSG_ID_HEARTBEAT) {
+            return;
+        }
+        for (uint8_t i=0; i<num_routes; i++) {
+            if (routes[i].sysid == msg.sysid &&
+                routes[i].compid == msg.compid &&
+                routes[i].channel == in_channel) {
+                if (routes[i].mavtype == 0) {
+                    routes[i].mavtype = mavlink_msg_heartbeat_get_type(&msg);
+                }
+                break;
             }
-            break;
         }
+        return;
     }
-    if (i == num_routes && i<MAVLINK_MAX_ROUTES) {
-        routes[i].sysid = msg.sysid;
-        routes[i].compid = msg.compid;
-        routes[i].channel = in_channel;
-        if (msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-            routes[i].mavtype = mavlink_msg_heartbeat_get_type(&msg);
-        }
-        num_routes++;
+    if (slot == nullptr || num_routes >= MAVLINK_MAX_ROUTES) {
+        return;
+    }
+    const uint8_t i = num_routes;
+    routes[i].sysid = msg.sysid;
+    routes[i].compid = msg.compid;
+    routes[i].channel = in_channel;
+    if (msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
+        routes[i].mavtype = mavlink_msg_heartbeat_get_type(&msg);
+    }
+    num_routes++;
+
+    slot->sysid = msg.sysid;
+    slot->compid = msg.compid;
+    slot->chan_mask |= in_chan_bit;
+    system_chan_mask[msg.sysid] |= in_chan_bit;
+    route_chan_mask |= in_chan_bit;
 #if ROUTING_DEBUG
-        ::printf("learned route %u %u via %u\n",
-                 (unsigned)msg.sysid,
-                 (unsigned)msg.compid,
-                 (unsigned)in_channel);
+    ::printf("learned route %u %u via %u\n",
+             (unsigned)msg.sysid,
+             (unsigned)msg.compid,
+             (unsigned)in_channel);
 #endif
+}
+
+/*
+  find the hash table slot for a sysid/compid, or the empty slot it
+  would go in. Returns nullptr if the table is full
+*/
+MAVLink_routing::route_hash_entry *MAVLink_routing::find_route_slot(uint8_t sysid, uint8_t compid)
+{
+    uint8_t idx = (sysid * 31U + compid) & (ROUTE_HASH_SIZE-1);
+    for (uint8_t n=0; n<ROUTE_HASH_SIZE; n++) {
+        route_hash_entry &e = route_hash[idx];
+        if (e.sysid == 0 || (e.sysid == sysid && e.compid == compid)) {
+            return &e;
+        }
+        idx = (idx + 1) & (ROUTE_HASH_SIZE-1);
+    }
+    return nullptr;
+}
+
+/*
+  return the channels a sysid/compid has been seen on
+*/
+uint8_t MAVLink_routing::find_route_chan_mask(uint8_t sysid, uint8_t compid) const
+{
+    if (sysid == 0) {
+        // routes to the broadcast system are never learned
+        return 0;
+    }
+    uint8_t idx = (sysid * 31U + compid) & (ROUTE_HASH_SIZE-1);
+    for (uint8_t n=0; n<ROUTE_HASH_SIZE; n++) {
+        const route_hash_entry &e = route_hash[idx];
+        if (e.sysid == 0) {
+            return 0;
+        }
+        if (e.sysid == sysid && e.compid == compid) {
+            return e.chan_mask;
+        }
+        idx = (idx + 1) & (ROUTE_HASH_SIZE-1);
     }
+    return 0;
 }
 
+/*
+  serialise a message exactly as it was received. Unlike
+  mavlink_msg_to_send_buffer() this never trims trailing zeros from a
+  MAVLink2 payload, as the checksum and any signature were computed
+  over msg.len bytes by the sender
+*/
+static uint16_t msg_to_forward_buffer(uint8_t *buf, const mavlink_message_t &msg)
+{
+    uint16_t n = 0;
+    buf[n++] = msg.magic;
+    buf[n++] = msg.len;
+    if (msg.magic == MAVLINK_STX_MAVLINK1) {
+        buf[n++] = msg.seq;
+        buf[n++] = msg.sysid;
+        buf[n++] = msg.compid;
+        buf[n++] = msg.msgid & 0xFF;
+    } else {
+        buf[n++] = msg.incompat_flags;
+        buf[n++] = msg.compat_flags;
+        buf[n++] = msg.seq;
+        buf[n++] = msg.sysid;
+        buf[n++] = msg.compid;
+        buf[n++] = msg.msgid & 0xFF;
+        buf[n++] = (msg.msgid >> 8) & 0xFF;
+        buf[n++] = (msg.msgid >> 16) & 0xFF;
+    }
+    memcpy(&buf[n], _MAV_PAYLOAD(&msg), msg.len);
+    n += msg.len;
+    buf[n++] = msg.checksum & 0xFF;
+    buf[n++] = msg.checksum >> 8;
+    if (msg.magic != MAVLINK_STX_MAVLINK1 && (msg.incompat_flags & MAVLINK_IFLAG_SIGNED)) {
+        memcpy(&buf[n], msg.signature, MAVLINK_SIGNATURE_BLOCK_LEN);
+        n += MAVLINK_SIGNATURE_BLOCK_LEN;
+    }
+    return n;
+}
+
+/*
+  send a message on all channels in chan_mask. The message is
+  serialised once and the same bytes written to each channel
+*/
+void MAVLink_routing::send_to_channels(const mavlink_message_t &msg, uint8_t chan_mask)
+{
+    if (chan_mask == 0) {
+        return;
+    }
+    uint8_t buf[MAVLINK_MAX_PACKET_LEN];
+    const uint16_t len = msg_to_forward_buffer(buf, msg);
+    for (uint8_t i=0; i<MAVLINK_COMM_NUM_BUFFERS; i++) {
+        if ((chan_mask & (1U<<i)) == 0) {
+            continue;
+        }
+        const mavlink_channel_t chan = (mavlink_channel_t)(MAVLINK_COMM_0 + i);
+        comm_send_lock(chan, len);
+        // comm_send_buffer() takes at most 255 bytes at a time
+        for (uint16_t ofs=0; ofs<len; ofs += UINT8_MAX) {
+            comm_send_buffer(chan, &buf[ofs], MIN(len - ofs, uint16_t(UINT8_MAX)));
+        }
+        comm_send_unlock(chan);
+    }
+}
 
 /*
   special handling for heartbeat messages. To ensure routing
@@ -382,18 +499,10 @@ void MAVLink_routing::handle_heartbeat(GCS_MAVLINK &link, const mavlink_message_
     mask &= ~no_route_mask;
     
     // mask out channels that are known sources for this sysid/compid
-    for (uint8_t i=0; i<num_routes; i++) {
-        if (routes[i].sysid == msg.sysid && routes[i].compid == msg.compid) {
-            mask &= ~(1U<<((unsigned)(routes[i].channel-MAVLINK_COMM_0)));
-        }
-    }
+    mask &= ~find_route_chan_mask(msg.sysid, msg.compid);
 
-    if (mask == 0) {
-        // nothing to send to
-        return;
-    }
-
-    // send on the remaining channels
+    // send on the remaining channels with space for the heartbeat
+    uint8_t send_mask = 0;
     for (uint8_t i=0; i<MAVLINK_COMM_NUM_BUFFERS; i++) {
         if (mask & (1U<<i)) {
             mavlink_channel_t channel = (mavlink_channel_t)(MAVLINK_COMM_0 + i);
@@ -406,13 +515,13 @@ void MAVLink_routing::handle_heartbeat(GCS_MAVLINK &link, const mavlink_message_
                          (unsigned)msg.sysid,
                          (unsigned)msg.compid);
 #endif
-                _mavlink_resend_uart(channel, &msg);
+                send_mask |= 1U<<i;
             }
         }
     }
+    send_to_channels(msg, send_mask);
 }
 
-
 /*
   extract target sysid and compid from a message. int16_t is used so
   that the caller can set them to -1 and know when a sysid or compid
@@ -50,8 +50,8 @@ public:
     bool find_by_mavtype_and_compid(uint8_t mavtype, uint8_t compid, uint8_t &sysid, mavlink_channel_t &channel) const;
 
 private:
-    // a simple linear routing table. We don't expect to have a lot of
-    // routes, so a scalable structure isn't worthwhile yet.
+    // a simple linear routing table, kept in the order routes were
+    // learned for the find_by_mavtype() searches
     uint8_t num_routes;
     struct route {
         uint8_t sysid;
@@ -59,7 +59,35 @@ private:
         mavlink_channel_t channel;
         uint8_t mavtype;
     } routes[MAVLINK_MAX_ROUTES];
-    
+
+    // the channels each sysid/compid has been seen on, in an open
+    // addressed hash table so that forwarding a message doesn't need
+    // to scan the routing table. Routes are never removed, so there
+    // are no deleted slots to handle
+    static const uint8_t ROUTE_HASH_SIZE = 32;  // power of two larger than MAVLINK_MAX_ROUTES
+    struct route_hash_entry {
+        uint8_t sysid;              // zero for an empty slot
+        uint8_t compid;
+        uint8_t chan_mask;
+    } route_hash[ROUTE_HASH_SIZE];
+
+    // the channels each sysid has been seen on, with any compid
+    uint8_t system_chan_mask[256];
+
+    // the channels any route has been learned on
+    uint8_t route_chan_mask;
+
+    // find the hash table slot for a sysid/compid, or the empty slot
+    // it would go in. Returns nullptr if the table is full
+    route_hash_entry *find_route_slot(uint8_t sysid, uint8_t compid);
+
+    // channels a sysid/compid has been seen on
+    uint8_t find_route_chan_mask(uint8_t sysid, uint8_t compid) const;
+
+    // send a message on all channels in chan_mask, serialising it
+    // only once. Channels without space for the message are skipped
+    void send_to_channels(const mavlink_message_t &msg, uint8_t chan_mask);
+
     // a channel mask to block routing as required
     uint8_t no_route_mask;
     
@@ -15,8 +15,21 @@ void MissionItemProtocol::init_send_requests(GCS_MAVLINK &_link,
     timelast_receive_ms = AP_HAL::millis();    // set time we last received commands to now
     receiving = true;              // record that we expect to receive commands
     request_i = _request_first;                 // reset the next expected command number to zero
+    request_next = _request_first;
     request_last = _request_last;         // record how many commands we expect to receive
 
+    // the buffer for out of order items is kept for later uploads
+    window_size = constrain_int16(upload_window(), 1, MAX_UPLOAD_WINDOW);
+    if (window_size > 1 && window_items_size < window_size) {
+        delete[] window_items;
+        window_items = NEW_NOTHROW mavlink_mission_item_int_t[window_size];
+        window_items_size = (window_items != nullptr) ? window_size : 0;
+    }
+    if (window_items_size < window_size) {
+        window_size = 1;
+    }
+    window_received = 0;
+
     dest_sysid = msg.sysid;       // record system id of GCS who wants to upload the mission
     dest_compid = msg.compid;     // record component id of GCS who wants to upload the mission
 
@@ -270,8 +283,11 @@ void MissionItemProtocol::handle_mission_item(const mavlink_message_t &msg, cons
         return;
     }
 
-    // check if this is the requested waypoint
-    if (cmd.seq != request_i) {
+    // check if this is the requested waypoint, or one of the items
+    // requested after it
+    if (cmd.seq < request_i ||
+        cmd.seq > request_last ||
+        uint32_t(cmd.seq) >= uint32_t(request_i) + window_size) {
         send_mission_ack(msg, MAV_MISSION_INVALID_SEQUENCE);
         return;
     }
@@ -285,6 +301,44 @@ void MissionItemProtocol::handle_mission_item(const mavlink_message_t &msg, cons
         return;
     }
 
+    if (cmd.seq != request_i) {
+        // hold the item until the items before it have arrived
+        const uint8_t slot = cmd.seq % window_size;
+        window_items[slot] = cmd;
+        window_received |= (1U<<slot);
+        timelast_receive_ms = AP_HAL::millis();
+        return;
+    }
+
+    if (!store_item(msg, cmd)) {
+        return;
+    }
+    // store any items following this one which arrived early
+    while (window_size > 1 && request_i <= request_last) {
+        const uint8_t slot = request_i % window_size;
+        if ((window_received & (1U<<slot)) == 0) {
+            break;
+        }
+        window_received &= ~(1U<<slot);
+        if (!store_item(msg, window_items[slot])) {
+            return;
+        }
+    }
+
+    if (request_i > request_last) {
+        transfer_is_complete(*link, msg);
+        return;
+    }
+    // if we have enough space, then send the next WP request immediately
+    if (HAVE_PAYLOAD_SPACE(link->get_chan(), MISSION_REQUEST)) {
+        queued_request_send();
+    } else {
+        link->send_message(next_item_ap_message_id());
+    }
+}
+
+bool MissionItemProtocol::store_item(const mavlink_message_t &msg, const mavlink_mission_item_int_t &cmd)
+{
     const uint16_t _item_count = item_count();
 
     MAV_MISSION_RESULT result;
@@ -303,23 +357,14 @@ void MissionItemProtocol::handle_mission_item(const mavlink_message_t &msg, cons
         receiving = false;
         link = nullptr;
         free_upload_resources();
-        return;
+        return false;
     }
 
     // update waypoint receiving state machine
     timelast_receive_ms = AP_HAL::millis();
     request_i++;
 
-    if (request_i > request_last) {
-        transfer_is_complete(*link, msg);
-        return;
-    }
-    // if we have enough space, then send the next WP request immediately
-    if (HAVE_PAYLOAD_SPACE(link->get_chan(), MISSION_REQUEST)) {
-        queued_request_send();
-    } else {
-        link->send_message(next_item_ap_message_id());
-    }
+    return true;
 }
 
 void MissionItemProtocol::transfer_is_complete(const GCS_MAVLINK &_link, const mavlink_message_t &msg)
@@ -368,14 +413,27 @@ void MissionItemProtocol::queued_request_send()
         INTERNAL_ERROR(AP_InternalError::error_t::gcs_bad_missionprotocol_link);
         return;
     }
-    CHECK_PAYLOAD_SIZE2_VOID(link->get_chan(), MISSION_REQUEST);
-    mavlink_msg_mission_request_send(
-        link->get_chan(),
-        dest_sysid,
-        dest_compid,
-        request_i,
-        mission_type());
-    timelast_request_ms = AP_HAL::millis();
+    // request every item in the window which hasn't been requested
+    // or received yet
+    if (request_next < request_i) {
+        request_next = request_i;
+    }
+    const uint16_t window_last = MIN(uint32_t(request_last), uint32_t(request_i) + window_size - 1);
+    while (request_next <= window_last) {
+        if ((window_received & (1U<<(request_next % window_size))) != 0) {
+            request_next++;
+            continue;
+        }
+        CHECK_PAYLOAD_SIZE2_VOID(link->get_chan(), MISSION_REQUEST);
+        mavlink_msg_mission_request_send(
+            link->get_chan(),
+            dest_sysid,
+            dest_compid,
+            request_next,
+            mission_type());
+        timelast_request_ms = AP_HAL::millis();
+        request_next++;
+    }
 }
 
 void MissionItemProtocol::update()
@@ -409,6 +467,8 @@ void MissionItemProtocol::update()
     const uint32_t wp_recv_timeout_ms = 1000U + link->get_stream_slowdown_ms();
     if (tnow - timelast_request_ms > wp_recv_timeout_ms) {
         timelast_request_ms = tnow;
+        // request the items still missing from the window again
+        request_next = request_i;
         link->send_message(next_item_ap_message_id());
     }
 }
@@ -21,6 +21,12 @@
 // Starting of uploads (for the same protocol) is also blocked -
 // essentially the GCS uploading a set of items (e.g. a mission) has a
 // mutex over the mission.
+//
+// Backends may request a window of several items ahead of the next
+// item to be stored, which hides the link latency on large uploads.
+// Items arriving ahead of the next item to be stored are held until
+// the items before them arrive, so items are always passed to the
+// backend in order.
 class MissionItemProtocol
 {
 public:
@@ -75,6 +81,11 @@ protected:
 
     virtual bool clear_all_items() = 0;
 
+    // number of items which may be requested ahead of the next item
+    // to be stored during an upload, at most MAX_UPLOAD_WINDOW
+    virtual uint8_t upload_window() const { return 1; }
+    static const uint8_t MAX_UPLOAD_WINDOW = 32;
+
     uint16_t        request_last; // last request index
 
 private:
@@ -86,6 +97,19 @@ private:
     virtual void truncate(const mavlink_mission_count_t &packet) = 0;
 
     uint16_t        request_i; // request index
+    uint16_t        request_next; // next index to send a request for
+
+    // items received ahead of request_i, indexed by seq modulo the
+    // window size
+    uint8_t         window_size;            // number of items requested ahead in the current upload
+    uint8_t         window_items_size;      // number of entries allocated in window_items
+    mavlink_mission_item_int_t *window_items;
+    uint32_t        window_received;        // bitmask of window_items entries holding a received item
+
+    // pass an item to the backend and advance request_i.  Returns
+    // false if the backend rejected the item, in which case the
+    // upload has been abandoned
+    bool store_item(const mavlink_message_t &msg, const mavlink_mission_item_int_t &cmd);
 
     // waypoints
     uint8_t         dest_sysid;  // where to send requests
@@ -44,6 +44,9 @@ MAV_MISSION_RESULT MissionItemProtocol_Waypoints::append_item(const mavlink_miss
         }
     }
 
+    if (batch != nullptr) {
+        return batch_cmd(cmd);
+    }
     if (!mission.add_cmd(cmd)) {
         return MAV_MISSION_ERROR;
     }
@@ -57,6 +60,9 @@ bool MissionItemProtocol_Waypoints::clear_all_items()
 
 MAV_MISSION_RESULT MissionItemProtocol_Waypoints::complete(const GCS_MAVLINK &_link)
 {
+    if (!flush_batch()) {
+        return MAV_MISSION_ERROR;
+    }
     _link.send_text(MAV_SEVERITY_INFO, "Flight plan received");
 #if HAL_LOGGING_ENABLED
     AP::logger().Write_EntireMission();
@@ -108,7 +114,9 @@ MAV_MISSION_RESULT MissionItemProtocol_Waypoints::get_item(const GCS_MAVLINK &_l
 }
 
 uint16_t MissionItemProtocol_Waypoints::item_count() const {
-    return mission.num_commands();
+    // batched commands past the end of the mission will be appended
+    // to it
+    return MAX(mission.num_commands(), uint16_t(batch_start + batch_count));
 }
 
 uint16_t MissionItemProtocol_Waypoints::max_items() const {
@@ -130,6 +138,9 @@ MAV_MISSION_RESULT MissionItemProtocol_Waypoints::replace_item(const mavlink_mis
             return MAV_MISSION_ERROR;
         }
     }
+    if (batch != nullptr) {
+        return batch_cmd(cmd);
+    }
     if (!mission.replace_cmd(cmd.index, cmd)) {
         return MAV_MISSION_ERROR;
     }
@@ -141,6 +152,78 @@ void MissionItemProtocol_Waypoints::timeout()
     link->send_text(MAV_SEVERITY_WARNING, "Mission upload timeout");
 }
 
+uint8_t MissionItemProtocol_Waypoints::upload_window() const
+{
+    return mission.pipelined_upload() ? PIPELINED_UPLOAD_WINDOW : 1;
+}
+
+MAV_MISSION_RESULT MissionItemProtocol_Waypoints::allocate_receive_resources(const uint16_t count)
+{
+    allocate_batch();
+    return MAV_MISSION_ACCEPTED;
+}
+
+MAV_MISSION_RESULT MissionItemProtocol_Waypoints::allocate_update_resources()
+{
+    allocate_batch();
+    return MAV_MISSION_ACCEPTED;
+}
+
+void MissionItemProtocol_Waypoints::allocate_batch()
+{
+    batch_count = 0;
+    batch_start = 0;
+    if (!mission.pipelined_upload() || batch != nullptr) {
+        return;
+    }
+    // if we can't get the memory the upload still works, one item
+    // at a time
+    batch = NEW_NOTHROW AP_Mission::Mission_Command[PIPELINED_UPLOAD_WINDOW];
+}
+
+void MissionItemProtocol_Waypoints::free_upload_resources()
+{
+    // items accepted before an upload is cancelled or times out are
+    // kept, as they are when each item is written on arrival. The
+    // upload's link may already have been released so tell all GCSs
+    // if they could not be stored
+    if (!flush_batch()) {
+        GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "Mission: failed to store received items");
+    }
+    delete[] batch;
+    batch = nullptr;
+}
+
+MAV_MISSION_RESULT MissionItemProtocol_Waypoints::batch_cmd(const AP_Mission::Mission_Command &cmd)
+{
+    if (batch_count > 0 && cmd.index != batch_start + batch_count) {
+        if (!flush_batch()) {
+            return MAV_MISSION_ERROR;
+        }
+    }
+    if (batch_count == 0) {
+        batch_start = cmd.index;
+    }
+    batch[batch_count++] = cmd;
+    if (batch_count >= PIPELINED_UPLOAD_WINDOW) {
+        if (!flush_batch()) {
+            return MAV_MISSION_ERROR;
+        }
+    }
+    return MAV_MISSION_ACCEPTED;
+}
+
+bool MissionItemProtocol_Waypoints::flush_batch()
+{
+    if (batch_count == 0) {
+        return true;
+    }
+    const bool ret = mission.write_cmds(batch_start, batch, batch_count);
+    batch_count = 0;
+    batch_start = 0;
+    return ret;
+}
+
 void MissionItemProtocol_Waypoints::truncate(const mavlink_mission_count_t &packet)
 {
     // new mission arriving, truncate mission to be the same length
@@ -2,6 +2,8 @@
 
 #include "MissionItemProtocol.h"
 
+#include <AP_Mission/AP_Mission.h>
+
 class MissionItemProtocol_Waypoints : public MissionItemProtocol {
 public:
     MissionItemProtocol_Waypoints(class AP_Mission &_mission) :
@@ -38,6 +40,10 @@ protected:
         return MSG_NEXT_MISSION_REQUEST_WAYPOINTS;
     }
 
+    // upload_window() returns the number of items requested ahead
+    // during an upload
+    uint8_t upload_window() const override;
+
 private:
     AP_Mission &mission;
 
@@ -64,5 +70,30 @@ private:
     // replace_item() replaces an item in the stored list
     MAV_MISSION_RESULT replace_item(const mavlink_mission_item_int_t &) override WARN_IF_UNUSED;
 
+    // with the PIPELINED_UPLOAD mission option set, items are
+    // requested this many at a time and written to the mission in
+    // batches of this size
+    static const uint8_t PIPELINED_UPLOAD_WINDOW = 16;
+
+    // commands received but not yet written to the mission.  batch
+    // is only allocated during pipelined uploads
+    AP_Mission::Mission_Command *batch;
+    uint16_t batch_start;   // mission index of the first command in batch
+    uint8_t batch_count;    // number of commands in batch
+
+    MAV_MISSION_RESULT allocate_receive_resources(const uint16_t count) override WARN_IF_UNUSED;
+    MAV_MISSION_RESULT allocate_update_resources() override WARN_IF_UNUSED;
+    void free_upload_resources() override;
+
+    // allocate the batch if uploads are pipelined.  Uploads without a
+    // batch write each item as it arrives
+    void allocate_batch();
+
+    // add a command to the batch, writing the batch to the mission
+    // once full
+    MAV_MISSION_RESULT batch_cmd(const AP_Mission::Mission_Command &cmd) WARN_IF_UNUSED;
+
+    // write the batched commands to the mission
+    bool flush_batch() WARN_IF_UNUSED;
 };
 
@@ -0,0 +1,121 @@
+#include <AP_gbenchmark.h>
+
+#include <GCS_MAVLink/GCS_Dummy.h>
+#include <GCS_MAVLink/GCS_MAVLink.h>
+
+#include "benchmark_uart.h"
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+const AP_Param::GroupInfo GCS_MAVLINK_Parameters::var_info[] = {
+    AP_GROUPEND
+};
+
+/*
+  messages per second through the MAVLink router for a vehicle with
+  a GCS on channel 0 and components spread across the other
+  channels. Each round the GCS sends a PARAM_SET to every component,
+  which is forwarded on one channel, and every component sends an
+  ATTITUDE, which is broadcast on all other channels
+ */
+
+class BenchLink : public GCS_MAVLINK_Dummy {
+public:
+    BenchLink(GCS_MAVLINK_Parameters &params, AP_HAL::UARTDriver &uart, mavlink_channel_t _chan) :
+        GCS_MAVLINK_Dummy(params, uart) {
+        chan = _chan;
+    }
+};
+
+// a GCS whose links are the benchmark's links
+class BenchGCS : public GCS_Dummy {
+public:
+    GCS_MAVLINK_Dummy *links[MAVLINK_COMM_NUM_BUFFERS];
+    uint8_t num_links;
+
+    GCS_MAVLINK_Dummy *chan(const uint8_t ofs) override {
+        return ofs < num_links ? links[ofs] : nullptr;
+    }
+    const GCS_MAVLINK_Dummy *chan(const uint8_t ofs) const override {
+        return ofs < num_links ? links[ofs] : nullptr;
+    }
+};
+
+BenchGCS _gcs;
+
+static GCS_MAVLINK_Parameters params;
+static BenchUART uarts[MAVLINK_COMM_NUM_BUFFERS];
+
+#define GCS_SYSID 255
+#define FIRST_COMPID 100
+
+static void BM_MAVLinkRouting(benchmark::State& state)
+{
+    const uint8_t num_chans = state.range(0);
+    const uint8_t num_components = state.range(1);
+
+    mavlink_system.sysid = 1;
+    mavlink_system.compid = MAV_COMP_ID_AUTOPILOT1;
+
+    // allocated so the routing table starts empty
+    MAVLink_routing *routing = NEW_NOTHROW MAVLink_routing();
+
+    _gcs.num_links = num_chans;
+    for (uint8_t i=0; i<num_chans; i++) {
+        const mavlink_channel_t chan = mavlink_channel_t(MAVLINK_COMM_0 + i);
+        _gcs.links[i] = NEW_NOTHROW BenchLink(params, uarts[i], chan);
+        mavlink_comm_port[i] = &uarts[i];
+    }
+    GCS_MAVLINK &gcs_link = *_gcs.links[0];
+
+    // component c is on channel 1 + c % (num_chans-1)
+    auto component_link = [&](uint8_t c) -> GCS_MAVLINK & {
+        return *_gcs.links[1 + c % (num_chans-1)];
+    };
+
+    // learn the routes
+    mavlink_message_t msg;
+    mavlink_msg_heartbeat_pack(GCS_SYSID, MAV_COMP_ID_MISSIONPLANNER, &msg, MAV_TYPE_GCS, MAV_AUTOPILOT_INVALID, 0, 0, 0);
+    routing->check_and_forward(gcs_link, msg);
+    for (uint8_t c=0; c<num_components; c++) {
+        mavlink_msg_heartbeat_pack(mavlink_system.sysid, FIRST_COMPID+c, &msg, MAV_TYPE_GIMBAL, MAV_AUTOPILOT_INVALID, 0, 0, 0);
+        routing->check_and_forward(component_link(c), msg);
+    }
+
+    // the traffic of a round
+    mavlink_message_t param_set[MAVLINK_MAX_ROUTES];
+    mavlink_message_t attitude[MAVLINK_MAX_ROUTES];
+    for (uint8_t c=0; c<num_components; c++) {
+        mavlink_msg_param_set_pack(GCS_SYSID, MAV_COMP_ID_MISSIONPLANNER, &param_set[c],
+                                   mavlink_system.sysid, FIRST_COMPID+c, "BENCH_PARAM", 1.0, MAV_PARAM_TYPE_REAL32);
+        mavlink_msg_attitude_pack(mavlink_system.sysid, FIRST_COMPID+c, &attitude[c],
+                                  c, 0.1, 0.2, 0.3, 0.01, 0.02, 0.03);
+    }
+
+    while (state.KeepRunning()) {
+        for (uint8_t c=0; c<num_components; c++) {
+            routing->check_and_forward(gcs_link, param_set[c]);
+            routing->check_and_forward(component_link(c), attitude[c]);
+        }
+        for (uint8_t i=0; i<num_chans; i++) {
+            uarts[i].drain();
+        }
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * num_components * 2);
+
+    for (uint8_t i=0; i<num_chans; i++) {
+        mavlink_comm_port[i] = nullptr;
+        delete _gcs.links[i];
+        _gcs.links[i] = nullptr;
+    }
+    _gcs.num_links = 0;
+    delete routing;
+}
+
+BENCHMARK(BM_MAVLinkRouting)
+    ->Args({2, 4})
+    ->Args({MAVLINK_COMM_NUM_BUFFERS, 4})
+    ->Args({MAVLINK_COMM_NUM_BUFFERS, MAVLINK_MAX_ROUTES-1});
+
+BENCHMARK_MAIN();
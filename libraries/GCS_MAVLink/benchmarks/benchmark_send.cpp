@@ -0,0 +1,80 @@
+#include <AP_gbenchmark.h>
+
+#include <GCS_MAVLink/GCS_Dummy.h>
+#include <GCS_MAVLink/GCS_MAVLink.h>
+
+#include "benchmark_uart.h"
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+const AP_Param::GroupInfo GCS_MAVLINK_Parameters::var_info[] = {
+    AP_GROUPEND
+};
+GCS_Dummy _gcs;
+
+/*
+  messages per second sent through the MAVLink channel send path,
+  with each message written to the port in parts (as the MAVLink
+  library sends header, payload and checksum), and with the message
+  copied into space reserved in the port's write buffer and committed
+  once.  The port is a write buffer drained as a UART thread would
+ */
+
+static BenchUART uarts[MAVLINK_COMM_NUM_BUFFERS];
+
+// an ATTITUDE message as the MAVLink library sends it
+#define HEADER_LEN  10
+#define PAYLOAD_LEN MAVLINK_MSG_ID_ATTITUDE_LEN
+#define CRC_LEN     2
+
+static void send_messages(benchmark::State& state, bool reserve_supported)
+{
+    const uint8_t num_chans = state.range(0);
+    for (uint8_t i=0; i<num_chans; i++) {
+        uarts[i].reserve_supported = reserve_supported;
+        mavlink_comm_port[i] = &uarts[i];
+    }
+
+    uint8_t header[HEADER_LEN] {};
+    uint8_t payload[PAYLOAD_LEN] {};
+    uint8_t crc[CRC_LEN] {};
+    const uint16_t msg_len = sizeof(header) + sizeof(payload) + sizeof(crc);
+    const uint16_t msgs_per_drain = BenchUART::BUFFER_SIZE / msg_len;
+
+    while (state.KeepRunning()) {
+        for (uint8_t i=0; i<num_chans; i++) {
+            const mavlink_channel_t chan = mavlink_channel_t(MAVLINK_COMM_0 + i);
+            for (uint16_t m=0; m<msgs_per_drain; m++) {
+                comm_send_lock(chan, msg_len);
+                comm_send_buffer(chan, header, sizeof(header));
+                comm_send_buffer(chan, payload, sizeof(payload));
+                comm_send_buffer(chan, crc, sizeof(crc));
+                comm_send_unlock(chan);
+            }
+            uarts[i].drain();
+        }
+    }
+
+    const int64_t msgs_per_chan = int64_t(state.iterations()) * msgs_per_drain;
+    state.SetItemsProcessed(msgs_per_chan * num_chans);
+    state.counters["msgs_per_chan"] = benchmark::Counter(msgs_per_chan, benchmark::Counter::kIsRate);
+
+    for (uint8_t i=0; i<num_chans; i++) {
+        mavlink_comm_port[i] = nullptr;
+    }
+}
+
+static void BM_MAVLinkSendWrites(benchmark::State& state)
+{
+    send_messages(state, false);
+}
+
+static void BM_MAVLinkSendReserved(benchmark::State& state)
+{
+    send_messages(state, true);
+}
+
+BENCHMARK(BM_MAVLinkSendWrites)->Arg(1)->Arg(MAVLINK_COMM_NUM_BUFFERS);
+BENCHMARK(BM_MAVLinkSendReserved)->Arg(1)->Arg(MAVLINK_COMM_NUM_BUFFERS);
+
+BENCHMARK_MAIN();
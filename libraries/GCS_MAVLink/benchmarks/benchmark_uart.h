@@ -0,0 +1,60 @@
+#pragma once
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/RingBuffer.h>
+
+/*
+  port for the MAVLink benchmarks: written bytes are held in a write
+  buffer until drained, as a UART thread would.  Writes are locked as
+  in the ChibiOS and Linux UART drivers
+ */
+class BenchUART : public AP_HAL::UARTDriver {
+public:
+    static const uint16_t BUFFER_SIZE = 8192;
+
+    // false to make senders write messages in parts
+    bool reserve_supported = true;
+
+    bool is_initialized() override { return true; }
+    bool tx_pending() override { return writebuf.available() > 0; }
+    uint32_t txspace() override { return writebuf.space(); }
+
+    // what the UART thread would do with the written bytes
+    void drain() {
+        WITH_SEMAPHORE(write_mutex);
+        writebuf.advance(writebuf.available());
+    }
+
+protected:
+    void _begin(uint32_t baud, uint16_t rxSpace, uint16_t txSpace) override {}
+    void _end() override {}
+    void _flush() override {}
+    uint32_t _available() override { return 0; }
+    bool _discard_input() override { return true; }
+    ssize_t _read(uint8_t *buffer, uint16_t count) override { return 0; }
+
+    size_t _write(const uint8_t *buffer, size_t size) override {
+        WITH_SEMAPHORE(write_mutex);
+        return writebuf.write(buffer, size);
+    }
+    uint8_t _reserve_write(ByteBuffer::IoVec vec[2], uint32_t len) override {
+        if (!reserve_supported) {
+            return 0;
+        }
+        write_mutex.take_blocking();
+        if (writebuf.space() < len) {
+            write_mutex.give();
+            return 0;
+        }
+        return writebuf.reserve(vec, len);
+    }
+    bool _commit_write(uint32_t len) override {
+        const bool ret = writebuf.commit(len);
+        write_mutex.give();
+        return ret;
+    }
+
+private:
+    ByteBuffer writebuf{BUFFER_SIZE};
+    HAL_Semaphore write_mutex;
+};
@@ -0,0 +1,321 @@
+#include <AP_gtest.h>
+
+#include <GCS_MAVLink/GCS_Dummy.h>
+#include <GCS_MAVLink/GCS_MAVLink.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+const AP_Param::GroupInfo GCS_MAVLINK_Parameters::var_info[] = {
+    AP_GROUPEND
+};
+
+// port which decodes the messages sent on it
+class TestUART : public AP_HAL::UARTDriver {
+public:
+    bool is_initialized() override { return true; }
+    bool tx_pending() override { return false; }
+    uint32_t txspace() override { return 4096; }
+
+    // number of messages with this id sent since the last clear
+    uint8_t count(uint32_t msgid) const {
+        uint8_t ret = 0;
+        for (uint8_t i=0; i<num_msgs; i++) {
+            if (msgids[i] == msgid) {
+                ret++;
+            }
+        }
+        return ret;
+    }
+    uint8_t total() const { return num_msgs; }
+    void clear() {
+        num_msgs = 0;
+        num_bytes = 0;
+    }
+
+    // true if exactly these bytes were sent since the last clear
+    bool sent(const uint8_t *buf, uint16_t len) const {
+        return num_bytes == len && memcmp(bytes, buf, len) == 0;
+    }
+
+protected:
+    void _begin(uint32_t baud, uint16_t rxSpace, uint16_t txSpace) override {}
+    void _end() override {}
+    void _flush() override {}
+    uint32_t _available() override { return 0; }
+    bool _discard_input() override { return true; }
+    ssize_t _read(uint8_t *buffer, uint16_t count) override { return 0; }
+
+    size_t _write(const uint8_t *buffer, size_t size) override {
+        for (size_t i=0; i<size; i++) {
+            if (num_bytes < ARRAY_SIZE(bytes)) {
+                bytes[num_bytes++] = buffer[i];
+            }
+            mavlink_message_t msg;
+            mavlink_status_t status;
+            if (mavlink_frame_char_buffer(&rxmsg, &rxstatus, buffer[i], &msg, &status) == MAVLINK_FRAMING_OK &&
+                num_msgs < ARRAY_SIZE(msgids)) {
+                msgids[num_msgs++] = msg.msgid;
+            }
+        }
+        return size;
+    }
+
+private:
+    mavlink_message_t rxmsg {};
+    mavlink_status_t rxstatus {};
+    uint32_t msgids[16];
+    uint8_t num_msgs;
+    uint8_t bytes[2*MAVLINK_MAX_PACKET_LEN];
+    uint16_t num_bytes;
+};
+
+class TestLink : public GCS_MAVLINK_Dummy {
+public:
+    TestLink(GCS_MAVLINK_Parameters &params, AP_HAL::UARTDriver &uart, mavlink_channel_t _chan) :
+        GCS_MAVLINK_Dummy(params, uart) {
+        chan = _chan;
+    }
+};
+
+#define NUM_LINKS 4
+#define PRIVATE_CHAN 3
+
+// a GCS whose links are the test's links
+class TestGCS : public GCS_Dummy {
+public:
+    GCS_MAVLINK_Dummy *links[NUM_LINKS];
+
+    GCS_MAVLINK_Dummy *chan(const uint8_t ofs) override {
+        return ofs < NUM_LINKS ? links[ofs] : nullptr;
+    }
+    const GCS_MAVLINK_Dummy *chan(const uint8_t ofs) const override {
+        return ofs < NUM_LINKS ? links[ofs] : nullptr;
+    }
+};
+
+TestGCS _gcs;
+
+static GCS_MAVLINK_Parameters params;
+static TestUART uarts[NUM_LINKS];
+
+#define GCS_SYSID 255
+#define GIMBAL_COMPID 154
+#define CAMERA_COMPID 100
+
+static void setup_links()
+{
+    mavlink_system.sysid = 1;
+    mavlink_system.compid = MAV_COMP_ID_AUTOPILOT1;
+    for (uint8_t i=0; i<NUM_LINKS; i++) {
+        if (_gcs.links[i] == nullptr) {
+            _gcs.links[i] = NEW_NOTHROW TestLink(params, uarts[i], mavlink_channel_t(MAVLINK_COMM_0 + i));
+            mavlink_comm_port[i] = &uarts[i];
+        }
+        uarts[i].clear();
+    }
+}
+
+static GCS_MAVLINK &link(uint8_t i)
+{
+    return *_gcs.links[i];
+}
+
+// learn a route to sysid/compid on a link
+static void heartbeat(MAVLink_routing &routing, uint8_t i, uint8_t sysid, uint8_t compid)
+{
+    mavlink_message_t msg;
+    mavlink_msg_heartbeat_pack(sysid, compid, &msg, MAV_TYPE_GIMBAL, MAV_AUTOPILOT_INVALID, 0, 0, 0);
+    routing.check_and_forward(link(i), msg);
+    for (uint8_t j=0; j<NUM_LINKS; j++) {
+        uarts[j].clear();
+    }
+}
+
+static mavlink_message_t param_set(uint8_t target_system, uint8_t target_component)
+{
+    mavlink_message_t msg;
+    mavlink_msg_param_set_pack(GCS_SYSID, MAV_COMP_ID_MISSIONPLANNER, &msg,
+                               target_system, target_component, "TEST_PARAM", 1.0, MAV_PARAM_TYPE_REAL32);
+    return msg;
+}
+
+static mavlink_message_t attitude(uint8_t compid)
+{
+    mavlink_message_t msg;
+    mavlink_msg_attitude_pack(mavlink_system.sysid, compid, &msg, 0, 0.1, 0.2, 0.3, 0.01, 0.02, 0.03);
+    return msg;
+}
+
+/*
+  build a MAVLink2 ATTITUDE frame by hand with the full payload,
+  including the trailing zero bytes a sender may choose not to trim
+*/
+static uint16_t attitude_frame(uint8_t *buf, uint8_t incompat_flags)
+{
+    mavlink_attitude_t attitude {};
+    attitude.roll = 0.1;
+    attitude.pitch = 0.2;
+    // yawspeed left zero, so trimming would shorten the payload
+    const uint8_t len = MAVLINK_MSG_ID_ATTITUDE_LEN;
+    uint16_t n = 0;
+    buf[n++] = MAVLINK_STX;
+    buf[n++] = len;
+    buf[n++] = incompat_flags;
+    buf[n++] = 0;
+    buf[n++] = 7;
+    buf[n++] = mavlink_system.sysid;
+    buf[n++] = CAMERA_COMPID;
+    buf[n++] = MAVLINK_MSG_ID_ATTITUDE & 0xFF;
+    buf[n++] = (MAVLINK_MSG_ID_ATTITUDE >> 8) & 0xFF;
+    buf[n++] = (MAVLINK_MSG_ID_ATTITUDE >> 16) & 0xFF;
+    memcpy(&buf[n], &attitude, len);
+    n += len;
+    uint16_t crc = crc_calculate(&buf[1], n-1);
+    crc_accumulate(MAVLINK_MSG_ID_ATTITUDE_CRC, &crc);
+    buf[n++] = crc & 0xFF;
+    buf[n++] = crc >> 8;
+    if (incompat_flags & MAVLINK_IFLAG_SIGNED) {
+        // the router does not check signatures, so any bytes will do
+        for (uint8_t i=0; i<MAVLINK_SIGNATURE_BLOCK_LEN; i++) {
+            buf[n++] = 0xA0 + i;
+        }
+    }
+    return n;
+}
+
+// parse a frame as a receiving link would
+static mavlink_message_t parse_frame(const uint8_t *buf, uint16_t len)
+{
+    mavlink_message_t rxmsg {}, msg {};
+    mavlink_status_t rxstatus {}, status {};
+    uint8_t ret = MAVLINK_FRAMING_INCOMPLETE;
+    for (uint16_t i=0; i<len; i++) {
+        ret = mavlink_frame_char_buffer(&rxmsg, &rxstatus, buf[i], &msg, &status);
+    }
+    EXPECT_EQ(ret, MAVLINK_FRAMING_OK);
+    return msg;
+}
+
+TEST(MAVLink_routing, forwarded_byte_for_byte)
+{
+    setup_links();
+    MAVLink_routing routing;
+    heartbeat(routing, 0, GCS_SYSID, MAV_COMP_ID_MISSIONPLANNER);
+    heartbeat(routing, 1, mavlink_system.sysid, CAMERA_COMPID);
+    heartbeat(routing, 2, mavlink_system.sysid, GIMBAL_COMPID);
+
+    uint8_t frame[MAVLINK_MAX_PACKET_LEN];
+
+    // an untrimmed MAVLink2 frame keeps its length and checksum
+    uint16_t len = attitude_frame(frame, 0);
+    EXPECT_TRUE(routing.check_and_forward(link(1), parse_frame(frame, len)));
+    EXPECT_TRUE(uarts[0].sent(frame, len));
+    EXPECT_TRUE(uarts[2].sent(frame, len));
+    EXPECT_EQ(uarts[0].count(MAVLINK_MSG_ID_ATTITUDE), 1);
+    uarts[0].clear();
+    uarts[2].clear();
+
+    // a signed frame keeps its signature
+    len = attitude_frame(frame, MAVLINK_IFLAG_SIGNED);
+    EXPECT_TRUE(routing.check_and_forward(link(1), parse_frame(frame, len)));
+    EXPECT_TRUE(uarts[0].sent(frame, len));
+    EXPECT_TRUE(uarts[2].sent(frame, len));
+    EXPECT_EQ(uarts[0].count(MAVLINK_MSG_ID_ATTITUDE), 1);
+}
+
+TEST(MAVLink_routing, learned_routes)
+{
+    setup_links();
+    MAVLink_routing routing;
+    heartbeat(routing, 0, GCS_SYSID, MAV_COMP_ID_MISSIONPLANNER);
+    heartbeat(routing, 1, mavlink_system.sysid, GIMBAL_COMPID);
+    heartbeat(routing, 2, mavlink_system.sysid, CAMERA_COMPID);
+
+    // for a learned component, so only forwarded on its link
+    EXPECT_FALSE(routing.check_and_forward(link(0), param_set(mavlink_system.sysid, GIMBAL_COMPID)));
+    EXPECT_EQ(uarts[0].total(), 0);
+    EXPECT_EQ(uarts[1].count(MAVLINK_MSG_ID_PARAM_SET), 1);
+    EXPECT_EQ(uarts[2].total(), 0);
+    uarts[1].clear();
+
+    // for us, so not forwarded
+    EXPECT_TRUE(routing.check_and_forward(link(0), param_set(mavlink_system.sysid, mavlink_system.compid)));
+    for (uint8_t i=0; i<NUM_LINKS; i++) {
+        EXPECT_EQ(uarts[i].total(), 0);
+    }
+
+    // for an unknown component of our system, so handled locally
+    EXPECT_TRUE(routing.check_and_forward(link(0), param_set(mavlink_system.sysid, 200)));
+    for (uint8_t i=0; i<NUM_LINKS; i++) {
+        EXPECT_EQ(uarts[i].total(), 0);
+    }
+
+    // for every component of our system, so forwarded on each
+    // component's link and handled locally
+    EXPECT_TRUE(routing.check_and_forward(link(0), param_set(mavlink_system.sysid, 0)));
+    EXPECT_EQ(uarts[0].total(), 0);
+    EXPECT_EQ(uarts[1].count(MAVLINK_MSG_ID_PARAM_SET), 1);
+    EXPECT_EQ(uarts[2].count(MAVLINK_MSG_ID_PARAM_SET), 1);
+    uarts[1].clear();
+    uarts[2].clear();
+
+    // a component seen on a second link is reached on both
+    heartbeat(routing, 2, mavlink_system.sysid, GIMBAL_COMPID);
+    EXPECT_FALSE(routing.check_and_forward(link(0), param_set(mavlink_system.sysid, GIMBAL_COMPID)));
+    EXPECT_EQ(uarts[1].count(MAVLINK_MSG_ID_PARAM_SET), 1);
+    EXPECT_EQ(uarts[2].count(MAVLINK_MSG_ID_PARAM_SET), 1);
+}
+
+TEST(MAVLink_routing, broadcast_once_per_channel)
+{
+    setup_links();
+    MAVLink_routing routing;
+    heartbeat(routing, 0, GCS_SYSID, MAV_COMP_ID_MISSIONPLANNER);
+    heartbeat(routing, 0, GCS_SYSID, MAV_COMP_ID_MISSIONPLANNER+1);
+    heartbeat(routing, 1, mavlink_system.sysid, GIMBAL_COMPID);
+    heartbeat(routing, 2, mavlink_system.sysid, CAMERA_COMPID);
+    heartbeat(routing, 2, mavlink_system.sysid, CAMERA_COMPID+1);
+
+    // sent once on each other link with a route, however many
+    // components are on it, and never back on the incoming link
+    EXPECT_TRUE(routing.check_and_forward(link(1), attitude(GIMBAL_COMPID)));
+    EXPECT_EQ(uarts[0].count(MAVLINK_MSG_ID_ATTITUDE), 1);
+    EXPECT_EQ(uarts[1].total(), 0);
+    EXPECT_EQ(uarts[2].count(MAVLINK_MSG_ID_ATTITUDE), 1);
+    EXPECT_EQ(uarts[3].total(), 0);
+}
+
+TEST(MAVLink_routing, private_channel)
+{
+    setup_links();
+    GCS_MAVLINK::set_channel_private(mavlink_channel_t(MAVLINK_COMM_0 + PRIVATE_CHAN));
+    MAVLink_routing routing;
+    heartbeat(routing, 0, GCS_SYSID, MAV_COMP_ID_MISSIONPLANNER);
+    heartbeat(routing, 1, mavlink_system.sysid, CAMERA_COMPID);
+    heartbeat(routing, PRIVATE_CHAN, mavlink_system.sysid, GIMBAL_COMPID);
+
+    // broadcasts are not sent on private channels
+    EXPECT_TRUE(routing.check_and_forward(link(1), attitude(CAMERA_COMPID)));
+    EXPECT_EQ(uarts[0].count(MAVLINK_MSG_ID_ATTITUDE), 1);
+    EXPECT_EQ(uarts[PRIVATE_CHAN].total(), 0);
+    uarts[0].clear();
+
+    // nor are messages for every component of our system
+    EXPECT_TRUE(routing.check_and_forward(link(0), param_set(mavlink_system.sysid, 0)));
+    EXPECT_EQ(uarts[1].count(MAVLINK_MSG_ID_PARAM_SET), 1);
+    EXPECT_EQ(uarts[PRIVATE_CHAN].total(), 0);
+    uarts[1].clear();
+
+    // messages for a component seen on a private channel are
+    EXPECT_FALSE(routing.check_and_forward(link(0), param_set(mavlink_system.sysid, GIMBAL_COMPID)));
+    EXPECT_EQ(uarts[PRIVATE_CHAN].count(MAVLINK_MSG_ID_PARAM_SET), 1);
+    uarts[PRIVATE_CHAN].clear();
+
+    // nothing from a private channel is forwarded
+    EXPECT_TRUE(routing.check_and_forward(link(PRIVATE_CHAN), attitude(GIMBAL_COMPID)));
+    for (uint8_t i=0; i<NUM_LINKS; i++) {
+        EXPECT_EQ(uarts[i].total(), 0);
+    }
+}
+
+AP_GTEST_MAIN()
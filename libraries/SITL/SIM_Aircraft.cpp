@@ -285,7 +285,10 @@ void Aircraft::sync_frame_time(void)
         // don't let a large negative debt build up
         sleep_debt_us = -1.0e5;
     }
-    if (sleep_debt_us > min_sleep_time) {
+    if (max_speed) {
+        // never sleep, just keep the achieved rate up to date
+        sleep_debt_us = 0;
+    } else if (sleep_debt_us > min_sleep_time) {
         // sleep if we have built up a debt of min_sleep_tim
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
         usleep(sleep_debt_us);
@@ -679,6 +682,12 @@ void Aircraft::update_dynamics(const Vector3f &rot_accel)
     eas2tas = AP_Baro::get_EAS2TAS_for_alt_amsl(location.alt*0.01);
     air_density = AP_Baro::get_air_density_for_alt_amsl(location.alt*0.01);
 
+    // trapezoidal integration uses the average of the rates at the
+    // start and end of the step, which is exact for constant
+    // accelerations
+    const bool trapezoidal = sitl != nullptr && sitl->integrator == SIM::Integrator::TRAPEZOIDAL;
+    const Vector3f gyro_prev = gyro;
+
     // update rotational rates in body frame
     gyro += rot_accel * delta_time;
 
@@ -693,7 +702,7 @@ void Aircraft::update_dynamics(const Vector3f &rot_accel)
     accel_body.z = constrain_float(accel_body.z, -accel_limit, accel_limit);
 
     // update attitude
-    dcm.rotate(gyro * delta_time);
+    dcm.rotate((trapezoidal ? (gyro_prev + gyro) * 0.5f : gyro) * delta_time);
     dcm.normalize();
 
     Vector3f accel_earth = dcm * accel_body;
@@ -710,11 +719,12 @@ void Aircraft::update_dynamics(const Vector3f &rot_accel)
     accel_body = dcm.transposed() * (accel_earth + Vector3f(0.0f, 0.0f, -GRAVITY_MSS));
 
     // new velocity vector
+    const Vector3f velocity_prev = velocity_ef;
     velocity_ef += accel_earth * delta_time;
 
     const bool was_on_ground = on_ground();
     // new position vector
-    position += (velocity_ef * delta_time).todouble();
+    position += ((trapezoidal ? (velocity_prev + velocity_ef) * 0.5f : velocity_ef) * delta_time).todouble();
 
     // velocity relative to air mass, in earth frame
     velocity_air_ef = velocity_ef - wind_ef;
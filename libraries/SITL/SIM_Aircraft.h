@@ -61,6 +61,11 @@ public:
     void set_speedup(float speedup);
     float get_speedup() const { return target_speedup; }
 
+    /*
+      run as fast as possible, with no pacing to the wall clock
+     */
+    void set_max_speed(bool enable) { max_speed = enable; }
+
     /*
       set instance number
      */
@@ -243,6 +248,7 @@ protected:
     uint32_t last_fps_report_ms;
     float achieved_rate_hz;  // achieved speedup rate
     int64_t sleep_debt_us;
+    bool max_speed;
     uint32_t last_frame_count;
     uint8_t instance;
     const char *autotest_dir;
@@ -514,6 +514,8 @@ void Frame::init(const char *frame_str, Battery *_battery)
         model.moment_of_inertia.z = model.mass * 0.5 * sq(model.diagonal_size*0.5);
     }
 
+    setup_batch();
+
     // setup reasonable defaults for battery
     AP_Param::set_default_by_name("SIM_BATT_VOLTAGE", model.maxVoltage);
     AP_Param::set_default_by_name("SIM_BATT_CAP_AH", model.battCapacityAh);
@@ -522,6 +524,167 @@ void Frame::init(const char *frame_str, Battery *_battery)
     }
 }
 
+/*
+  copy the motors which can't tilt into the structure of arrays
+ */
+void Frame::setup_batch(void)
+{
+    if (batch == nullptr) {
+        batch = NEW_NOTHROW MotorBatch;
+    }
+    memset(batch_index, not_batched, sizeof(batch_index));
+    if (batch == nullptr) {
+        return;
+    }
+    batch->count = 0;
+    for (uint8_t i=0; i<MIN(num_motors, max_batch_motors); i++) {
+        const Motor &m = motors[i];
+        if (m.roll_servo >= 0 || m.pitch_servo >= 0) {
+            continue;
+        }
+        const uint8_t j = batch->count++;
+        batch_index[i] = j;
+        batch->motor[j] = i;
+        batch->servo[j] = m.servo;
+        // as Motor::pwm_to_command()
+        batch->pwm_thrust_min[j] = m.mot_pwm_min + m.mot_spin_min * (m.mot_pwm_max - m.mot_pwm_min);
+        const float pwm_thrust_max = m.mot_pwm_min + m.mot_spin_max * (m.mot_pwm_max - m.mot_pwm_min);
+        batch->pwm_thrust_range[j] = pwm_thrust_max - batch->pwm_thrust_min[j];
+        batch->slew_max[j] = m.slew_max;
+        batch->expo[j] = m.mot_expo;
+        batch->voltage_max[j] = m.voltage_max;
+        batch->velocity_max[j] = m.max_outflow_velocity;
+        batch->prop_area[j] = m.effective_prop_area;
+        batch->true_prop_area[j] = m.true_prop_area;
+        batch->mdrag_coef[j] = m.momentum_drag_coefficient;
+        batch->diagonal_size[j] = m.diagonal_size;
+        batch->yaw_factor[j] = m.yaw_factor;
+        batch->power_factor[j] = m.power_factor;
+        batch->pos_x[j] = m.position.x;
+        batch->pos_y[j] = m.position.y;
+        batch->pos_z[j] = m.position.z;
+        batch->thrust_x[j] = m.thrust_vector.x;
+        batch->thrust_y[j] = m.thrust_vector.y;
+        batch->thrust_z[j] = m.thrust_vector.z;
+        batch->thrust_sq[j] = m.thrust_vector * m.thrust_vector;
+        batch->last_command[j] = 0;
+        batch->current[j] = 0;
+        batch->last_calc_us[j] = 0;
+    }
+}
+
+/*
+  calculate the total torque and thrust of the motors. Motors in the
+  batch are calculated in one pass over the arrays, following the
+  same steps as Motor::calculate_forces(). Tilting motors use
+  Motor::calculate_forces()
+ */
+void Frame::calculate_motor_forces(const struct sitl_input &input,
+                                   const Vector3f &vel_air_bf,
+                                   const Vector3f &gyro,
+                                   float air_density,
+                                   float voltage,
+                                   bool use_drag,
+                                   Vector3f &torque,
+                                   Vector3f &thrust)
+{
+    torque.zero();
+    thrust.zero();
+
+    const uint8_t count = batch != nullptr ? batch->count : 0;
+    const uint64_t now_us = AP_HAL::micros64();
+    for (uint8_t j=0; j<count; j++) {
+        float command = constrain_float((input.servos[motor_offset+batch->servo[j]] - batch->pwm_thrust_min[j]) / batch->pwm_thrust_range[j], 0, 1);
+        const float voltage_scale = voltage / batch->voltage_max[j];
+        if (voltage_scale < 0.1) {
+            // battery is dead
+            batch->current[j] = 0;
+            continue;
+        }
+
+        // apply slew limiter to command
+        if (batch->last_calc_us[j] != 0 && batch->slew_max[j] > 0) {
+            const float dt = (now_us - batch->last_calc_us[j])*1.0e-6;
+            const float slew_max_change = batch->slew_max[j] * dt;
+            command = constrain_float(command, batch->last_command[j]-slew_max_change, batch->last_command[j]+slew_max_change);
+        }
+        batch->last_calc_us[j] = now_us;
+        batch->last_command[j] = command;
+
+        // velocity of motor through air, including rotation of the vehicle
+        const float pos_x = batch->pos_x[j];
+        const float pos_y = batch->pos_y[j];
+        const float pos_z = batch->pos_z[j];
+        const float vel_x = vel_air_bf.x + -(pos_y*gyro.z - pos_z*gyro.y);
+        const float vel_y = vel_air_bf.y + -(pos_z*gyro.x - pos_x*gyro.z);
+        const float vel_z = vel_air_bf.z + -(pos_x*gyro.y - pos_y*gyro.x);
+
+        // velocity into prop, clipping at zero
+        const float tv_x = batch->thrust_x[j];
+        const float tv_y = batch->thrust_y[j];
+        const float tv_z = batch->thrust_z[j];
+        const float vel_dot_tv = vel_x*tv_x + vel_y*tv_y + vel_z*tv_z;
+        const float velocity_in = MAX(0, -(tv_z * vel_dot_tv / batch->thrust_sq[j]));
+
+        // thrust of untilted motor, as Motor::calc_thrust()
+        const float velocity_out = voltage_scale * batch->velocity_max[j] * sqrtf((1-batch->expo[j])*command + batch->expo[j]*sq(command));
+        const float motor_thrust = 0.5 * air_density * batch->prop_area[j] * (sq(velocity_out) - sq(velocity_in));
+
+        // thrust in bodyframe NED
+        float thrust_x = tv_x * motor_thrust;
+        float thrust_y = tv_y * motor_thrust;
+        float thrust_z = tv_z * motor_thrust;
+
+        if (use_drag) {
+            const float momentum_drag_factor = batch->mdrag_coef[j] * sqrtf(air_density * batch->true_prop_area[j]);
+            const float sqrt_x = sqrtf(fabsf(thrust_x));
+            const float sqrt_y = sqrtf(fabsf(thrust_y));
+            const float sqrt_z = sqrtf(fabsf(thrust_z));
+            const float drag_x = momentum_drag_factor * vel_x * (sqrt_y + sqrt_z);
+            const float drag_y = momentum_drag_factor * vel_y * (sqrt_x + sqrt_z);
+            const float drag_z = momentum_drag_factor * vel_z * (sqrt_x + sqrt_y + sqrt_z);
+            thrust_x -= drag_x;
+            thrust_y -= drag_y;
+            thrust_z -= drag_z;
+        }
+
+        // torque from thrust plus the yaw torque of the rotor
+        const float yaw_scale = 0.05 * batch->diagonal_size[j] * motor_thrust;
+        const float yaw_factor = batch->yaw_factor[j];
+        torque.x += (pos_y*thrust_z - pos_z*thrust_y) + tv_x * yaw_factor * command * yaw_scale * -1.0f;
+        torque.y += (pos_z*thrust_x - pos_x*thrust_z) + tv_y * yaw_factor * command * yaw_scale * -1.0f;
+        torque.z += (pos_x*thrust_y - pos_y*thrust_x) + tv_z * yaw_factor * command * yaw_scale * -1.0f;
+        thrust.x += thrust_x;
+        thrust.y += thrust_y;
+        thrust.z += thrust_z;
+
+        const float power = batch->power_factor[j] * fabsf(motor_thrust);
+        batch->current[j] = power / MAX(voltage, 0.1);
+    }
+
+    // motors which tilt
+    for (uint8_t i=0; i<num_motors; i++) {
+        if (i < max_batch_motors && batch != nullptr && batch_index[i] != not_batched) {
+            continue;
+        }
+        Vector3f mtorque, mthrust;
+        motors[i].calculate_forces(input, motor_offset, mtorque, mthrust, vel_air_bf, gyro, air_density, voltage, use_drag);
+        torque += mtorque;
+        thrust += mthrust;
+    }
+}
+
+/*
+  get the command from 0 to 1 last applied to a motor
+ */
+float Frame::get_motor_command(uint8_t i) const
+{
+    if (i < max_batch_motors && batch != nullptr && batch_index[i] != not_batched) {
+        return batch->last_command[batch_index[i]];
+    }
+    return motors[i].get_command();
+}
+
 /*
   find a frame by name
  */
@@ -552,15 +715,13 @@ void Frame::calculate_forces(const Aircraft &aircraft,
 
     Vector3f vel_air_bf = aircraft.get_dcm().transposed() * aircraft.get_velocity_air_ef();
 
+    calculate_motor_forces(input, vel_air_bf, gyro, air_density, battery->get_voltage(), use_drag, torque, thrust);
+
     const auto *_sitl = AP::sitl();
-    for (uint8_t i=0; i<num_motors; i++) {
-        Vector3f mtorque, mthrust;
-        motors[i].calculate_forces(input, motor_offset, mtorque, mthrust, vel_air_bf, gyro, air_density, battery->get_voltage(), use_drag);
-        torque += mtorque;
-        thrust += mthrust;
+    if (!is_zero(_sitl->vibe_motor)) {
         // simulate motor rpm
-        if (!is_zero(_sitl->vibe_motor)) {
-            rpm[motor_offset+i] = motors[i].get_command() * AP::sitl()->vibe_motor * 60.0f;
+        for (uint8_t i=0; i<num_motors; i++) {
+            rpm[motor_offset+i] = get_motor_command(i) * _sitl->vibe_motor * 60.0f;
         }
     }
 
@@ -612,7 +773,11 @@ void Frame::current_and_voltage(float &voltage, float &current)
     voltage = battery->get_voltage();
     current = 0;
     for (uint8_t i=0; i<num_motors; i++) {
-        current += motors[i].get_current();
+        if (i < max_batch_motors && batch != nullptr && batch_index[i] != not_batched) {
+            current += batch->current[batch_index[i]];
+        } else {
+            current += motors[i].get_current();
+        }
     }
 }
 #endif // AP_SIM_ENABLED
@@ -61,6 +61,22 @@ public:
     // calculate current and voltage
     void current_and_voltage(float &voltage, float &current);
 
+#if AP_SIM_ENABLED
+    // calculate the total torque and thrust of the motors, in body
+    // frame, and the current drawn by each motor
+    void calculate_motor_forces(const struct sitl_input &input,
+                                const Vector3f &vel_air_bf,
+                                const Vector3f &gyro,
+                                float air_density,
+                                float voltage,
+                                bool use_drag,
+                                Vector3f &torque,
+                                Vector3f &thrust);
+#endif
+
+    // get the command from 0 to 1 last applied to a motor
+    float get_motor_command(uint8_t i) const;
+
     // get mass in kg
     float get_mass(void) const {
         return mass;
@@ -160,6 +176,48 @@ private:
     Battery *battery;
 #endif
 
+    /*
+      structure of arrays copy of the parameters and state of the
+      motors which can't tilt, so that their forces are calculated
+      in one pass with the same results as Motor::calculate_forces()
+     */
+    static const uint8_t max_batch_motors = 12;
+    struct MotorBatch {
+        uint8_t count;
+        uint8_t motor[max_batch_motors];    // index into motors
+        uint8_t servo[max_batch_motors];
+        float pwm_thrust_min[max_batch_motors];
+        float pwm_thrust_range[max_batch_motors];
+        float slew_max[max_batch_motors];
+        float expo[max_batch_motors];
+        float voltage_max[max_batch_motors];
+        float velocity_max[max_batch_motors];
+        float prop_area[max_batch_motors];
+        float true_prop_area[max_batch_motors];
+        float mdrag_coef[max_batch_motors];
+        float diagonal_size[max_batch_motors];
+        float yaw_factor[max_batch_motors];
+        float power_factor[max_batch_motors];
+        float pos_x[max_batch_motors];
+        float pos_y[max_batch_motors];
+        float pos_z[max_batch_motors];
+        float thrust_x[max_batch_motors];
+        float thrust_y[max_batch_motors];
+        float thrust_z[max_batch_motors];
+        float thrust_sq[max_batch_motors];      // thrust vector length squared
+
+        // state
+        float last_command[max_batch_motors];
+        float current[max_batch_motors];
+        uint64_t last_calc_us[max_batch_motors];
+    } *batch;
+    // index into batch of each motor, or not_batched
+    static const uint8_t not_batched = 0xFF;
+    uint8_t batch_index[max_batch_motors];
+
+    // copy the motors which can't tilt into batch
+    void setup_batch(void);
+
     // json parsing helpers
     void parse_float(AP_JSON::value val, const char* label, float &param);
     void parse_vector3(AP_JSON::value val, const char* label, Vector3f &param);
@@ -269,16 +269,34 @@ void JSON::recv_fdm(const struct sitl_input &input)
     }
 
     const uint32_t received_bitmask = parse_sensors((const char *)(p1+1));
-    if (received_bitmask == 0) {
-        // did not receive one of the mandatory fields
-        printf("Did not contain all mandatory fields\n");
+    if (!check_received_fields(received_bitmask)) {
         return;
     }
 
+    memmove(sensor_buffer, p2, sensor_buffer_len - (p2 - sensor_buffer));
+    sensor_buffer_len = sensor_buffer_len - (p2 - sensor_buffer);
+
+    update_from_state(received_bitmask);
+}
+
+/*
+    check the fields received include the mandatory ones, printing
+    the fields when they change
+*/
+bool JSON::check_received_fields(uint32_t received_bitmask)
+{
+    for (uint16_t i=0; i<ARRAY_SIZE(keytable); i++) {
+        if (keytable[i].required && (received_bitmask & 1U << i) == 0) {
+            // did not receive one of the mandatory fields
+            printf("Did not contain all mandatory fields\n");
+            return false;
+        }
+    }
+
     // Must get either attitude or quaternion fields
     if ((received_bitmask & (EULER_ATT | QUAT_ATT)) == 0) {
         printf("Did not receive attitude or quaternion\n");
-        return;
+        return false;
     }
 
     if (received_bitmask != last_received_bitmask) {
@@ -299,9 +317,14 @@ void JSON::recv_fdm(const struct sitl_input &input)
     }
     last_received_bitmask = received_bitmask;
 
-    memmove(sensor_buffer, p2, sensor_buffer_len - (p2 - sensor_buffer));
-    sensor_buffer_len = sensor_buffer_len - (p2 - sensor_buffer);
+    return true;
+}
 
+/*
+    update the vehicle from the received state
+*/
+void JSON::update_from_state(uint32_t received_bitmask)
+{
     accel_body = state.imu.accel_body;
     gyro = state.imu.gyro;
     velocity_ef = state.velocity;
@@ -42,7 +42,7 @@ public:
     /*  Create and set in/out socket for JSON generic simulator */
     void set_interface_ports(const char* address, const int port_in, const int port_out) override;
 
-private:
+protected:
 
     struct servo_packet_16 {
         uint16_t magic = 18458; // constant magic value
@@ -69,8 +69,14 @@ private:
     uint32_t frame_counter;
     double last_timestamp_s;
 
-    void output_servos(const struct sitl_input &input);
-    void recv_fdm(const struct sitl_input &input);
+    virtual void output_servos(const struct sitl_input &input);
+    virtual void recv_fdm(const struct sitl_input &input);
+
+    // check the fields received include the mandatory ones
+    bool check_received_fields(uint32_t received_bitmask);
+
+    // update the vehicle from the received state
+    void update_from_state(uint32_t received_bitmask);
 
     uint32_t parse_sensors(const char *json);
 
@@ -0,0 +1,152 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+    Simulator Connector for JSON based interfaces over shared memory
+
+    Servo outputs and physics state are exchanged through rings in
+    shared memory, laid out in SIM_JSON_SHM_Protocol.h, with the same
+    fields as the JSON backend but without sockets or text parsing.
+*/
+
+#include "SIM_JSON_SHM.h"
+
+#if HAL_SIM_JSON_SHM_ENABLED
+
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include <AP_HAL/AP_HAL.h>
+
+#define SHM_TIMEOUT_MS 100
+
+extern const AP_HAL::HAL& hal;
+
+using namespace SITL;
+
+static_assert(JSON_SHM_TIMESTAMP == 1U << 0 && JSON_SHM_VELOCITY == 1U << 6 &&
+              JSON_SHM_RNG_1 == 1U << 7 && JSON_SHM_TIME_SYNC == 1U << 16,
+              "fields must match the JSON keytable");
+
+JSON_SHM::JSON_SHM(const char *frame_str) :
+    JSON(frame_str)
+{
+    printf("Starting SITL: JSON over shared memory\n");
+
+    const char *colon = strchr(frame_str, ':');
+    if (colon) {
+        snprintf(shm_name, sizeof(shm_name), "%s%s", colon[1] == '/' ? "" : "/", colon+1);
+    }
+}
+
+/*
+    Create the shared memory, named after the instance's port unless
+    given in the frame string
+*/
+void JSON_SHM::set_interface_ports(const char* address, const int port_in, const int port_out)
+{
+    if (shm_name[0] == 0) {
+        snprintf(shm_name, sizeof(shm_name), "/ardupilot_json_%d", port_out);
+    }
+
+    const int fd = shm_open(shm_name, O_RDWR|O_CREAT, 0600);
+    if (fd == -1 || ftruncate(fd, sizeof(JSON_SHM_Region)) != 0) {
+        AP_HAL::panic("JSON-SHM: failed to create %s: %s", shm_name, strerror(errno));
+    }
+    region = (JSON_SHM_Region *)mmap(nullptr, sizeof(JSON_SHM_Region), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (region == MAP_FAILED) {
+        AP_HAL::panic("JSON-SHM: failed to map %s: %s", shm_name, strerror(errno));
+    }
+
+    // start the rings afresh. A simulator which is already attached
+    // sees the frame count start again, as it would with the JSON
+    // backend
+    region->magic = 0;
+    region->servos.head = 0;
+    region->servos.tail = 0;
+    region->state.head = 0;
+    region->state.tail = 0;
+    region->version = JSON_SHM_VERSION;
+    region->magic = JSON_SHM_MAGIC;
+
+    printf("JSON-SHM control interface set to %s\n", shm_name);
+}
+
+/*
+    Send servos
+*/
+void JSON_SHM::output_servos(const struct sitl_input &input)
+{
+    JSON_SHM_Servos pkt;
+    pkt.frame_rate = rate_hz;
+    pkt.frame_count = frame_counter;
+    for (uint8_t i=0; i<ARRAY_SIZE(pkt.pwm); i++) {
+        pkt.pwm[i] = input.servos[i];
+    }
+    if (!json_shm_push(region->servos, pkt)) {
+        printf("JSON-SHM servo ring full\n");
+    }
+}
+
+/*
+    Receive new sensor data from simulator
+    This is a blocking function
+*/
+void JSON_SHM::recv_fdm(const struct sitl_input &input)
+{
+    JSON_SHM_State pkt;
+    uint32_t wait_ms = 0;
+    while (!json_shm_pop(region->state, pkt, SHM_TIMEOUT_MS)) {
+        wait_ms += SHM_TIMEOUT_MS;
+        // if the simulator has taken our servos without replying for
+        // a second it may have restarted, so send them again
+        if (wait_ms > 1000) {
+            wait_ms = 0;
+            if (region->servos.head == region->servos.tail) {
+                printf("No JSON-SHM state received, resending servos\n");
+                output_servos(input);
+            }
+        }
+    }
+
+    // use the latest state, as the JSON backend does
+    while (json_shm_pop(region->state, pkt, 0)) {
+    }
+
+    state.timestamp_s = pkt.timestamp_s;
+    state.imu.gyro = Vector3f(pkt.gyro[0], pkt.gyro[1], pkt.gyro[2]);
+    state.imu.accel_body = Vector3f(pkt.accel_body[0], pkt.accel_body[1], pkt.accel_body[2]);
+    state.position = Vector3d(pkt.position[0], pkt.position[1], pkt.position[2]);
+    state.attitude = Vector3f(pkt.attitude[0], pkt.attitude[1], pkt.attitude[2]);
+    state.quaternion = Quaternion(pkt.quaternion[0], pkt.quaternion[1], pkt.quaternion[2], pkt.quaternion[3]);
+    state.velocity = Vector3f(pkt.velocity[0], pkt.velocity[1], pkt.velocity[2]);
+    for (uint8_t i=0; i<ARRAY_SIZE(state.rng); i++) {
+        state.rng[i] = pkt.rng[i];
+    }
+    state.wind_vane_apparent.direction = pkt.windvane_direction;
+    state.wind_vane_apparent.speed = pkt.windvane_speed;
+    state.airspeed = pkt.airspeed;
+    state.no_time_sync = pkt.no_time_sync != 0;
+
+    if (!check_received_fields(pkt.fields)) {
+        return;
+    }
+
+    update_from_state(pkt.fields);
+}
+
+#endif  // HAL_SIM_JSON_SHM_ENABLED
@@ -0,0 +1,57 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+    JSON backend over shared memory rather than UDP and text
+*/
+#pragma once
+
+#include "SIM_JSON.h"
+
+#ifndef HAL_SIM_JSON_SHM_ENABLED
+#define HAL_SIM_JSON_SHM_ENABLED HAL_SIM_JSON_ENABLED
+#endif
+
+#if HAL_SIM_JSON_SHM_ENABLED
+
+#include "SIM_JSON_SHM_Protocol.h"
+
+namespace SITL {
+
+class JSON_SHM : public JSON {
+public:
+    JSON_SHM(const char *frame_str);
+
+    /* static object creator */
+    static Aircraft *create(const char *frame_str) {
+        return NEW_NOTHROW JSON_SHM(frame_str);
+    }
+
+    /*  Create the shared memory for this instance */
+    void set_interface_ports(const char* address, const int port_in, const int port_out) override;
+
+private:
+    void output_servos(const struct sitl_input &input) override;
+    void recv_fdm(const struct sitl_input &input) override;
+
+    // name of the shared memory object, from the frame string or the
+    // instance's port
+    char shm_name[64];
+
+    JSON_SHM_Region *region;
+};
+
+}
+
+#endif  // HAL_SIM_JSON_SHM_ENABLED
@@ -0,0 +1,169 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+  layout of the shared memory used by the JSON-SHM backend to exchange
+  servo outputs and physics state with an external simulator.
+
+  The state carries the same fields as the JSON backend's text
+  messages, in binary. The region holds two single producer, single
+  consumer rings: servo frames from SITL to the simulator and states
+  from the simulator to SITL. A producer fills the slot at head and
+  then increments head; a consumer reads the slot at tail and then
+  increments tail. Head and tail count frames and wrap at 2^32.
+
+  A consumer with nothing to read sleeps on the head of the ring with
+  a futex, after incrementing the ring's waiting count, and a producer
+  wakes it if that count is non-zero. Without futexes the consumer
+  polls.
+
+  This header has no ArduPilot dependencies so that simulators can
+  include it.
+ */
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#define JSON_SHM_MAGIC 0x4D48534A // "JSHM"
+#define JSON_SHM_VERSION 1
+#define JSON_SHM_RING_SLOTS 8   // must be a power of 2
+
+// servo outputs from SITL, as the JSON backend's servo packet
+struct JSON_SHM_Servos {
+    uint16_t frame_rate;
+    uint32_t frame_count;
+    uint16_t pwm[32];
+};
+
+// bits of JSON_SHM_State::fields, in the order of the JSON keys
+enum JSON_SHM_Field : uint32_t {
+    JSON_SHM_TIMESTAMP  = 1U << 0,
+    JSON_SHM_GYRO       = 1U << 1,
+    JSON_SHM_ACCEL_BODY = 1U << 2,
+    JSON_SHM_POSITION   = 1U << 3,
+    JSON_SHM_EULER_ATT  = 1U << 4,
+    JSON_SHM_QUAT_ATT   = 1U << 5,
+    JSON_SHM_VELOCITY   = 1U << 6,
+    JSON_SHM_RNG_1      = 1U << 7,  // rng_2 to rng_6 follow
+    JSON_SHM_WIND_DIR   = 1U << 13,
+    JSON_SHM_WIND_SPD   = 1U << 14,
+    JSON_SHM_AIRSPEED   = 1U << 15,
+    JSON_SHM_TIME_SYNC  = 1U << 16,
+};
+
+// physics state from the simulator. Units and frames are as for the
+// JSON backend
+struct JSON_SHM_State {
+    uint32_t fields;        // JSON_SHM_Field bits of the fields which are set
+    double timestamp_s;
+    float gyro[3];
+    float accel_body[3];
+    double position[3];
+    float attitude[3];
+    float quaternion[4];
+    float velocity[3];
+    float rng[6];
+    float windvane_direction;
+    float windvane_speed;
+    float airspeed;
+    uint8_t no_time_sync;
+};
+
+template <typename T>
+struct JSON_SHM_Ring {
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+    std::atomic<uint32_t> waiting;
+    T slot[JSON_SHM_RING_SLOTS];
+};
+
+struct JSON_SHM_Region {
+    uint32_t magic;
+    uint32_t version;
+    JSON_SHM_Ring<JSON_SHM_Servos> servos;
+    JSON_SHM_Ring<JSON_SHM_State> state;
+};
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex needs a plain 32 bit word");
+
+/*
+  add a frame to a ring, returning false if the ring is full
+ */
+template <typename T>
+static inline bool json_shm_push(JSON_SHM_Ring<T> &ring, const T &frame)
+{
+    const uint32_t head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) >= JSON_SHM_RING_SLOTS) {
+        return false;
+    }
+    ring.slot[head % JSON_SHM_RING_SLOTS] = frame;
+    // sequentially consistent, so that either we see the consumer
+    // waiting or it sees the new head
+    ring.head.store(head + 1);
+    if (ring.waiting.load() != 0) {
+#ifdef __linux__
+        syscall(SYS_futex, &ring.head, FUTEX_WAKE, 1, nullptr, nullptr, 0);
+#endif
+    }
+    return true;
+}
+
+/*
+  take the oldest frame from a ring, waiting up to timeout_ms for one
+  to arrive. Returns false on timeout
+ */
+template <typename T>
+static inline bool json_shm_pop(JSON_SHM_Ring<T> &ring, T &frame, uint32_t timeout_ms)
+{
+    const uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+    uint32_t head = ring.head.load(std::memory_order_acquire);
+    if (head == tail) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        const uint64_t deadline_ns = ts.tv_sec * 1000000000ULL + ts.tv_nsec + timeout_ms * 1000000ULL;
+        ring.waiting++;
+        while ((head = ring.head.load()) == tail) {
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            const uint64_t now_ns = ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+            if (now_ns >= deadline_ns) {
+                break;
+            }
+#ifdef __linux__
+            const struct timespec wait_ts {
+                time_t((deadline_ns - now_ns) / 1000000000ULL),
+                long((deadline_ns - now_ns) % 1000000000ULL)
+            };
+            // returns at once if head has already moved on
+            syscall(SYS_futex, &ring.head, FUTEX_WAIT, tail, &wait_ts, nullptr, 0);
+#else
+            usleep(50);
+#endif
+        }
+        ring.waiting--;
+        if (head == tail) {
+            return false;
+        }
+    }
+    frame = ring.slot[tail % JSON_SHM_RING_SLOTS];
+    ring.tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
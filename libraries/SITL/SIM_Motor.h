@@ -27,6 +27,8 @@ namespace SITL {
   class to describe a motor position
  */
 class Motor {
+    // Frame keeps a structure of arrays copy of the motor parameters
+    friend class Frame;
 public:
     float angle;
     float yaw_factor;
@@ -394,6 +394,13 @@ const AP_Param::GroupInfo SIM::var_info2[] = {
     // @Description: Ground behavior of aircraft (tailsitter, no movement, forward only)
     AP_GROUPINFO("GND_BEHAV",   41, SIM,  gnd_behav, -1),
 
+    // @Param: INTEGRATOR
+    // @DisplayName: Physics integrator
+    // @Description: Method used to integrate the rates and accelerations of the aircraft each physics step. Trapezoidal integration is second order, so allows a lower SIM_RATE_HZ for the same accuracy
+    // @Values: 0:Euler, 1:Trapezoidal
+    // @User: Advanced
+    AP_GROUPINFO("INTEGRATOR",  42, SIM,  integrator, uint8_t(Integrator::EULER)),
+
     // sailboat wave and tide simulation parameters
 
     // @Param: WAVE_ENABLE
@@ -430,6 +430,13 @@ public:
 
     AP_Int8 gnd_behav;
 
+    // method of integrating the physics each step
+    enum class Integrator {
+        EULER = 0,
+        TRAPEZOIDAL = 1,
+    };
+    AP_Enum<Integrator> integrator;
+
     struct {
         AP_Int8 enable;     // 0: disabled, 1: roll and pitch, 2: roll, pitch and heave
         AP_Float length;    // m
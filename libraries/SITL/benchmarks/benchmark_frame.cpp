@@ -0,0 +1,75 @@
+#include <AP_gbenchmark.h>
+
+#include <SITL/SIM_Frame.h>
+#include <SITL/SIM_Battery.h>
+#include <SITL/SITL_Input.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+using namespace SITL;
+
+/*
+  motor force calculations per second for multicopter frames, through
+  Motor::calculate_forces() one motor at a time and through the
+  batched calculation of the frame
+ */
+
+static const char *frame_names[] = { "quad", "octa", "dodeca-hexa" };
+
+static Battery battery;
+
+static Frame *setup_frame(benchmark::State& state, struct sitl_input &input)
+{
+    const char *name = frame_names[state.range(0)];
+    Frame *frame = Frame::find_frame(name);
+    frame->init(name, &battery);
+    state.SetLabel(name);
+
+    for (uint8_t i=0; i<ARRAY_SIZE(input.servos); i++) {
+        input.servos[i] = 1500 + 20*i;
+    }
+    return frame;
+}
+
+static const Vector3f vel_air_bf { 5, -2, 1 };
+static const Vector3f gyro { 0.1, -0.2, 0.3 };
+
+static void BM_MotorForces(benchmark::State& state)
+{
+    struct sitl_input input {};
+    Frame *frame = setup_frame(state, input);
+
+    while (state.KeepRunning()) {
+        Vector3f torque, thrust;
+        for (uint8_t i=0; i<frame->num_motors; i++) {
+            Vector3f mtorque, mthrust;
+            frame->motors[i].calculate_forces(input, 0, mtorque, mthrust, vel_air_bf, gyro, 1.225, 12.6, true);
+            torque += mtorque;
+            thrust += mthrust;
+        }
+        benchmark::DoNotOptimize(torque);
+        benchmark::DoNotOptimize(thrust);
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * frame->num_motors);
+}
+
+static void BM_FrameMotorForces(benchmark::State& state)
+{
+    struct sitl_input input {};
+    Frame *frame = setup_frame(state, input);
+
+    while (state.KeepRunning()) {
+        Vector3f torque, thrust;
+        frame->calculate_motor_forces(input, vel_air_bf, gyro, 1.225, 12.6, true, torque, thrust);
+        benchmark::DoNotOptimize(torque);
+        benchmark::DoNotOptimize(thrust);
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * frame->num_motors);
+}
+
+BENCHMARK(BM_MotorForces)->DenseRange(0, ARRAY_SIZE(frame_names)-1);
+BENCHMARK(BM_FrameMotorForces)->DenseRange(0, ARRAY_SIZE(frame_names)-1);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,116 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+// Stand-in physics for the JSON-SHM backend: a multicopter which can
+// only move up and down, stepped once for each servo frame from SITL.
+// Usage: hoverSHM [shared memory name], defaulting to that of instance 0
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <chrono>
+
+#include "../../../SIM_JSON_SHM_Protocol.h"
+
+#define GRAVITY_MSS 9.80665
+
+int main(int argc, const char *argv[])
+{
+    const char *name = argc > 1 ? argv[1] : "/ardupilot_json_9002";
+
+    // SITL creates the shared memory, wait for it
+    int fd;
+    while ((fd = shm_open(name, O_RDWR, 0)) == -1) {
+        printf("waiting for %s\n", name);
+        sleep(1);
+    }
+    JSON_SHM_Region *region = (JSON_SHM_Region *)mmap(nullptr, sizeof(JSON_SHM_Region), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (region == MAP_FAILED) {
+        printf("failed to map %s: %s\n", name, strerror(errno));
+        return 1;
+    }
+    while (region->magic != JSON_SHM_MAGIC) {
+        sleep(1);
+    }
+    if (region->version != JSON_SHM_VERSION) {
+        printf("version %u, expected %u\n", region->version, JSON_SHM_VERSION);
+        return 1;
+    }
+
+    double time_s = 0, height = 0, climb_rate = 0;
+    uint32_t last_frame_count = 0, frames = 0;
+    auto last_report = std::chrono::steady_clock::now();
+
+    while (true) {
+        JSON_SHM_Servos servos;
+        if (!json_shm_pop(region->servos, servos, 1000)) {
+            continue;
+        }
+
+        if (servos.frame_count < last_frame_count) {
+            // SITL has restarted
+            printf("reset\n");
+            time_s = height = climb_rate = 0;
+        }
+        last_frame_count = servos.frame_count;
+
+        // thrust of motors 1 to 4, hovering at half throttle
+        double throttle = 0;
+        for (uint8_t i=0; i<4; i++) {
+            throttle += (servos.pwm[i] - 1000) * 0.00025;
+        }
+        const double accel_up = throttle * 2 * GRAVITY_MSS;
+
+        const double dt = 1.0 / (servos.frame_rate > 0 ? servos.frame_rate : 1000);
+        time_s += dt;
+        climb_rate += (accel_up - GRAVITY_MSS) * dt;
+        height += climb_rate * dt;
+        double specific_force = accel_up;
+        if (height <= 0) {
+            // on the ground
+            height = 0;
+            if (climb_rate < 0) {
+                climb_rate = 0;
+            }
+            if (specific_force < GRAVITY_MSS) {
+                specific_force = GRAVITY_MSS;
+            }
+        }
+
+        JSON_SHM_State state {};
+        state.fields = JSON_SHM_TIMESTAMP | JSON_SHM_GYRO | JSON_SHM_ACCEL_BODY |
+            JSON_SHM_POSITION | JSON_SHM_EULER_ATT | JSON_SHM_VELOCITY;
+        state.timestamp_s = time_s;
+        state.accel_body[2] = -specific_force;
+        state.position[2] = -height;
+        state.velocity[2] = -climb_rate;
+        if (!json_shm_push(region->state, state)) {
+            printf("state ring full\n");
+        }
+
+        frames++;
+        const auto now = std::chrono::steady_clock::now();
+        if (now - last_report >= std::chrono::seconds(1)) {
+            printf("%u frames/s, height %.2fm\n", frames, height);
+            frames = 0;
+            last_report = now;
+        }
+    }
+    return 0;
+}
@@ -113,6 +113,24 @@ void StorageManager::erase(void)
     }
 }
 
+/*
+  zero the keys in a copy of storage, so they can't be read back
+ */
+void StorageManager::redact_keys(uint32_t offset, uint8_t *buf, uint32_t count)
+{
+    for (uint8_t i=0; i<STORAGE_NUM_AREAS; i++) {
+        const StorageArea &area = layout[i];
+        if (area.type != StorageKeys) {
+            continue;
+        }
+        const uint32_t start = MAX(offset, uint32_t(area.offset));
+        const uint32_t end = MIN(offset + count, uint32_t(area.offset) + area.length);
+        if (start < end) {
+            memset(&buf[start - offset], 0, end - start);
+        }
+    }
+}
+
 /*
   constructor for StorageAccess
  */
@@ -45,6 +45,15 @@
 #error "Unsupported storage size"
 #endif
 
+/*
+  layout of the StorageKeys area: the MAVLink signing key, then the key
+  authenticating the cache of compiled scripts
+ */
+#define STORAGE_KEYS_SIGNING_OFFSET      0
+#define STORAGE_KEYS_SIGNING_SIZE        48
+#define STORAGE_KEYS_SCRIPT_CACHE_OFFSET (STORAGE_KEYS_SIGNING_OFFSET + STORAGE_KEYS_SIGNING_SIZE)
+#define STORAGE_KEYS_SCRIPT_CACHE_SIZE   16
+
 /*
   The StorageManager holds the layout of non-volatile storage
  */
@@ -65,6 +74,10 @@ public:
     // erase whole of storage
     static void erase(void);
 
+    // zero the bytes of buf, a copy of count bytes of storage starting
+    // at offset, which hold keys
+    static void redact_keys(uint32_t offset, uint8_t *buf, uint32_t count);
+
     static bool storage_failed(void) {
         return last_io_failed;
     }